@@ -40,10 +40,28 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <print>
+#include <span>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -81,6 +99,67 @@ struct position {
     std::size_t pointer;
 };
 
+/**
+ *  @brief  Represent a line and column in the source code.
+ */
+struct location {
+    /**
+     *  @brief  The line number, starting from 1.
+     */
+    std::size_t line;
+
+    /**
+     *  @brief  The column number, starting from 1.
+     */
+    std::size_t column;
+};
+
+/**
+ *  @brief  Find the beginning of every line in the source code.
+ *
+ *  @param  src  The source code.
+ *  @return  Offsets where each line begins, the first one being 0.
+ */
+[[nodiscard]] auto index_lines(std::string_view src)
+-> std::vector<std::size_t>;
+
+/**
+ *  @brief  Find the index of the line containing the offset.
+ *
+ *  @param  line_starts  Offsets where each line begins, from
+ *                       @c index_lines .
+ *  @param  offset       The offset in the source code.
+ *  @return  Index of the line (starting from 0).
+ */
+[[nodiscard]] inline constexpr auto find_line(
+    std::span<const std::size_t> line_starts,
+    std::size_t                  offset
+) -> std::size_t
+{
+    auto it = std::ranges::upper_bound(line_starts, offset);
+    return it == line_starts.begin() ? 0 : it - line_starts.begin() - 1;
+}
+
+/**
+ *  @brief  Resolve the offset into line and column.
+ *
+ *  @param  line_starts  Offsets where each line begins, from
+ *                       @c index_lines .
+ *  @param  offset       The offset in the source code.
+ *  @return  Line and column of the offset.
+ */
+[[nodiscard]] inline constexpr auto locate(
+    std::span<const std::size_t> line_starts,
+    std::size_t                  offset
+) -> location
+{
+    auto line = find_line(line_starts, offset);
+    return location {
+        .line   = line + 1,
+        .column = offset - line_starts[line] + 1
+    };
+}
+
 /**
  *  @brief  Type or severity of message.
  */
@@ -123,15 +202,285 @@ enum class message_severity {
     return ""s;
 }
 
+/**
+ *  @brief  What the message is about.  This decides the text of the
+ *          message and the meaning of its arguments.
+ */
+enum class message_id : std::uint8_t {
+    /**
+     *  @brief  Uninitialized.
+     */
+    unknown,
+    /**
+     *  @brief  Unable to open file (string index).
+     */
+    unable_to_open_file,
+    /**
+     *  @brief  Source code too large to tokenize.
+     */
+    source_too_large,
+    /**
+     *  @brief  Unexpected EOF.
+     */
+    unexpected_eof,
+    /**
+     *  @brief  Invalid character (char) in source code.
+     */
+    invalid_character,
+    /**
+     *  @brief  Invalid character (char) in escape code.
+     */
+    invalid_escape_character,
+    /**
+     *  @brief  Invalid character (char) in numerical literal of base
+     *          (@c std::uint32_t ).
+     */
+    invalid_digit,
+    /**
+     *  @brief  Invalid character (char) in escape code of base
+     *          (@c std::uint32_t ).
+     */
+    invalid_escape_digit,
+    /**
+     *  @brief  Multiple decimal points in numerical literal of base
+     *          (@c std::uint32_t ).
+     */
+    multiple_decimal_points,
+    /**
+     *  @brief  Numerical literal cannot be converted to a number.
+     */
+    invalid_number,
+    /**
+     *  @brief  Number (@c double ) too large for character.
+     */
+    number_too_large_for_char,
+    /**
+     *  @brief  Too many characters in char literal.
+     */
+    too_many_characters,
+    /**
+     *  @brief  Char literal cannot be empty.
+     */
+    empty_char_literal,
+    /**
+     *  @brief  Expected an expression.
+     */
+    expected_expression,
+    /**
+     *  @brief  Expected a character (char).
+     */
+    expected_character,
+    /**
+     *  @brief  Expected a name.
+     */
+    expected_name,
+    /**
+     *  @brief  Expected a statement or an indented block.
+     */
+    expected_body,
+    /**
+     *  @brief  Expected the end of the line.
+     */
+    expected_end_of_line,
+    /**
+     *  @brief  Indentation does not match the enclosing block.
+     */
+    unexpected_indentation,
+    /**
+     *  @brief  Token cannot appear here.
+     */
+    unexpected_token,
+    /**
+     *  @brief  Operator is neither a regular operator nor declared.
+     */
+    unknown_operator,
+    /**
+     *  @brief  Name is not declared.
+     */
+    undeclared_name,
+    /**
+     *  @brief  Type is not declared.
+     */
+    unknown_type,
+    /**
+     *  @brief  Name is already declared in the scope.
+     */
+    redeclared_name,
+    /**
+     *  @brief  Expression cannot be assigned to.
+     */
+    not_assignable,
+    /**
+     *  @brief  Assignment to a constant.
+     */
+    assign_to_constant,
+    /**
+     *  @brief  No overload takes the number of arguments (@c std::uint32_t ).
+     */
+    no_matching_function,
+    /**
+     *  @brief  Expression cannot be called.
+     */
+    not_callable,
+    /**
+     *  @brief  Member is not declared in the structure.
+     */
+    unknown_member,
+    /**
+     *  @brief  Declaration is not allowed in the scope.
+     */
+    misplaced_declaration,
+    /**
+     *  @brief  Too many registers, constants or functions for the bytecode.
+     */
+    program_too_large,
+    /**
+     *  @brief  Index (@c double ) out of range.
+     */
+    index_out_of_range,
+    /**
+     *  @brief  Integer division by zero.
+     */
+    division_by_zero,
+    /**
+     *  @brief  Operator cannot be applied to the values.
+     */
+    invalid_operands,
+    /**
+     *  @brief  Value cannot be converted to the type.
+     */
+    invalid_conversion,
+    /**
+     *  @brief  No overload accepts the values.
+     */
+    no_matching_overload,
+    /**
+     *  @brief  Calls nested too deeply.
+     */
+    stack_overflow,
+    /**
+     *  @brief  Stopped after too many errors (@c std::uint32_t ).
+     */
+    too_many_errors,
+    /**
+     *  @brief  Number of message IDs.
+     */
+    max
+};
+
+/**
+ *  @brief  Convert @c message_id to string.
+ *
+ *  @param  id  The message ID.
+ *  @return  String representing @c message_id enumeration.
+ */
+[[nodiscard]] inline constexpr auto to_string(message_id id)
+{
+    using namespace std::string_literals;
+
+    switch (id)
+    {
+    using enum message_id;
+        case unknown: return "unknown"s;
+        case unable_to_open_file: return "unable_to_open_file"s;
+        case source_too_large: return "source_too_large"s;
+        case unexpected_eof: return "unexpected_eof"s;
+        case invalid_character: return "invalid_character"s;
+        case invalid_escape_character: return "invalid_escape_character"s;
+        case invalid_digit: return "invalid_digit"s;
+        case invalid_escape_digit: return "invalid_escape_digit"s;
+        case multiple_decimal_points: return "multiple_decimal_points"s;
+        case invalid_number: return "invalid_number"s;
+        case number_too_large_for_char: return "number_too_large_for_char"s;
+        case too_many_characters: return "too_many_characters"s;
+        case empty_char_literal: return "empty_char_literal"s;
+        case expected_expression: return "expected_expression"s;
+        case expected_character: return "expected_character"s;
+        case expected_name: return "expected_name"s;
+        case expected_body: return "expected_body"s;
+        case expected_end_of_line: return "expected_end_of_line"s;
+        case unexpected_indentation: return "unexpected_indentation"s;
+        case unexpected_token: return "unexpected_token"s;
+        case unknown_operator: return "unknown_operator"s;
+        case undeclared_name: return "undeclared_name"s;
+        case unknown_type: return "unknown_type"s;
+        case redeclared_name: return "redeclared_name"s;
+        case not_assignable: return "not_assignable"s;
+        case assign_to_constant: return "assign_to_constant"s;
+        case no_matching_function: return "no_matching_function"s;
+        case not_callable: return "not_callable"s;
+        case unknown_member: return "unknown_member"s;
+        case misplaced_declaration: return "misplaced_declaration"s;
+        case program_too_large: return "program_too_large"s;
+        case index_out_of_range: return "index_out_of_range"s;
+        case division_by_zero: return "division_by_zero"s;
+        case invalid_operands: return "invalid_operands"s;
+        case invalid_conversion: return "invalid_conversion"s;
+        case no_matching_overload: return "no_matching_overload"s;
+        case stack_overflow: return "stack_overflow"s;
+        case too_many_errors: return "too_many_errors"s;
+        case max: return "max"s;
+    }
+    return ""s;
+}
+
+/**
+ *  @brief  How to render the message.
+ */
+enum class message_style {
+    /**
+     *  @brief  Highlighted using ANSI escape codes.
+     */
+    ansi,
+    /**
+     *  @brief  Plain text.
+     */
+    raw
+};
+
+/**
+ *  @brief  Convert @c message_style to string.
+ *
+ *  @param  style  The message style.
+ *  @return  String representing @c message_style enumeration.
+ */
+[[nodiscard]] inline constexpr auto to_string(message_style style)
+{
+    using namespace std::string_literals;
+
+    switch (style)
+    {
+        case message_style::ansi: return "ansi"s;
+        case message_style::raw: return "raw"s;
+    }
+    return ""s;
+}
+
+/**
+ *  @brief  An argument of the message, interpreted according to the
+ *          @c message_id .
+ */
+using message_argument = std::variant<
+    std::monostate,
+    char,
+    double,
+    std::uint32_t
+>;
+
 /**
  *  @brief  The information.
+ *
+ *  The message is only a record of what happened.  The text is formatted
+ *  when the message is rendered using @c text or @c str .  String
+ *  arguments, such as a filename, are indices into the strings passed to
+ *  them.
  */
 struct message {
 
     /**
-     *  @brief  The message (multi-line string).
+     *  @brief  What the message is about.
      */
-    std::string msg;
+    message_id id;
 
     /**
      *  @brief  The severity of the message.
@@ -141,25 +490,55 @@ struct message {
     /**
      *  @brief  The position of the fault.
      */
-    position pos;
+    position pos = {};
 
     /**
-     *  @brief  Get formatted message (multi-line) ready to be outputted.
+     *  @brief  The arguments of the message.
+     */
+    std::array<message_argument, 2> args = {};
+
+    /**
+     *  @brief  Get the text of the message (single-line).
+     *
+     *  @param  strings  The strings that the string arguments refer to.
+     *  @param  style    How to render the message.
+     *  @return  Text of the message.
+     */
+    [[nodiscard]] auto text(
+        std::span<const std::string> strings = {},
+        message_style                style   = message_style::ansi
+    ) const -> std::string;
+
+    /**
+     *  @brief  Get formatted message (multi-line) ready to be outputted,
+     *          using an existing line index.
      *
-     *  @param  name  The name of the source code.
-     *  @param  src   The source code.
+     *  @param  name         The name of the source code.
+     *  @param  src          The source code.
+     *  @param  line_starts  Offsets where each line begins, from
+     *                       @c index_lines .
+     *  @param  strings      The strings that the string arguments refer to.
+     *  @param  style        How to render the message.
      *  @return  Formatted message.
+     *  @note  Use @c detronade::message_str to render the messages of a
+     *         source code, which passes its strings and line index.
      */
     auto str(
-        std::string_view name,
-        std::string_view src
+        std::string_view             name,
+        std::string_view             src,
+        std::span<const std::size_t> line_starts,
+        std::span<const std::string> strings = {},
+        message_style                style   = message_style::ansi
     ) -> std::string;
 };
 
+static_assert(std::is_trivially_copyable_v<message>,
+    "Messages must stay cheap to record");
+
 /**
  *  @brief  The type of token.
  */
-enum class token_type {
+enum class token_type : std::uint8_t {
     /**
      *  @brief  Numerical literal starts with 0-9 and can contain `.` or
      *          `'`.
@@ -257,6 +636,13 @@ enum class token_type {
     return ""s;
 }
 
+/**
+ *  @brief  Value of a numerical literal.  Integers are kept exact as
+ *          @c std::uint64_t when they fit, otherwise the value is the
+ *          nearest @c double .
+ */
+using number = std::variant<double, std::uint64_t>;
+
 /**
  *  @brief  The smallest unit, besides a character.
  */
@@ -267,130 +653,3466 @@ struct token {
      */
     token_type type;
 
+    /**
+     *  @brief  The beginning of the token in the source code.
+     */
+    std::uint32_t begin;
+
+    /**
+     *  @brief  The length of the token in the source code.
+     */
+    std::uint32_t length;
+
     /**
      *  @brief  The value of the token.
+     *
+     *  - @c numerical_literal holds the index to @c detronade::numbers as
+     *    @c std::uint32_t .
+     *  - @c char_literal and @c punctuation hold the @c char .
+     *  - @c string_literal holds the index to @c detronade::decoded_strings
+     *    as @c std::uint32_t if it contains escape sequences, otherwise it
+     *    holds nothing and the value is the source code without the quotes.
+     *  - @c identifier and @c operator_ hold the symbol ID in
+     *    @c detronade::symbols as @c std::uint32_t .
      */
-    std::variant<std::monostate, float, std::string, char> value;
+    std::variant<std::monostate, char, std::uint32_t> value;
 };
 
 /**
- *  @brief  Contains every information regarding the source code.
+ *  @brief  Interned names of identifiers and operators, each given a dense
+ *          32-bit symbol ID.
  */
-struct detronade {
+struct symbol_table {
 
     /**
-     *  @brief  Name of the source code, which can be a filename.
+     *  @brief  Hash that allows looking up names by @c std::string_view .
      */
-    std::string name;
+    struct name_hash {
+        /**
+         *  @brief  Enable heterogeneous lookup.
+         */
+        using is_transparent = void;
+
+        /**
+         *  @brief  Hash the name.
+         *
+         *  @param  name  The name.
+         *  @return  Hash of the name.
+         */
+        [[nodiscard]] inline constexpr auto operator()(
+            std::string_view name
+        ) const -> std::size_t
+        {
+            return std::hash<std::string_view> {}(name);
+        }
+    };
 
     /**
-     *  @brief  The entire source code.
+     *  @brief  Names indexed by their symbol ID.
      */
-    std::string source_code;
+    std::vector<std::string> names;
 
     /**
-     *  @brief  All the messages regarding the source code.
+     *  @brief  Symbol IDs by their names.
      */
-    std::vector<message> messages;
+    std::unordered_map<std::string, std::uint32_t, name_hash, std::equal_to<>>
+    ids;
 
     /**
-     *  @brief  Parsed tokens.
+     *  @brief  Get the symbol ID of the name, adding it if it is new.
+     *
+     *  @param  name  The name.
+     *  @return  Symbol ID of the name.
      */
-    std::vector<token> tokens;
+    [[nodiscard]] inline constexpr auto intern(std::string_view name)
+    -> std::uint32_t
+    {
+        auto it = ids.find(name);
+        if (it != ids.end())
+        {
+            return it->second;
+        }
+
+        auto id = static_cast<std::uint32_t>(names.size());
+        names.emplace_back(name);
+        ids.emplace(name, id);
+        return id;
+    }
 
     /**
-     *  @brief  Number of lines in the source code.
+     *  @brief  Find the symbol ID of the name without adding it.
+     *
+     *  @param  name  The name.
+     *  @return  Symbol ID of the name, if it was interned.
      */
-    std::size_t num_lines;
+    [[nodiscard]] inline constexpr auto find(std::string_view name) const
+    -> std::optional<std::uint32_t>
+    {
+        auto it = ids.find(name);
+        if (it == ids.end())
+        {
+            return std::nullopt;
+        }
+        return it->second;
+    }
 
     /**
-     *  @brief  This is set to true when the last compilation is successful.
+     *  @brief  Get the name of the symbol ID.
+     *
+     *  @param  id  The symbol ID.
+     *  @return  Name of the symbol.
+     */
+    [[nodiscard]] inline constexpr auto name(std::uint32_t id) const
+    -> std::string_view
+    {
+        return names[id];
+    }
+};
+
+/**
+ *  @brief  Read-only memory mapping of a file, which is always followed by
+ *          at least one `\0` so that it can be scanned like a
+ *          null-terminated string.
+ */
+struct mapped_file {
+
+    /**
+     *  @brief  The beginning of the file contents.
      */
-    bool compilation_successful;
+    const char *data = nullptr;
 
     /**
-     *  @brief  Default constructor.
+     *  @brief  The size of the file contents.
      */
-    inline constexpr detronade() = default;
+    std::size_t size = 0;
 
     /**
-     *  @brief  Creates the source from name and content.
-     *
-     *  @param  name         The name of the source, can be a filename.
-     *  @param  source_code  The source code.
+     *  @brief  The size of the entire mapping, including the `\0` padding.
      */
-    inline constexpr detronade(
-        std::string_view name,
-        std::string_view source_code
-    ) : name(name), source_code(source_code) {}
+    std::size_t mapped_size = 0;
 
     /**
-     *  @brief  Creates the source from filename and reads contents.
-     *  @param  filename  The filename for the source name.
+     *  @brief  Platform handle of the mapping, if required by the platform.
      */
-    inline constexpr detronade(std::string_view filename)
-        : name(filename)
+    void *handle = nullptr;
+
+    /**
+     *  @brief  Default constructor, maps nothing.
+     */
+    inline constexpr mapped_file() = default;
+
+    /**
+     *  @brief  Mappings cannot be copied.
+     */
+    mapped_file(const mapped_file &) = delete;
+
+    /**
+     *  @brief  Take over the mapping from other.
+     *  @param  other  The other mapping.
+     */
+    inline constexpr mapped_file(mapped_file &&other) noexcept
+        : data(std::exchange(other.data, nullptr)),
+          size(std::exchange(other.size, 0)),
+          mapped_size(std::exchange(other.mapped_size, 0)),
+          handle(std::exchange(other.handle, nullptr)) {}
+
+    /**
+     *  @brief  Unmaps the file.
+     */
+    inline ~mapped_file()
     {
-        load_file(filename);
+        unmap();
     }
 
     /**
-     *  @brief  Loads file contents into @c source_code .
+     *  @brief  Map the file, unmapping the previous one.
      *
-     *  @param  filename  The file to load.
-     *  @return  True if successfully loaded.
-     *  @note  Does not set the source name to the filename.
+     *  @param  filename  The file to map.
+     *  @return  True if successfully mapped.
      */
-    inline constexpr auto load_file(
-        std::string_view filename
-    ) -> bool
-    {
-        try
-        {
-            source_code = alce::file::read_all(filename);
-        }
-        catch (const std::exception &e)
-        {
-            using namespace alce::aec;
-            using namespace alce::aec_operators;
-            auto msg      = message {
-                .msg      = "Unable to open file " + (bold + white)(filename),
-                .severity = message_severity::error
-            };
-            messages.emplace_back(msg);
-            return false;
-        }
-
-        return true;
-    }
+    [[nodiscard]] auto map(std::string_view filename) -> bool;
 
     /**
-     *  @brief  Tokenize the source.
-     *  @return  Individual tokens of the source.
+     *  @brief  Unmap the file, if mapped.
      */
-    [[nodiscard]] auto tokenize() -> std::optional<std::vector<token>>;
+    auto unmap() -> void;
 
     /**
-     *  @brief  Compile the source code.
+     *  @brief  Get the file contents.
+     *  @return  View to the file contents.
      */
-    inline constexpr auto compile()
+    [[nodiscard]] inline constexpr auto view() const
     {
-        num_lines   = std::ranges::count(source_code, '\n') + 1;
-        auto tokens = tokenize();
-        if (!tokens.has_value())
-        {
-            return;
-        }
-
-        this->tokens = tokens.value();
+        return std::string_view(data, size);
     }
 
-    inline constexpr auto print_messages()
+    /**
+     *  @brief  Mappings cannot be copied.
+     */
+    auto operator=(const mapped_file &) -> mapped_file & = delete;
+
+    /**
+     *  @brief  Take over the mapping from other.
+     *
+     *  @param  other  The other mapping.
+     *  @return  This mapping.
+     */
+    inline constexpr auto operator=(mapped_file &&other) noexcept
+    -> mapped_file &
+    {
+        if (this != &other)
+        {
+            unmap();
+            data        = std::exchange(other.data, nullptr);
+            size        = std::exchange(other.size, 0);
+            mapped_size = std::exchange(other.mapped_size, 0);
+            handle      = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+};
+
+/**
+ *  @brief  Result of lexing a token.
+ */
+enum class lex_status : std::uint8_t {
+    /**
+     *  @brief  A token was lexed.
+     */
+    token,
+    /**
+     *  @brief  Reached the end of the source code.
+     */
+    end,
+    /**
+     *  @brief  A lexical error occurred, which is added to the messages.
+     */
+    error
+};
+
+/**
+ *  @brief  Convert @c lex_status to string.
+ *
+ *  @param  status  The lex status.
+ *  @return  String representing @c lex_status enumeration.
+ */
+[[nodiscard]] inline constexpr auto to_string(lex_status status)
+{
+    using namespace std::string_literals;
+
+    switch (status)
+    {
+        case lex_status::token: return "token"s;
+        case lex_status::end: return "end"s;
+        case lex_status::error: return "error"s;
+    }
+    return ""s;
+}
+
+/**
+ *  @brief  Index of a node in @c syntax_tree::nodes , or of the first
+ *          element of a list in @c syntax_tree::extra .
+ */
+using node_index = std::uint32_t;
+
+/**
+ *  @brief  Refers to no node, such as a missing initializer.
+ */
+inline constexpr node_index no_node = std::numeric_limits<node_index>::max();
+
+/**
+ *  @brief  The kind of operator.
+ */
+enum class operator_kind : std::uint8_t {
+    /**
+     *  @brief  Uninitialized, or not an operator.
+     */
+    unknown,
+    /**
+     *  @brief  Addition `+`, or unary plus.
+     */
+    add,
+    /**
+     *  @brief  Subtraction `-`, or negation.
+     */
+    subtract,
+    /**
+     *  @brief  Multiplication `*`.
+     */
+    multiply,
+    /**
+     *  @brief  Division `/`.
+     */
+    divide,
+    /**
+     *  @brief  Flooring division `//`.
+     */
+    floor_divide,
+    /**
+     *  @brief  Modulo `%`.
+     */
+    modulo,
+    /**
+     *  @brief  Exponentiation `**`.
+     */
+    power,
+    /**
+     *  @brief  Left shift `<<`.
+     */
+    shift_left,
+    /**
+     *  @brief  Right shift `>>`.
+     */
+    shift_right,
+    /**
+     *  @brief  Less than `<`.
+     */
+    less,
+    /**
+     *  @brief  Less than or equal to `<=`.
+     */
+    less_equal,
+    /**
+     *  @brief  Greater than `>`.
+     */
+    greater,
+    /**
+     *  @brief  Greater than or equal to `>=`.
+     */
+    greater_equal,
+    /**
+     *  @brief  Equal to `==`.
+     */
+    equal,
+    /**
+     *  @brief  Not equal to `!=`.
+     */
+    not_equal,
+    /**
+     *  @brief  Bitwise and `&`.
+     */
+    bitwise_and,
+    /**
+     *  @brief  Bitwise exclusive or `^`.
+     */
+    bitwise_xor,
+    /**
+     *  @brief  Bitwise or `|`.
+     */
+    bitwise_or,
+    /**
+     *  @brief  Logical and `&&`.
+     */
+    logical_and,
+    /**
+     *  @brief  Logical or `||`.
+     */
+    logical_or,
+    /**
+     *  @brief  Logical not `!`.
+     */
+    logical_not,
+    /**
+     *  @brief  Bitwise not `~`.
+     */
+    bitwise_not,
+    /**
+     *  @brief  Increment `++`.
+     */
+    increment,
+    /**
+     *  @brief  Decrement `--`.
+     */
+    decrement,
+    /**
+     *  @brief  Assignment `=`.
+     */
+    assign,
+    /**
+     *  @brief  Beginning of subscript `[`.
+     */
+    subscript_begin,
+    /**
+     *  @brief  End of subscript `]`.
+     */
+    subscript_end,
+    /**
+     *  @brief  User-defined operator, identified by its symbol ID.
+     */
+    custom,
+    /**
+     *  @brief  Number of operator kinds.
+     */
+    max
+};
+
+/**
+ *  @brief  Convert @c operator_kind to string.
+ *
+ *  @param  kind  The operator kind.
+ *  @return  String representing @c operator_kind enumeration.
+ */
+[[nodiscard]] inline constexpr auto to_string(operator_kind kind)
+{
+    using namespace std::string_literals;
+
+    switch (kind)
+    {
+    using enum operator_kind;
+        case unknown: return "unknown"s;
+        case add: return "add"s;
+        case subtract: return "subtract"s;
+        case multiply: return "multiply"s;
+        case divide: return "divide"s;
+        case floor_divide: return "floor_divide"s;
+        case modulo: return "modulo"s;
+        case power: return "power"s;
+        case shift_left: return "shift_left"s;
+        case shift_right: return "shift_right"s;
+        case less: return "less"s;
+        case less_equal: return "less_equal"s;
+        case greater: return "greater"s;
+        case greater_equal: return "greater_equal"s;
+        case equal: return "equal"s;
+        case not_equal: return "not_equal"s;
+        case bitwise_and: return "bitwise_and"s;
+        case bitwise_xor: return "bitwise_xor"s;
+        case bitwise_or: return "bitwise_or"s;
+        case logical_and: return "logical_and"s;
+        case logical_or: return "logical_or"s;
+        case logical_not: return "logical_not"s;
+        case bitwise_not: return "bitwise_not"s;
+        case increment: return "increment"s;
+        case decrement: return "decrement"s;
+        case assign: return "assign"s;
+        case subscript_begin: return "subscript_begin"s;
+        case subscript_end: return "subscript_end"s;
+        case custom: return "custom"s;
+        case max: return "max"s;
+    }
+    return ""s;
+}
+
+/**
+ *  @brief  Where the operands of an overloaded operator go.
+ */
+enum class operator_form : std::uint8_t {
+    /**
+     *  @brief  Uninitialized.
+     */
+    unknown,
+    /**
+     *  @brief  Operator before the operand, `^-^v`.
+     */
+    prefix,
+    /**
+     *  @brief  Operator after the operand, `v!!`.
+     */
+    postfix,
+    /**
+     *  @brief  Operator between the operands, `a |/ b`.
+     */
+    binary,
+    /**
+     *  @brief  Operand enclosed after the other, `a[b]`.
+     */
+    subscript
+};
+
+/**
+ *  @brief  Convert @c operator_form to string.
+ *
+ *  @param  form  The operator form.
+ *  @return  String representing @c operator_form enumeration.
+ */
+[[nodiscard]] inline constexpr auto to_string(operator_form form)
+{
+    using namespace std::string_literals;
+
+    switch (form)
+    {
+    using enum operator_form;
+        case unknown: return "unknown"s;
+        case prefix: return "prefix"s;
+        case postfix: return "postfix"s;
+        case binary: return "binary"s;
+        case subscript: return "subscript"s;
+    }
+    return ""s;
+}
+
+/**
+ *  @brief  The kind of node in the syntax tree.
+ *
+ *  The meaning of @c node::a , @c node::b and @c node::c depends on the
+ *  kind, documented on each kind.  A list is stored in
+ *  @c syntax_tree::extra beginning at @c node::b with @c node::c elements.
+ */
+enum class node_kind : std::uint8_t {
+    /**
+     *  @brief  Uninitialized.
+     */
+    unknown,
+    /**
+     *  @brief  Numerical literal, a: index to @c detronade::numbers .
+     */
+    number,
+    /**
+     *  @brief  Char literal, a: the char.
+     */
+    character,
+    /**
+     *  @brief  String literal, the value of the token.
+     */
+    string,
+    /**
+     *  @brief  `true` or `false`, a: 1 or 0.
+     */
+    boolean,
+    /**
+     *  @brief  Name of a variable, function or type, a: symbol ID.
+     */
+    name,
+    /**
+     *  @brief  Prefix operator, a: operand, b: symbol ID if custom.
+     */
+    unary,
+    /**
+     *  @brief  Postfix operator, a: operand, b: symbol ID if custom.
+     */
+    postfix,
+    /**
+     *  @brief  Binary operator, a: left, b: right, c: symbol ID if custom.
+     */
+    binary,
+    /**
+     *  @brief  Assignment, a: target, b: value.  The operator is
+     *          @c operator_kind::assign , or the operator of a compound
+     *          assignment like `+=`.
+     */
+    assign,
+    /**
+     *  @brief  Call, a: callee, b and c: arguments.
+     */
+    call,
+    /**
+     *  @brief  Member access, a: object, b: symbol ID of the member.
+     */
+    member,
+    /**
+     *  @brief  Subscript, a: object, b: index.
+     */
+    subscript,
+    /**
+     *  @brief  Array literal, b and c: elements.
+     */
+    array,
+    /**
+     *  @brief  Type, a: symbol ID of the type name.
+     */
+    type_name,
+    /**
+     *  @brief  Array type, a: element type, b: size or @c no_node .
+     */
+    type_array,
+    /**
+     *  @brief  Expression statement, a: expression.
+     */
+    expression,
+    /**
+     *  @brief  Variable declaration, a: type, b and c: @c variable nodes.
+     *          @c node::constant is set in flags for `const`.
+     */
+    declaration,
+    /**
+     *  @brief  Declared variable, a: symbol ID, b: initializer or
+     *          @c no_node .
+     */
+    variable,
+    /**
+     *  @brief  `if` statement, a: condition, b: body, c: `else` body or
+     *          @c no_node .
+     */
+    if_,
+    /**
+     *  @brief  `while` statement, a: condition, b: body.
+     */
+    while_,
+    /**
+     *  @brief  `for` statement, a: index to @c syntax_tree::extra of the
+     *          initializer, condition and step (each may be @c no_node ),
+     *          b: body.
+     */
+    for_,
+    /**
+     *  @brief  Indented block, b and c: statements.
+     */
+    block,
+    /**
+     *  @brief  `return` statement, a: value or @c no_node .
+     */
+    return_,
+    /**
+     *  @brief  `void` statement, does nothing.
+     */
+    void_,
+    /**
+     *  @brief  Function, a: return type, b: index to
+     *          @c syntax_tree::extra of the symbol ID, the body and the
+     *          parameters, c: number of parameters.
+     */
+    function,
+    /**
+     *  @brief  Parameter, a: type, b: symbol ID.
+     */
+    parameter,
+    /**
+     *  @brief  Constructor, laid out like @c function without a return
+     *          type.
+     */
+    constructor,
+    /**
+     *  @brief  Destructor, laid out like @c function without a return type.
+     */
+    destructor,
+    /**
+     *  @brief  Operator overload, laid out like @c function with the symbol
+     *          ID of the operator.  The @c operator_form is in flags.
+     */
+    operator_,
+    /**
+     *  @brief  Structure, a: symbol ID, b: body.
+     */
+    struct_,
+    /**
+     *  @brief  Number of node kinds.
+     */
+    max
+};
+
+/**
+ *  @brief  Convert @c node_kind to string.
+ *
+ *  @param  kind  The node kind.
+ *  @return  String representing @c node_kind enumeration.
+ */
+[[nodiscard]] inline constexpr auto to_string(node_kind kind)
+{
+    using namespace std::string_literals;
+
+    switch (kind)
+    {
+    using enum node_kind;
+        case unknown: return "unknown"s;
+        case number: return "number"s;
+        case character: return "character"s;
+        case string: return "string"s;
+        case boolean: return "boolean"s;
+        case name: return "name"s;
+        case unary: return "unary"s;
+        case postfix: return "postfix"s;
+        case binary: return "binary"s;
+        case assign: return "assign"s;
+        case call: return "call"s;
+        case member: return "member"s;
+        case subscript: return "subscript"s;
+        case array: return "array"s;
+        case type_name: return "type_name"s;
+        case type_array: return "type_array"s;
+        case expression: return "expression"s;
+        case declaration: return "declaration"s;
+        case variable: return "variable"s;
+        case if_: return "if_"s;
+        case while_: return "while_"s;
+        case for_: return "for_"s;
+        case block: return "block"s;
+        case return_: return "return_"s;
+        case void_: return "void_"s;
+        case function: return "function"s;
+        case parameter: return "parameter"s;
+        case constructor: return "constructor"s;
+        case destructor: return "destructor"s;
+        case operator_: return "operator_"s;
+        case struct_: return "struct_"s;
+        case max: return "max"s;
+    }
+    return ""s;
+}
+
+/**
+ *  @brief  A node of the syntax tree, referring to other nodes by index.
+ */
+struct node {
+
+    /**
+     *  @brief  Flag of @c node_kind::declaration declared `const`.
+     */
+    static inline constexpr std::uint16_t constant = 1;
+
+    /**
+     *  @brief  The kind of node.
+     */
+    node_kind kind = node_kind::unknown;
+
+    /**
+     *  @brief  The operator, if the node has one.
+     */
+    operator_kind op = operator_kind::unknown;
+
+    /**
+     *  @brief  Flags, depending on the kind.
+     */
+    std::uint16_t flags = 0;
+
+    /**
+     *  @brief  Index of the main token in @c detronade::tokens , used to
+     *          locate the node in the source code.
+     */
+    std::uint32_t token = 0;
+
+    /**
+     *  @brief  First operand, depending on the kind.
+     */
+    std::uint32_t a = no_node;
+
+    /**
+     *  @brief  Second operand, depending on the kind.
+     */
+    std::uint32_t b = no_node;
+
+    /**
+     *  @brief  Third operand, depending on the kind.
+     */
+    std::uint32_t c = no_node;
+};
+
+static_assert(sizeof(node) == 20, "Nodes must stay compact");
+
+/**
+ *  @brief  Syntax tree stored in two contiguous arrays.  Nodes refer to
+ *          each other by 32-bit index, and lists of nodes are stored
+ *          consecutively in @c extra .
+ */
+struct syntax_tree {
+
+    /**
+     *  @brief  All the nodes.
+     */
+    std::vector<node> nodes;
+
+    /**
+     *  @brief  Lists of node indices, and other data that does not fit in a
+     *          node.
+     */
+    std::vector<std::uint32_t> extra;
+
+    /**
+     *  @brief  The @c node_kind::block of the statements in global scope.
+     */
+    node_index root = no_node;
+
+    /**
+     *  @brief  Add a node.
+     *
+     *  @param  n  The node.
+     *  @return  Index of the node.
+     */
+    inline constexpr auto add(const node &n) -> node_index
+    {
+        auto index = static_cast<node_index>(nodes.size());
+        nodes.emplace_back(n);
+        return index;
+    }
+
+    /**
+     *  @brief  Get the list of a node, such as the arguments of a
+     *          @c node_kind::call or the statements of a
+     *          @c node_kind::block .
+     *
+     *  @param  n  The node.
+     *  @return  Indices of the nodes in the list.
+     */
+    [[nodiscard]] inline constexpr auto list(const node &n) const
+    {
+        return std::span<const std::uint32_t>(extra).subspan(n.b, n.c);
+    }
+
+    /**
+     *  @brief  Get the symbol ID of a function, constructor, destructor or
+     *          operator overload.
+     *
+     *  @param  n  The function node.
+     *  @return  The symbol ID of the name or the operator.
+     */
+    [[nodiscard]] inline constexpr auto function_symbol(const node &n) const
+    {
+        return extra[n.b];
+    }
+
+    /**
+     *  @brief  Get the body of a function, constructor, destructor or
+     *          operator overload.
+     *
+     *  @param  n  The function node.
+     *  @return  Index of the body.
+     */
+    [[nodiscard]] inline constexpr auto function_body(const node &n) const
+    {
+        return extra[n.b + 1];
+    }
+
+    /**
+     *  @brief  Get the parameters of a function, constructor, destructor or
+     *          operator overload.
+     *
+     *  @param  n  The function node.
+     *  @return  Indices of the @c node_kind::parameter nodes.
+     */
+    [[nodiscard]] inline constexpr auto parameters(const node &n) const
+    {
+        return std::span<const std::uint32_t>(extra).subspan(n.b + 2, n.c);
+    }
+
+    /**
+     *  @brief  Get the node.
+     *
+     *  @param  index  Index of the node.
+     *  @return  The node.
+     */
+    [[nodiscard]] inline constexpr auto operator[](node_index index) const
+    -> const node &
+    {
+        return nodes[index];
+    }
+};
+
+/**
+ *  @brief  Index of a type in @c program::types .
+ */
+using type_index = std::uint32_t;
+
+/**
+ *  @brief  Type that is only known when the program runs.
+ */
+inline constexpr type_index unknown_type = 0;
+
+/**
+ *  @brief  Type of functions that return nothing.
+ */
+inline constexpr type_index void_type = 1;
+
+/**
+ *  @brief  `real`, a 64-bit floating point number.
+ */
+inline constexpr type_index real_type = 2;
+
+/**
+ *  @brief  `int`, a 32-bit signed integer.
+ */
+inline constexpr type_index int_type = 3;
+
+/**
+ *  @brief  `bool`.
+ */
+inline constexpr type_index bool_type = 4;
+
+/**
+ *  @brief  `char`, an 8-bit character.
+ */
+inline constexpr type_index char_type = 5;
+
+/**
+ *  @brief  Index of a function that does not exist.
+ */
+inline constexpr std::uint32_t no_function =
+    std::numeric_limits<std::uint32_t>::max();
+
+/**
+ *  @brief  The kind of type.
+ */
+enum class type_kind : std::uint8_t {
+    /**
+     *  @brief  Only known when the program runs.
+     */
+    unknown,
+    /**
+     *  @brief  Nothing.
+     */
+    void_,
+    /**
+     *  @brief  `real`.
+     */
+    real,
+    /**
+     *  @brief  `int`.
+     */
+    int_,
+    /**
+     *  @brief  `bool`.
+     */
+    bool_,
+    /**
+     *  @brief  `char`.
+     */
+    char_,
+    /**
+     *  @brief  Array of another type.
+     */
+    array,
+    /**
+     *  @brief  Structure.
+     */
+    struct_,
+    /**
+     *  @brief  Number of type kinds.
+     */
+    max
+};
+
+/**
+ *  @brief  Convert @c type_kind to string.
+ *
+ *  @param  kind  The type kind.
+ *  @return  String representing @c type_kind enumeration.
+ */
+[[nodiscard]] inline constexpr auto to_string(type_kind kind)
+{
+    using namespace std::string_literals;
+
+    switch (kind)
+    {
+    using enum type_kind;
+        case unknown: return "unknown"s;
+        case void_: return "void_"s;
+        case real: return "real"s;
+        case int_: return "int_"s;
+        case bool_: return "bool_"s;
+        case char_: return "char_"s;
+        case array: return "array"s;
+        case struct_: return "struct_"s;
+        case max: break;
+    }
+    return ""s;
+}
+
+/**
+ *  @brief  A type of the program.
+ */
+struct type_info {
+
+    /**
+     *  @brief  The kind of type.
+     */
+    type_kind kind = type_kind::unknown;
+
+    /**
+     *  @brief  The element type of @c type_kind::array , or the index to
+     *          @c program::structs of @c type_kind::struct_ .
+     */
+    std::uint32_t index = 0;
+};
+
+struct array_buffer;
+struct array_object;
+struct struct_object;
+
+/**
+ *  @brief  A value of the program when it runs, boxed in 64 bits.
+ *
+ *  A `real` is stored as its own bits.  Other values are stored in the
+ *  negative quiet NaNs from @c value::boxed up, with the tag in the upper
+ *  16 bits and the payload in the lower 48 bits, which is an `int`,
+ *  `bool` or `char`, or the address of an array or structure.  A NaN that
+ *  would fall among them is stored as the canonical NaN instead.  Copying
+ *  a value copies 8 bytes and counts a reference to its object, if any.
+ *
+ *  Arrays and structures are on the heap, shared by the values that refer
+ *  to them, and are copied by @c opcode::copy wherever the language
+ *  copies them by value.  A copy of an array of numbers shares the
+ *  elements until one of the arrays is changed.  A structure is a single
+ *  allocation with its fields at fixed offsets after the header.  The
+ *  reference counts are not atomic, so the values of a program that runs
+ *  are not shared between threads.
+ */
+struct value {
+
+    /**
+     *  @brief  Bit position of the tag.
+     */
+    static constexpr int tag_shift = 48;
+
+    /**
+     *  @brief  The payload bits of a boxed value.
+     */
+    static constexpr std::uint64_t payload = (1ull << tag_shift) - 1;
+
+    /**
+     *  @brief  The lowest boxed value, the bits of a real are below it.
+     */
+    static constexpr std::uint64_t boxed = 0xFFF9ull << tag_shift;
+
+    /**
+     *  @brief  The bits of the canonical NaN.
+     */
+    static constexpr std::uint64_t canonical_nan = 0x7FF8ull << tag_shift;
+
+    /**
+     *  @brief  The tag of values of the type, @c std::monostate for no
+     *          value.  The tags from the array's up are of objects.
+     *
+     *  @tparam  T  The type.
+     */
+    template <typename T>
+    static constexpr std::uint64_t tag =
+        std::is_same_v<T, std::monostate> ? 0xFFF9
+      : std::is_same_v<T, std::int32_t>   ? 0xFFFA
+      : std::is_same_v<T, bool>           ? 0xFFFB
+      : std::is_same_v<T, char>           ? 0xFFFC
+      : std::is_same_v<T, array_object>   ? 0xFFFD
+      : std::is_same_v<T, struct_object>  ? 0xFFFE
+      : 0;
+
+    /**
+     *  @brief  The boxed value.  Do not modify it directly, it may hold a
+     *          reference to an object.
+     */
+    std::uint64_t bits = tag<std::monostate> << tag_shift;
+
+    /**
+     *  @brief  Default constructor, no value.
+     */
+    inline constexpr value() noexcept = default;
+
+    /**
+     *  @brief  No value.
+     */
+    inline constexpr value(std::monostate) noexcept {}
+
+    /**
+     *  @brief  A `real`.
+     *  @param  x  The real.
+     */
+    inline constexpr value(double x) noexcept
+        : bits(std::bit_cast<std::uint64_t>(x))
+    {
+        if (bits >= boxed)
+        {
+            bits = canonical_nan;
+        }
+    }
+
+    /**
+     *  @brief  An `int`.
+     *  @param  i  The int.
+     */
+    inline constexpr value(std::int32_t i) noexcept
+        : bits(tag<std::int32_t> << tag_shift
+             | static_cast<std::uint32_t>(i)) {}
+
+    /**
+     *  @brief  A `bool`.
+     *  @param  b  The bool.
+     */
+    inline constexpr value(bool b) noexcept
+        : bits(tag<bool> << tag_shift | b) {}
+
+    /**
+     *  @brief  A `char`.
+     *  @param  c  The char.
+     */
+    inline constexpr value(char c) noexcept
+        : bits(tag<char> << tag_shift | static_cast<unsigned char>(c)) {}
+
+    /**
+     *  @brief  Create an array on the heap.
+     *
+     *  @param  type      The type of the array.
+     *  @param  flat      Whether the elements are numbers, which copies of
+     *                    the array can share.
+     *  @param  elements  The elements.
+     *  @return  The array.
+     */
+    [[nodiscard]] inline static auto make_array(
+        type_index         type,
+        bool               flat,
+        std::vector<value> elements
+    ) -> value;
+
+    /**
+     *  @brief  Create an array of numbers on the heap that shares the
+     *          elements of another until one of them is changed.
+     *
+     *  @param  array  The other array, which is flat.
+     *  @return  The array.
+     */
+    [[nodiscard]] inline static auto make_array(const array_object &array)
+        -> value;
+
+    /**
+     *  @brief  Create a structure on the heap, with no value in its
+     *          fields.
+     *
+     *  @param  type  The type of the structure.
+     *  @param  size  Number of fields.
+     *  @return  The structure.
+     */
+    [[nodiscard]] inline static auto make_struct(
+        type_index    type,
+        std::uint32_t size
+    ) -> value;
+
+    /**
+     *  @brief  Refer to the object of other too.
+     *  @param  other  The other value.
+     */
+    inline value(const value &other) noexcept : bits(other.bits)
+    {
+        retain(bits);
+    }
+
+    /**
+     *  @brief  Take over the value of other, leaving no value.
+     *  @param  other  The other value.
+     */
+    inline constexpr value(value &&other) noexcept
+        : bits(std::exchange(other.bits, value {}.bits)) {}
+
+    /**
+     *  @brief  Releases the object.
+     */
+    inline ~value()
+    {
+        release(bits);
+    }
+
+    /**
+     *  @brief  Refer to the object of other too.
+     *
+     *  @param  other  The other value.
+     *  @return  This value.
+     */
+    inline auto operator=(const value &other) noexcept -> value &
+    {
+        retain(other.bits);
+        release(std::exchange(bits, other.bits));
+        return *this;
+    }
+
+    /**
+     *  @brief  Take over the value of other, leaving no value.  The value
+     *          of other is taken before the object of this one is
+     *          released, in case it owns other.
+     *
+     *  @param  other  The other value.
+     *  @return  This value.
+     */
+    inline auto operator=(value &&other) noexcept -> value &
+    {
+        auto taken = std::exchange(other.bits, value {}.bits);
+        release(std::exchange(bits, taken));
+        return *this;
+    }
+
+    /**
+     *  @brief  Check if the value is of the type.
+     *
+     *  @tparam  T  @c std::monostate , `double`, @c std::int32_t , `bool`,
+     *              `char`, @c array_object or @c struct_object .
+     *  @return  True if the value is of the type.
+     */
+    template <typename T>
+    [[nodiscard]] inline constexpr auto holds() const noexcept -> bool
+    {
+        if constexpr (std::is_same_v<T, double>)
+        {
+            return bits < boxed;
+        }
+        else
+        {
+            static_assert(tag<T> != 0, "Not a type of value");
+            return bits >> tag_shift == tag<T>;
+        }
+    }
+
+    /**
+     *  @brief  Check if the value is an array or a structure.
+     *  @return  True if the value refers to an object.
+     */
+    [[nodiscard]] inline constexpr auto is_object() const noexcept -> bool
+    {
+        return is_object(bits);
+    }
+
+    /**
+     *  @brief  Get the value as the type, without checking it.
+     *
+     *  @tparam  T  `double`, @c std::int32_t , `bool` or `char`.
+     *  @return  The value.
+     */
+    template <typename T>
+    [[nodiscard]] inline constexpr auto get() const noexcept -> T
+    {
+        if constexpr (std::is_same_v<T, double>)
+        {
+            return std::bit_cast<double>(bits);
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            return (bits & 1) != 0;
+        }
+        else
+        {
+            using bits_type = std::make_unsigned_t<T>;
+            return static_cast<T>(static_cast<bits_type>(bits));
+        }
+    }
+
+    /**
+     *  @brief  Get the value as the type, if it is of the type.
+     *
+     *  @tparam  T  `double`, @c std::int32_t , `bool`, `char`,
+     *              @c array_object or @c struct_object .
+     *  @return  The number, or a pointer to the object.  Nothing, or null
+     *           if the value is not of the type.
+     */
+    template <typename T>
+    [[nodiscard]] inline auto get_if() const noexcept
+    {
+        if constexpr (std::is_same_v<T, array_object>
+                   || std::is_same_v<T, struct_object>)
+        {
+            return holds<T>() ? reinterpret_cast<T *>(bits & payload)
+                              : nullptr;
+        }
+        else
+        {
+            return holds<T>() ? std::optional<T>(get<T>()) : std::nullopt;
+        }
+    }
+
+    /**
+     *  @brief  Check if the bits refer to an object.
+     *
+     *  @param  bits  The bits of a value.
+     *  @return  True if the bits refer to an array or a structure.
+     */
+    [[nodiscard]] static inline constexpr auto is_object(std::uint64_t bits)
+    noexcept -> bool
+    {
+        return bits >= tag<array_object> << tag_shift;
+    }
+
+    /**
+     *  @brief  Add a reference to the object of the bits, if any.
+     *  @param  bits  The bits of a value.
+     */
+    static inline auto retain(std::uint64_t bits) noexcept -> void;
+
+    /**
+     *  @brief  Remove a reference to the object of the bits, if any, and
+     *          delete it if it was the last one.
+     *
+     *  @param  bits  The bits of a value.
+     */
+    static inline auto release(std::uint64_t bits) noexcept -> void;
+
+    /**
+     *  @brief  Delete the object of the bits, which has no references
+     *          left.  It is not inline, so that the values copied in the
+     *          hot paths do not carry the destructors of the objects.
+     *
+     *  @param  bits  The bits of a value that refers to an object.
+     */
+    static auto delete_object(std::uint64_t bits) noexcept -> void;
+};
+
+static_assert(sizeof(value) == 8, "A value is boxed in 64 bits");
+
+/**
+ *  @brief  The elements of an array, shared by the copies of an array of
+ *          numbers until one of them is changed.
+ */
+struct array_buffer {
+
+    /**
+     *  @brief  Number of arrays that share the elements.
+     */
+    std::size_t shares = 1;
+
+    /**
+     *  @brief  The elements.
+     */
+    std::vector<value> elements;
+};
+
+/**
+ *  @brief  An array, including `char[]` strings.
+ */
+struct array_object {
+
+    /**
+     *  @brief  Number of values that refer to the array, maintained by
+     *          @c value .
+     */
+    std::size_t references = 0;
+
+    /**
+     *  @brief  The type of the array.
+     */
+    type_index type;
+
+    /**
+     *  @brief  Whether the elements are numbers, `bool`s or `char`s, which
+     *          copies of the array share instead of copying.
+     */
+    bool flat = false;
+
+    /**
+     *  @brief  The elements, maintained by @c value .
+     */
+    array_buffer *buffer = nullptr;
+
+    /**
+     *  @brief  Get the elements to read them.
+     *  @return  The elements.
+     */
+    [[nodiscard]] inline auto elements() const noexcept
+        -> const std::vector<value> &
+    {
+        return buffer->elements;
+    }
+
+    /**
+     *  @brief  Get the elements to change them, copying them first if
+     *          other arrays share them.
+     *
+     *  @return  The elements.
+     */
+    [[nodiscard]] inline auto change() -> std::vector<value> &
+    {
+        if (buffer->shares > 1)
+        {
+            auto copy = new array_buffer { .elements = buffer->elements };
+            buffer->shares--;
+            buffer = copy;
+        }
+        return buffer->elements;
+    }
+};
+
+/**
+ *  @brief  An instance of a structure.
+ */
+struct struct_object {
+
+    /**
+     *  @brief  Number of values that refer to the structure, maintained by
+     *          @c value .
+     */
+    std::size_t references = 0;
+
+    /**
+     *  @brief  The type of the structure.
+     */
+    type_index type;
+
+    /**
+     *  @brief  Number of fields, which follow the header in the same
+     *          allocation.
+     */
+    std::uint32_t size = 0;
+
+    /**
+     *  @brief  Get the fields, in the order they are declared.
+     *  @return  The fields.
+     */
+    [[nodiscard]] inline auto fields() noexcept -> std::span<value>
+    {
+        return { std::launder(reinterpret_cast<value *>(this + 1)), size };
+    }
+
+    /**
+     *  @brief  Get the fields, in the order they are declared.
+     *  @return  The fields.
+     */
+    [[nodiscard]] inline auto fields() const noexcept
+        -> std::span<const value>
+    {
+        return {
+            std::launder(reinterpret_cast<const value *>(this + 1)), size
+        };
+    }
+};
+
+static_assert(sizeof(struct_object) % alignof(value) == 0,
+    "The fields of a structure are aligned after its header");
+
+/**
+ *  @brief  Create an array on the heap.
+ *
+ *  @param  type      The type of the array.
+ *  @param  flat      Whether the elements are numbers, which copies of the
+ *                    array can share.
+ *  @param  elements  The elements.
+ *  @return  The array.
+ */
+inline auto value::make_array(
+    type_index         type,
+    bool               flat,
+    std::vector<value> elements
+) -> value
+{
+    auto buffer = new array_buffer { .elements = std::move(elements) };
+    auto heap   = new array_object {
+        .references = 1,
+        .type       = type,
+        .flat       = flat,
+        .buffer     = buffer
+    };
+
+    auto result = value {};
+    result.bits = tag<array_object> << tag_shift
+                | reinterpret_cast<std::uintptr_t>(heap);
+    return result;
+}
+
+/**
+ *  @brief  Create an array of numbers on the heap that shares the
+ *          elements of another until one of them is changed.
+ *
+ *  @param  array  The other array, which is flat.
+ *  @return  The array.
+ */
+inline auto value::make_array(const array_object &array) -> value
+{
+    array.buffer->shares++;
+    auto heap = new array_object {
+        .references = 1,
+        .type       = array.type,
+        .flat       = true,
+        .buffer     = array.buffer
+    };
+
+    auto result = value {};
+    result.bits = tag<array_object> << tag_shift
+                | reinterpret_cast<std::uintptr_t>(heap);
+    return result;
+}
+
+/**
+ *  @brief  Create a structure on the heap, with no value in its fields.
+ *
+ *  @param  type  The type of the structure.
+ *  @param  size  Number of fields.
+ *  @return  The structure.
+ */
+inline auto value::make_struct(
+    type_index    type,
+    std::uint32_t size
+) -> value
+{
+    auto memory = ::operator new(sizeof(struct_object)
+                                 + size * sizeof(value));
+    auto heap   = new (memory) struct_object {
+        .references = 1,
+        .type       = type,
+        .size       = size
+    };
+    std::uninitialized_value_construct_n(
+        reinterpret_cast<value *>(heap + 1), size);
+
+    auto result = value {};
+    result.bits = tag<struct_object> << tag_shift
+                | reinterpret_cast<std::uintptr_t>(heap);
+    return result;
+}
+
+/**
+ *  @brief  Add a reference to the object of the bits, if any.
+ *  @param  bits  The bits of a value.
+ */
+inline auto value::retain(std::uint64_t bits) noexcept -> void
+{
+    if (!is_object(bits))
+    {
+        return;
+    }
+
+    auto address = bits & payload;
+    if (bits >> tag_shift == tag<array_object>)
+    {
+        reinterpret_cast<array_object *>(address)->references++;
+    }
+    else
+    {
+        reinterpret_cast<struct_object *>(address)->references++;
+    }
+}
+
+/**
+ *  @brief  Remove a reference to the object of the bits, if any, and
+ *          delete it if it was the last one.
+ *
+ *  @param  bits  The bits of a value.
+ */
+inline auto value::release(std::uint64_t bits) noexcept -> void
+{
+    if (!is_object(bits))
+    {
+        return;
+    }
+
+    auto address = bits & payload;
+    auto last    = bits >> tag_shift == tag<array_object>
+        ? --reinterpret_cast<array_object *>(address)->references == 0
+        : --reinterpret_cast<struct_object *>(address)->references == 0;
+    if (last)
+    {
+        delete_object(bits);
+    }
+}
+
+/**
+ *  @brief  Convert @c value to string.  A nonempty array of chars is
+ *          converted to its characters, other arrays to `[a, b]` and
+ *          structures to `{a, b}`.
+ *
+ *  @param  v  The value.
+ *  @return  String representing the value.
+ */
+[[nodiscard]] auto to_string(const value &v) -> std::string;
+
+/**
+ *  @brief  Operation of an @c instruction .
+ *
+ *  Instructions operate on the registers of the function, written as
+ *  R[a], the constants K[bc] and the global variables G[bc].  Calls
+ *  pass the arguments in R[a] onwards, which become the first registers
+ *  of the called function, and the result is stored to R[a].
+ *
+ *  The opcodes ending in `_int` and `_real` are only used on operands
+ *  that are always of that type, and do not check them.
+ */
+enum class opcode : std::uint8_t {
+    /**
+     *  @brief  R[a] = R[b].
+     */
+    move,
+    /**
+     *  @brief  R[a] = copy of R[b], copying arrays and structures.
+     */
+    copy,
+    /**
+     *  @brief  R[a] = R[b], leaving no value in R[b].
+     */
+    take,
+    /**
+     *  @brief  R[a] = copy of K[bc].
+     */
+    load_constant,
+    /**
+     *  @brief  R[a] = G[bc].
+     */
+    get_global,
+    /**
+     *  @brief  G[bc] = R[a].
+     */
+    set_global,
+    /**
+     *  @brief  R[a] = field c of the structure R[b].
+     */
+    get_field,
+    /**
+     *  @brief  Field b of the structure R[a] = R[c].
+     */
+    set_field,
+    /**
+     *  @brief  R[a] = R[b][R[c]], or the subscript operator overload.
+     */
+    get_index,
+    /**
+     *  @brief  R[a][R[b]] = R[c], converted to the element type.
+     */
+    set_index,
+    /**
+     *  @brief  R[a] = array of type c with the elements R[a] to
+     *          R[a + b - 1].
+     */
+    new_array,
+    /**
+     *  @brief  R[a] = array of type c with R[b] default elements.
+     */
+    new_array_sized,
+    /**
+     *  @brief  R[a] = number of elements of the array R[b].
+     */
+    count,
+    /**
+     *  @brief  R[a] = R[c + 1], inserted to the array R[b] at R[c].
+     */
+    insert,
+    /**
+     *  @brief  R[a] = element removed from the array R[b] at R[c].
+     */
+    remove,
+    /**
+     *  @brief  R[a] = R[b] converted to type c.
+     */
+    convert,
+    /**
+     *  @brief  R[a] = R[b] + R[c].  Concatenates arrays.
+     */
+    add,
+    /**
+     *  @brief  R[a] = R[b] - R[c].
+     */
+    subtract,
+    /**
+     *  @brief  R[a] = R[b] * R[c].
+     */
+    multiply,
+    /**
+     *  @brief  R[a] = R[b] / R[c], always `real`.
+     */
+    divide,
+    /**
+     *  @brief  R[a] = floor(R[b] / R[c]).
+     */
+    floor_divide,
+    /**
+     *  @brief  R[a] = R[b] - R[c] * floor(R[b] / R[c]).
+     */
+    modulo,
+    /**
+     *  @brief  R[a] = R[b] ** R[c], always `real`.
+     */
+    power,
+    /**
+     *  @brief  R[a] = R[b] << R[c].
+     */
+    shift_left,
+    /**
+     *  @brief  R[a] = R[b] >> R[c].
+     */
+    shift_right,
+    /**
+     *  @brief  R[a] = R[b] & R[c].
+     */
+    bitwise_and,
+    /**
+     *  @brief  R[a] = R[b] ^ R[c].
+     */
+    bitwise_xor,
+    /**
+     *  @brief  R[a] = R[b] | R[c].
+     */
+    bitwise_or,
+    /**
+     *  @brief  R[a] = R[b] < R[c].
+     */
+    less,
+    /**
+     *  @brief  R[a] = R[b] <= R[c].
+     */
+    less_equal,
+    /**
+     *  @brief  R[a] = R[b] > R[c].
+     */
+    greater,
+    /**
+     *  @brief  R[a] = R[b] >= R[c].
+     */
+    greater_equal,
+    /**
+     *  @brief  R[a] = R[b] == R[c].
+     */
+    equal,
+    /**
+     *  @brief  R[a] = R[b] != R[c].
+     */
+    not_equal,
+    /**
+     *  @brief  R[a] = -R[b].
+     */
+    negate,
+    /**
+     *  @brief  R[a] = !R[b].
+     */
+    logical_not,
+    /**
+     *  @brief  R[a] = ~R[b].
+     */
+    bitwise_not,
+    /**
+     *  @brief  R[a] = R[b] converted from `int` to `real`.
+     */
+    int_to_real,
+    /**
+     *  @brief  R[a] = R[b] converted from `real` to `int`, floored and
+     *          saturated.
+     */
+    real_to_int,
+    /**
+     *  @brief  R[a] = R[b] + R[c], wrapped.
+     */
+    add_int,
+    /**
+     *  @brief  R[a] = R[b] + R[c].
+     */
+    add_real,
+    /**
+     *  @brief  R[a] = R[b] - R[c], wrapped.
+     */
+    subtract_int,
+    /**
+     *  @brief  R[a] = R[b] - R[c].
+     */
+    subtract_real,
+    /**
+     *  @brief  R[a] = R[b] * R[c], wrapped.
+     */
+    multiply_int,
+    /**
+     *  @brief  R[a] = R[b] * R[c].
+     */
+    multiply_real,
+    /**
+     *  @brief  R[a] = R[b] / R[c] as `real`.
+     */
+    divide_int,
+    /**
+     *  @brief  R[a] = R[b] / R[c].
+     */
+    divide_real,
+    /**
+     *  @brief  R[a] = floor(R[b] / R[c]), failing if R[c] is 0.
+     */
+    floor_divide_int,
+    /**
+     *  @brief  R[a] = floor(R[b] / R[c]).
+     */
+    floor_divide_real,
+    /**
+     *  @brief  R[a] = R[b] - R[c] * floor(R[b] / R[c]), failing if R[c]
+     *          is 0.
+     */
+    modulo_int,
+    /**
+     *  @brief  R[a] = R[b] - R[c] * floor(R[b] / R[c]).
+     */
+    modulo_real,
+    /**
+     *  @brief  R[a] = R[b] < R[c].
+     */
+    less_int,
+    /**
+     *  @brief  R[a] = R[b] < R[c].
+     */
+    less_real,
+    /**
+     *  @brief  R[a] = R[b] <= R[c].
+     */
+    less_equal_int,
+    /**
+     *  @brief  R[a] = R[b] <= R[c].
+     */
+    less_equal_real,
+    /**
+     *  @brief  R[a] = R[b] == R[c].
+     */
+    equal_int,
+    /**
+     *  @brief  R[a] = R[b] == R[c].
+     */
+    equal_real,
+    /**
+     *  @brief  R[a] = R[b] != R[c].
+     */
+    not_equal_int,
+    /**
+     *  @brief  R[a] = R[b] != R[c].
+     */
+    not_equal_real,
+    /**
+     *  @brief  R[a] = -R[b], wrapped.
+     */
+    negate_int,
+    /**
+     *  @brief  R[a] = -R[b].
+     */
+    negate_real,
+    /**
+     *  @brief  Continue from bc.
+     */
+    jump,
+    /**
+     *  @brief  Continue from bc if R[a] is false.
+     */
+    jump_if_false,
+    /**
+     *  @brief  Continue from bc if R[a] is true.
+     */
+    jump_if_true,
+    /**
+     *  @brief  Call the function c with b arguments.
+     */
+    call,
+    /**
+     *  @brief  Call the @c builtin_function c with b arguments.
+     */
+    call_builtin,
+    /**
+     *  @brief  Call the overload of the custom operator
+     *          @c program::operator_symbols [c] in the @c operator_form b.
+     */
+    call_operator,
+    /**
+     *  @brief  R[a] = new structure of the constructor c, which is called
+     *          with the structure and b arguments from R[a + 1].
+     */
+    construct,
+    /**
+     *  @brief  Call the destructors of R[a], its fields and elements.
+     */
+    destroy,
+    /**
+     *  @brief  Return R[a].
+     */
+    return_,
+    /**
+     *  @brief  Return nothing.
+     */
+    return_void,
+    /**
+     *  @brief  Number of opcodes.
+     */
+    max
+};
+
+/**
+ *  @brief  Convert @c opcode to string.
+ *
+ *  @param  op  The opcode.
+ *  @return  String representing @c opcode enumeration.
+ */
+[[nodiscard]] inline constexpr auto to_string(opcode op)
+{
+    using namespace std::string_literals;
+
+    switch (op)
+    {
+    using enum opcode;
+        case move: return "move"s;
+        case copy: return "copy"s;
+        case take: return "take"s;
+        case load_constant: return "load_constant"s;
+        case get_global: return "get_global"s;
+        case set_global: return "set_global"s;
+        case get_field: return "get_field"s;
+        case set_field: return "set_field"s;
+        case get_index: return "get_index"s;
+        case set_index: return "set_index"s;
+        case new_array: return "new_array"s;
+        case new_array_sized: return "new_array_sized"s;
+        case count: return "count"s;
+        case insert: return "insert"s;
+        case remove: return "remove"s;
+        case convert: return "convert"s;
+        case add: return "add"s;
+        case subtract: return "subtract"s;
+        case multiply: return "multiply"s;
+        case divide: return "divide"s;
+        case floor_divide: return "floor_divide"s;
+        case modulo: return "modulo"s;
+        case power: return "power"s;
+        case shift_left: return "shift_left"s;
+        case shift_right: return "shift_right"s;
+        case bitwise_and: return "bitwise_and"s;
+        case bitwise_xor: return "bitwise_xor"s;
+        case bitwise_or: return "bitwise_or"s;
+        case less: return "less"s;
+        case less_equal: return "less_equal"s;
+        case greater: return "greater"s;
+        case greater_equal: return "greater_equal"s;
+        case equal: return "equal"s;
+        case not_equal: return "not_equal"s;
+        case negate: return "negate"s;
+        case logical_not: return "logical_not"s;
+        case bitwise_not: return "bitwise_not"s;
+        case int_to_real: return "int_to_real"s;
+        case real_to_int: return "real_to_int"s;
+        case add_int: return "add_int"s;
+        case add_real: return "add_real"s;
+        case subtract_int: return "subtract_int"s;
+        case subtract_real: return "subtract_real"s;
+        case multiply_int: return "multiply_int"s;
+        case multiply_real: return "multiply_real"s;
+        case divide_int: return "divide_int"s;
+        case divide_real: return "divide_real"s;
+        case floor_divide_int: return "floor_divide_int"s;
+        case floor_divide_real: return "floor_divide_real"s;
+        case modulo_int: return "modulo_int"s;
+        case modulo_real: return "modulo_real"s;
+        case less_int: return "less_int"s;
+        case less_real: return "less_real"s;
+        case less_equal_int: return "less_equal_int"s;
+        case less_equal_real: return "less_equal_real"s;
+        case equal_int: return "equal_int"s;
+        case equal_real: return "equal_real"s;
+        case not_equal_int: return "not_equal_int"s;
+        case not_equal_real: return "not_equal_real"s;
+        case negate_int: return "negate_int"s;
+        case negate_real: return "negate_real"s;
+        case jump: return "jump"s;
+        case jump_if_false: return "jump_if_false"s;
+        case jump_if_true: return "jump_if_true"s;
+        case call: return "call"s;
+        case call_builtin: return "call_builtin"s;
+        case call_operator: return "call_operator"s;
+        case construct: return "construct"s;
+        case destroy: return "destroy"s;
+        case return_: return "return_"s;
+        case return_void: return "return_void"s;
+        case max: break;
+    }
+    return ""s;
+}
+
+/**
+ *  @brief  Functions that every program can call.
+ */
+enum class builtin_function : std::uint8_t {
+    /**
+     *  @brief  `sqrt(x)`.
+     */
+    sqrt,
+    /**
+     *  @brief  `cbrt(x)`.
+     */
+    cbrt,
+    /**
+     *  @brief  `exp(x)`.
+     */
+    exp,
+    /**
+     *  @brief  `log(x)` for the natural logarithm, `log(x, base)`
+     *          otherwise.
+     */
+    log,
+    /**
+     *  @brief  `sin(x)`.
+     */
+    sin,
+    /**
+     *  @brief  `cos(x)`.
+     */
+    cos,
+    /**
+     *  @brief  `tan(x)`.
+     */
+    tan,
+    /**
+     *  @brief  `asin(x)`.
+     */
+    asin,
+    /**
+     *  @brief  `acos(x)`.
+     */
+    acos,
+    /**
+     *  @brief  `atan(x)`.
+     */
+    atan,
+    /**
+     *  @brief  `atan2(y, x)`.
+     */
+    atan2,
+    /**
+     *  @brief  `abs(x)`.
+     */
+    abs,
+    /**
+     *  @brief  `floor(x)`.
+     */
+    floor,
+    /**
+     *  @brief  `ceil(x)`.
+     */
+    ceil,
+    /**
+     *  @brief  `round(x)`.
+     */
+    round,
+    /**
+     *  @brief  `pow(x, y)`.
+     */
+    pow,
+    /**
+     *  @brief  `min(x, y)`.
+     */
+    min,
+    /**
+     *  @brief  `max(x, y)`.
+     */
+    max_,
+    /**
+     *  @brief  Number of builtin functions.
+     */
+    max
+};
+
+/**
+ *  @brief  Convert @c builtin_function to string.
+ *
+ *  @param  function  The builtin function.
+ *  @return  The name of the builtin function in the language.
+ */
+[[nodiscard]] inline constexpr auto to_string(builtin_function function)
+{
+    using namespace std::string_literals;
+
+    switch (function)
+    {
+    using enum builtin_function;
+        case sqrt: return "sqrt"s;
+        case cbrt: return "cbrt"s;
+        case exp: return "exp"s;
+        case log: return "log"s;
+        case sin: return "sin"s;
+        case cos: return "cos"s;
+        case tan: return "tan"s;
+        case asin: return "asin"s;
+        case acos: return "acos"s;
+        case atan: return "atan"s;
+        case atan2: return "atan2"s;
+        case abs: return "abs"s;
+        case floor: return "floor"s;
+        case ceil: return "ceil"s;
+        case round: return "round"s;
+        case pow: return "pow"s;
+        case min: return "min"s;
+        case max_: return "max"s;
+        case max: break;
+    }
+    return ""s;
+}
+
+/**
+ *  @brief  Apply a regular operator to numbers, the way the program
+ *          does when it runs.  Integers stay integers except for `/`
+ *          and `**`, and wrap around.
+ *
+ *  @param  op   The opcode, from @c opcode::add to
+ *               @c opcode::bitwise_not .
+ *  @param  lhs  The operand, or the left operand.
+ *  @param  rhs  The right operand, unused by prefix operators.
+ *  @return  The result, or nothing if an operand is not a number or on
+ *           integer division by zero.
+ */
+[[nodiscard]] auto apply_operator(
+    opcode       op,
+    const value &lhs,
+    const value &rhs = {}
+) -> std::optional<value>;
+
+/**
+ *  @brief  Convert a number to a scalar type.  Reals are floored and
+ *          saturated when converted to `int`, and integers are clamped
+ *          when converted to `char`.
+ *
+ *  @param  v     The number.
+ *  @param  type  `real`, `int`, `bool` or `char`.
+ *  @return  The converted number, or nothing if @p v is not a number or
+ *           @p type is not a scalar type.
+ */
+[[nodiscard]] auto convert_number(const value &v, type_index type)
+-> std::optional<value>;
+
+/**
+ *  @brief  Evaluate a builtin function.
+ *
+ *  @param  function  The builtin function.
+ *  @param  args      The arguments.
+ *  @return  The result.
+ */
+[[nodiscard]] auto apply_builtin(
+    builtin_function        function,
+    std::span<const double> args
+) -> double;
+
+/**
+ *  @brief  Computes a builtin function for rows of arguments,
+ *          `result[i] = f(x[i], y[i])` .  @p y is @c nullptr when the
+ *          function is called with one argument.  @p result may be one
+ *          of the arguments.
+ */
+using builtin_kernel = void (*)(
+    double       *result,
+    const double *x,
+    const double *y,
+    std::size_t   count
+);
+
+/**
+ *  @brief  Implementations of a builtin function.
+ */
+struct builtin_info {
+
+    /**
+     *  @brief  Minimum number of arguments.
+     */
+    std::uint8_t least = 1;
+
+    /**
+     *  @brief  Maximum number of arguments.
+     */
+    std::uint8_t most = 1;
+
+    /**
+     *  @brief  Computes each row with the standard library, which is what
+     *          the program uses when it runs.
+     */
+    builtin_kernel scalar = nullptr;
+
+    /**
+     *  @brief  Computes the rows with the SIMD instructions that the CPU
+     *          supports, or is @c scalar if there are none for the
+     *          function.  Used by @c batch_function .
+     */
+    builtin_kernel lanes = nullptr;
+
+    /**
+     *  @brief  Maximum difference of the results of @c lanes from the
+     *          results of @c scalar , in units in the last place.
+     */
+    double ulps = 0.0;
+};
+
+/**
+ *  @brief  Get the implementations of the builtin functions.
+ *  @return  The implementations indexed by @c builtin_function , whose
+ *           lanes are selected once at runtime.
+ */
+[[nodiscard]] auto builtins() -> std::span<const builtin_info>;
+
+/**
+ *  @brief  A bytecode instruction.  The meaning of the operands depends
+ *          on the @c opcode .
+ */
+struct instruction {
+
+    /**
+     *  @brief  The operation.
+     */
+    opcode op = opcode::max;
+
+    /**
+     *  @brief  First operand, usually the destination register.
+     */
+    std::uint16_t a = 0;
+
+    /**
+     *  @brief  Second operand.
+     */
+    std::uint16_t b = 0;
+
+    /**
+     *  @brief  Third operand.
+     */
+    std::uint16_t c = 0;
+
+    /**
+     *  @brief  Get b and c as one 32-bit operand.
+     *  @return  The 32-bit operand.
+     */
+    [[nodiscard]] inline constexpr auto bc() const -> std::uint32_t
+    {
+        return b | static_cast<std::uint32_t>(c) << 16;
+    }
+
+    /**
+     *  @brief  Set b and c as one 32-bit operand.
+     *  @param  operand  The 32-bit operand.
+     */
+    inline constexpr auto set_bc(std::uint32_t operand)
+    {
+        b = static_cast<std::uint16_t>(operand);
+        c = static_cast<std::uint16_t>(operand >> 16);
+    }
+};
+
+static_assert(sizeof(instruction) == 8, "Instructions must stay compact");
+
+/**
+ *  @brief  A compiled function, method, constructor, destructor or
+ *          operator overload.
+ */
+struct function_info {
+
+    /**
+     *  @brief  Symbol ID of the name or the operator.
+     */
+    std::uint32_t symbol = 0;
+
+    /**
+     *  @brief  The structure of the method, constructor or destructor,
+     *          as index to @c program::structs , or @c no_function .
+     */
+    std::uint32_t owner = no_function;
+
+    /**
+     *  @brief  The instructions.
+     */
+    std::vector<instruction> code = {};
+
+    /**
+     *  @brief  Index of the token of each instruction in
+     *          @c detronade::tokens , to locate runtime errors.
+     */
+    std::vector<std::uint32_t> tokens = {};
+
+    /**
+     *  @brief  Types of the parameters, beginning with the structure for
+     *          methods, constructors and destructors.
+     */
+    std::vector<type_index> parameters = {};
+
+    /**
+     *  @brief  The return type.
+     */
+    type_index return_type = void_type;
+
+    /**
+     *  @brief  Number of registers used by the function.
+     */
+    std::uint16_t registers = 0;
+};
+
+/**
+ *  @brief  A compiled structure.
+ */
+struct struct_info {
+
+    /**
+     *  @brief  Symbol ID of the name.
+     */
+    std::uint32_t symbol = 0;
+
+    /**
+     *  @brief  The type of the structure.
+     */
+    type_index type = unknown_type;
+
+    /**
+     *  @brief  Symbol IDs of the fields.
+     */
+    std::vector<std::uint32_t> field_symbols = {};
+
+    /**
+     *  @brief  Types of the fields.
+     */
+    std::vector<type_index> field_types = {};
+
+    /**
+     *  @brief  The function that sets the fields to their initial values
+     *          before a constructor is called.
+     */
+    std::uint32_t initializer = no_function;
+
+    /**
+     *  @brief  The constructor without parameters, or @c no_function .
+     */
+    std::uint32_t default_constructor = no_function;
+
+    /**
+     *  @brief  The destructor, or @c no_function .
+     */
+    std::uint32_t destructor = no_function;
+
+    /**
+     *  @brief  Whether the structure, its fields or their elements have a
+     *          destructor.
+     */
+    bool needs_destroy = false;
+};
+
+/**
+ *  @brief  An operator overload.
+ */
+struct overload {
+
+    /**
+     *  @brief  The operator.
+     */
+    operator_kind op = operator_kind::unknown;
+
+    /**
+     *  @brief  Where the operator is written.
+     */
+    operator_form form = operator_form::unknown;
+
+    /**
+     *  @brief  Symbol ID of a custom operator.
+     */
+    std::uint32_t symbol = 0;
+
+    /**
+     *  @brief  Types of the operands.
+     */
+    std::array<type_index, 2> operands = { unknown_type, unknown_type };
+
+    /**
+     *  @brief  The function of the overload.
+     */
+    std::uint32_t function = no_function;
+};
+
+/**
+ *  @brief  Key of an operator overload: the operator, where it is written,
+ *          symbol ID of a custom operator and types of the operands.
+ */
+using overload_key = std::tuple<
+    operator_kind,
+    operator_form,
+    std::uint32_t,
+    type_index,
+    type_index
+>;
+
+/**
+ *  @brief  Get the key of an operator overload.  The symbol ID is only
+ *          part of the key of custom operators.
+ *
+ *  @param  op        The operator.
+ *  @param  form      Where the operator is written.
+ *  @param  symbol    Symbol ID of a custom operator.
+ *  @param  operands  Types of the operands, @c unknown_type for the right
+ *                    operand of a prefix or postfix operator.
+ *  @return  The key.
+ */
+[[nodiscard]] inline constexpr auto make_overload_key(
+    operator_kind                    op,
+    operator_form                    form,
+    std::uint32_t                    symbol,
+    const std::array<type_index, 2> &operands
+) -> overload_key
+{
+    if (op != operator_kind::custom)
+    {
+        symbol = 0;
+    }
+    return { op, form, symbol, operands[0], operands[1] };
+}
+
+/**
+ *  @brief  A compiled program, ready to be run.
+ */
+struct program {
+
+    /**
+     *  @brief  The functions.
+     */
+    std::vector<function_info> functions;
+
+    /**
+     *  @brief  The structures.
+     */
+    std::vector<struct_info> structs;
+
+    /**
+     *  @brief  The types, beginning with the builtin types from
+     *          @c unknown_type to @c char_type .
+     */
+    std::vector<type_info> types;
+
+    /**
+     *  @brief  The constants.
+     */
+    std::vector<value> constants;
+
+    /**
+     *  @brief  The operator overloads.
+     */
+    std::vector<overload> overloads;
+
+    /**
+     *  @brief  Symbol IDs of the custom operators used by
+     *          @c opcode::call_operator .
+     */
+    std::vector<std::uint32_t> operator_symbols;
+
+    /**
+     *  @brief  Index in @c overloads of the first overload declared for
+     *          each key, to find an overload without searching.
+     */
+    std::map<overload_key, std::uint32_t> overload_table;
+
+    /**
+     *  @brief  Number of global variables.
+     */
+    std::uint32_t globals = 0;
+
+    /**
+     *  @brief  The function of the statements in global scope.
+     */
+    std::uint32_t main = no_function;
+};
+
+/**
+ *  @brief  Find the operator overload that accepts operands of some
+ *          types, the way the program does when it runs.  An overload
+ *          that takes exactly the types is preferred, otherwise the first
+ *          overload declared that accepts the numbers converted.
+ *
+ *  @param  prog      The program.
+ *  @param  op        The operator.
+ *  @param  form      Where the operator is written.
+ *  @param  symbol    Symbol ID of a custom operator.
+ *  @param  operands  Types of the operands.
+ *  @return  The overload, or @c nullptr if none accepts the operands.
+ */
+[[nodiscard]] auto match_overload(
+    const program              &prog,
+    operator_kind               op,
+    operator_form               form,
+    std::uint32_t               symbol,
+    std::span<const type_index> operands
+) -> const overload *;
+
+/**
+ *  @brief  Copy the program with constants of its own.  The reference
+ *          counts of values are not atomic, so programs that run on
+ *          different threads must not share their constants.
+ *
+ *  @param  prog  The program, whose constants are only read, so it can
+ *                run on another thread meanwhile.
+ *  @return  The copy.
+ */
+[[nodiscard]] auto copy_program(const program &prog)
+-> std::shared_ptr<const program>;
+
+/**
+ *  @brief  Options for compiling the source code.
+ */
+struct compile_options {
+
+    /**
+     *  @brief  Number of threads used to tokenize, or 0 to use every
+     *          hardware thread.
+     */
+    std::size_t threads = 1;
+
+    /**
+     *  @brief  Approximate size of the source code that a thread tokenizes
+     *          at once.  Chunks end at newlines.
+     */
+    std::size_t chunk_size = 4 * 1024 * 1024;
+
+    /**
+     *  @brief  Keep tokenizing after a lexical error to report every error
+     *          in one pass.  The tokens are not used when an error occurs.
+     */
+    bool recover_errors = false;
+
+    /**
+     *  @brief  Stop tokenizing after this many errors when recovering from
+     *          errors.
+     */
+    std::size_t max_errors = 100;
+
+    /**
+     *  @brief  Maximum depth of function calls when running the program.
+     */
+    std::size_t max_call_depth = 1000;
+
+    /**
+     *  @brief  Evaluate the loop-invariant expressions once before their
+     *          loop, and the expressions written more than once in a block
+     *          once.  Turning it off is for measuring what it saves.
+     */
+    bool hoist_expressions = true;
+
+    /**
+     *  @brief  Reuse the compilation of the same source code and
+     *          @c codegen_key from @c compile_cache::global , and keep a
+     *          successful compilation there.  Only used when the symbol
+     *          table is empty, before the first compilation, so that symbol
+     *          IDs remain the same.
+     */
+    bool cache = false;
+
+    /**
+     *  @brief  Get the options that change the compiled program, which
+     *          tell apart the compilations of a source code in
+     *          @c compile_cache .
+     *  @return  One bit for each option that changes the program.
+     *  @note  Every option that changes the program must be added here.
+     */
+    [[nodiscard]] inline constexpr auto codegen_key() const -> std::uint32_t
+    {
+        return hoist_expressions ? 1u : 0u;
+    }
+};
+
+/**
+ *  @brief  A function of numbers compiled to be evaluated for many rows at
+ *          once, one column of numbers per parameter.  Each instruction is
+ *          applied to a block of rows before the next one, with SIMD
+ *          kernels where the CPU supports them.
+ *  @note  Created by @c detronade::compile_batch .
+ */
+struct batch_function {
+
+    /**
+     *  @brief  The instructions, which only compute numbers and do not
+     *          branch.  @c opcode::load_constant loads from @c constants .
+     */
+    std::vector<instruction> code = {};
+
+    /**
+     *  @brief  The constants as reals.
+     */
+    std::vector<double> constants = {};
+
+    /**
+     *  @brief  Types of the parameters, `real` or `int`.
+     */
+    std::vector<type_index> parameters = {};
+
+    /**
+     *  @brief  Number of registers used by the function.
+     */
+    std::uint16_t registers = 0;
+
+    /**
+     *  @brief  Evaluate the function for every row.
+     *
+     *  @param  columns  One column per parameter, each with at least as
+     *                   many numbers as @p results .  Columns of `int`
+     *                   parameters are floored and saturated.
+     *  @param  results  Receives the result of each row.
+     *  @return  False if the number of columns does not match the
+     *           parameters or a column is too short.
+     */
+    [[nodiscard]] auto evaluate(
+        std::span<const std::span<const double>> columns,
+        std::span<double>                        results
+    ) const -> bool;
+};
+
+/**
+ *  @brief  Everything that a successful compilation produces from the
+ *          source code, kept by @c compile_cache to be reused.
+ */
+struct compiled_source {
+
+    /**
+     *  @brief  The source code, to tell apart sources of the same hash.
+     */
+    std::string source_code;
+
+    /**
+     *  @brief  The options that the program was compiled with, from
+     *          @c compile_options::codegen_key .
+     */
+    std::uint32_t codegen_key = 0;
+
+    /**
+     *  @brief  Messages of the compilation, which are only notes and
+     *          warnings.
+     */
+    std::vector<message> messages;
+
+    /**
+     *  @brief  Number of the messages that were reported by the lexer.
+     */
+    std::size_t lexed_messages = 0;
+
+    /**
+     *  @brief  Parsed tokens.
+     */
+    std::vector<token> tokens;
+
+    /**
+     *  @brief  Values of string literals that contain escape sequences.
+     */
+    std::vector<std::string> decoded_strings;
+
+    /**
+     *  @brief  Values of numerical literals.
+     */
+    std::vector<number> numbers;
+
+    /**
+     *  @brief  Parsed syntax tree.
+     */
+    syntax_tree tree;
+
+    /**
+     *  @brief  The compiled program, which never runs.
+     */
+    std::shared_ptr<const program> bytecode;
+
+    /**
+     *  @brief  Interned identifiers and operators, beginning from an empty
+     *          table.
+     */
+    symbol_table symbols;
+
+    /**
+     *  @brief  Offsets where each line in the source code begins.
+     */
+    std::vector<std::size_t> line_starts;
+};
+
+/**
+ *  @brief  Number of lookups and size of @c compile_cache at one moment.
+ */
+struct compile_cache_statistics {
+
+    /**
+     *  @brief  Number of compilations found in the cache.
+     */
+    std::size_t hits = 0;
+
+    /**
+     *  @brief  Number of compilations not found in the cache.
+     */
+    std::size_t misses = 0;
+
+    /**
+     *  @brief  Number of compilations in the cache.
+     */
+    std::size_t entries = 0;
+
+    /**
+     *  @brief  Approximate number of bytes used by the compilations in the
+     *          cache.
+     */
+    std::size_t size = 0;
+
+    /**
+     *  @brief  Maximum of @c size .
+     */
+    std::size_t budget = 0;
+};
+
+/**
+ *  @brief  Compilations by the hash of their source code and the options
+ *          that change their program, of which the least recently used are
+ *          evicted to stay within a budget of bytes.
+ *
+ *  Only @c compile_options::codegen_key is part of the key, since a
+ *  successful compilation does not depend on the other options:
+ *  @c compile_options::threads and @c compile_options::chunk_size only
+ *  split the work, the options of errors only change what a failed
+ *  compilation reports, and @c compile_options::max_call_depth is read
+ *  when the program runs.
+ *
+ *  The cache can be used from many threads.  Its programs never run, and
+ *  each compilation found gets a copy from @c copy_program , so unrelated
+ *  instances of the same source code can run on different threads.
+ */
+struct compile_cache {
+
+    /**
+     *  @brief  Default budget, in bytes.
+     */
+    static inline constexpr std::size_t default_budget = 64 * 1024 * 1024;
+
+    /**
+     *  @brief  Guards every other member.
+     */
+    mutable std::mutex mutex;
+
+    /**
+     *  @brief  The compilations with their hash and size, the most recently
+     *          used first.
+     */
+    std::list<std::tuple<
+        std::size_t,
+        std::size_t,
+        std::shared_ptr<const compiled_source>
+    >> recent;
+
+    /**
+     *  @brief  Positions in @c recent by the hash of the source code and
+     *          the options.
+     */
+    std::unordered_map<std::size_t, decltype(recent)::iterator> entries;
+
+    /**
+     *  @brief  Approximate number of bytes used by the compilations.
+     */
+    std::size_t size = 0;
+
+    /**
+     *  @brief  Maximum of @c size .
+     */
+    std::size_t budget = default_budget;
+
+    /**
+     *  @brief  Number of compilations found.
+     */
+    std::size_t hits = 0;
+
+    /**
+     *  @brief  Number of compilations not found.
+     */
+    std::size_t misses = 0;
+
+    /**
+     *  @brief  Get the cache shared by the whole process, which
+     *          @c detronade::compile uses when @c compile_options::cache is
+     *          set.
+     *  @return  The cache.
+     */
+    [[nodiscard]] static auto global() -> compile_cache &;
+
+    /**
+     *  @brief  Find the compilation of the source code, and count a hit or
+     *          a miss.
+     *
+     *  @param  source       The source code.
+     *  @param  codegen_key  The options, from
+     *                       @c compile_options::codegen_key .
+     *  @return  The compilation, or @c nullptr if it is not in the cache.
+     */
+    [[nodiscard]] auto find(
+        std::string_view source,
+        std::uint32_t    codegen_key
+    ) -> std::shared_ptr<const compiled_source>;
+
+    /**
+     *  @brief  Keep the compilation, replacing one of the same hash and
+     *          evicting the least recently used ones beyond the budget.  A
+     *          compilation larger than the budget is not kept.
+     *
+     *  @param  compiled  The compilation.
+     */
+    auto insert(std::shared_ptr<const compiled_source> compiled) -> void;
+
+    /**
+     *  @brief  Change the budget, evicting the least recently used
+     *          compilations beyond it.
+     *
+     *  @param  bytes  The budget, in bytes.
+     */
+    auto set_budget(std::size_t bytes) -> void;
+
+    /**
+     *  @brief  Evict every compilation and reset the counters.
+     */
+    auto clear() -> void;
+
+    /**
+     *  @brief  Get the counters and the size.
+     *  @return  The statistics.
+     */
+    [[nodiscard]] auto statistics() const -> compile_cache_statistics;
+};
+
+/**
+ *  @brief  Contains every information regarding the source code.
+ */
+struct detronade {
+
+    /**
+     *  @brief  Name of the source code, which can be a filename.
+     */
+    std::string name;
+
+    /**
+     *  @brief  The entire source code.
+     *  @note  Empty when the source code is memory mapped, use @c source .
+     */
+    std::string source_code;
+
+    /**
+     *  @brief  The memory mapped source code, shared between copies.  When
+     *          set, it is used instead of @c source_code .
+     */
+    std::shared_ptr<const mapped_file> mapped_source;
+
+    /**
+     *  @brief  Options for compiling the source code.
+     */
+    compile_options options;
+
+    /**
+     *  @brief  All the messages regarding the source code.
+     */
+    std::vector<message> messages;
+
+    /**
+     *  @brief  Strings referred to by the arguments of the messages.
+     */
+    std::vector<std::string> message_strings;
+
+    /**
+     *  @brief  Parsed tokens.
+     *  @note  Use @c offset to get where the tokens begin, since @c edit
+     *         may have moved them.
+     */
+    std::vector<token> tokens;
+
+    /**
+     *  @brief  Index of the first token that @c edit moved without updating
+     *          its @c token::begin .
+     */
+    std::size_t moved_tokens = {};
+
+    /**
+     *  @brief  How far the tokens from @c moved_tokens on were moved.
+     */
+    std::ptrdiff_t token_shift = {};
+
+    /**
+     *  @brief  Values of string literals that contain escape sequences.
+     */
+    std::vector<std::string> decoded_strings;
+
+    /**
+     *  @brief  Values of numerical literals.
+     */
+    std::vector<number> numbers;
+
+    /**
+     *  @brief  Slots of @c decoded_strings that no token refers to after an
+     *          edit, reused by the next edits.
+     */
+    std::vector<std::uint32_t> free_strings;
+
+    /**
+     *  @brief  Slots of @c numbers that no token refers to after an edit,
+     *          reused by the next edits.
+     */
+    std::vector<std::uint32_t> free_numbers;
+
+    /**
+     *  @brief  Parsed syntax tree.
+     */
+    syntax_tree tree;
+
+    /**
+     *  @brief  The compiled program, shared between copies.
+     */
+    std::shared_ptr<const program> bytecode;
+
+    /**
+     *  @brief  Interned identifiers and operators.  This is kept across
+     *          compilations so that symbol IDs remain the same.
+     */
+    symbol_table symbols;
+
+    /**
+     *  @brief  Number of lines in the source code.
+     */
+    std::size_t num_lines = 0;
+
+    /**
+     *  @brief  Offsets where each line in the source code begins.
+     *  @note  Those from @c moved_lines on are @c line_shift away from
+     *         where the lines begin.
+     */
+    std::vector<std::size_t> line_starts;
+
+    /**
+     *  @brief  Index of the first line that @c edit moved without updating
+     *          its offset in @c line_starts .
+     */
+    std::size_t moved_lines = {};
+
+    /**
+     *  @brief  How far the lines from @c moved_lines on were moved.
+     */
+    std::ptrdiff_t line_shift = {};
+
+    /**
+     *  @brief  This is set to true when the last compilation is successful.
+     */
+    bool compilation_successful = false;
+
+    /**
+     *  @brief  Set when @c edit changed the tokens without parsing and
+     *          compiling them again, which is left to @c rebuild .
+     */
+    bool stale = false;
+
+    /**
+     *  @brief  Set when the tokens, their literals, the line index and the
+     *          messages of the lexer match the source code, even with
+     *          lexical errors, so that @c edit can patch them.
+     */
+    bool tokens_valid = false;
+
+    /**
+     *  @brief  Number of the messages from the beginning that were reported
+     *          by the lexer, which @c edit patches.  The messages after them
+     *          were reported by the parser and the compiler.
+     */
+    std::size_t lexed_messages = 0;
+
+    /**
+     *  @brief  Default constructor.
+     */
+    inline constexpr detronade() = default;
+
+    /**
+     *  @brief  Creates the source from name and content.
+     *
+     *  @param  name         The name of the source, can be a filename.
+     *  @param  source_code  The source code.
+     */
+    inline constexpr detronade(
+        std::string_view name,
+        std::string_view source_code
+    ) : name(name), source_code(source_code) {}
+
+    /**
+     *  @brief  Creates the source from filename and reads contents.
+     *  @param  filename  The filename for the source name.
+     */
+    inline constexpr detronade(std::string_view filename)
+        : name(filename)
+    {
+        load_file(filename);
+    }
+
+    /**
+     *  @brief  Loads file contents into @c source_code .
+     *
+     *  @param  filename  The file to load.
+     *  @return  True if successfully loaded.
+     *  @note  Does not set the source name to the filename.
+     */
+    inline constexpr auto load_file(
+        std::string_view filename
+    ) -> bool
+    {
+        try
+        {
+            source_code = alce::file::read_all(filename);
+            mapped_source.reset();
+        }
+        catch (const std::exception &e)
+        {
+            auto index = static_cast<std::uint32_t>(message_strings.size());
+            message_strings.emplace_back(filename);
+            messages.emplace_back(message {
+                .id       = message_id::unable_to_open_file,
+                .severity = message_severity::error,
+                .args     = { index }
+            });
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     *  @brief  Memory maps the file as the source code, without copying it.
+     *
+     *  @param  filename  The file to map.
+     *  @return  True if successfully mapped or loaded.
+     *  @note  Does not set the source name to the filename.
+     *  @note  Falls back to @c load_file if the file cannot be mapped.
+     */
+    inline constexpr auto map_file(
+        std::string_view filename
+    ) -> bool
+    {
+        auto mapping = std::make_shared<mapped_file>();
+        if (!mapping->map(filename))
+        {
+            return load_file(filename);
+        }
+
+        mapped_source = std::move(mapping);
+        source_code.clear();
+        source_code.shrink_to_fit();
+        return true;
+    }
+
+    /**
+     *  @brief  Get the source code, whether it is owned or memory mapped.
+     *  @return  View to the source code, which is always followed by `\0`.
+     */
+    [[nodiscard]] inline constexpr auto source() const -> std::string_view
+    {
+        if (mapped_source)
+        {
+            return mapped_source->view();
+        }
+        return source_code;
+    }
+
+    /**
+     *  @brief  Tokenize the source.
+     *  @return  Individual tokens of the source.
+     *  @note  Tokens can be pulled on demand instead using
+     *         @c token_cursor .
+     */
+    [[nodiscard]] auto tokenize() -> std::optional<std::vector<token>>;
+
+    /**
+     *  @brief  Parse the tokens into the syntax tree.
+     *  @return  The syntax tree of the tokens.
+     */
+    [[nodiscard]] auto parse() -> std::optional<syntax_tree>;
+
+    /**
+     *  @brief  Compile the syntax tree into bytecode.
+     *  @return  The compiled program.
+     */
+    [[nodiscard]] auto generate() -> std::optional<program>;
+
+    /**
+     *  @brief  Run the compiled program.
+     *  @return  The result of the uncaptured expression that ended the
+     *           program, @c std::monostate if there was none, or
+     *           @c std::nullopt if a runtime error occurred.
+     *  @note  Requires a successful compilation.  The program is rebuilt
+     *         first if @c edit left it @c stale .
+     */
+    [[nodiscard]] auto run() -> std::optional<value>;
+
+    /**
+     *  @brief  Compile a function to be evaluated for many rows at once,
+     *          instead of running it once per row.
+     *
+     *  The function must take only `real` and `int` parameters, return a
+     *  `real`, and compute it without branches, calls other than builtin
+     *  functions, global variables or `int` arithmetic.  Calls to small
+     *  functions are usually inlined and do not prevent it.
+     *
+     *  @param  name  The name of the function.
+     *  @return  The batch function, or @c std::nullopt if no function of
+     *           the name can be evaluated in batches.
+     *  @note  Requires a successful compilation, and @c rebuild after
+     *         @c edit .
+     */
+    [[nodiscard]] auto compile_batch(std::string_view name) const
+    -> std::optional<batch_function>;
+
+    /**
+     *  @brief  Get the offset where the token begins in the source code.
+     *
+     *  @param  index  Index of the token in @c tokens .
+     *  @return  The offset of the token.
+     */
+    [[nodiscard]] inline constexpr auto offset(std::size_t index) const
+    -> std::size_t
+    {
+        std::size_t begin = tokens[index].begin;
+        if (index < moved_tokens)
+        {
+            return begin;
+        }
+        return static_cast<std::size_t>(
+            static_cast<std::ptrdiff_t>(begin) + token_shift);
+    }
+
+    /**
+     *  @brief  Get the source code that the token covers.
+     *
+     *  @param  tok  The token.
+     *  @return  The source code of the token.
+     *  @note  For tokens in @c tokens , use the index instead.
+     */
+    [[nodiscard]] inline constexpr auto text(const token &tok) const
+    {
+        return source().substr(tok.begin, tok.length);
+    }
+
+    /**
+     *  @brief  Get the source code that the token covers.
+     *
+     *  @param  index  Index of the token in @c tokens .
+     *  @return  The source code of the token.
+     */
+    [[nodiscard]] inline constexpr auto text(std::size_t index) const
+    {
+        return source().substr(offset(index), tokens[index].length);
+    }
+
+    /**
+     *  @brief  Get the symbol ID of an identifier or operator token.
+     *
+     *  @param  tok  The identifier or operator token.
+     *  @return  The symbol ID in @c symbols .
+     */
+    [[nodiscard]] inline constexpr auto symbol(const token &tok) const
+    {
+        return std::get<std::uint32_t>(tok.value);
+    }
+
+    /**
+     *  @brief  Get the value of a numerical literal token.
+     *
+     *  @param  tok  The numerical literal token.
+     *  @return  The number.
+     */
+    [[nodiscard]] inline constexpr auto number_value(const token &tok) const
+    {
+        return numbers[std::get<std::uint32_t>(tok.value)];
+    }
+
+    /**
+     *  @brief  Get the value of a string literal token.
+     *
+     *  @param  tok  The string literal token.
+     *  @return  The decoded value, or the source code without the quotes if
+     *           the string literal has no escape sequences.
+     */
+    [[nodiscard]] inline constexpr auto string_value(const token &tok) const
+    -> std::string_view
+    {
+        if (std::holds_alternative<std::uint32_t>(tok.value))
+        {
+            return decoded_strings[std::get<std::uint32_t>(tok.value)];
+        }
+        return text(tok).substr(1, tok.length - 2);
+    }
+
+    /**
+     *  @brief  Get the value of a string literal token.
+     *
+     *  @param  index  Index of the string literal token in @c tokens .
+     *  @return  The decoded value, or the source code without the quotes if
+     *           the string literal has no escape sequences.
+     */
+    [[nodiscard]] inline constexpr auto string_value(std::size_t index) const
+    -> std::string_view
+    {
+        auto &tok = tokens[index];
+        if (std::holds_alternative<std::uint32_t>(tok.value))
+        {
+            return decoded_strings[std::get<std::uint32_t>(tok.value)];
+        }
+        return text(index).substr(1, tok.length - 2);
+    }
+
+    /**
+     *  @brief  Compile the source code.
+     *  @note  With @c compile_options::cache set, a compilation of the same
+     *         source code and options is copied from the cache instead,
+     *         skipping the lexer, the parser and the compiler.
+     */
+    inline constexpr auto compile()
+    {
+        compilation_successful = false;
+        stale                  = false;
+        tokens_valid           = false;
+        moved_tokens           = 0;
+        token_shift            = 0;
+        moved_lines            = 0;
+        line_shift             = 0;
+        free_strings.clear();
+        free_numbers.clear();
+
+        // Symbol IDs of a compilation in the cache begin from an empty table
+        auto cache = options.cache && symbols.names.empty();
+        if (cache)
+        {
+            if (auto compiled = compile_cache::global().find(source(),
+                options.codegen_key()))
+            {
+                lexed_messages = messages.size() + compiled->lexed_messages;
+                messages.insert(messages.end(), compiled->messages.begin(),
+                    compiled->messages.end());
+                tokens          = compiled->tokens;
+                decoded_strings = compiled->decoded_strings;
+                numbers         = compiled->numbers;
+                tree            = compiled->tree;
+                bytecode        = copy_program(*compiled->bytecode);
+                symbols         = compiled->symbols;
+                line_starts     = compiled->line_starts;
+                num_lines       = line_starts.size();
+                tokens_valid    = true;
+                compilation_successful = true;
+                return;
+            }
+        }
+
+        auto first_message = messages.size();
+        line_starts = index_lines(source());
+        num_lines   = line_starts.size();
+        auto tokens = tokenize();
+        if (!tokens.has_value())
+        {
+            return;
+        }
+
+        this->tokens   = std::move(tokens.value());
+        lexed_messages = messages.size();
+        tokens_valid   = true;
+        auto tree      = parse();
+        if (!tree.has_value())
+        {
+            return;
+        }
+
+        this->tree   = std::move(tree.value());
+        auto program = generate();
+        if (!program.has_value())
+        {
+            return;
+        }
+
+        bytecode = std::make_shared<const dtn::program>(
+            std::move(program.value()));
+        compilation_successful = true;
+
+        if (cache)
+        {
+            compile_cache::global().insert(
+                std::make_shared<const compiled_source>(compiled_source {
+                    .source_code     = std::string(source()),
+                    .codegen_key     = options.codegen_key(),
+                    .messages        = std::vector<message>(
+                        messages.begin() + first_message, messages.end()),
+                    .lexed_messages  = lexed_messages - first_message,
+                    .tokens          = this->tokens,
+                    .decoded_strings = decoded_strings,
+                    .numbers         = numbers,
+                    .tree            = this->tree,
+                    .bytecode        = copy_program(*bytecode),
+                    .symbols         = symbols,
+                    .line_starts     = line_starts
+                }));
+        }
+    }
+
+    /**
+     *  @brief  Replace the range of the source code with the text, and
+     *          re-tokenize only the affected part of the source code.
+     *
+     *  Tokens before the edit are kept, and the tokens after the edit are
+     *  reused as soon as the lexer reaches a token boundary that existed
+     *  before the edit.  The tokens and lines after the edit are not
+     *  rewritten, but recorded as moved, and the literals of the replaced
+     *  tokens are reused.  The syntax tree and the bytecode are only
+     *  marked @c stale , and built again by @c rebuild on the next
+     *  @c run .  Lexical errors leave no token and are patched like the
+     *  tokens, every one of them being reported regardless of
+     *  @c compile_options::max_errors .  Without @c tokens_valid , the
+     *  whole source code is lexed again.
+     *
+     *  @param  begin  The beginning of the range to replace.
+     *  @param  end    The end of the range to replace (exclusive).
+     *  @param  text   The replacement text.
+     *  @return  True if the source code has no lexical errors after the
+     *           edit.
+     *  @note  A memory-mapped source code is copied before the edit.
+     */
+    auto edit(std::size_t begin, std::size_t end, std::string_view text)
+    -> bool;
+
+    /**
+     *  @brief  Parse and compile the tokens again if @c edit changed them.
+     *  @return  True if the syntax tree and the bytecode are valid.
+     *  @note  Nothing is parsed while the lexer reports an error.
+     */
+    auto rebuild() -> bool;
+
+    /**
+     *  @brief  Resolve the offset in the source code into line and column.
+     *
+     *  @param  offset  The offset in the source code.
+     *  @return  Line and column of the offset.
+     *  @note  Requires @c line_starts , which is built by @c compile .
+     */
+    [[nodiscard]] inline constexpr auto locate(std::size_t offset) const
+    -> location
+    {
+        auto lines = std::span<const std::size_t>(line_starts);
+        auto moved = std::min(moved_lines, lines.size());
+        if (moved == lines.size() || static_cast<std::ptrdiff_t>(offset)
+            < static_cast<std::ptrdiff_t>(lines[moved]) + line_shift)
+        {
+            return dtn::locate(lines.first(moved), offset);
+        }
+
+        auto result = dtn::locate(lines.subspan(moved),
+            static_cast<std::size_t>(
+                static_cast<std::ptrdiff_t>(offset) - line_shift));
+        result.line += moved;
+        return result;
+    }
+
+    /**
+     *  @brief  Get formatted message (multi-line) ready to be outputted.
+     *
+     *  @param  msg    The message.
+     *  @param  style  How to render the message.
+     *  @return  Formatted message.
+     */
+    [[nodiscard]] inline constexpr auto message_str(
+        message       msg,
+        message_style style = message_style::ansi
+    )
+    {
+        if (line_starts.empty())
+        {
+            line_starts = index_lines(source());
+            num_lines   = line_starts.size();
+        }
+
+        // Apply the moves left by edit, since the message needs the lines
+        for (auto i = moved_lines; i < line_starts.size(); i++)
+        {
+            line_starts[i] = static_cast<std::size_t>(
+                static_cast<std::ptrdiff_t>(line_starts[i]) + line_shift);
+        }
+        moved_lines = line_starts.size();
+        line_shift  = 0;
+
+        return msg.str(name, source(), line_starts, message_strings,
+            style);
+    }
+
+    /**
+     *  @brief  Print all the messages.
+     *  @param  style  How to render the messages.
+     */
+    inline constexpr auto print_messages(
+        message_style style = message_style::ansi
+    )
     {
         for (auto &message : messages)
         {
-            std::print("{}", message.str(name, source_code));
+            std::print("{}", message_str(message, style));
+        }
+    }
+};
+
+/**
+ *  @brief  Pulls tokens from the source code on demand, keeping only a
+ *          bounded number of them in memory.
+ *
+ *  Tokens are lexed in small batches into a buffer that holds at most
+ *  @c lookahead + @c batch_size tokens, regardless of the size of the
+ *  source code.
+ *
+ *  @note  This is for consumers that read tokens once, in order.  The
+ *         parser refers back to tokens by index, so it parses the tokens
+ *         of @c detronade::tokens and does not use a cursor.
+ */
+struct token_cursor {
+
+    /**
+     *  @brief  Number of tokens lexed at once when the buffer runs out.
+     */
+    static inline constexpr std::size_t batch_size = 32;
+
+    /**
+     *  @brief  The source code's information, receives symbols, messages,
+     *          decoded strings and numbers.
+     */
+    detronade *dtn;
+
+    /**
+     *  @brief  Maximum number of tokens that can be peeked after the
+     *          current token.
+     */
+    std::size_t lookahead;
+
+    /**
+     *  @brief  Lexed tokens that are not consumed yet, beginning at
+     *          @c position .
+     */
+    std::vector<token> buffer;
+
+    /**
+     *  @brief  Position of the current token in @c buffer .
+     */
+    std::size_t position = 0;
+
+    /**
+     *  @brief  The offset in the source code to lex the next batch from.
+     */
+    std::size_t index = 0;
+
+    /**
+     *  @brief  Set to @c lex_status::end or @c lex_status::error when the
+     *          lexer stops.
+     */
+    lex_status status = lex_status::token;
+
+    /**
+     *  @brief  Number of lexical errors, which the lexer recovers from if
+     *          @c compile_options::recover_errors is set.
+     */
+    std::size_t errors = 0;
+
+    /**
+     *  @brief  Creates the cursor at the beginning of the source code.
+     *
+     *  @param  dtn        The source code's information.
+     *  @param  lookahead  Maximum number of tokens that can be peeked after
+     *                     the current token.
+     *  @note  Literals are appended to the decoded strings and numbers of
+     *         the source code's information, so that its tokens remain
+     *         valid.
+     */
+    token_cursor(detronade &dtn, std::size_t lookahead = 1);
+
+    /**
+     *  @brief  Lex the next batch of tokens into the buffer, discarding the
+     *          consumed tokens.
+     */
+    auto fill() -> void;
+
+    /**
+     *  @brief  Peek a token without consuming it.
+     *
+     *  @param  offset  Number of tokens after the current token, at most
+     *                  @c lookahead .
+     *  @return  The token, if the lexer did not stop before it.
+     */
+    [[nodiscard]] inline constexpr auto peek(std::size_t offset = 0)
+    -> std::optional<token>
+    {
+        // The buffer is only filled up to the lookahead, so a token past it
+        // would look like the end of the source code
+        assert(offset <= lookahead && "Peeking beyond the lookahead");
+
+        if (position + offset >= buffer.size()
+         && status == lex_status::token)
+        {
+            fill();
+        }
+
+        if (position + offset >= buffer.size())
+        {
+            return std::nullopt;
+        }
+        return buffer[position + offset];
+    }
+
+    /**
+     *  @brief  Consume the current token.
+     *  @return  The token, if the lexer did not stop.
+     */
+    inline constexpr auto next() -> std::optional<token>
+    {
+        auto tok = peek();
+        if (tok)
+        {
+            position++;
         }
+        return tok;
+    }
+
+    /**
+     *  @brief  Check whether a lexical error occurred, even if the lexer
+     *          recovered from it.
+     *  @return  True if a lexical error occurred.
+     */
+    [[nodiscard]] inline constexpr auto failed() const
+    {
+        return errors > 0;
     }
 };
 
@@ -38,9 +38,18 @@
  *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
  */
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <format>
+#include <limits>
 #include <optional>
+#include <ranges>
+#include <thread>
 
 #include "alce_string_manipulators.hpp"
 #include "plons_detronade.hpp"
@@ -53,17 +62,334 @@ using namespace std::string_literals;
 using namespace plons::dtn;
 
 namespace stdr = std::ranges;
+namespace stdv = std::views;
+
+// SSE2 is the baseline for x86-64, AVX2 is selected at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+#define PLONS_LIBRARY_DTN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define PLONS_LIBRARY_DTN_AVX2
+#else
+#define PLONS_LIBRARY_DTN_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define PLONS_LIBRARY_DTN_X86 0
+#endif
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 /**
- *  @brief  Get formatted message (multi-line) ready to be outputted.
+ *  @brief  Find the beginning of every line in the source code.
  *
- *  @param  name  The name of the source code.
- *  @param  src   The source code.
+ *  @param  src  The source code.
+ *  @return  Offsets where each line begins, the first one being 0.
+ */
+auto plons::dtn::index_lines(std::string_view src)
+-> std::vector<std::size_t>
+{
+    std::vector<std::size_t> line_starts = { 0 };
+
+    const char *data    = src.data();
+    const char *end     = data + src.size();
+    const char *newline = data;
+    while (newline < end)
+    {
+        newline = static_cast<const char *>(
+            std::memchr(newline, '\n', end - newline));
+        if (newline == nullptr)
+        {
+            break;
+        }
+
+        newline++;
+        line_starts.emplace_back(newline - data);
+    }
+
+    return line_starts;
+}
+
+/**
+ *  @brief  Map the file, unmapping the previous one.
+ *
+ *  @param  filename  The file to map.
+ *  @return  True if successfully mapped.
+ */
+auto mapped_file::map(std::string_view filename) -> bool
+{
+    unmap();
+
+    auto path = std::string(filename);
+
+#if defined(_WIN32)
+    auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER file_size = {};
+    SYSTEM_INFO   system    = {};
+    GetSystemInfo(&system);
+
+    // The view is only zero-padded up to the page boundary, so a file that
+    // ends exactly at one has no room for the `\0`
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0
+     || file_size.QuadPart % system.dwPageSize == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+        nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+    {
+        return false;
+    }
+
+    auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    data        = static_cast<const char *>(view);
+    size        = static_cast<std::size_t>(file_size.QuadPart);
+    mapped_size = size;
+    handle      = mapping;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info = {};
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    auto file_size = static_cast<std::size_t>(info.st_size);
+    auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    // Reserve zeroed pages with room for at least one `\0` after the file,
+    // then map the file over them.  The rest of the last page of the file
+    // also reads as zero
+    std::size_t total = (file_size / page_size + 1) * page_size;
+    void       *base  = ::mmap(nullptr, total, PROT_READ,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (file_size != 0)
+    {
+        void *file = ::mmap(base, file_size, PROT_READ,
+            MAP_PRIVATE | MAP_FIXED, fd, 0);
+        if (file == MAP_FAILED)
+        {
+            ::munmap(base, total);
+            ::close(fd);
+            return false;
+        }
+        ::posix_madvise(base, file_size, POSIX_MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+
+    data        = static_cast<const char *>(base);
+    size        = file_size;
+    mapped_size = total;
+#endif
+
+    return true;
+}
+
+/**
+ *  @brief  Unmap the file, if mapped.
+ */
+auto mapped_file::unmap() -> void
+{
+    if (data == nullptr)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle(handle);
+#else
+    ::munmap(const_cast<char *>(data), mapped_size);
+#endif
+
+    data        = nullptr;
+    size        = 0;
+    mapped_size = 0;
+    handle      = nullptr;
+}
+
+/**
+ *  @brief  Get the name of the base of a number.
+ *
+ *  @param  base  The base.
+ *  @return  Name of the base.
+ */
+[[nodiscard]] static inline constexpr auto base_name(std::uint32_t base)
+{
+    switch (base)
+    {
+        case 2: return "binary"s;
+        case 8: return "octal"s;
+        case 10: return "decimal"s;
+        case 16: return "hexadecimal"s;
+    }
+    return "unknown"s;
+}
+
+/**
+ *  @brief  Get the text of the message (single-line).
+ *
+ *  @param  strings  The strings that the string arguments refer to.
+ *  @param  style    How to render the message.
+ *  @return  Text of the message.
+ */
+auto message::text(
+    std::span<const std::string> strings,
+    message_style                style
+) const -> std::string
+{
+    auto highlight = [&](const auto &value)
+    {
+        if (style == message_style::raw)
+        {
+            return std::format("`{}`", value);
+        }
+        return std::format("{}`{}`{}", bold + white, value, !(bold + white));
+    };
+
+    auto get_char = [&](std::size_t index)
+    {
+        return std::get<char>(args[index]);
+    };
+
+    auto get_u32 = [&](std::size_t index)
+    {
+        return std::get<std::uint32_t>(args[index]);
+    };
+
+    switch (id)
+    {
+    using enum message_id;
+        case unknown: return "Unknown"s;
+        case unable_to_open_file:
+        {
+            auto index    = get_u32(0);
+            auto filename = index < strings.size() ? strings[index] : ""s;
+            if (style == message_style::raw)
+            {
+                return "Unable to open file " + filename;
+            }
+            return "Unable to open file " + (bold + white)(filename);
+        }
+        case source_too_large: return "Source code too large to tokenize"s;
+        case unexpected_eof: return "Unexpected EOF"s;
+        case invalid_character:
+            return std::format("Invalid character {} in source code",
+                highlight(get_char(0)));
+        case invalid_escape_character:
+            return std::format("Invalid character {} in escape code",
+                highlight(get_char(0)));
+        case invalid_digit:
+            return std::format("Invalid character {} in {} numerical literal",
+                highlight(get_char(0)), base_name(get_u32(1)));
+        case invalid_escape_digit:
+            return std::format("Invalid character {} in {} escape code",
+                highlight(get_char(0)), base_name(get_u32(1)));
+        case multiple_decimal_points:
+            return std::format("Multiple decimal points in {} numerical "
+                "literal", base_name(get_u32(0)));
+        case invalid_number:
+            return "Cannot convert numerical literal to a number"s;
+        case number_too_large_for_char:
+            return std::format("Number {} too large for character",
+                highlight(std::get<double>(args[0])));
+        case too_many_characters:
+            return "Too many characters in char literal"s;
+        case empty_char_literal: return "Char literal cannot be empty"s;
+        case expected_expression: return "Expected an expression"s;
+        case expected_character:
+            return std::format("Expected {}", highlight(get_char(0)));
+        case expected_name: return "Expected a name"s;
+        case expected_body:
+            return "Expected a statement or an indented block"s;
+        case expected_end_of_line: return "Expected the end of the line"s;
+        case unexpected_indentation: return "Unexpected indentation"s;
+        case unexpected_token: return "Unexpected token"s;
+        case unknown_operator: return "Unknown operator"s;
+        case undeclared_name: return "Undeclared name"s;
+        case unknown_type: return "Unknown type"s;
+        case redeclared_name: return "Name is already declared in this scope"s;
+        case not_assignable: return "Cannot assign to this expression"s;
+        case assign_to_constant: return "Cannot assign to a constant"s;
+        case no_matching_function:
+            return std::format("No overload takes {} arguments", get_u32(0));
+        case not_callable: return "Expression cannot be called"s;
+        case unknown_member: return "Unknown member"s;
+        case misplaced_declaration: return "Declaration is not allowed here"s;
+        case program_too_large: return "Program too large for the bytecode"s;
+        case index_out_of_range:
+            return std::format("Index {} out of range",
+                highlight(std::get<double>(args[0])));
+        case division_by_zero: return "Integer division by zero"s;
+        case invalid_operands:
+            return "Operator cannot be applied to these values"s;
+        case invalid_conversion:
+            return "Value cannot be converted to the type"s;
+        case no_matching_overload: return "No overload accepts these values"s;
+        case stack_overflow: return "Stack overflow"s;
+        case too_many_errors:
+            return std::format("Stopped after {} errors",
+                get_u32(0));
+        case max: break;
+    }
+    return ""s;
+}
+
+/**
+ *  @brief  Get formatted message (multi-line) ready to be outputted, using
+ *          an existing line index.
+ *
+ *  @param  name         The name of the source code.
+ *  @param  src          The source code.
+ *  @param  line_starts  Offsets where each line begins, from
+ *                       @c index_lines .
+ *  @param  strings      The strings that the string arguments refer to.
+ *  @param  style        How to render the message.
  *  @return  Formatted message.
  */
 auto message::str(
-    std::string_view name,
-    std::string_view src
+    std::string_view             name,
+    std::string_view             src,
+    std::span<const std::size_t> line_starts,
+    std::span<const std::string> strings,
+    message_style                style
 ) -> std::string
 {
     // Severity highlighting
@@ -78,7 +404,13 @@ auto message::str(
         case error: sev   = { "error", bold + red }; break;
     }
 
-    auto total_lines     = stdr::count(src, '\n') + 1;
+    // Plain text when rendering raw
+    auto paint = [&](const aec_t &code, const std::string &string)
+    {
+        return style == message_style::raw ? string : code(string);
+    };
+
+    auto total_lines     = line_starts.size();
     auto total_lines_str = std::to_string(total_lines);
 
     /*
@@ -262,16 +594,22 @@ Multi-line (again, so I can see and implement)
         }
     };
 
-    auto        lines        = sm::split(src, '\n');
+    // Only the lines from the beginning to the end of the fault are shown
+    std::size_t first_line   = find_line(line_starts, pos.begin);
+    std::size_t last_line    = find_line(line_starts, end);
     std::string msg_lines    = "";
-    std::size_t index        = 0;
-    std::size_t line_num     = 0;
     std::size_t msg_line_num = 0;
     std::size_t msg_col_num  = 0;
-    for (auto &line : lines)
+    for (std::size_t i = first_line; i <= last_line; i++)
     {
-        line_num++;
-        auto line_num_str = std::to_string(line_num);
+        std::size_t index    = line_starts[i];
+        std::size_t line_end = i + 1 < line_starts.size()
+                             ? line_starts[i + 1] - 1
+                             : src.size();
+        auto        line     = src.substr(index, line_end - index);
+
+        std::size_t line_num     = i + 1;
+        auto        line_num_str = std::to_string(line_num);
 
         // Look, naming is hard ok?
         auto i_begin   = std::string::npos;
@@ -295,8 +633,9 @@ Multi-line (again, so I can see and implement)
         {
             i_length = end - index - i_begin;
         }
-        else if (end > index + line.size() + 1)
+        else if (index <= end)
         {
+            // The fault continues past the end of this line
             i_length = line.size() + 1 - i_begin;
         }
 
@@ -327,36 +666,39 @@ Multi-line (again, so I can see and implement)
             {
                 // Sub-line before the pointer
                 auto pre_point = line.substr(i_begin, i_pointer);
-                msg_lines     += (bold + white)(pre_point);
-                msg_squiggles += sev.second("~"s * pre_point.size());
+                msg_lines     += paint(bold + white, std::string(pre_point));
+                msg_squiggles += paint(sev.second, "~"s * pre_point.size());
 
                 // The pointer
-                auto point     = sm::to_string(line[i_begin + i_pointer]);
-                msg_lines     += sev.second(point);
-                msg_squiggles += sev.second("^");
+                auto point     = sm::to_string(i_begin + i_pointer < line.size()
+                    ? line[i_begin + i_pointer] : ' ');
+                msg_lines     += paint(sev.second, point);
+                msg_squiggles += paint(sev.second, "^");
 
                 // Sub-line after the pointer
                 if (i_begin + i_pointer + 1 < line.size() + 1)
                 {
                     auto post_point = line.substr(i_begin + i_pointer + 1,
                         i_length - i_pointer - 1);
-                    msg_lines     += (bold + white)(post_point);
-                    msg_squiggles += sev.second("~"s * post_point.size());
+                    msg_lines     += paint(bold + white,
+                        std::string(post_point));
+                    msg_squiggles += paint(sev.second,
+                        "~"s * post_point.size());
                 }
             }
             else
             {
                 // The entire line as fault
                 auto fault_line = line.substr(i_begin, i_length);
-                msg_lines      += (bold + white)(fault_line);
-                msg_squiggles  += sev.second("~"s * fault_line.size());
+                msg_lines      += paint(bold + white, std::string(fault_line));
+                msg_squiggles  += paint(sev.second, "~"s * fault_line.size());
 
                 // Special case: pointer is at newline or at EOF to indicate
                 // unexpected newline or EOF
                 if (index <= pointing_to
                  && pointing_to <= index + line.size() + 1)
                 {
-                    msg_squiggles += sev.second("^");
+                    msg_squiggles += paint(sev.second, "^");
                 }
             }
 
@@ -369,171 +711,275 @@ Multi-line (again, so I can see and implement)
 
             msg_lines += "\n" + msg_squiggles + "\n";
         }
-        index += line.size() + 1;
+    }
+
+    if (style == message_style::raw)
+    {
+        return std::format("{}:{}:{}: {}: {}\n{}",
+            name, msg_line_num, msg_col_num, sev.first, text(strings, style),
+            msg_lines);
     }
 
     return std::format("{}{}:{}:{}{}: {}{}{}: {}\n{}",
         bold + white, name, msg_line_num, msg_col_num, !(bold + white),
-        sev.second, sev.first, !sev.second, msg,
+        sev.second, sev.first, !sev.second, text(strings, style),
         msg_lines);
 }
 
 /**
- *  @brief  Convert the string to a real.
+ *  @brief  Build the table of digit values at compile time.
+ *  @return  Value of every byte as a digit, or 255 if it is not a digit.
+ */
+[[nodiscard]] static consteval auto make_digit_values()
+{
+    std::array<std::uint8_t, 256> table = {};
+    table.fill(255);
+
+    for (std::uint8_t i = 0; i < 10; i++)
+    {
+        table['0' + i] = i;
+    }
+
+    for (std::uint8_t i = 0; i < 6; i++)
+    {
+        table['a' + i] = 10 + i;
+        table['A' + i] = 10 + i;
+    }
+
+    return table;
+}
+
+/**
+ *  @brief  Value of every byte as a digit, or 255 if it is not a digit.
+ */
+static constexpr auto digit_values = make_digit_values();
+
+/**
+ *  @brief  Get the value of the character as a digit.
+ *
+ *  @param  c  The character.
+ *  @return  Value of the digit, or 255 if it is not a digit.
+ */
+[[nodiscard]] static inline constexpr auto digit_value(char c)
+{
+    return digit_values[static_cast<unsigned char>(c)];
+}
+
+/**
+ *  @brief  Convert the digits in a power of two base to the nearest real.
+ *
+ *  The first 64 significant bits are accumulated, and the rest of the bits
+ *  are folded into the lowest bit so that the conversion to @c double
+ *  rounds correctly.
+ *
+ *  @param  digits  The digits, with an optional point.
+ *  @param  shift   Number of bits per digit.
+ *  @return  The nearest real.
+ */
+[[nodiscard]] static inline constexpr auto bits_to_real(
+    std::string_view digits,
+    int              shift
+) -> double
+{
+    std::uint64_t mantissa = 0;
+    int           exponent = 0;
+    bool          sticky   = false;
+    bool          fraction = false;
+
+    for (auto &c : digits)
+    {
+        if (c == '.')
+        {
+            fraction = true;
+            continue;
+        }
+
+        auto digit = digit_value(c);
+        if (mantissa >> (64 - shift) == 0)
+        {
+            mantissa = mantissa << shift | digit;
+            exponent -= fraction ? shift : 0;
+        }
+        else
+        {
+            sticky   |= digit != 0;
+            exponent += fraction ? 0 : shift;
+        }
+    }
+
+    if (sticky)
+    {
+        mantissa |= 1;
+    }
+    return std::ldexp(static_cast<double>(mantissa), exponent);
+}
+
+/**
+ *  @brief  Convert the string to a number.
+ *
+ *  Integers are kept exact if they fit in 64 bits, otherwise the number is
+ *  converted to the nearest real.
  *
  *  @param  messages        The list of messages to append to.
  *  @param  begin           The beginning of the string.
- *  @param  string          The string to convert to a real.
+ *  @param  string          The string to convert to a number.
  *  @param  is_escape_code  Whether the string is from an escape code.
- *  @return  Real number converted from string.
+ *  @return  Number converted from string.
  */
 [[nodiscard]] static inline constexpr auto parse_number(
     std::vector<message> &messages,
     std::size_t           begin,
-    std::string           string,
+    std::string_view      string,
     bool                  is_escape_code = false
-) -> std::optional<float>
+) -> std::optional<number>
 {
-    std::size_t start = 0;
-    float       base  = 10;
-
-    string = sm::to_lower(string);
+    std::size_t   start = 0;
+    std::uint32_t base  = 10;
 
+    // Prefixes are case insensitive, `| 0x20` lowers the letters
     if (is_escape_code)
     {
-        if (string.starts_with("\\d"))
-        {
-            start = 2;
-        }
-        else if (string.starts_with("\\i"))
+        // `\` alone is decimal, and binary uses `\i` since `\b` is taken
+        start = 1;
+        switch (string.size() >= 2 ? string[1] | 0x20 : 0)
         {
-            base  = 2;
-            start = 2;
-        }
-        else if (string.starts_with("\\o"))
-        {
-            base  = 8;
-            start = 2;
-        }
-        else if (string.starts_with("\\x"))
-        {
-            base  = 16;
-            start = 2;
-        }
-        else if (string.starts_with("\\"))
-        {
-            start = 1;
+            case 'd': start = 2; break;
+            case 'i': base = 2; start = 2; break;
+            case 'o': base = 8; start = 2; break;
+            case 'x': base = 16; start = 2; break;
         }
     }
-    else
+    else if (string.size() >= 2 && string[0] == '0')
     {
-        if (string.starts_with("0d"))
-        {
-            start = 2;
-        }
-        else if (string.starts_with("0b"))
-        {
-            base  = 2;
-            start = 2;
-        }
-        else if (string.starts_with("0o"))
-        {
-            base  = 8;
-            start = 2;
-        }
-        else if (string.starts_with("0x"))
+        switch (string[1] | 0x20)
         {
-            base  = 16;
-            start = 2;
+            case 'd': start = 2; break;
+            case 'b': base = 2; start = 2; break;
+            case 'o': base = 8; start = 2; break;
+            case 'x': base = 16; start = 2; break;
         }
     }
 
-    std::string base_name;
-
-    switch ((int)std::round(base))
-    {
-        case 2: base_name  = "binary"; break;
-        case 8: base_name  = "octal"; break;
-        case 10: base_name = "decimal"; break;
-        case 16: base_name = "hexadecimal"; break;
-        default: base_name = "unknown";
-    }
-
-    // Eliminate invalid digits
-    std::string digits   = "0123456789abcdef"s.substr(0, base);
-    std::string filtered = "";
-    std::size_t point    = std::string::npos;
+    // Validate the digits, and find the point and separators
+    std::size_t point      = std::string_view::npos;
+    bool        separators = false;
 
     for (std::size_t i = start; i < string.size(); i++)
     {
-        auto pos = digits.find(string[i]);
-        if (pos != std::string::npos)
+        if (digit_value(string[i]) < base)
         {
-            filtered += string[i];
             continue;
         }
 
         if (!is_escape_code && string[i] == '.')
         {
-            if (point == std::string::npos)
+            if (point == std::string_view::npos)
             {
-                point = filtered.size();
+                point = i;
                 continue;
             }
 
-            auto msg = std::format("Multiple decimal points in {}",
-                is_escape_code
-                ? base_name + " escape code"
-                : base_name + " numerical literal");
             messages.emplace_back(message {
-                .msg         = msg,
+                .id          = message_id::multiple_decimal_points,
                 .severity    = message_severity::error,
                 .pos         = {
                     .begin   = begin,
                     .length  = string.length(),
                     .pointer = i
-                }
+                },
+                .args        = { base }
             });
             return std::nullopt;
         }
 
         if (!is_escape_code && string[i] == '\'')
         {
+            separators = true;
             continue;
         }
 
-        auto msg = std::format("Invalid character {}`{}`{} in {}",
-            bold + white, string[i], !(bold + white),
-            is_escape_code
-            ? base_name + " escape code"
-            : base_name + " numerical literal");
         messages.emplace_back(message {
-            .msg         = msg,
+            .id          = is_escape_code
+                         ? message_id::invalid_escape_digit
+                         : message_id::invalid_digit,
             .severity    = message_severity::error,
             .pos         = {
                 .begin   = begin,
                 .length  = string.length(),
                 .pointer = i
-            }
+            },
+            .args        = { string[i], base }
         });
         return std::nullopt;
     }
 
-    float result = 0;
-    for (auto &c : filtered)
+    auto        digits   = string.substr(start);
+    std::string filtered = {};
+    if (separators)
+    {
+        filtered.reserve(digits.size());
+        for (auto &c : digits)
+        {
+            if (c != '\'')
+            {
+                filtered += c;
+            }
+        }
+        digits = filtered;
+    }
+
+    // A prefix without digits is 0
+    if (digits.empty() || digits == ".")
     {
-        auto pos = digits.find(c);
-        result  *= base;
-        result  += pos;
+        return std::uint64_t {0};
     }
 
-    if (!is_escape_code && point != std::string::npos)
+    auto first = digits.data();
+    auto last  = digits.data() + digits.size();
+    if (point == std::string_view::npos)
     {
-        auto exp = filtered.size() - point;
-        result  /= std::pow<float>(base, exp);
+        std::uint64_t integer = 0;
+        auto [end, error] = std::from_chars(first, last, integer,
+            static_cast<int>(base));
+        if (error == std::errc {})
+        {
+            return integer;
+        }
     }
 
-    return result;
+    if (base == 10)
+    {
+        double real = 0;
+        auto [end, error] = std::from_chars(first, last, real,
+            std::chars_format::fixed);
+
+        // Beyond the range of reals, a literal overflows if it has a
+        // nonzero integral part and underflows otherwise
+        if (error == std::errc::result_out_of_range)
+        {
+            auto integral = digits.substr(0, digits.find('.'));
+            return integral.find_first_not_of('0') == std::string_view::npos
+                 ? 0.0
+                 : HUGE_VAL;
+        }
+
+        if (error != std::errc {} || end != last)
+        {
+            messages.emplace_back(message {
+                .id          = message_id::invalid_number,
+                .severity    = message_severity::error,
+                .pos         = {
+                    .begin   = begin,
+                    .length  = string.length(),
+                    .pointer = 0
+                },
+                .args        = {}
+            });
+            return std::nullopt;
+        }
+        return real;
+    }
+    return bits_to_real(digits, std::countr_zero(base));
 }
 
 /**
@@ -572,23 +1018,26 @@ Multi-line (again, so I can see and implement)
         case 'r': return '\r';
         case 't': return '\t';
         case 'v': return '\v';
-        default:
+
+        case '\0':
         {
-            auto msg = std::format("Unexpected EOF");
             messages.emplace_back(message {
-                .msg         = msg,
+                .id          = message_id::unexpected_eof,
                 .severity    = message_severity::error,
                 .pos         = {
                     .begin   = begin,
-                    .length  = index - begin + 1,
-                    .pointer = index - begin
+                    .length  = index - begin,
+                    .pointer = index - begin - 1
                 }
             });
             return std::nullopt;
         }
+
+        // Numeric escape code
+        default: break;
     }
 
-    int base = 0;
+    std::uint32_t base = 0;
 
     switch (c)
     {
@@ -604,80 +1053,100 @@ Multi-line (again, so I can see and implement)
 
     if (base == 0)
     {
-        auto msg = std::format("Invalid character {}`{}`{} in escape code",
-            bold + white, src[index], !(bold + white));
         messages.emplace_back(message {
-            .msg         = msg,
+            .id          = message_id::invalid_escape_character,
             .severity    = message_severity::error,
             .pos         = {
                 .begin   = begin,
-                .length  = index - begin + 1,
-                .pointer = index - begin
-            }
+                .length  = index - begin,
+                .pointer = index - begin - 1
+            },
+            .args        = { c }
         });
         return std::nullopt;
     }
 
-    std::string digits = "0123456789abcdef"s.substr(0, base);
-    while (digits.contains(std::tolower(src[index])))
+    while (digit_value(src[index]) < base)
     {
         index++;
     }
 
+    // A base without digits has no value
+    if (index == begin + 2 && digit_value(c) >= base)
+    {
+        messages.emplace_back(message {
+            .id          = message_id::invalid_escape_digit,
+            .severity    = message_severity::error,
+            .pos         = {
+                .begin   = begin,
+                .length  = index - begin + 1,
+                .pointer = index - begin
+            },
+            .args        = { src[index], base }
+        });
+        return std::nullopt;
+    }
+
     auto result = parse_number(messages, begin,
-        std::string(src.substr(begin, index - begin)), true);
+        src.substr(begin, index - begin), true);
 
     if (!result.has_value())
     {
         return std::nullopt;
     }
 
-    auto value = result.value();
+    auto value = std::visit([](auto value)
+    {
+        return static_cast<double>(value);
+    }, result.value());
     if (value > 255)
     {
-        auto msg = std::format("Number {}`{}`{} too large for character",
-            bold + white, value, !(bold + white));
         messages.emplace_back(message {
-            .msg         = msg,
+            .id          = message_id::number_too_large_for_char,
             .severity    = message_severity::warning,
             .pos         = {
                 .begin   = begin,
                 .length  = index - begin,
                 .pointer = 0
-            }
+            },
+            .args        = { value }
         });
     }
 
-    return (char)value;
+    // Only numbers beyond 64 bits are not integers
+    auto integer = std::get_if<std::uint64_t>(&result.value());
+    return static_cast<char>(integer ? *integer : 255);
 }
 
 /**
  *  @brief  Parse string literal.
  *
- *  @param  messages   The list of messages to append to.
- *  @param  src        The boundless source code.
- *  @param  index      The current char (enclosing char) in the source code.
- *  @param  encloser   The character that encloses a string.
- *  @return constexpr auto
+ *  @param  messages  The list of messages to append to.
+ *  @param  src       The boundless source code.
+ *  @param  index     The current char (enclosing char) in the source code.
+ *  @param  encloser  The character that encloses a string.
+ *  @param  decoded   The decoded value, only written to if the string has
+ *                    escape sequences.
+ *  @return  True if the string has escape sequences.
  */
 [[nodiscard]] static inline constexpr auto parse_string(
     std::vector<message>      &messages,
     cu::boundless_string_view &src,
     std::size_t               &index,
-    char                       encloser
-) -> std::optional<std::string>
+    char                       encloser,
+    std::string               &decoded
+) -> std::optional<bool>
 {
-    std::size_t begin = index;
-    std::string value = "";
+    std::size_t begin   = index;
+    bool        escaped = false;
     index++;
 
     while (src[index] != encloser)
     {
         if (src[index] == '\0')
         {
-            auto msg = std::format("Unexpected EOF");
             messages.emplace_back(message {
-                .msg         = msg,
+                .id          = message_id::unexpected_eof,
                 .severity    = message_severity::error,
                 .pos         = {
                     .begin   = begin,
@@ -690,6 +1159,13 @@ Multi-line (again, so I can see and implement)
 
         if (src[index] == '\\')
         {
+            // Only the strings with escape sequences need to be decoded
+            if (!escaped)
+            {
+                decoded = src.substr(begin + 1, index - begin - 1);
+                escaped = true;
+            }
+
             auto escape_code = parse_escape_code(messages, src, index);
             if (!escape_code.has_value())
             {
@@ -702,197 +1178,1774 @@ Multi-line (again, so I can see and implement)
             {
                 continue;
             }
-            value += std::get<char>(escape_code.value());
+            decoded += std::get<char>(escape_code.value());
         }
         else
         {
-            value += src[index];
+            if (escaped)
+            {
+                decoded += src[index];
+            }
             index++;
         }
     }
     index++;
 
-    return value;
+    return escaped;
 }
 
 /**
- *  @brief  Tokenize the source code.
- *  @return  Individual tokens of the source code.
+ *  @brief  Character classes used by the tokenizer, as bit flags.
  */
-[[nodiscard]] auto detronade::tokenize()
--> std::optional<std::vector<token>>
+struct char_class {
+    enum : std::uint8_t {
+        /**
+         *  @brief  Not a valid character in the source code.
+         */
+        none         = 0,
+        /**
+         *  @brief  Any of ` `, `\t`, `\n`, `\r`, `\f` or `\v`.
+         */
+        whitespace   = 1 << 0,
+        /**
+         *  @brief  Any of the characters that can form an operator.
+         */
+        operator_    = 1 << 1,
+        /**
+         *  @brief  Any of the characters that is a punctuation.
+         */
+        punctuation  = 1 << 2,
+        /**
+         *  @brief  a-z, A-Z or _.
+         */
+        id_start     = 1 << 3,
+        /**
+         *  @brief  a-z, A-Z, _ or 0-9.
+         */
+        id_continue  = 1 << 4,
+        /**
+         *  @brief  0-9.
+         */
+        num_start    = 1 << 5,
+        /**
+         *  @brief  a-z, A-Z, _, 0-9, `.` or `'`.
+         */
+        num_continue = 1 << 6
+    };
+};
+
+/**
+ *  @brief  What to lex, decided by the first character of a token.
+ */
+enum class lex_start : std::uint8_t {
+    /**
+     *  @brief  Invalid character.
+     */
+    invalid,
+    /**
+     *  @brief  End of source code (`\0`).
+     */
+    end,
+    /**
+     *  @brief  Whitespace run.
+     */
+    whitespace,
+    /**
+     *  @brief  Comment till the end of line.
+     */
+    comment,
+    /**
+     *  @brief  Char literal.
+     */
+    char_literal,
+    /**
+     *  @brief  String literal.
+     */
+    string_literal,
+    /**
+     *  @brief  Numerical literal.
+     */
+    numerical_literal,
+    /**
+     *  @brief  Identifier.
+     */
+    identifier,
+    /**
+     *  @brief  Operator.
+     */
+    operator_,
+    /**
+     *  @brief  Punctuation.
+     */
+    punctuation
+};
+
+/**
+ *  @brief  Build the character class table at compile time.
+ *  @return  Character class flags for every byte.
+ */
+[[nodiscard]] static consteval auto make_char_classes()
 {
-    std::vector<token>        tokens = {};
-    cu::boundless_string_view src    = std::string_view(source_code);
+    std::array<std::uint8_t, 256> table = {};
+
+    auto mark = [&](std::string_view chars, std::uint8_t flags)
+    {
+        for (auto &c : chars)
+        {
+            table[static_cast<unsigned char>(c)] |= flags;
+        }
+    };
 
-    const std::string whitespaces  = " \t\n\r\f\v";
-    const std::string operators    = "~!%^&*-+=[]\\|:<>/?";
-    const std::string punctuations = "@$(){};,.";
+    mark(" \t\n\r\f\v", char_class::whitespace);
+    mark("~!%^&*-+=[]\\|:<>/?", char_class::operator_);
+    mark("@$(){};,.", char_class::punctuation);
+    mark("abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+        char_class::id_start | char_class::id_continue
+        | char_class::num_continue);
+    mark("0123456789", char_class::num_start | char_class::id_continue
+        | char_class::num_continue);
+    mark(".'", char_class::num_continue);
+
+    return table;
+}
 
-    // Is this inefficient?  Yes.  Does it matter?  No
-    const std::string id_start
-        = "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-    const std::string num_start    = "0123456789";
-    const std::string id_continue  = id_start + num_start;
-    const std::string num_continue = num_start + id_continue + ".'";
+/**
+ *  @brief  Build the table for the first character of a token at compile
+ *          time.
+ *  @return  What to lex for every byte.
+ */
+[[nodiscard]] static consteval auto make_lex_starts()
+{
+    std::array<lex_start, 256> table = {};
+    auto                       classes = make_char_classes();
 
-    // Do not need to worry about out of bounds in boundless sv!
-    std::size_t index = 0;
-    while (src[index] != '\0')
+    for (std::size_t i = 0; i < table.size(); i++)
     {
-        if (whitespaces.contains(src[index]))
+        auto flags = classes[i];
+
+        if (flags & char_class::whitespace)
         {
-            while (whitespaces.contains(src[index]))
-            {
-                index++;
-            }
+            table[i] = lex_start::whitespace;
         }
-        // Skip comment
-        else if (src[index] == '#')
+        else if (flags & char_class::num_start)
         {
-            do
-            {
-                index++;
-            }
-            while (src[index] != '\n' && src[index] != '\0');
-            index++;
+            table[i] = lex_start::numerical_literal;
         }
-        else if (src[index] == '\'')
+        else if (flags & char_class::id_start)
         {
-            std::size_t begin  = index;
-            auto        string = parse_string(messages, src, index, '\'');
-            if (!string.has_value())
-            {
-                return std::nullopt;
-            }
+            table[i] = lex_start::identifier;
+        }
+        else if (flags & char_class::operator_)
+        {
+            table[i] = lex_start::operator_;
+        }
+        else if (flags & char_class::punctuation)
+        {
+            table[i] = lex_start::punctuation;
+        }
+    }
 
-            if (string.value().size() > 1)
-            {
-                auto msg = std::format("Too many characters in char literal");
+    table['\0'] = lex_start::end;
+    table['#']  = lex_start::comment;
+    table['\''] = lex_start::char_literal;
+    table['\"'] = lex_start::string_literal;
+
+    return table;
+}
+
+/**
+ *  @brief  Character class flags for every byte.
+ */
+static constexpr auto char_classes = make_char_classes();
+
+/**
+ *  @brief  What to lex for every byte at the beginning of a token.
+ */
+static constexpr auto lex_starts = make_lex_starts();
+
+/**
+ *  @brief  Check if the character belongs to the character class(es).
+ *
+ *  @param  c      The character.
+ *  @param  flags  The @c char_class flags.
+ *  @return  True if the character belongs to any of the flags.
+ */
+[[nodiscard]] static inline constexpr auto is_class(char c, std::uint8_t flags)
+{
+    return (char_classes[static_cast<unsigned char>(c)] & flags) != 0;
+}
+
+/**
+ *  @brief  Skip whitespaces one byte at a time.
+ *
+ *  @param  text   The null-terminated source code.
+ *  @param  index  The index to start skipping from.
+ *  @param  size   The size of the source code.
+ *  @return  Index of the first non-whitespace character.
+ */
+[[nodiscard]] static inline constexpr auto skip_whitespace_scalar(
+    const char *text,
+    std::size_t index,
+    std::size_t size
+) -> std::size_t
+{
+    while (index < size && is_class(text[index], char_class::whitespace))
+    {
+        index++;
+    }
+    return index;
+}
+
+/**
+ *  @brief  Find the end of the line one byte at a time.
+ *
+ *  @param  text   The null-terminated source code.
+ *  @param  index  The index to start searching from.
+ *  @param  size   The size of the source code.
+ *  @return  Index of the first `\n` or `\0`.
+ */
+[[nodiscard]] static inline constexpr auto find_line_end_scalar(
+    const char *text,
+    std::size_t index,
+    std::size_t size
+) -> std::size_t
+{
+    while (index < size && text[index] != '\n' && text[index] != '\0')
+    {
+        index++;
+    }
+    return index;
+}
+
+/**
+ *  @brief  Skip identifier continuation one byte at a time.
+ *
+ *  @param  text   The null-terminated source code.
+ *  @param  index  The index to start skipping from.
+ *  @param  size   The size of the source code.
+ *  @return  Index of the first character that cannot continue identifier.
+ */
+[[nodiscard]] static inline constexpr auto skip_identifier_scalar(
+    const char *text,
+    std::size_t index,
+    std::size_t size
+) -> std::size_t
+{
+    while (index < size && is_class(text[index], char_class::id_continue))
+    {
+        index++;
+    }
+    return index;
+}
+
+#if PLONS_LIBRARY_DTN_X86
+
+/**
+ *  @brief  Match whitespaces in 16 bytes.
+ *
+ *  @param  c  The 16 bytes.
+ *  @return  Bytes set to 0xff where there is whitespace.
+ */
+[[nodiscard]] static inline auto match_whitespace_sse2(__m128i c) -> __m128i
+{
+    // `\t`, `\n`, `\v`, `\f` and `\r` are contiguous (9-13)
+    auto control = _mm_subs_epu8(_mm_sub_epi8(c, _mm_set1_epi8(9)),
+        _mm_set1_epi8(4));
+    return _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')),
+        _mm_cmpeq_epi8(control, _mm_setzero_si128()));
+}
+
+/**
+ *  @brief  Match line end in 16 bytes.
+ *
+ *  @param  c  The 16 bytes.
+ *  @return  Bytes set to 0xff where there is `\n` or `\0`.
+ */
+[[nodiscard]] static inline auto match_line_end_sse2(__m128i c) -> __m128i
+{
+    return _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\n')),
+        _mm_cmpeq_epi8(c, _mm_setzero_si128()));
+}
+
+/**
+ *  @brief  Match identifier continuation in 16 bytes.
+ *
+ *  @param  c  The 16 bytes.
+ *  @return  Bytes set to 0xff where there is a-z, A-Z, 0-9 or _.
+ */
+[[nodiscard]] static inline auto match_identifier_sse2(__m128i c) -> __m128i
+{
+    auto zero   = _mm_setzero_si128();
+    auto lower  = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    auto alpha  = _mm_subs_epu8(_mm_sub_epi8(lower, _mm_set1_epi8('a')),
+        _mm_set1_epi8(25));
+    auto digit  = _mm_subs_epu8(_mm_sub_epi8(c, _mm_set1_epi8('0')),
+        _mm_set1_epi8(9));
+    auto under  = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(alpha, zero),
+        _mm_cmpeq_epi8(digit, zero)), under);
+}
+
+/**
+ *  @brief  Skip the bytes while they match, 16 bytes at a time.
+ *
+ *  @tparam  matches  Whether to skip while matching or not matching.
+ *  @param   text     The null-terminated source code.
+ *  @param   index    The index to start skipping from.
+ *  @param   size     The size of the source code.
+ *  @param   match    The matcher for 16 bytes.
+ *  @return  Index of the first byte that stops the skipping.
+ */
+template<bool matches>
+[[nodiscard]] static inline auto skip_sse2(
+    const char    *text,
+    std::size_t    index,
+    std::size_t    size,
+    auto         &&match
+) -> std::size_t
+{
+    while (index + 16 <= size)
+    {
+        auto c    = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(text + index));
+        auto mask = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(match(c)));
+        if constexpr (matches)
+        {
+            mask = ~mask & 0xffff;
+        }
+
+        if (mask != 0)
+        {
+            return index + std::countr_zero(mask);
+        }
+        index += 16;
+    }
+    return index;
+}
+
+/**
+ *  @brief  Skip whitespaces 16 bytes at a time.
+ *
+ *  @param  text   The null-terminated source code.
+ *  @param  index  The index to start skipping from.
+ *  @param  size   The size of the source code.
+ *  @return  Index of the first non-whitespace character.
+ */
+[[nodiscard]] static auto skip_whitespace_sse2(
+    const char *text,
+    std::size_t index,
+    std::size_t size
+) -> std::size_t
+{
+    index = skip_sse2<true>(text, index, size, match_whitespace_sse2);
+    return skip_whitespace_scalar(text, index, size);
+}
+
+/**
+ *  @brief  Find the end of the line 16 bytes at a time.
+ *
+ *  @param  text   The null-terminated source code.
+ *  @param  index  The index to start searching from.
+ *  @param  size   The size of the source code.
+ *  @return  Index of the first `\n` or `\0`.
+ */
+[[nodiscard]] static auto find_line_end_sse2(
+    const char *text,
+    std::size_t index,
+    std::size_t size
+) -> std::size_t
+{
+    index = skip_sse2<false>(text, index, size, match_line_end_sse2);
+    return find_line_end_scalar(text, index, size);
+}
+
+/**
+ *  @brief  Skip identifier continuation 16 bytes at a time.
+ *
+ *  @param  text   The null-terminated source code.
+ *  @param  index  The index to start skipping from.
+ *  @param  size   The size of the source code.
+ *  @return  Index of the first character that cannot continue identifier.
+ */
+[[nodiscard]] static auto skip_identifier_sse2(
+    const char *text,
+    std::size_t index,
+    std::size_t size
+) -> std::size_t
+{
+    index = skip_sse2<true>(text, index, size, match_identifier_sse2);
+    return skip_identifier_scalar(text, index, size);
+}
+
+/**
+ *  @brief  Match whitespaces in 32 bytes.
+ *
+ *  @param  c  The 32 bytes.
+ *  @return  Bytes set to 0xff where there is whitespace.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto
+match_whitespace_avx2(__m256i c) -> __m256i
+{
+    auto control = _mm256_subs_epu8(_mm256_sub_epi8(c, _mm256_set1_epi8(9)),
+        _mm256_set1_epi8(4));
+    return _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')),
+        _mm256_cmpeq_epi8(control, _mm256_setzero_si256()));
+}
+
+/**
+ *  @brief  Match line end in 32 bytes.
+ *
+ *  @param  c  The 32 bytes.
+ *  @return  Bytes set to 0xff where there is `\n` or `\0`.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto
+match_line_end_avx2(__m256i c) -> __m256i
+{
+    return _mm256_or_si256(_mm256_cmpeq_epi8(c, _mm256_set1_epi8('\n')),
+        _mm256_cmpeq_epi8(c, _mm256_setzero_si256()));
+}
+
+/**
+ *  @brief  Match identifier continuation in 32 bytes.
+ *
+ *  @param  c  The 32 bytes.
+ *  @return  Bytes set to 0xff where there is a-z, A-Z, 0-9 or _.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto
+match_identifier_avx2(__m256i c) -> __m256i
+{
+    auto zero  = _mm256_setzero_si256();
+    auto lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    auto alpha = _mm256_subs_epu8(
+        _mm256_sub_epi8(lower, _mm256_set1_epi8('a')), _mm256_set1_epi8(25));
+    auto digit = _mm256_subs_epu8(
+        _mm256_sub_epi8(c, _mm256_set1_epi8('0')), _mm256_set1_epi8(9));
+    auto under = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'));
+    return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(alpha, zero),
+        _mm256_cmpeq_epi8(digit, zero)), under);
+}
+
+/**
+ *  @brief  Skip whitespaces 32 bytes at a time.
+ *
+ *  @param  text   The null-terminated source code.
+ *  @param  index  The index to start skipping from.
+ *  @param  size   The size of the source code.
+ *  @return  Index of the first non-whitespace character.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static auto skip_whitespace_avx2(
+    const char *text,
+    std::size_t index,
+    std::size_t size
+) -> std::size_t
+{
+    while (index + 32 <= size)
+    {
+        auto c    = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(text + index));
+        auto mask = ~static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(match_whitespace_avx2(c)));
+        if (mask != 0)
+        {
+            return index + std::countr_zero(mask);
+        }
+        index += 32;
+    }
+    return skip_whitespace_sse2(text, index, size);
+}
+
+/**
+ *  @brief  Find the end of the line 32 bytes at a time.
+ *
+ *  @param  text   The null-terminated source code.
+ *  @param  index  The index to start searching from.
+ *  @param  size   The size of the source code.
+ *  @return  Index of the first `\n` or `\0`.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static auto find_line_end_avx2(
+    const char *text,
+    std::size_t index,
+    std::size_t size
+) -> std::size_t
+{
+    while (index + 32 <= size)
+    {
+        auto c    = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(text + index));
+        auto mask = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(match_line_end_avx2(c)));
+        if (mask != 0)
+        {
+            return index + std::countr_zero(mask);
+        }
+        index += 32;
+    }
+    return find_line_end_sse2(text, index, size);
+}
+
+/**
+ *  @brief  Skip identifier continuation 32 bytes at a time.
+ *
+ *  @param  text   The null-terminated source code.
+ *  @param  index  The index to start skipping from.
+ *  @param  size   The size of the source code.
+ *  @return  Index of the first character that cannot continue identifier.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static auto skip_identifier_avx2(
+    const char *text,
+    std::size_t index,
+    std::size_t size
+) -> std::size_t
+{
+    while (index + 32 <= size)
+    {
+        auto c    = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(text + index));
+        auto mask = ~static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(match_identifier_avx2(c)));
+        if (mask != 0)
+        {
+            return index + std::countr_zero(mask);
+        }
+        index += 32;
+    }
+    return skip_identifier_sse2(text, index, size);
+}
+
+/**
+ *  @brief  Check if the CPU and the OS support AVX2.
+ *  @return  True if AVX2 can be used.
+ */
+[[nodiscard]] static auto has_avx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx     = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // PLONS_LIBRARY_DTN_X86
+
+/**
+ *  @brief  Scanning kernels used by the tokenizer for long runs.
+ */
+struct scan_kernels {
+
+    /**
+     *  @brief  Skip whitespaces.
+     */
+    std::size_t (*skip_whitespace)(const char *, std::size_t, std::size_t);
+
+    /**
+     *  @brief  Find the end of the line.
+     */
+    std::size_t (*find_line_end)(const char *, std::size_t, std::size_t);
+
+    /**
+     *  @brief  Skip identifier continuation.
+     */
+    std::size_t (*skip_identifier)(const char *, std::size_t, std::size_t);
+};
+
+/**
+ *  @brief  Select the fastest scanning kernels supported by the CPU.
+ *  @return  The scanning kernels, selected once at runtime.
+ */
+[[nodiscard]] static auto get_scan_kernels() -> const scan_kernels &
+{
+    static const auto kernels = []()
+    {
+#if PLONS_LIBRARY_DTN_X86
+        if (has_avx2())
+        {
+            return scan_kernels {
+                skip_whitespace_avx2,
+                find_line_end_avx2,
+                skip_identifier_avx2
+            };
+        }
+
+        return scan_kernels {
+            skip_whitespace_sse2,
+            find_line_end_sse2,
+            skip_identifier_sse2
+        };
+#else
+        return scan_kernels {
+            skip_whitespace_scalar,
+            find_line_end_scalar,
+            skip_identifier_scalar
+        };
+#endif
+    }();
+
+    return kernels;
+}
+
+/**
+ *  @brief  Tokenizer over the source code, lexing one token at a time.
+ */
+struct lexer {
+
+    /**
+     *  @brief  The boundless source code.
+     */
+    cu::boundless_string_view src;
+
+    /**
+     *  @brief  The source code, always followed by `\0`.
+     */
+    const char *text;
+
+    /**
+     *  @brief  The size of the source code.
+     */
+    std::size_t size;
+
+    /**
+     *  @brief  The scanning kernels for long runs.
+     */
+    const scan_kernels &kernels;
+
+    /**
+     *  @brief  Receives identifiers and operators.
+     */
+    symbol_table &symbols;
+
+    /**
+     *  @brief  Receives the messages.
+     */
+    std::vector<message> &messages;
+
+    /**
+     *  @brief  Receives values of string literals with escape sequences.
+     */
+    std::vector<std::string> &decoded_strings;
+
+    /**
+     *  @brief  Receives values of numerical literals.
+     */
+    std::vector<number> &numbers;
+
+    /**
+     *  @brief  Buffer for decoding string literals with escape sequences.
+     */
+    std::string decoded;
+
+    /**
+     *  @brief  Creates the lexer over the source code.
+     *
+     *  @param  src              The source code.
+     *  @param  symbols          Receives identifiers and operators.
+     *  @param  messages         Receives the messages.
+     *  @param  decoded_strings  Receives values of string literals with
+     *                           escape sequences.
+     *  @param  numbers          Receives values of numerical literals.
+     */
+    inline lexer(
+        std::string_view          src,
+        symbol_table             &symbols,
+        std::vector<message>     &messages,
+        std::vector<std::string> &decoded_strings,
+        std::vector<number>      &numbers
+    ) : src(src), text(this->src.data()), size(this->src.size()),
+        kernels(get_scan_kernels()), symbols(symbols), messages(messages),
+        decoded_strings(decoded_strings), numbers(numbers) {}
+
+    /**
+     *  @brief  Creates the lexer over the source code.
+     *  @param  dtn  The source code's information, receives symbols,
+     *               messages, decoded strings and numbers.
+     */
+    inline lexer(detronade &dtn)
+        : lexer(dtn.source(), dtn.symbols, dtn.messages, dtn.decoded_strings,
+            dtn.numbers) {}
+
+    /**
+     *  @brief  Find the end of a char or string literal, skipping escape
+     *          sequences.
+     *
+     *  @param  begin  The beginning of the literal (the enclosing char).
+     *  @return  The offset just after the literal, or the end of the source
+     *           code if it is not closed.
+     */
+    [[nodiscard]] inline auto skip_literal(std::size_t begin) const
+    {
+        char        encloser = text[begin];
+        std::size_t index    = begin + 1;
+        while (index < size && text[index] != encloser)
+        {
+            index += text[index] == '\\' && index + 1 < size ? 2 : 1;
+        }
+        return std::min(index + 1, size);
+    }
+
+    /**
+     *  @brief  Lex the next token, skipping whitespaces and comments.
+     *
+     *  @param  index  The index to lex from, advanced past the token.
+     *  @param  tok    The lexed token.
+     *  @return  Whether a token was lexed.
+     *  @note  On error, @p index is advanced past the erroneous part, so
+     *         that lexing can continue from there.
+     */
+    [[nodiscard]] auto next(std::size_t &index, token &tok) -> lex_status;
+};
+
+/**
+ *  @brief  Lex the next token, skipping whitespaces and comments.
+ *
+ *  @param  index  The index to lex from, advanced past the token.
+ *  @param  tok    The lexed token.
+ *  @return  Whether a token was lexed.
+ *  @note  On error, @p index is advanced past the erroneous part, so that
+ *         lexing can continue from there.
+ */
+auto lexer::next(std::size_t &index, token &tok) -> lex_status
+{
+    auto make_token = [&](token_type type, std::size_t begin, auto value)
+    {
+        tok = token {
+            .type   = type,
+            .begin  = static_cast<std::uint32_t>(begin),
+            .length = static_cast<std::uint32_t>(index - begin),
+            .value  = value
+        };
+        return lex_status::token;
+    };
+
+    while (true)
+    {
+        switch (lex_starts[static_cast<unsigned char>(text[index])])
+        {
+        using enum lex_start;
+            case end: return lex_status::end;
+
+            case whitespace:
+                index = kernels.skip_whitespace(text, index + 1, size);
+                break;
+
+            // Skip comment
+            case comment:
+                index = kernels.find_line_end(text, index + 1, size);
+                break;
+
+            case char_literal:
+            {
+                std::size_t begin   = index;
+                auto        escaped = parse_string(messages, src, index,
+                    '\'', decoded);
+                if (!escaped.has_value())
+                {
+                    index = skip_literal(begin);
+                    return lex_status::error;
+                }
+
+                auto value = std::string_view(text + begin + 1,
+                    index - begin - 2);
+                if (escaped.value())
+                {
+                    value = decoded;
+                }
+
+                if (value.size() > 1)
+                {
+                    messages.emplace_back(message {
+                        .id          = message_id::too_many_characters,
+                        .severity    = message_severity::error,
+                        .pos         = {
+                            .begin   = begin,
+                            .length  = index - begin,
+                            .pointer = 2
+                        }
+                    });
+                    return lex_status::error;
+                }
+
+                if (value.size() < 1)
+                {
+                    messages.emplace_back(message {
+                        .id          = message_id::empty_char_literal,
+                        .severity    = message_severity::error,
+                        .pos         = {
+                            .begin   = begin,
+                            .length  = 2,
+                            .pointer = 1
+                        }
+                    });
+                    return lex_status::error;
+                }
+
+                return make_token(token_type::char_literal, begin,
+                    value.front());
+            }
+
+            case string_literal:
+            {
+                std::size_t begin   = index;
+                auto        escaped = parse_string(messages, src, index,
+                    '\"', decoded);
+                if (!escaped.has_value())
+                {
+                    index = skip_literal(begin);
+                    return lex_status::error;
+                }
+
+                if (!escaped.value())
+                {
+                    return make_token(token_type::string_literal, begin,
+                        std::monostate {});
+                }
+
+                auto decoded_index = static_cast<std::uint32_t>(
+                    decoded_strings.size());
+                decoded_strings.emplace_back(decoded);
+                return make_token(token_type::string_literal, begin,
+                    decoded_index);
+            }
+
+            case numerical_literal:
+            {
+                std::size_t begin = index;
+                do
+                {
+                    index++;
+                }
+                while (is_class(text[index], char_class::num_continue));
+
+                auto parsed_num = parse_number(messages, begin,
+                    src.substr(begin, index - begin));
+                if (!parsed_num.has_value())
+                {
+                    return lex_status::error;
+                }
+
+                auto number_index = static_cast<std::uint32_t>(
+                    numbers.size());
+                numbers.emplace_back(parsed_num.value());
+                return make_token(token_type::numerical_literal, begin,
+                    number_index);
+            }
+
+            case identifier:
+            {
+                std::size_t begin = index;
+                index = kernels.skip_identifier(text, index + 1, size);
+
+                return make_token(token_type::identifier, begin,
+                    symbols.intern(
+                        std::string_view(text + begin, index - begin)));
+            }
+
+            case operator_:
+            {
+                std::size_t begin = index;
+                do
+                {
+                    index++;
+                }
+                while (is_class(text[index], char_class::operator_));
+
+                return make_token(token_type::operator_, begin,
+                    symbols.intern(
+                        std::string_view(text + begin, index - begin)));
+            }
+
+            case punctuation:
+                index++;
+                return make_token(token_type::punctuation, index - 1,
+                    text[index - 1]);
+
+            case invalid:
+            {
                 messages.emplace_back(message {
-                    .msg         = msg,
+                    .id          = message_id::invalid_character,
                     .severity    = message_severity::error,
                     .pos         = {
-                        .begin   = begin,
-                        .length  = index,
-                        .pointer = 2
-                    }
+                        .begin   = index,
+                        .length  = 1,
+                        .pointer = 0
+                    },
+                    .args        = { text[index] }
                 });
-                return std::nullopt;
+
+                // Report a run of invalid characters (such as a multi-byte
+                // character) once
+                do
+                {
+                    index++;
+                }
+                while (lex_starts[static_cast<unsigned char>(text[index])]
+                    == invalid);
+                return lex_status::error;
+            }
+        }
+    }
+}
+
+/**
+ *  @brief  Check if the source code fits in the 32-bit offsets of tokens.
+ *
+ *  @param  dtn  The source code's information.
+ *  @return  True if the source code can be tokenized.
+ */
+[[nodiscard]] static inline constexpr auto check_source_size(detronade &dtn)
+{
+    if (dtn.source().size() > std::numeric_limits<std::uint32_t>::max())
+    {
+        dtn.messages.emplace_back(message {
+            .id       = message_id::source_too_large,
+            .severity = message_severity::error
+        });
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Part of the source code that is tokenized by a thread.
+ */
+struct lexed_chunk {
+
+    /**
+     *  @brief  The offset where the chunk begins, just after a newline.
+     */
+    std::size_t begin;
+
+    /**
+     *  @brief  The offset where the next chunk begins.
+     */
+    std::size_t end;
+
+    /**
+     *  @brief  Tokens that begin in the chunk.
+     */
+    std::vector<token> tokens = {};
+
+    /**
+     *  @brief  Number of messages that were reported before each token.
+     */
+    std::vector<std::size_t> message_marks = {};
+
+    /**
+     *  @brief  Messages reported by the chunk.
+     */
+    std::vector<message> messages = {};
+
+    /**
+     *  @brief  Values of the chunk's string literals with escape sequences.
+     */
+    std::vector<std::string> decoded_strings = {};
+
+    /**
+     *  @brief  Values of the chunk's numerical literals.
+     */
+    std::vector<number> numbers = {};
+
+    /**
+     *  @brief  Identifiers and operators of the chunk.
+     */
+    symbol_table symbols = {};
+
+    /**
+     *  @brief  The offset just after the last token.
+     */
+    std::size_t index = 0;
+
+    /**
+     *  @brief  What ended the chunk, @c lex_status::token when the next
+     *          token begins in the next chunk.
+     */
+    lex_status status = lex_status::token;
+
+    /**
+     *  @brief  Tokenize the chunk.
+     *
+     *  @param  src      The source code.
+     *  @param  options  Options for compiling the source code.
+     */
+    inline auto tokenize(std::string_view src, const compile_options &options)
+    {
+        lexer       lex(src, symbols, messages, decoded_strings, numbers);
+        token       tok    = {};
+        std::size_t errors = 0;
+        index              = begin;
+
+        while (true)
+        {
+            std::size_t item_index    = index;
+            std::size_t message_count = messages.size();
+
+            status = lex.next(index, tok);
+
+            // Leave it for the next chunk
+            if ((status == lex_status::token && tok.begin >= end)
+             || (status == lex_status::error && options.recover_errors
+             && index > end))
+            {
+                index  = item_index;
+                status = lex_status::token;
+                messages.resize(message_count);
+                break;
+            }
+
+            if (status == lex_status::token)
+            {
+                message_marks.emplace_back(message_count);
+                tokens.emplace_back(tok);
+                continue;
+            }
+
+            if (status == lex_status::error && options.recover_errors
+             && ++errors < options.max_errors)
+            {
+                continue;
             }
+            break;
+        }
+    }
+};
+
+/**
+ *  @brief  Count the lexical error, and check whether to keep tokenizing.
+ *
+ *  @param  dtn     The source code's information.
+ *  @param  errors  Number of errors so far, which is incremented.
+ *  @return  True if tokenizing continues.
+ */
+[[nodiscard]] static inline constexpr auto recover_error(
+    detronade   &dtn,
+    std::size_t &errors
+)
+{
+    errors++;
+    if (!dtn.options.recover_errors)
+    {
+        return false;
+    }
+
+    if (errors < dtn.options.max_errors)
+    {
+        return true;
+    }
+
+    dtn.messages.emplace_back(message {
+        .id       = message_id::too_many_errors,
+        .severity = message_severity::note,
+        .pos      = dtn.messages.back().pos,
+        .args     = { static_cast<std::uint32_t>(errors) }
+    });
+    return false;
+}
+
+/**
+ *  @brief  Tokenize the source code in chunks on multiple threads.
+ *
+ *  Each chunk is tokenized as if a token began at its beginning, which is
+ *  not the case when the newline before it is in a string literal.  While
+ *  stitching, the source code after each chunk is tokenized again until a
+ *  token begins where a token of a later chunk began, since the tokenizer
+ *  carries no state between tokens.  Usually, that is the first token.
+ *
+ *  @param  dtn      The source code's information.
+ *  @param  threads  Number of threads to use.
+ *  @return  Individual tokens of the source code, identical to tokenizing
+ *           it on a single thread.
+ */
+[[nodiscard]] static auto tokenize_chunks(detronade &dtn, std::size_t threads)
+-> std::optional<std::vector<token>>
+{
+    auto src        = dtn.source();
+    auto chunk_size = std::max<std::size_t>(dtn.options.chunk_size, 1);
 
-            if (string.value().size() < 1)
+    std::vector<lexed_chunk> chunks = {};
+    std::size_t              begin  = 0;
+    while (begin < src.size())
+    {
+        std::size_t end = src.size();
+        if (src.size() - begin > chunk_size)
+        {
+            auto newline = src.find('\n', begin + chunk_size);
+            if (newline != std::string_view::npos)
             {
-                auto msg = std::format("Char literal cannot be empty");
-                messages.emplace_back(message {
-                    .msg         = msg,
-                    .severity    = message_severity::error,
-                    .pos         = {
-                        .begin   = begin,
-                        .length  = 2,
-                        .pointer = 1
-                    }
-                });
-                return std::nullopt;
+                end = newline + 1;
             }
+        }
+
+        chunks.emplace_back(lexed_chunk {
+            .begin = begin,
+            .end   = end
+        });
+        begin = end;
+    }
 
-            tokens.emplace_back(token {
-                .type  = token_type::char_literal,
-                .value = string.value().front()
+    std::atomic<std::size_t> next_chunk = 0;
+    {
+        std::vector<std::jthread> workers = {};
+        threads = std::min(threads, chunks.size());
+        for (std::size_t i = 0; i < threads; i++)
+        {
+            workers.emplace_back([&]
+            {
+                std::size_t chunk;
+                while ((chunk = next_chunk++) < chunks.size())
+                {
+                    chunks[chunk].tokenize(src, dtn.options);
+                }
             });
         }
-        else if (src[index] == '\"')
+    }
+
+    std::vector<token> tokens = {};
+    lexer              lex(dtn);
+    token              tok    = {};
+    std::size_t        chunk  = 0;
+    std::size_t        from   = 0;
+    std::size_t        errors = 0;
+
+    // Messages of the chunk to take, which is every message of the first
+    // chunk, or the messages from the token where the chunk agrees
+    std::size_t from_message = 0;
+
+    std::size_t num_tokens = 0;
+    for (auto &lexed : chunks)
+    {
+        num_tokens += lexed.tokens.size();
+    }
+    tokens.reserve(num_tokens);
+
+    while (true)
+    {
+        // Take the chunk's tokens from where it agrees with the source code
+        auto &current    = chunks[chunk];
+        auto  symbol_ids = std::vector<std::uint32_t>(
+            current.symbols.names.size(),
+            std::numeric_limits<std::uint32_t>::max());
+
+        // Messages are taken in order with the tokens, so that nothing after
+        // the error that stops tokenizing is taken
+        std::size_t message       = from_message;
+        auto        take_messages = [&](std::size_t until)
+        {
+            for (; message < until; message++)
+            {
+                dtn.messages.emplace_back(current.messages[message]);
+                if (current.messages[message].severity
+                    == message_severity::error && !recover_error(dtn, errors))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        for (std::size_t i = from; i < current.tokens.size(); i++)
         {
-            auto string = parse_string(messages, src, index, '\"');
-            if (!string.has_value())
+            if (!take_messages(current.message_marks[i]))
             {
                 return std::nullopt;
             }
 
-            tokens.emplace_back(token {
-                .type  = token_type::string_literal,
-                .value = string.value()
-            });
+            auto copied = current.tokens[i];
+            switch (copied.type)
+            {
+            using enum token_type;
+                case identifier:
+                case operator_:
+                {
+                    auto  local = std::get<std::uint32_t>(copied.value);
+                    auto &id    = symbol_ids[local];
+                    if (id == std::numeric_limits<std::uint32_t>::max())
+                    {
+                        id = dtn.symbols.intern(current.symbols.name(local));
+                    }
+                    copied.value = id;
+                    break;
+                }
+
+                case string_literal:
+                    if (std::holds_alternative<std::uint32_t>(copied.value))
+                    {
+                        auto index   = std::get<std::uint32_t>(copied.value);
+                        copied.value = static_cast<std::uint32_t>(
+                            dtn.decoded_strings.size());
+                        dtn.decoded_strings.emplace_back(
+                            std::move(current.decoded_strings[index]));
+                    }
+                    break;
+
+                case numerical_literal:
+                {
+                    auto index   = std::get<std::uint32_t>(copied.value);
+                    copied.value = static_cast<std::uint32_t>(
+                        dtn.numbers.size());
+                    dtn.numbers.emplace_back(current.numbers[index]);
+                    break;
+                }
+
+                default: break;
+            }
+            tokens.emplace_back(copied);
         }
-        else if (num_start.contains(src[index]))
+
+        if (!take_messages(current.messages.size()))
         {
-            std::size_t begin = index;
-            index++;
+            return std::nullopt;
+        }
+
+        if (current.status == lex_status::end)
+        {
+            return errors == 0 ? std::optional(std::move(tokens))
+                               : std::nullopt;
+        }
+
+        // Tokenize until a token agrees with a later chunk
+        std::size_t index = current.index;
+        while (true)
+        {
+            std::size_t message_count = dtn.messages.size();
+            std::size_t decoded_count = dtn.decoded_strings.size();
+            std::size_t number_count  = dtn.numbers.size();
 
-            while (num_continue.contains(src[index]))
+            auto status = lex.next(index, tok);
+            if (status == lex_status::end)
             {
-                index++;
+                return errors == 0 ? std::optional(std::move(tokens))
+                                   : std::nullopt;
             }
 
-            auto parsed_num = parse_number(messages, begin,
-                std::string(src.substr(begin, index - begin)));
-            if (!parsed_num.has_value())
+            if (status == lex_status::error)
             {
-                return std::nullopt;
+                if (!recover_error(dtn, errors))
+                {
+                    return std::nullopt;
+                }
+                continue;
             }
 
-            tokens.emplace_back(token {
-                .type  = token_type::numerical_literal,
-                .value = parsed_num.value()
-            });
-        }
-        else if (id_start.contains(src[index]))
-        {
-            std::size_t begin = index;
-            index++;
+            while (chunk + 1 < chunks.size()
+                && chunks[chunk + 1].begin <= tok.begin)
+            {
+                chunk++;
+            }
 
-            while (id_continue.contains(src[index]))
+            auto &later = chunks[chunk];
+            auto  found = stdr::lower_bound(later.tokens, tok.begin, {},
+                &token::begin);
+            if (found != later.tokens.end() && found->begin == tok.begin)
             {
-                index++;
+                // The chunk reports this token on its own
+                dtn.messages.resize(message_count);
+                dtn.decoded_strings.resize(decoded_count);
+                dtn.numbers.resize(number_count);
+                from         = found - later.tokens.begin();
+                from_message = later.message_marks[from];
+                break;
             }
 
-            tokens.emplace_back(token {
-                .type  = token_type::identifier,
-                .value = std::string(src.substr(begin, index - begin))
-            });
+            tokens.emplace_back(tok);
         }
-        else if (operators.contains(src[index]))
+    }
+}
+
+/**
+ *  @brief  Tokenize the source code.
+ *  @return  Individual tokens of the source code.
+ */
+[[nodiscard]] auto detronade::tokenize()
+-> std::optional<std::vector<token>>
+{
+    auto threads = options.threads;
+    if (threads == 0)
+    {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // The tokens replace the previous ones, and so do their literals
+    decoded_strings.clear();
+    numbers.clear();
+
+    if (threads > 1 && source().size() > options.chunk_size)
+    {
+        // Tokens refer to the source code using 32-bit offsets
+        if (!check_source_size(*this))
         {
-            std::size_t begin = index;
-            index++;
+            return std::nullopt;
+        }
+        return tokenize_chunks(*this, threads);
+    }
 
-            while (operators.contains(src[index]))
-            {
-                index++;
-            }
+    token_cursor       cursor(*this, 0);
+    std::vector<token> tokens = {};
 
-            tokens.emplace_back(token {
-                .type  = token_type::operator_,
-                .value = std::string(src.substr(begin, index - begin))
-            });
+    // Take the whole batch at once
+    while (cursor.peek())
+    {
+        tokens.insert(tokens.end(), cursor.buffer.begin() + cursor.position,
+            cursor.buffer.end());
+        cursor.position = cursor.buffer.size();
+    }
+
+    if (cursor.failed())
+    {
+        return std::nullopt;
+    }
+    return tokens;
+}
+
+/**
+ *  @brief  Creates the cursor at the beginning of the source code.
+ *
+ *  @param  dtn        The source code's information.
+ *  @param  lookahead  Maximum number of tokens that can be peeked after the
+ *                     current token.
+ *  @note  Literals are appended to the decoded strings and numbers of the
+ *         source code's information, so that its tokens remain valid.
+ */
+token_cursor::token_cursor(detronade &dtn, std::size_t lookahead)
+    : dtn(&dtn), lookahead(lookahead)
+{
+    buffer.reserve(lookahead + batch_size);
+
+    // Tokens refer to the source code using 32-bit offsets
+    if (!check_source_size(dtn))
+    {
+        status = lex_status::error;
+        errors = 1;
+    }
+}
+
+/**
+ *  @brief  Lex the next batch of tokens into the buffer, discarding the
+ *          consumed tokens.
+ */
+auto token_cursor::fill() -> void
+{
+    buffer.erase(buffer.begin(), buffer.begin() + position);
+    position = 0;
+
+    lexer lex(*dtn);
+    token tok = {};
+    while (buffer.size() < lookahead + batch_size)
+    {
+        status = lex.next(index, tok);
+        if (status == lex_status::error && recover_error(*dtn, errors))
+        {
+            status = lex_status::token;
+            continue;
+        }
+
+        if (status != lex_status::token)
+        {
+            return;
+        }
+        buffer.emplace_back(tok);
+    }
+}
+
+/**
+ *  @brief  Get the offset that the item holds, where the items from
+ *          @p moved on are @p shift away from the offset they store.
+ *
+ *  @param  stored  The offset stored in the item.
+ *  @param  index   Index of the item.
+ *  @param  moved   Index of the first moved item.
+ *  @param  shift   How far the moved items were moved.
+ *  @return  The offset of the item.
+ */
+[[nodiscard]] static constexpr auto moved_offset(
+    std::size_t    stored,
+    std::size_t    index,
+    std::size_t    moved,
+    std::ptrdiff_t shift
+) -> std::size_t
+{
+    if (index < moved)
+    {
+        return stored;
+    }
+    return static_cast<std::size_t>(static_cast<std::ptrdiff_t>(stored)
+        + shift);
+}
+
+/**
+ *  @brief  Replace a range of items ordered by offset, and move the items
+ *          after the range without rewriting their offsets.
+ *
+ *  Only the items between the range and @p moved get their offsets
+ *  rewritten, so the cost of an edit grows with its distance from the
+ *  previous edit rather than with the number of items.  The items after
+ *  the range are moved in memory only if the range changes size.
+ *
+ *  @param  items        The items.
+ *  @param  first        Index of the first item to replace.
+ *  @param  last         Index after the last item to replace.
+ *  @param  replacement  The new items, with offsets after the edit.
+ *  @param  delta        How far the items after the range move.
+ *  @param  moved        Index of the first moved item, updated.
+ *  @param  shift        How far the moved items were moved, updated.
+ *  @param  offset_of    Gets a reference to the offset stored in an item.
+ */
+template<typename T, typename F>
+static auto splice_moved(
+    std::vector<T>     &items,
+    std::size_t         first,
+    std::size_t         last,
+    std::span<const T>  replacement,
+    std::ptrdiff_t      delta,
+    std::size_t        &moved,
+    std::ptrdiff_t     &shift,
+    F                   offset_of
+)
+{
+    auto move = [&](std::size_t from, std::size_t to, std::ptrdiff_t by)
+    {
+        for (auto i = from; i < to; i++)
+        {
+            auto &offset = offset_of(items[i]);
+            offset = static_cast<std::remove_cvref_t<decltype(offset)>>(
+                static_cast<std::ptrdiff_t>(offset) + by);
+        }
+    };
+
+    // The items between the previous edit and this one either stay or move
+    // with the rest, whichever keeps the moved items after the range
+    if (shift != 0 && moved < first)
+    {
+        move(moved, first, shift);
+        moved = last;
+    }
+    else if (shift != 0 && moved > last)
+    {
+        move(last, moved, delta);
+    }
+    else
+    {
+        moved = last;
+    }
+    shift += delta;
+
+    auto kept = std::min(last - first, replacement.size());
+    stdr::copy(replacement.first(kept), items.begin() + first);
+    if (kept < replacement.size())
+    {
+        items.insert(items.begin() + last, replacement.begin() + kept,
+            replacement.end());
+    }
+    else
+    {
+        items.erase(items.begin() + first + kept, items.begin() + last);
+    }
+    moved = moved - (last - first) + replacement.size();
+}
+
+/**
+ *  @brief  Move the literal at the end of the values into a free slot, so
+ *          that the values do not grow with every edit.
+ *
+ *  @param  values  The values of the literals.
+ *  @param  slots   The free slots of the values.
+ *  @param  tok     The token of the literal at the end of the values.
+ */
+template<typename T>
+static auto reuse_slot(
+    std::vector<T>             &values,
+    std::vector<std::uint32_t> &slots,
+    token                      &tok
+)
+{
+    if (slots.empty())
+    {
+        return;
+    }
+
+    auto slot = slots.back();
+    slots.pop_back();
+    values[slot] = std::move(values.back());
+    values.pop_back();
+    tok.value = slot;
+}
+
+/**
+ *  @brief  Check if the lexer reported an error for the tokens.
+ *
+ *  @param  dtn  The source code's information.
+ *  @return  True if any message of the lexer is an error.
+ */
+[[nodiscard]] static auto has_lexical_errors(const detronade &dtn)
+{
+    return stdr::any_of(stdr::subrange(dtn.messages.begin(),
+        dtn.messages.begin() + dtn.lexed_messages), [](const message &msg)
+        {
+            return msg.severity == message_severity::error;
+        });
+}
+
+/**
+ *  @brief  Replace the range of the source code with the text, and
+ *          re-tokenize only the affected part of the source code.
+ *
+ *  @param  begin  The beginning of the range to replace.
+ *  @param  end    The end of the range to replace (exclusive).
+ *  @param  text   The replacement text.
+ *  @return  True if the source code has no lexical errors after the edit.
+ */
+auto detronade::edit(
+    std::size_t      begin,
+    std::size_t      end,
+    std::string_view text
+) -> bool
+{
+    // Edits require an owned source code
+    if (mapped_source)
+    {
+        source_code = std::string(source());
+        mapped_source.reset();
+    }
+
+    end   = std::min(end, source_code.size());
+    begin = std::min(begin, end);
+
+    // Without valid tokens to patch, lex the whole source code as if the
+    // edit replaced nothing
+    if (!tokens_valid)
+    {
+        source_code.replace(begin, end - begin, text);
+        messages.clear();
+        tokens.clear();
+        decoded_strings.clear();
+        numbers.clear();
+        free_strings.clear();
+        free_numbers.clear();
+        line_starts    = index_lines(source());
+        lexed_messages = 0;
+        moved_tokens   = 0;
+        token_shift    = 0;
+        moved_lines    = 0;
+        line_shift     = 0;
+        begin          = 0;
+        end            = 0;
+        text           = {};
+    }
+
+    // Messages of the parser and the compiler are reported again when the
+    // tokens are parsed again
+    messages.resize(lexed_messages);
+
+    auto delta = static_cast<std::ptrdiff_t>(text.size())
+               - static_cast<std::ptrdiff_t>(end - begin);
+    auto token_end = [&](std::size_t index)
+    {
+        return offset(index) + tokens[index].length;
+    };
+    auto line_start = [&](std::size_t index)
+    {
+        return moved_offset(line_starts[index], index, moved_lines,
+            line_shift);
+    };
+
+    // Tokens ending before the edit are unaffected, including the character
+    // that terminated them.  Re-lex from the end of the last such token
+    auto token_indices = stdv::iota(std::size_t {0}, tokens.size());
+    auto first_index   = *stdr::lower_bound(token_indices, begin, {},
+        token_end);
+    std::size_t relex_begin = first_index == 0
+                            ? 0
+                            : token_end(first_index - 1);
+
+    // Patch line index
+    auto line_indices = stdv::iota(std::size_t {0}, line_starts.size());
+    auto line_first   = *stdr::upper_bound(line_indices, begin, {},
+        line_start);
+    auto line_last    = *stdr::upper_bound(line_indices, end, {},
+        line_start);
+
+    std::vector<std::size_t> new_lines = {};
+    for (std::size_t i = 0; i < text.size(); i++)
+    {
+        if (text[i] == '\n')
+        {
+            new_lines.emplace_back(begin + i + 1);
+        }
+    }
+    splice_moved<std::size_t>(line_starts, line_first, line_last, new_lines,
+        delta, moved_lines, line_shift,
+        [](std::size_t &line) -> std::size_t & { return line; });
+    num_lines = line_starts.size();
+
+    source_code.replace(begin, end - begin, text);
+
+    // The tokens are patched to the end, or not at all
+    tokens_valid = false;
+    stale        = false;
+    if (!check_source_size(*this))
+    {
+        compilation_successful = false;
+        return false;
+    }
+
+    // Re-lex until a token begins after the edit where an old token began.
+    // From there on the lexer would see the same text as before, so the rest
+    // of the old tokens are reused
+    std::vector<token> relexed      = {};
+    lexer              lex(*this);
+    token              tok          = {};
+    std::size_t        index        = relex_begin;
+    std::size_t        sync         = tokens.size();
+    std::size_t        old_messages = messages.size();
+
+    while (true)
+    {
+        std::size_t message_count = messages.size();
+        std::size_t decoded_count = decoded_strings.size();
+        std::size_t number_count  = numbers.size();
+
+        // Lexical errors leave no token, and lexing continues after them
+        auto status = lex.next(index, tok);
+        if (status == lex_status::error)
+        {
+            continue;
+        }
+
+        if (status == lex_status::end)
+        {
+            break;
         }
-        else if (punctuations.contains(src[index]))
+
+        if (tok.begin >= begin + text.size())
         {
-            while (punctuations.contains(src[index]))
+            auto old_begin = static_cast<std::size_t>(tok.begin - delta);
+            auto old       = *stdr::lower_bound(
+                stdv::iota(first_index, tokens.size()), old_begin, {},
+                [&](std::size_t i) { return offset(i); });
+            if (old != tokens.size() && offset(old) == old_begin)
             {
-                tokens.emplace_back(token {
-                    .type  = token_type::punctuation,
-                    .value = src[index]
-                });
-                index++;
+                // The old token keeps its literal and its messages, drop
+                // the ones just added
+                messages.resize(message_count);
+                decoded_strings.resize(decoded_count);
+                numbers.resize(number_count);
+                sync = old;
+                break;
             }
         }
-        else
+
+        relexed.emplace_back(tok);
+    }
+
+    // Messages of the re-lexed part were reported again by the lexer
+    std::size_t sync_begin = sync == tokens.size()
+                           ? std::numeric_limits<std::size_t>::max()
+                           : offset(sync);
+    auto        kept_end   = std::remove_if(messages.begin(),
+        messages.begin() + old_messages, [&](const message &msg)
         {
-            auto msg = std::format("Invalid character {}`{}`{} in source code",
-                bold + white, src[index], !(bold + white));
-            messages.emplace_back(message {
-                .msg         = msg,
-                .severity    = message_severity::error,
-                .pos         = {
-                    .begin   = index,
-                    .length  = 1,
-                    .pointer = 0
-                }
-            });
-            return std::nullopt;
+            return msg.pos.begin >= relex_begin && msg.pos.begin < sync_begin;
+        });
+    auto        moved      = std::find_if(messages.begin(), kept_end,
+        [&](const message &msg) { return msg.pos.begin >= sync_begin; });
+    for (auto it = moved; it != kept_end; it++)
+    {
+        it->pos.begin = static_cast<std::size_t>(
+            static_cast<std::ptrdiff_t>(it->pos.begin) + delta);
+    }
+
+    // Keep the messages in the order of the source code, with the new
+    // messages before those of the moved tokens
+    auto moved_index = moved - messages.begin();
+    auto new_index   = kept_end - messages.begin();
+    messages.erase(kept_end, messages.begin() + old_messages);
+    std::rotate(messages.begin() + moved_index,
+        messages.begin() + new_index, messages.end());
+    lexed_messages = messages.size();
+
+    // Literals of the replaced tokens are no longer referred to, and those
+    // of the new tokens were added to the end.  Fill the free slots from the
+    // end
+    for (auto i = first_index; i < sync; i++)
+    {
+        if (tokens[i].type == token_type::numerical_literal)
+        {
+            free_numbers.emplace_back(std::get<std::uint32_t>(
+                tokens[i].value));
+        }
+        else if (tokens[i].type == token_type::string_literal
+              && std::holds_alternative<std::uint32_t>(tokens[i].value))
+        {
+            free_strings.emplace_back(std::get<std::uint32_t>(
+                tokens[i].value));
+        }
+    }
+    for (auto &tok : relexed | stdv::reverse)
+    {
+        if (tok.type == token_type::numerical_literal)
+        {
+            reuse_slot(numbers, free_numbers, tok);
+        }
+        else if (tok.type == token_type::string_literal
+              && std::holds_alternative<std::uint32_t>(tok.value))
+        {
+            reuse_slot(decoded_strings, free_strings, tok);
         }
     }
 
-    return tokens;
+    splice_moved<token>(tokens, first_index, sync, relexed, delta,
+        moved_tokens, token_shift,
+        [](token &tok) -> std::uint32_t & { return tok.begin; });
+
+    // Parsing and compiling cost as much as the whole source code, so leave
+    // them to the next run
+    tokens_valid = true;
+    stale        = true;
+    return !has_lexical_errors(*this);
+}
+
+/**
+ *  @brief  Parse and compile the tokens again if @c edit changed them.
+ *  @return  True if the syntax tree and the bytecode are valid.
+ */
+auto detronade::rebuild() -> bool
+{
+    if (!stale)
+    {
+        return compilation_successful;
+    }
+
+    stale                  = false;
+    compilation_successful = false;
+    if (has_lexical_errors(*this))
+    {
+        return false;
+    }
+
+    auto tree = parse();
+    if (!tree.has_value())
+    {
+        compilation_successful = false;
+        return false;
+    }
+
+    this->tree   = std::move(tree.value());
+    auto program = generate();
+    if (!program.has_value())
+    {
+        compilation_successful = false;
+        return false;
+    }
+
+    bytecode = std::make_shared<const dtn::program>(
+        std::move(program.value()));
+    compilation_successful = true;
+    return true;
 }
@@ -0,0 +1,1234 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Batch evaluation and builtin functions of Detronade,
+ *           implementations of @c detronade::compile_batch and
+ *           @c builtins from @c plons_detronade.hpp .
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "plons_detronade.hpp"
+
+using namespace plons::dtn;
+
+// SSE2 is the baseline for x86-64, AVX2 is selected at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+#define PLONS_LIBRARY_DTN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define PLONS_LIBRARY_DTN_AVX2
+#else
+#define PLONS_LIBRARY_DTN_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define PLONS_LIBRARY_DTN_X86 0
+#endif
+
+// Lane kernels compute a = expr of x = b and y = c for n rows, with y = x
+// when c is nullptr.  The vector kernels finish the rows that do not fill
+// a vector with the scalar kernel
+#define PLONS_LIBRARY_DTN_SCALAR_LANES(name, expr)                           \
+    static auto name##_scalar(                                               \
+        double       *a,                                                     \
+        const double *b,                                                     \
+        const double *c,                                                     \
+        std::size_t   n                                                      \
+    ) -> void                                                                \
+    {                                                                        \
+        for (std::size_t i = 0; i < n; i++)                                  \
+        {                                                                    \
+            [[maybe_unused]] auto x = b[i];                                  \
+            [[maybe_unused]] auto y = c ? c[i] : x;                          \
+            a[i] = (expr);                                                   \
+        }                                                                    \
+    }
+
+#define PLONS_LIBRARY_DTN_SSE2_LANES(name, expr)                             \
+    static auto name##_sse2(                                                 \
+        double       *a,                                                     \
+        const double *b,                                                     \
+        const double *c,                                                     \
+        std::size_t   n                                                      \
+    ) -> void                                                                \
+    {                                                                        \
+        std::size_t i = 0;                                                   \
+        for (; i + 2 <= n; i += 2)                                           \
+        {                                                                    \
+            [[maybe_unused]] auto x = _mm_loadu_pd(b + i);                   \
+            [[maybe_unused]] auto y = c ? _mm_loadu_pd(c + i) : x;           \
+            _mm_storeu_pd(a + i, (expr));                                    \
+        }                                                                    \
+        name##_scalar(a + i, b + i, c ? c + i : c, n - i);                   \
+    }
+
+#define PLONS_LIBRARY_DTN_AVX2_LANES(name, expr)                             \
+    PLONS_LIBRARY_DTN_AVX2 static auto name##_avx2(                          \
+        double       *a,                                                     \
+        const double *b,                                                     \
+        const double *c,                                                     \
+        std::size_t   n                                                      \
+    ) -> void                                                                \
+    {                                                                        \
+        std::size_t i = 0;                                                   \
+        for (; i + 4 <= n; i += 4)                                           \
+        {                                                                    \
+            [[maybe_unused]] auto x = _mm256_loadu_pd(b + i);                \
+            [[maybe_unused]] auto y = c ? _mm256_loadu_pd(c + i) : x;        \
+            _mm256_storeu_pd(a + i, (expr));                                 \
+        }                                                                    \
+        name##_scalar(a + i, b + i, c ? c + i : c, n - i);                   \
+    }
+
+// Math kernels compute expr like the lane kernels, where expr clears the
+// lanes of `fast` that it cannot compute accurately, such as arguments out
+// of range and special values.  Those rows are computed by the scalar
+// kernel instead
+#define PLONS_LIBRARY_DTN_AVX2_MATH(name, expr)                              \
+    PLONS_LIBRARY_DTN_AVX2 static auto name##_avx2(                          \
+        double       *a,                                                     \
+        const double *b,                                                     \
+        const double *c,                                                     \
+        std::size_t   n                                                      \
+    ) -> void                                                                \
+    {                                                                        \
+        std::size_t i = 0;                                                   \
+        for (; i + 4 <= n; i += 4)                                           \
+        {                                                                    \
+            [[maybe_unused]] auto x = _mm256_loadu_pd(b + i);                \
+            [[maybe_unused]] auto y = c ? _mm256_loadu_pd(c + i) : x;        \
+            auto fast   = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));       \
+            auto result = (expr);                                            \
+            auto slow   = ~_mm256_movemask_pd(fast) & 0xf;                   \
+            if (slow != 0)                                                   \
+            {                                                                \
+                alignas(32) std::array<double, 4> rows;                      \
+                _mm256_store_pd(rows.data(), result);                        \
+                for (; slow != 0; slow &= slow - 1)                          \
+                {                                                            \
+                    auto j = std::countr_zero(static_cast<unsigned>(slow));  \
+                    name##_scalar(rows.data() + j, b + i + j,                \
+                        c ? c + i + j : c, 1);                               \
+                }                                                            \
+                result = _mm256_load_pd(rows.data());                        \
+            }                                                                \
+            _mm256_storeu_pd(a + i, result);                                 \
+        }                                                                    \
+        name##_scalar(a + i, b + i, c ? c + i : c, n - i);                   \
+    }
+
+/**
+ *  @brief  Number of rows that each instruction is applied to at once.
+ *          The registers of a block stay in the cache.
+ */
+static constexpr std::size_t block_size = 256;
+
+PLONS_LIBRARY_DTN_SCALAR_LANES(add, x + y)
+PLONS_LIBRARY_DTN_SCALAR_LANES(subtract, x - y)
+PLONS_LIBRARY_DTN_SCALAR_LANES(multiply, x * y)
+PLONS_LIBRARY_DTN_SCALAR_LANES(divide, x / y)
+PLONS_LIBRARY_DTN_SCALAR_LANES(negate, -x)
+
+PLONS_LIBRARY_DTN_SCALAR_LANES(sqrt, std::sqrt(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(cbrt, std::cbrt(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(exp, std::exp(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(log, c ? std::log(x) / std::log(y)
+                                      : std::log(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(sin, std::sin(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(cos, std::cos(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(tan, std::tan(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(asin, std::asin(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(acos, std::acos(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(atan, std::atan(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(atan2, std::atan2(x, y))
+PLONS_LIBRARY_DTN_SCALAR_LANES(abs, std::abs(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(floor, std::floor(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(ceil, std::ceil(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(round, std::round(x))
+PLONS_LIBRARY_DTN_SCALAR_LANES(pow, std::pow(x, y))
+PLONS_LIBRARY_DTN_SCALAR_LANES(min, std::min(x, y))
+PLONS_LIBRARY_DTN_SCALAR_LANES(max, std::max(x, y))
+
+#if PLONS_LIBRARY_DTN_X86
+
+// `std::min` and `std::max` return x unless y is strictly less or greater,
+// the instructions return the second operand unless the first one is
+PLONS_LIBRARY_DTN_SSE2_LANES(add, _mm_add_pd(x, y))
+PLONS_LIBRARY_DTN_SSE2_LANES(subtract, _mm_sub_pd(x, y))
+PLONS_LIBRARY_DTN_SSE2_LANES(multiply, _mm_mul_pd(x, y))
+PLONS_LIBRARY_DTN_SSE2_LANES(divide, _mm_div_pd(x, y))
+PLONS_LIBRARY_DTN_SSE2_LANES(negate, _mm_xor_pd(x, _mm_set1_pd(-0.0)))
+PLONS_LIBRARY_DTN_SSE2_LANES(sqrt, _mm_sqrt_pd(x))
+PLONS_LIBRARY_DTN_SSE2_LANES(abs, _mm_andnot_pd(_mm_set1_pd(-0.0), x))
+PLONS_LIBRARY_DTN_SSE2_LANES(min, _mm_min_pd(y, x))
+PLONS_LIBRARY_DTN_SSE2_LANES(max, _mm_max_pd(y, x))
+
+/**
+ *  @brief  Adding this to a real below 2^51 in magnitude rounds it to an
+ *          integer, held by the low bits of the sum.
+ */
+static constexpr double round_shifter = 0x1.8p52;
+
+/**
+ *  @brief  Upper 32 bits of ln(2), whose products with exponents are
+ *          exact.
+ */
+static constexpr double ln2_hi = 0x1.62e42feep-1;
+
+/**
+ *  @brief  The rest of ln(2).
+ */
+static constexpr double ln2_lo = 0x1.a39ef35793c76p-33;
+
+/**
+ *  @brief  Upper 33 bits of pi / 2.
+ */
+static constexpr double pi_2_hi = 0x1.921fb544p+0;
+
+/**
+ *  @brief  The next 33 bits of pi / 2.
+ */
+static constexpr double pi_2_mid = 0x1.0b4611a6p-34;
+
+/**
+ *  @brief  The rest of pi / 2.
+ */
+static constexpr double pi_2_lo = 0x1.3198a2e037073p-69;
+
+/**
+ *  @brief  Coefficients of e^r from r^13 / 13! to r^2 / 2!.  The rest of
+ *          the series is below 2^-57 for |r| <= ln(2) / 2.
+ */
+static constexpr auto exp_coefficients = std::to_array<double>({
+    1.0 / 6227020800, 1.0 / 479001600, 1.0 / 39916800, 1.0 / 3628800,
+    1.0 / 362880, 1.0 / 40320, 1.0 / 5040, 1.0 / 720, 1.0 / 120,
+    1.0 / 24, 1.0 / 6, 1.0 / 2
+});
+
+/**
+ *  @brief  Coefficients of 2 atanh(s) - 2s from 2s^23 / 23 to 2s^3 / 3,
+ *          divided by s^3.  The rest of the series is below 2^-60 for
+ *          |s| <= 3 - 2 sqrt(2).
+ */
+static constexpr auto log_coefficients = std::to_array<double>({
+    2.0 / 23, 2.0 / 21, 2.0 / 19, 2.0 / 17, 2.0 / 15, 2.0 / 13, 2.0 / 11,
+    2.0 / 9, 2.0 / 7, 2.0 / 5, 2.0 / 3
+});
+
+/**
+ *  @brief  The coefficients of @c log_coefficients without the last,
+ *          divided by s^2 once more.
+ */
+static constexpr auto log_rest_coefficients = std::to_array<double>({
+    2.0 / 23, 2.0 / 21, 2.0 / 19, 2.0 / 17, 2.0 / 15, 2.0 / 13, 2.0 / 11,
+    2.0 / 9, 2.0 / 7, 2.0 / 5
+});
+
+/**
+ *  @brief  The rest of 2 / 3.
+ */
+static constexpr double two_thirds_lo = 0x1.5555555555555p-55;
+
+/**
+ *  @brief  Coefficients of sin(r) from r^17 / 17! to -r^3 / 3!, divided by
+ *          r^3.  The rest of the series is below 2^-63 for |r| <= pi / 4.
+ */
+static constexpr auto sin_coefficients = std::to_array<double>({
+    1.0 / 355687428096000, -1.0 / 1307674368000, 1.0 / 6227020800,
+    -1.0 / 39916800, 1.0 / 362880, -1.0 / 5040, 1.0 / 120, -1.0 / 6
+});
+
+/**
+ *  @brief  Coefficients of cos(r) from -r^18 / 18! to r^4 / 4!, divided by
+ *          r^4.  The rest of the series is below 2^-68 for |r| <= pi / 4.
+ */
+static constexpr auto cos_coefficients = std::to_array<double>({
+    -1.0 / 6402373705728000, 1.0 / 20922789888000, -1.0 / 87178291200,
+    1.0 / 479001600, -1.0 / 3628800, 1.0 / 40320, -1.0 / 720, 1.0 / 24
+});
+
+PLONS_LIBRARY_DTN_AVX2_LANES(add, _mm256_add_pd(x, y))
+PLONS_LIBRARY_DTN_AVX2_LANES(subtract, _mm256_sub_pd(x, y))
+PLONS_LIBRARY_DTN_AVX2_LANES(multiply, _mm256_mul_pd(x, y))
+PLONS_LIBRARY_DTN_AVX2_LANES(divide, _mm256_div_pd(x, y))
+PLONS_LIBRARY_DTN_AVX2_LANES(negate,
+    _mm256_xor_pd(x, _mm256_set1_pd(-0.0)))
+PLONS_LIBRARY_DTN_AVX2_LANES(floor, _mm256_floor_pd(x))
+PLONS_LIBRARY_DTN_AVX2_LANES(ceil, _mm256_ceil_pd(x))
+PLONS_LIBRARY_DTN_AVX2_LANES(sqrt, _mm256_sqrt_pd(x))
+PLONS_LIBRARY_DTN_AVX2_LANES(abs,
+    _mm256_andnot_pd(_mm256_set1_pd(-0.0), x))
+PLONS_LIBRARY_DTN_AVX2_LANES(min, _mm256_min_pd(y, x))
+PLONS_LIBRARY_DTN_AVX2_LANES(max, _mm256_max_pd(y, x))
+
+/**
+ *  @brief  Evaluate a polynomial with Horner's method.
+ *
+ *  @param  x             The variable.
+ *  @param  coefficients  The coefficients from the highest degree.
+ *  @return  The polynomial of @p x .
+ */
+template <std::size_t N>
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto horner_avx2(
+    __m256d                             x,
+    const std::array<double, N>        &coefficients
+) -> __m256d
+{
+    auto p = _mm256_set1_pd(coefficients[0]);
+    for (std::size_t i = 1; i < N; i++)
+    {
+        p = _mm256_add_pd(_mm256_mul_pd(p, x),
+            _mm256_set1_pd(coefficients[i]));
+    }
+    return p;
+}
+
+/**
+ *  @brief  Round reals to the nearest integers.
+ *
+ *  @param  x        Reals below 2^51 in magnitude.
+ *  @param  integer  Receives the integers as 64-bit integers.
+ *  @return  The integers as reals.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto round_avx2(
+    __m256d  x,
+    __m256i &integer
+) -> __m256d
+{
+    auto shifter = _mm256_set1_pd(round_shifter);
+    auto sum     = _mm256_add_pd(x, shifter);
+    integer      = _mm256_sub_epi64(_mm256_castpd_si256(sum),
+        _mm256_castpd_si256(shifter));
+    return _mm256_sub_pd(sum, shifter);
+}
+
+#if !defined(__FMA__)
+
+/**
+ *  @brief  Split reals into halves of 26 bits.
+ *
+ *  @param  x   Reals below 2^996 in magnitude.
+ *  @param  lo  Receives the lower halves.
+ *  @return  The upper halves.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto split_avx2(
+    __m256d  x,
+    __m256d &lo
+) -> __m256d
+{
+    auto t  = _mm256_mul_pd(x, _mm256_set1_pd(0x1p27 + 1));
+    auto hi = _mm256_sub_pd(t, _mm256_sub_pd(t, x));
+    lo      = _mm256_sub_pd(x, hi);
+    return hi;
+}
+
+#endif
+
+/**
+ *  @brief  Multiply reals exactly.
+ *
+ *  @param  a      The left reals.
+ *  @param  b      The right reals, whose products with @p a do not
+ *                 overflow.
+ *  @param  error  Receives a * b minus the product.
+ *  @return  The rounded product.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto exact_product_avx2(
+    __m256d  a,
+    __m256d  b,
+    __m256d &error
+) -> __m256d
+{
+    auto product = _mm256_mul_pd(a, b);
+#if defined(__FMA__)
+    error = _mm256_fmsub_pd(a, b, product);
+#else
+    // The products of the halves are exact (Dekker)
+    __m256d a_lo;
+    __m256d b_lo;
+    auto    a_hi = split_avx2(a, a_lo);
+    auto    b_hi = split_avx2(b, b_lo);
+    error = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+        _mm256_sub_pd(_mm256_mul_pd(a_hi, b_hi), product),
+        _mm256_mul_pd(a_hi, b_lo)), _mm256_mul_pd(a_lo, b_hi)),
+        _mm256_mul_pd(a_lo, b_lo));
+#endif
+    return product;
+}
+
+/**
+ *  @brief  Compute e^r scaled by 2^n.
+ *
+ *  @param  r  Reals of magnitude up to about ln(2) / 2.
+ *  @param  n  Integers from -1021 to 1022.
+ *  @return  e^r * 2^n.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto scaled_exp_avx2(
+    __m256d r,
+    __m256i n
+) -> __m256d
+{
+    auto one   = _mm256_set1_pd(1.0);
+    auto p     = horner_avx2(r, exp_coefficients);
+    auto e     = _mm256_add_pd(one,
+        _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(r, r), p)));
+    auto scale = _mm256_castsi256_pd(_mm256_slli_epi64(
+        _mm256_add_epi64(n, _mm256_set1_epi64x(1023)), 52));
+    return _mm256_mul_pd(e, scale);
+}
+
+/**
+ *  @brief  Compute e^x, with x = n ln(2) + r.
+ *
+ *  @param  x     The reals.
+ *  @param  fast  Cleared where x is beyond +-708 or NaN.
+ *  @return  e^x.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto exp_lanes_avx2(
+    __m256d  x,
+    __m256d &fast
+) -> __m256d
+{
+    auto magnitude = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+    fast = _mm256_and_pd(fast,
+        _mm256_cmp_pd(magnitude, _mm256_set1_pd(708.0), _CMP_LE_OQ));
+
+    __m256i n;
+    auto    k = round_avx2(
+        _mm256_mul_pd(x, _mm256_set1_pd(std::numbers::log2e)), n);
+    auto    r = _mm256_sub_pd(
+        _mm256_sub_pd(x, _mm256_mul_pd(k, _mm256_set1_pd(ln2_hi))),
+        _mm256_mul_pd(k, _mm256_set1_pd(ln2_lo)));
+    return scaled_exp_avx2(r, n);
+}
+
+/**
+ *  @brief  Split reals into x = (1 + f) 2^e, where 1 + f is from
+ *          sqrt(1/2) to sqrt(2).
+ *
+ *  @param  x     The reals.
+ *  @param  e     Receives the exponents as reals.
+ *  @param  fast  Cleared where x is not positive, normal and finite.
+ *  @return  f.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto split_log_avx2(
+    __m256d  x,
+    __m256d &e,
+    __m256d &fast
+) -> __m256d
+{
+    fast = _mm256_and_pd(fast, _mm256_and_pd(
+        _mm256_cmp_pd(x, _mm256_set1_pd(0x1p-1022), _CMP_GE_OQ),
+        _mm256_cmp_pd(x, _mm256_set1_pd(HUGE_VAL), _CMP_LT_OQ)));
+
+    // Read the biased exponent as a real by putting it under 2^52
+    auto bits     = _mm256_castpd_si256(x);
+    auto mantissa = _mm256_castsi256_pd(_mm256_or_si256(
+        _mm256_and_si256(bits, _mm256_set1_epi64x(0x000fffffffffffff)),
+        _mm256_set1_epi64x(0x3ff0000000000000)));
+    auto biased   = _mm256_castsi256_pd(_mm256_or_si256(
+        _mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(0x4330000000000000)));
+    e = _mm256_sub_pd(biased, _mm256_set1_pd(0x1p52 + 1023));
+
+    auto large = _mm256_cmp_pd(mantissa, _mm256_set1_pd(std::numbers::sqrt2),
+        _CMP_GE_OQ);
+    mantissa   = _mm256_blendv_pd(mantissa,
+        _mm256_mul_pd(mantissa, _mm256_set1_pd(0.5)), large);
+    e = _mm256_add_pd(e, _mm256_and_pd(large, _mm256_set1_pd(1.0)));
+    return _mm256_sub_pd(mantissa, _mm256_set1_pd(1.0));
+}
+
+/**
+ *  @brief  Compute ln(x) = e ln(2) + 2 atanh(s), with s = f / (2 + f).
+ *
+ *  @param  x     The reals.
+ *  @param  fast  Cleared where x is not positive, normal and finite.
+ *  @return  ln(x).
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto log_lanes_avx2(
+    __m256d  x,
+    __m256d &fast
+) -> __m256d
+{
+    __m256d e;
+    auto    f = split_log_avx2(x, e, fast);
+    auto    s = _mm256_div_pd(f, _mm256_add_pd(f, _mm256_set1_pd(2.0)));
+    auto    z = _mm256_mul_pd(s, s);
+    auto    r = _mm256_mul_pd(z, horner_avx2(z, log_coefficients));
+
+    // 2s = f - sf, so that only the smaller sf (f - r) is rounded
+    auto log1p = _mm256_sub_pd(f, _mm256_sub_pd(
+        _mm256_mul_pd(s, _mm256_sub_pd(f, r)),
+        _mm256_mul_pd(e, _mm256_set1_pd(ln2_lo))));
+    return _mm256_add_pd(_mm256_mul_pd(e, _mm256_set1_pd(ln2_hi)), log1p);
+}
+
+/**
+ *  @brief  Compute sin(x) or cos(x) from x = n pi / 2 + r.
+ *
+ *  @param  x       The reals.
+ *  @param  cosine  Whether to compute cos(x), which is sin(x + pi / 2).
+ *  @param  fast    Cleared where x is beyond +-10^6 or NaN.
+ *  @return  sin(x) or cos(x).
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto sin_lanes_avx2(
+    __m256d  x,
+    bool     cosine,
+    __m256d &fast
+) -> __m256d
+{
+    auto magnitude = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+    fast = _mm256_and_pd(fast,
+        _mm256_cmp_pd(magnitude, _mm256_set1_pd(1.0e6), _CMP_LE_OQ));
+
+    // n has at most 20 bits, so its products with the upper parts of
+    // pi / 2 are exact
+    __m256i n;
+    auto    k = round_avx2(
+        _mm256_mul_pd(x, _mm256_set1_pd(2.0 / std::numbers::pi)), n);
+    auto    r = _mm256_sub_pd(_mm256_sub_pd(
+        _mm256_sub_pd(x, _mm256_mul_pd(k, _mm256_set1_pd(pi_2_hi))),
+        _mm256_mul_pd(k, _mm256_set1_pd(pi_2_mid))),
+        _mm256_mul_pd(k, _mm256_set1_pd(pi_2_lo)));
+    if (cosine)
+    {
+        n = _mm256_add_epi64(n, _mm256_set1_epi64x(1));
+    }
+
+    auto z    = _mm256_mul_pd(r, r);
+    auto sine = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(r, z),
+        horner_avx2(z, sin_coefficients)));
+
+    // 1 - z / 2 is rounded once, and its error is added back
+    auto half = _mm256_mul_pd(z, _mm256_set1_pd(0.5));
+    auto w    = _mm256_sub_pd(_mm256_set1_pd(1.0), half);
+    auto tail = _mm256_sub_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), w), half);
+    auto cos  = _mm256_add_pd(w, _mm256_add_pd(tail, _mm256_mul_pd(
+        _mm256_mul_pd(z, z), horner_avx2(z, cos_coefficients))));
+
+    // Odd quadrants use the cosine, the last two negate the result
+    auto odd  = _mm256_castsi256_pd(_mm256_cmpeq_epi64(
+        _mm256_and_si256(n, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(1)));
+    auto sign = _mm256_castsi256_pd(_mm256_slli_epi64(
+        _mm256_and_si256(n, _mm256_set1_epi64x(2)), 62));
+    return _mm256_xor_pd(_mm256_blendv_pd(sine, cos, odd), sign);
+}
+
+/**
+ *  @brief  Compute x^y = e^(y ln(x)), with ln(x) in twice the precision
+ *          so that the error does not grow with y ln(x).
+ *
+ *  @param  x     The bases.
+ *  @param  y     The exponents.
+ *  @param  fast  Cleared where x is not positive, normal and finite, y
+ *                is beyond +-2^900 or NaN, or x^y is beyond e^+-708.
+ *  @return  x^y.
+ */
+[[nodiscard]] PLONS_LIBRARY_DTN_AVX2 static inline auto pow_lanes_avx2(
+    __m256d  x,
+    __m256d  y,
+    __m256d &fast
+) -> __m256d
+{
+    auto magnitude = _mm256_andnot_pd(_mm256_set1_pd(-0.0), y);
+    fast = _mm256_and_pd(fast,
+        _mm256_cmp_pd(magnitude, _mm256_set1_pd(0x1p900), _CMP_LE_OQ));
+
+    __m256d e;
+    auto    two = _mm256_set1_pd(2.0);
+    auto    f   = split_log_avx2(x, e, fast);
+
+    // s = f / (2 + f), with the remainder of the rounded 2 + f and of the
+    // division kept in s_lo
+    auto    u_hi = _mm256_add_pd(two, f);
+    auto    u_lo = _mm256_add_pd(_mm256_sub_pd(two, u_hi), f);
+    auto    s    = _mm256_div_pd(f, u_hi);
+    __m256d p_lo;
+    auto    p    = exact_product_avx2(s, u_hi, p_lo);
+    auto    s_lo = _mm256_div_pd(_mm256_sub_pd(_mm256_sub_pd(
+        _mm256_sub_pd(f, p), p_lo), _mm256_mul_pd(s, u_lo)), u_hi);
+
+    // 2s^3 / 3 = c_hi + c_lo in twice the precision, as it is the only
+    // term of the series whose rounding error shows in the result
+    auto    z = _mm256_mul_pd(s, s);
+    __m256d q_lo;
+    auto    q_hi = exact_product_avx2(s, s, q_lo);
+    __m256d c_lo;
+    auto    c_hi = exact_product_avx2(q_hi, s, c_lo);
+    c_lo = _mm256_add_pd(c_lo, _mm256_mul_pd(q_lo, s));
+    auto    cube = c_hi;
+    c_hi = exact_product_avx2(cube, _mm256_set1_pd(2.0 / 3), q_lo);
+    c_lo = _mm256_add_pd(_mm256_add_pd(q_lo,
+        _mm256_mul_pd(c_lo, _mm256_set1_pd(2.0 / 3))),
+        _mm256_mul_pd(cube, _mm256_set1_pd(two_thirds_lo)));
+    auto    rest = _mm256_mul_pd(_mm256_mul_pd(cube, z),
+        horner_avx2(z, log_rest_coefficients));
+
+    // ln(x) = l_hi + l_lo = e ln(2) + 2s + c_hi + c_lo + rest, with s_lo
+    // scaled by the derivative 2 / (1 - s^2) of the series
+    auto a    = _mm256_mul_pd(e, _mm256_set1_pd(ln2_hi));
+    auto b    = _mm256_add_pd(s, s);
+    auto l_hi = _mm256_add_pd(a, b);
+    auto bb   = _mm256_sub_pd(l_hi, a);
+    auto l_lo = _mm256_add_pd(
+        _mm256_sub_pd(a, _mm256_sub_pd(l_hi, bb)), _mm256_sub_pd(b, bb));
+    a         = l_hi;
+    l_hi      = _mm256_add_pd(a, c_hi);
+    bb        = _mm256_sub_pd(l_hi, a);
+    l_lo      = _mm256_add_pd(l_lo, _mm256_add_pd(
+        _mm256_sub_pd(a, _mm256_sub_pd(l_hi, bb)), _mm256_sub_pd(c_hi, bb)));
+    l_lo      = _mm256_add_pd(l_lo, _mm256_add_pd(c_lo, _mm256_add_pd(rest,
+        _mm256_add_pd(_mm256_mul_pd(s_lo, _mm256_add_pd(two,
+        _mm256_add_pd(z, z))), _mm256_mul_pd(e, _mm256_set1_pd(ln2_lo))))));
+    auto sum  = _mm256_add_pd(l_hi, l_lo);
+    l_lo      = _mm256_sub_pd(l_lo, _mm256_sub_pd(sum, l_hi));
+    l_hi      = sum;
+
+    // y ln(x) = t_hi + t_lo
+    __m256d t_lo;
+    auto    t_hi = exact_product_avx2(y, l_hi, t_lo);
+    t_lo = _mm256_add_pd(t_lo, _mm256_mul_pd(y, l_lo));
+
+    magnitude = _mm256_andnot_pd(_mm256_set1_pd(-0.0), t_hi);
+    fast = _mm256_and_pd(fast,
+        _mm256_cmp_pd(magnitude, _mm256_set1_pd(708.0), _CMP_LE_OQ));
+
+    __m256i n;
+    auto    k = round_avx2(
+        _mm256_mul_pd(t_hi, _mm256_set1_pd(std::numbers::log2e)), n);
+    auto    r = _mm256_add_pd(_mm256_sub_pd(
+        _mm256_sub_pd(t_hi, _mm256_mul_pd(k, _mm256_set1_pd(ln2_hi))),
+        _mm256_mul_pd(k, _mm256_set1_pd(ln2_lo))), t_lo);
+    return scaled_exp_avx2(r, n);
+}
+
+PLONS_LIBRARY_DTN_AVX2_MATH(exp, exp_lanes_avx2(x, fast))
+PLONS_LIBRARY_DTN_AVX2_MATH(log, c
+    ? _mm256_div_pd(log_lanes_avx2(x, fast), log_lanes_avx2(y, fast))
+    : log_lanes_avx2(x, fast))
+PLONS_LIBRARY_DTN_AVX2_MATH(sin, sin_lanes_avx2(x, false, fast))
+PLONS_LIBRARY_DTN_AVX2_MATH(cos, sin_lanes_avx2(x, true, fast))
+PLONS_LIBRARY_DTN_AVX2_MATH(pow, pow_lanes_avx2(x, y, fast))
+
+/**
+ *  @brief  Check if the CPU and the OS support AVX2.
+ *  @return  True if AVX2 can be used.
+ */
+[[nodiscard]] static auto has_avx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx     = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // PLONS_LIBRARY_DTN_X86
+
+/**
+ *  @brief  Kernels of the arithmetic used by batch functions.
+ */
+struct lane_kernels {
+
+    /**
+     *  @brief  x + y.
+     */
+    builtin_kernel add;
+
+    /**
+     *  @brief  x - y.
+     */
+    builtin_kernel subtract;
+
+    /**
+     *  @brief  x * y.
+     */
+    builtin_kernel multiply;
+
+    /**
+     *  @brief  x / y.
+     */
+    builtin_kernel divide;
+
+    /**
+     *  @brief  -x.
+     */
+    builtin_kernel negate;
+};
+
+/**
+ *  @brief  Select the fastest lane kernels supported by the CPU.
+ *  @return  The lane kernels, selected once at runtime.
+ */
+[[nodiscard]] static auto get_lane_kernels() -> const lane_kernels &
+{
+    static const auto kernels = []()
+    {
+#if PLONS_LIBRARY_DTN_X86
+        if (has_avx2())
+        {
+            return lane_kernels {
+                add_avx2,
+                subtract_avx2,
+                multiply_avx2,
+                divide_avx2,
+                negate_avx2
+            };
+        }
+
+        return lane_kernels {
+            add_sse2,
+            subtract_sse2,
+            multiply_sse2,
+            divide_sse2,
+            negate_sse2
+        };
+#else
+        return lane_kernels {
+            add_scalar,
+            subtract_scalar,
+            multiply_scalar,
+            divide_scalar,
+            negate_scalar
+        };
+#endif
+    }();
+
+    return kernels;
+}
+
+/**
+ *  @brief  Get the implementations of the builtin functions.
+ *  @return  The implementations indexed by @c builtin_function , whose
+ *           lanes are selected once at runtime.
+ */
+auto plons::dtn::builtins() -> std::span<const builtin_info>
+{
+    static const auto table = []()
+    {
+        auto table = std::to_array<builtin_info>({
+            { 1, 1, sqrt_scalar, sqrt_scalar },
+            { 1, 1, cbrt_scalar, cbrt_scalar },
+            { 1, 1, exp_scalar, exp_scalar },
+            { 1, 2, log_scalar, log_scalar },
+            { 1, 1, sin_scalar, sin_scalar },
+            { 1, 1, cos_scalar, cos_scalar },
+            { 1, 1, tan_scalar, tan_scalar },
+            { 1, 1, asin_scalar, asin_scalar },
+            { 1, 1, acos_scalar, acos_scalar },
+            { 1, 1, atan_scalar, atan_scalar },
+            { 2, 2, atan2_scalar, atan2_scalar },
+            { 1, 1, abs_scalar, abs_scalar },
+            { 1, 1, floor_scalar, floor_scalar },
+            { 1, 1, ceil_scalar, ceil_scalar },
+            { 1, 1, round_scalar, round_scalar },
+            { 2, 2, pow_scalar, pow_scalar },
+            { 2, 2, min_scalar, min_scalar },
+            { 2, 2, max_scalar, max_scalar }
+        });
+
+        static_assert(table.size()
+            == static_cast<std::size_t>(builtin_function::max),
+            "Every builtin function needs its implementations");
+
+#if PLONS_LIBRARY_DTN_X86
+        auto set = [&](builtin_function function, builtin_kernel lanes,
+            double ulps = 0.0)
+        {
+            table[static_cast<std::size_t>(function)].lanes = lanes;
+            table[static_cast<std::size_t>(function)].ulps  = ulps;
+        };
+
+        using enum builtin_function;
+        if (has_avx2())
+        {
+            set(sqrt, sqrt_avx2);
+            set(exp, exp_avx2, 1.0);
+            set(log, log_avx2, 4.0);
+            set(sin, sin_avx2, 2.0);
+            set(cos, cos_avx2, 2.0);
+            set(abs, abs_avx2);
+            set(floor, floor_avx2);
+            set(ceil, ceil_avx2);
+            set(pow, pow_avx2, 1.0);
+            set(min, min_avx2);
+            set(max_, max_avx2);
+        }
+        else
+        {
+            set(sqrt, sqrt_sse2);
+            set(abs, abs_sse2);
+            set(min, min_sse2);
+            set(max_, max_sse2);
+        }
+#endif
+        return table;
+    }();
+
+    return table;
+}
+
+/**
+ *  @brief  Convert a real to `int` the way the program does, flooring and
+ *          saturating it.  NaN is converted to 0.
+ *
+ *  @param  x  The real.
+ *  @return  The int, as a real.
+ */
+[[nodiscard]] static inline auto saturate(double x) -> double
+{
+    using limits = std::numeric_limits<std::int32_t>;
+    if (std::isnan(x))
+    {
+        return 0.0;
+    }
+    return std::clamp(std::floor(x), static_cast<double>(limits::min()),
+        static_cast<double>(limits::max()));
+}
+
+/**
+ *  @brief  Translate a function into a batch function.
+ *
+ *  @param  prog      The program.
+ *  @param  function  The function.
+ *  @return  The batch function, or nothing if the function does anything
+ *           other than computing a `real` from its parameters.
+ */
+[[nodiscard]] static auto to_batch(
+    const program       &prog,
+    const function_info &function
+) -> std::optional<batch_function>
+{
+    if (function.return_type != real_type)
+    {
+        return std::nullopt;
+    }
+
+    auto batch = batch_function {
+        .parameters = function.parameters,
+        .registers  = function.registers
+    };
+
+    // Type of the number in each register, `int` numbers are kept as whole
+    // reals.  Registers that were never set are unknown
+    auto types = std::vector<type_index>(function.registers, unknown_type);
+    for (std::size_t i = 0; i < function.parameters.size(); i++)
+    {
+        auto type = function.parameters[i];
+        if (type != real_type && type != int_type)
+        {
+            return std::nullopt;
+        }
+        types[i] = type;
+    }
+
+    auto is_number = [&](std::size_t reg)
+    {
+        return types[reg] != unknown_type;
+    };
+
+    auto is_real = [&](std::size_t reg)
+    {
+        return types[reg] == real_type;
+    };
+
+    for (auto in : function.code)
+    {
+        switch (in.op)
+        {
+        using enum opcode;
+            case move:
+            case copy:
+            case take:
+            {
+                if (!is_number(in.b))
+                {
+                    return std::nullopt;
+                }
+                types[in.a] = types[in.b];
+                break;
+            }
+
+            case load_constant:
+            {
+                auto &constant = prog.constants[in.bc()];
+                if (auto real = constant.get_if<double>())
+                {
+                    batch.constants.emplace_back(*real);
+                    types[in.a] = real_type;
+                }
+                else if (auto integer = constant.get_if<std::int32_t>())
+                {
+                    batch.constants.emplace_back(*integer);
+                    types[in.a] = int_type;
+                }
+                else
+                {
+                    return std::nullopt;
+                }
+                in.set_bc(static_cast<std::uint32_t>(
+                    batch.constants.size() - 1));
+                break;
+            }
+
+            case convert:
+            {
+                if (!is_number(in.b)
+                 || (in.c != real_type && in.c != int_type))
+                {
+                    return std::nullopt;
+                }
+                types[in.a] = in.c;
+                break;
+            }
+
+            case int_to_real:
+            case real_to_int:
+            {
+                if (!is_number(in.b))
+                {
+                    return std::nullopt;
+                }
+                types[in.a] = in.op == int_to_real ? real_type : int_type;
+                break;
+            }
+
+            case add_real:
+            case subtract_real:
+            case multiply_real:
+            case divide_real:
+            case floor_divide_real:
+            case modulo_real:
+            {
+                if (!is_real(in.b) || !is_real(in.c))
+                {
+                    return std::nullopt;
+                }
+                types[in.a] = real_type;
+                break;
+            }
+
+            case negate_real:
+            {
+                if (!is_real(in.b))
+                {
+                    return std::nullopt;
+                }
+                types[in.a] = real_type;
+                break;
+            }
+
+            case power:
+            {
+                if (!is_number(in.b) || !is_number(in.c))
+                {
+                    return std::nullopt;
+                }
+                types[in.a] = real_type;
+                break;
+            }
+
+            case call_builtin:
+            {
+                if (in.b == 0 || in.b > 2
+                 || in.c >= static_cast<std::uint16_t>(builtin_function::max))
+                {
+                    return std::nullopt;
+                }
+                for (std::size_t i = 0; i < in.b; i++)
+                {
+                    if (!is_number(in.a + i))
+                    {
+                        return std::nullopt;
+                    }
+                }
+                types[in.a] = real_type;
+                break;
+            }
+
+            case return_:
+            {
+                if (!is_real(in.a))
+                {
+                    return std::nullopt;
+                }
+                batch.code.emplace_back(in);
+                return batch;
+            }
+
+            default: return std::nullopt;
+        }
+
+        batch.code.emplace_back(in);
+    }
+
+    return std::nullopt;
+}
+
+/**
+ *  @brief  Compile a function to be evaluated for many rows at once,
+ *          instead of running it once per row.
+ *
+ *  The function must take only `real` and `int` parameters, return a
+ *  `real`, and compute it without branches, calls other than builtin
+ *  functions, global variables or `int` arithmetic.  Calls to small
+ *  functions are usually inlined and do not prevent it.
+ *
+ *  @param  name  The name of the function.
+ *  @return  The batch function, or @c std::nullopt if no function of the
+ *           name can be evaluated in batches.
+ *  @note  Requires a successful compilation, and @c rebuild after
+ *         @c edit .
+ */
+auto detronade::compile_batch(std::string_view name) const
+-> std::optional<batch_function>
+{
+    auto symbol = symbols.find(name);
+    if (!compilation_successful || stale || !bytecode
+        || !symbol.has_value())
+    {
+        return std::nullopt;
+    }
+
+    for (auto &function : bytecode->functions)
+    {
+        if (function.symbol != symbol.value()
+         || function.owner != no_function)
+        {
+            continue;
+        }
+
+        if (auto batch = to_batch(*bytecode, function))
+        {
+            return batch;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ *  @brief  Evaluate the function for every row.
+ *
+ *  @param  columns  One column per parameter, each with at least as many
+ *                   numbers as @p results .  Columns of `int` parameters
+ *                   are floored and saturated.
+ *  @param  results  Receives the result of each row.
+ *  @return  False if the number of columns does not match the parameters
+ *           or a column is too short.
+ */
+auto batch_function::evaluate(
+    std::span<const std::span<const double>> columns,
+    std::span<double>                        results
+) const -> bool
+{
+    if (columns.size() != parameters.size())
+    {
+        return false;
+    }
+
+    for (auto &column : columns)
+    {
+        if (column.size() < results.size())
+        {
+            return false;
+        }
+    }
+
+    auto &kernels   = get_lane_kernels();
+    auto  functions = builtins();
+    auto  lanes     = [&](builtin_function function)
+    {
+        return functions[static_cast<std::size_t>(function)].lanes;
+    };
+    auto  floor     = lanes(builtin_function::floor);
+    auto  pow       = lanes(builtin_function::pow);
+
+    // The registers of a block, followed by a scratch register
+    auto block = std::vector<double>((registers + 1) * block_size);
+    auto r     = [&](std::size_t reg)
+    {
+        return block.data() + reg * block_size;
+    };
+    auto scratch = r(registers);
+
+    for (std::size_t row = 0; row < results.size(); row += block_size)
+    {
+        auto rows = std::min(block_size, results.size() - row);
+        for (std::size_t i = 0; i < parameters.size(); i++)
+        {
+            auto column = columns[i].data() + row;
+            if (parameters[i] == int_type)
+            {
+                std::transform(column, column + rows, r(i), saturate);
+            }
+            else
+            {
+                std::copy_n(column, rows, r(i));
+            }
+        }
+
+        for (auto &in : code)
+        {
+            switch (in.op)
+            {
+            using enum opcode;
+                case move:
+                case copy:
+                case take:
+                case int_to_real:
+                {
+                    if (in.a != in.b)
+                    {
+                        std::copy_n(r(in.b), rows, r(in.a));
+                    }
+                    break;
+                }
+
+                case load_constant:
+                {
+                    std::fill_n(r(in.a), rows, constants[in.bc()]);
+                    break;
+                }
+
+                case convert:
+                case real_to_int:
+                {
+                    if (in.op == real_to_int || in.c == int_type)
+                    {
+                        std::transform(r(in.b), r(in.b) + rows, r(in.a),
+                            saturate);
+                    }
+                    else if (in.a != in.b)
+                    {
+                        std::copy_n(r(in.b), rows, r(in.a));
+                    }
+                    break;
+                }
+
+                case add_real:
+                {
+                    kernels.add(r(in.a), r(in.b), r(in.c), rows);
+                    break;
+                }
+
+                case subtract_real:
+                {
+                    kernels.subtract(r(in.a), r(in.b), r(in.c), rows);
+                    break;
+                }
+
+                case multiply_real:
+                {
+                    kernels.multiply(r(in.a), r(in.b), r(in.c), rows);
+                    break;
+                }
+
+                case divide_real:
+                {
+                    kernels.divide(r(in.a), r(in.b), r(in.c), rows);
+                    break;
+                }
+
+                case floor_divide_real:
+                {
+                    kernels.divide(r(in.a), r(in.b), r(in.c), rows);
+                    floor(r(in.a), r(in.a), nullptr, rows);
+                    break;
+                }
+
+                case modulo_real:
+                {
+                    // R[a] may be either operand, so the quotient is kept
+                    // in the scratch register
+                    kernels.divide(scratch, r(in.b), r(in.c), rows);
+                    floor(scratch, scratch, nullptr, rows);
+                    kernels.multiply(scratch, r(in.c), scratch, rows);
+                    kernels.subtract(r(in.a), r(in.b), scratch, rows);
+                    break;
+                }
+
+                case negate_real:
+                {
+                    kernels.negate(r(in.a), r(in.b), nullptr, rows);
+                    break;
+                }
+
+                case power:
+                {
+                    pow(r(in.a), r(in.b), r(in.c), rows);
+                    break;
+                }
+
+                case call_builtin:
+                {
+                    functions[in.c].lanes(r(in.a), r(in.a),
+                        in.b == 2 ? r(in.a + 1) : nullptr, rows);
+                    break;
+                }
+
+                case return_:
+                {
+                    std::copy_n(r(in.a), rows, results.data() + row);
+                    break;
+                }
+
+                default: break;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,348 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Compile cache of Detronade, implementation of
+ *           @c compile_cache from @c plons_detronade.hpp .
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "plons_detronade.hpp"
+
+using namespace plons::dtn;
+
+/**
+ *  @brief  Copy the value and the objects that it refers to, only reading
+ *          them.
+ *
+ *  @param  v  The value.
+ *  @return  The copy.
+ */
+[[nodiscard]] static auto copy_constant(const value &v) -> value
+{
+    if (auto array = v.get_if<array_object>())
+    {
+        std::vector<value> elements;
+        elements.reserve(array->elements().size());
+        for (auto &element : array->elements())
+        {
+            elements.emplace_back(copy_constant(element));
+        }
+        return value::make_array(array->type, array->flat,
+            std::move(elements));
+    }
+
+    if (auto object = v.get_if<struct_object>())
+    {
+        auto copy   = value::make_struct(object->type, object->size);
+        auto fields = copy.get_if<struct_object>()->fields();
+        for (std::size_t i = 0; i < fields.size(); i++)
+        {
+            fields[i] = copy_constant(object->fields()[i]);
+        }
+        return copy;
+    }
+    return v;
+}
+
+/**
+ *  @brief  Get the number of bytes of the elements of the vector,
+ *          including the unused capacity.
+ *
+ *  @tparam  type  Type of the elements.
+ *  @param   elements  The vector.
+ *  @return  Number of bytes.
+ */
+template<typename type>
+[[nodiscard]] static auto bytes_of(const std::vector<type> &elements)
+{
+    return elements.capacity() * sizeof(type);
+}
+
+/**
+ *  @brief  Get the number of bytes of the strings and their characters.
+ *
+ *  @param  strings  The strings.
+ *  @return  Number of bytes.
+ */
+[[nodiscard]] static auto bytes_of(const std::vector<std::string> &strings)
+{
+    auto bytes = strings.capacity() * sizeof(std::string);
+    for (auto &string : strings)
+    {
+        bytes += string.capacity();
+    }
+    return bytes;
+}
+
+/**
+ *  @brief  Estimate the number of bytes used by the compilation.  Nodes of
+ *          maps and objects of constants are counted by their contents.
+ *
+ *  @param  compiled  The compilation.
+ *  @return  Approximate number of bytes.
+ */
+[[nodiscard]] static auto approximate_size(const compiled_source &compiled)
+{
+    auto bytes = sizeof(compiled_source) + compiled.source_code.capacity()
+               + bytes_of(compiled.messages) + bytes_of(compiled.tokens)
+               + bytes_of(compiled.decoded_strings)
+               + bytes_of(compiled.numbers) + bytes_of(compiled.tree.nodes)
+               + bytes_of(compiled.tree.extra)
+               + bytes_of(compiled.line_starts);
+
+    // The map keeps another copy of each name
+    bytes += bytes_of(compiled.symbols.names) * 2
+           + compiled.symbols.ids.size()
+           * (sizeof(std::uint32_t) + 2 * sizeof(void *));
+
+    auto &prog = *compiled.bytecode;
+    bytes += sizeof(program) + bytes_of(prog.functions)
+           + bytes_of(prog.structs) + bytes_of(prog.types)
+           + bytes_of(prog.constants) + bytes_of(prog.overloads)
+           + bytes_of(prog.operator_symbols);
+    bytes += prog.overload_table.size() * (sizeof(overload_key)
+           + sizeof(std::uint32_t) + 4 * sizeof(void *));
+    for (auto &function : prog.functions)
+    {
+        bytes += bytes_of(function.code) + bytes_of(function.tokens)
+               + bytes_of(function.parameters);
+    }
+    for (auto &st : prog.structs)
+    {
+        bytes += bytes_of(st.field_symbols) + bytes_of(st.field_types);
+    }
+    for (auto &constant : prog.constants)
+    {
+        if (auto array = constant.get_if<array_object>())
+        {
+            bytes += sizeof(array_object) + sizeof(array_buffer)
+                   + bytes_of(array->elements());
+        }
+    }
+    return bytes;
+}
+
+/**
+ *  @brief  Get the key of the compilation of the source code with the
+ *          options.
+ *
+ *  @param  source       The source code.
+ *  @param  codegen_key  The options, from @c compile_options::codegen_key .
+ *  @return  The key.
+ */
+[[nodiscard]] static auto key_of(
+    std::string_view source,
+    std::uint32_t    codegen_key
+)
+{
+    auto hash = std::hash<std::string_view> {}(source);
+    return hash ^ (std::hash<std::uint32_t> {}(codegen_key)
+         + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2));
+}
+
+/**
+ *  @brief  Evict the least recently used compilations until the size is
+ *          within the budget.
+ *
+ *  @param  cache  The cache, which is locked.
+ */
+static auto evict(compile_cache &cache)
+{
+    while (cache.size > cache.budget && !cache.recent.empty())
+    {
+        auto &[hash, size, compiled] = cache.recent.back();
+        cache.size -= size;
+        cache.entries.erase(hash);
+        cache.recent.pop_back();
+    }
+}
+
+/**
+ *  @brief  Copy the program with constants of its own.  The reference
+ *          counts of values are not atomic, so programs that run on
+ *          different threads must not share their constants.
+ *
+ *  @param  prog  The program, whose constants are only read, so it can
+ *                run on another thread meanwhile.
+ *  @return  The copy.
+ */
+[[nodiscard]] auto plons::dtn::copy_program(const program &prog)
+-> std::shared_ptr<const program>
+{
+    auto copy = std::make_shared<program>(program {
+        .functions        = prog.functions,
+        .structs          = prog.structs,
+        .types            = prog.types,
+        .constants        = {},
+        .overloads        = prog.overloads,
+        .operator_symbols = prog.operator_symbols,
+        .overload_table   = prog.overload_table,
+        .globals          = prog.globals,
+        .main             = prog.main
+    });
+
+    copy->constants.reserve(prog.constants.size());
+    for (auto &constant : prog.constants)
+    {
+        copy->constants.emplace_back(copy_constant(constant));
+    }
+    return copy;
+}
+
+/**
+ *  @brief  Get the cache shared by the whole process, which
+ *          @c detronade::compile uses when @c compile_options::cache is
+ *          set.
+ *  @return  The cache.
+ */
+[[nodiscard]] auto compile_cache::global() -> compile_cache &
+{
+    static compile_cache cache;
+    return cache;
+}
+
+/**
+ *  @brief  Find the compilation of the source code, and count a hit or a
+ *          miss.
+ *
+ *  @param  source       The source code.
+ *  @param  codegen_key  The options, from @c compile_options::codegen_key .
+ *  @return  The compilation, or @c nullptr if it is not in the cache.
+ */
+[[nodiscard]] auto compile_cache::find(
+    std::string_view source,
+    std::uint32_t    codegen_key
+) -> std::shared_ptr<const compiled_source>
+{
+    auto hash = key_of(source, codegen_key);
+
+    std::lock_guard lock(mutex);
+    auto it = entries.find(hash);
+    if (it == entries.end()
+     || std::get<2>(*it->second)->source_code != source
+     || std::get<2>(*it->second)->codegen_key != codegen_key)
+    {
+        misses++;
+        return nullptr;
+    }
+
+    hits++;
+    recent.splice(recent.begin(), recent, it->second);
+    return std::get<2>(*it->second);
+}
+
+/**
+ *  @brief  Keep the compilation, replacing one of the same hash and
+ *          evicting the least recently used ones beyond the budget.  A
+ *          compilation larger than the budget is not kept.
+ *
+ *  @param  compiled  The compilation.
+ */
+auto compile_cache::insert(std::shared_ptr<const compiled_source> compiled)
+-> void
+{
+    auto hash  = key_of(compiled->source_code, compiled->codegen_key);
+    auto bytes = approximate_size(*compiled);
+
+    std::lock_guard lock(mutex);
+    if (auto it = entries.find(hash); it != entries.end())
+    {
+        size -= std::get<1>(*it->second);
+        recent.erase(it->second);
+        entries.erase(it);
+    }
+
+    if (bytes > budget)
+    {
+        return;
+    }
+
+    recent.emplace_front(hash, bytes, std::move(compiled));
+    entries.emplace(hash, recent.begin());
+    size += bytes;
+    evict(*this);
+}
+
+/**
+ *  @brief  Change the budget, evicting the least recently used
+ *          compilations beyond it.
+ *
+ *  @param  bytes  The budget, in bytes.
+ */
+auto compile_cache::set_budget(std::size_t bytes) -> void
+{
+    std::lock_guard lock(mutex);
+    budget = bytes;
+    evict(*this);
+}
+
+/**
+ *  @brief  Evict every compilation and reset the counters.
+ */
+auto compile_cache::clear() -> void
+{
+    std::lock_guard lock(mutex);
+    entries.clear();
+    recent.clear();
+    size   = 0;
+    hits   = 0;
+    misses = 0;
+}
+
+/**
+ *  @brief  Get the counters and the size.
+ *  @return  The statistics.
+ */
+[[nodiscard]] auto compile_cache::statistics() const
+-> compile_cache_statistics
+{
+    std::lock_guard lock(mutex);
+    return {
+        .hits    = hits,
+        .misses  = misses,
+        .entries = recent.size(),
+        .size    = size,
+        .budget  = budget
+    };
+}
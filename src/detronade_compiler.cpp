@@ -0,0 +1,6967 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Compiler of Detronade, implementations of @c detronade::generate
+ *           from @c plons_detronade.hpp .
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "plons_detronade.hpp"
+
+using namespace plons::dtn;
+
+namespace stdr = std::ranges;
+
+/**
+ *  @brief  Register operand meaning that the result is not used.
+ */
+static constexpr std::uint16_t no_register =
+    std::numeric_limits<std::uint16_t>::max();
+
+/**
+ *  @brief  Number of nodes of the function bodies that are compiled in
+ *          place of a call, with the calls inlined in them.
+ */
+static constexpr std::size_t inline_budget = 64;
+
+/**
+ *  @brief  Get the opcode of a regular operator.
+ *
+ *  @param  kind  The operator.
+ *  @param  form  Where the operator is written.
+ *  @return  The opcode, or @c opcode::max if the operator has none.
+ */
+[[nodiscard]] static inline constexpr auto operator_opcode(
+    operator_kind kind,
+    operator_form form
+) -> opcode
+{
+    switch (kind)
+    {
+    using enum operator_kind;
+        case add: return form == operator_form::binary
+                       ? opcode::add : opcode::move;
+        case subtract: return form == operator_form::binary
+                            ? opcode::subtract : opcode::negate;
+        case multiply: return opcode::multiply;
+        case divide: return opcode::divide;
+        case floor_divide: return opcode::floor_divide;
+        case modulo: return opcode::modulo;
+        case power: return opcode::power;
+        case shift_left: return opcode::shift_left;
+        case shift_right: return opcode::shift_right;
+        case less: return opcode::less;
+        case less_equal: return opcode::less_equal;
+        case greater: return opcode::greater;
+        case greater_equal: return opcode::greater_equal;
+        case equal: return opcode::equal;
+        case not_equal: return opcode::not_equal;
+        case bitwise_and: return opcode::bitwise_and;
+        case bitwise_xor: return opcode::bitwise_xor;
+        case bitwise_or: return opcode::bitwise_or;
+        case logical_not: return opcode::logical_not;
+        case bitwise_not: return opcode::bitwise_not;
+        default: return opcode::max;
+    }
+}
+
+/**
+ *  @brief  Check if the opcode only writes its result to R[a], after
+ *          reading its operands.
+ *
+ *  @param  op  The opcode.
+ *  @return  True if R[a] can be any register.
+ */
+[[nodiscard]] static inline constexpr auto writes_only_a(opcode op)
+{
+    return op == opcode::move || op == opcode::copy
+        || op == opcode::load_constant || op == opcode::get_global
+        || op == opcode::get_field || op == opcode::get_index
+        || op == opcode::count || op == opcode::convert
+        || (op >= opcode::add && op <= opcode::negate_real);
+}
+
+/**
+ *  @brief  Get the opcode of a regular operator for operands that are
+ *          always of the type.
+ *
+ *  @param  op    The opcode, from @c opcode::add to @c opcode::negate .
+ *  @param  type  Type of the operands.
+ *  @return  The opcode, or @c opcode::max if the operator has none for
+ *           the type.
+ */
+[[nodiscard]] static inline constexpr auto typed_opcode(
+    opcode     op,
+    type_index type
+) -> opcode
+{
+    bool integral = type == int_type;
+    if (!integral && type != real_type)
+    {
+        return opcode::max;
+    }
+
+    switch (op)
+    {
+    using enum opcode;
+        case add: return integral ? add_int : add_real;
+        case subtract: return integral ? subtract_int : subtract_real;
+        case multiply: return integral ? multiply_int : multiply_real;
+        case divide: return integral ? divide_int : divide_real;
+        case floor_divide:
+            return integral ? floor_divide_int : floor_divide_real;
+        case modulo: return integral ? modulo_int : modulo_real;
+        case less: return integral ? less_int : less_real;
+        case less_equal: return integral ? less_equal_int : less_equal_real;
+        case equal: return integral ? equal_int : equal_real;
+        case not_equal: return integral ? not_equal_int : not_equal_real;
+        case negate: return integral ? negate_int : negate_real;
+        default: return max;
+    }
+}
+
+/**
+ *  @brief  Get the type of a number known when compiling.
+ *
+ *  @param  v  The number.
+ *  @return  The type of the number.
+ */
+[[nodiscard]] static inline auto constant_type(const value &v) -> type_index
+{
+    if (v.holds<std::int32_t>())
+    {
+        return int_type;
+    }
+    if (v.holds<bool>())
+    {
+        return bool_type;
+    }
+    if (v.holds<char>())
+    {
+        return char_type;
+    }
+    return v.holds<double>() ? real_type : unknown_type;
+}
+
+/**
+ *  @brief  A variable in a scope of the function being compiled.
+ */
+struct local_variable {
+
+    /**
+     *  @brief  Symbol ID of the name.
+     */
+    std::uint32_t symbol;
+
+    /**
+     *  @brief  The declared type.
+     */
+    type_index type;
+
+    /**
+     *  @brief  The register of the variable.
+     */
+    std::uint16_t reg;
+
+    /**
+     *  @brief  Whether the variable is declared `const`.
+     */
+    bool constant;
+
+    /**
+     *  @brief  The value of a `const` number, if it is known when
+     *          compiling.
+     */
+    std::optional<value> known = std::nullopt;
+
+    /**
+     *  @brief  Whether the structure is kept in the registers from
+     *          @c reg , one for each field, because its value never
+     *          escapes.
+     */
+    bool unpacked = false;
+};
+
+/**
+ *  @brief  A global variable.
+ */
+struct global_variable {
+
+    /**
+     *  @brief  The declared type.
+     */
+    type_index type;
+
+    /**
+     *  @brief  Index of the variable in the global variables.
+     */
+    std::uint32_t slot;
+
+    /**
+     *  @brief  Whether the variable is declared `const`.
+     */
+    bool constant;
+
+    /**
+     *  @brief  The value of a `const` number, if it is known when
+     *          compiling.
+     */
+    std::optional<value> known;
+};
+
+/**
+ *  @brief  A scope of the function being compiled.
+ */
+struct scope {
+
+    /**
+     *  @brief  Number of local variables before the scope.
+     */
+    std::size_t locals;
+
+    /**
+     *  @brief  First register of the scope.
+     */
+    std::uint16_t top;
+};
+
+/**
+ *  @brief  The kind of @c place .
+ */
+enum class place_kind : std::uint8_t {
+    /**
+     *  @brief  Local variable in register @c place::reg .
+     */
+    local,
+    /**
+     *  @brief  Global variable @c place::slot .
+     */
+    global,
+    /**
+     *  @brief  Field @c place::slot of the structure in register
+     *          @c place::reg .
+     */
+    field,
+    /**
+     *  @brief  Element of the array in register @c place::reg at the
+     *          index in register @c place::index .
+     */
+    element
+};
+
+/**
+ *  @brief  Where a value can be stored, with its operands already
+ *          evaluated.
+ */
+struct place {
+
+    /**
+     *  @brief  The kind of place.
+     */
+    place_kind kind;
+
+    /**
+     *  @brief  The type of the stored value.
+     */
+    type_index type;
+
+    /**
+     *  @brief  The register of the local variable, the structure or the
+     *          array.
+     */
+    std::uint16_t reg = 0;
+
+    /**
+     *  @brief  The register of the index.
+     */
+    std::uint16_t index = 0;
+
+    /**
+     *  @brief  Index of the global variable or the field.
+     */
+    std::uint32_t slot = 0;
+};
+
+/**
+ *  @brief  Symbol IDs of the names that the compiler recognizes.
+ */
+struct names {
+    std::uint32_t void_;
+    std::uint32_t real;
+    std::uint32_t int_;
+    std::uint32_t bool_;
+    std::uint32_t char_;
+    std::uint32_t pi;
+    std::uint32_t count;
+    std::uint32_t insert;
+    std::uint32_t remove;
+};
+
+/**
+ *  @brief  What the statements of a region can change, to find the
+ *          expressions whose value stays the same in it.
+ */
+struct effects {
+
+    /**
+     *  @brief  Symbol IDs of the variables that are assigned or declared.
+     */
+    std::unordered_set<std::uint32_t> symbols;
+
+    /**
+     *  @brief  Whether a function, method, constructor or operator overload
+     *          can be called, which can change any field or global variable.
+     */
+    bool calls = false;
+
+    /**
+     *  @brief  Whether a field of a structure is assigned, which can be a
+     *          field of the structure of the method.
+     */
+    bool stores = false;
+
+    /**
+     *  @brief  Whether an element of an array is assigned.
+     */
+    bool elements = false;
+};
+
+/**
+ *  @brief  A function whose body is compiled in place of a call.
+ */
+struct inline_frame {
+
+    /**
+     *  @brief  Index of the function.
+     */
+    std::uint32_t function;
+
+    /**
+     *  @brief  Number of local variables of the caller, which the body
+     *          cannot see.
+     */
+    std::size_t locals;
+
+    /**
+     *  @brief  The register of the structure of a method.
+     */
+    std::uint16_t self;
+};
+
+/**
+ *  @brief  A structure of numbers that only the constructors added by the
+ *          compiler set, so that a value of it that never escapes can be
+ *          kept in registers instead of created.
+ */
+struct plain_struct {
+
+    /**
+     *  @brief  The initial values of the fields.
+     */
+    std::vector<value> initial;
+
+    /**
+     *  @brief  The constructor that takes every field.
+     */
+    std::uint32_t fieldwise = no_function;
+
+    /**
+     *  @brief  The constructor without arguments, or @c no_function if it
+     *          is declared.
+     */
+    std::uint32_t empty = no_function;
+};
+
+/**
+ *  @brief  A structure that is compiled to the registers of its fields
+ *          instead of created, by the constructor whose value goes to
+ *          @c reg .
+ */
+struct unpack_target {
+
+    /**
+     *  @brief  The register of the value, which gets nothing.
+     */
+    std::uint16_t reg;
+
+    /**
+     *  @brief  The register of the first field.
+     */
+    std::uint16_t first;
+
+    /**
+     *  @brief  Type of the structure.
+     */
+    type_index type;
+
+    /**
+     *  @brief  Number of instructions after the fields are compiled, or
+     *          nothing until then.
+     */
+    std::optional<std::size_t> end = std::nullopt;
+};
+
+/**
+ *  @brief  How much the compiler has emitted, to undo an inlined call
+ *          whose body has errors.
+ */
+struct checkpoint {
+
+    /**
+     *  @brief  Number of instructions of the function being compiled.
+     */
+    std::size_t code;
+
+    /**
+     *  @brief  Number of messages.
+     */
+    std::size_t messages;
+
+    /**
+     *  @brief  Number of errors.
+     */
+    std::size_t errors;
+
+    /**
+     *  @brief  First free register.
+     */
+    std::uint16_t top;
+
+    /**
+     *  @brief  Whether the program was reported too large.
+     */
+    bool too_large;
+};
+
+/**
+ *  @brief  Compiles the syntax tree into a @c program .
+ *
+ *  Structures, functions and operator overloads are declared first, so
+ *  that they can be used before they are declared.  The statements in
+ *  global scope are compiled into @c program::main , then the bodies of
+ *  the functions, which see every global variable.
+ *
+ *  Registers are allocated like a stack.  Local variables take the
+ *  registers in the order they are declared, and temporaries are taken
+ *  above them and released after each expression.
+ */
+struct compiler {
+
+    /**
+     *  @brief  The source code's information, receives the messages.
+     */
+    detronade &dtn;
+
+    /**
+     *  @brief  The syntax tree.
+     */
+    const syntax_tree &tree;
+
+    /**
+     *  @brief  The program being compiled.
+     */
+    program prog;
+
+    /**
+     *  @brief  Symbol IDs of the recognized names.
+     */
+    names words;
+
+    /**
+     *  @brief  Types by the symbol ID of their name.
+     */
+    std::unordered_map<std::uint32_t, type_index> type_names;
+
+    /**
+     *  @brief  Array types by their element type.
+     */
+    std::unordered_map<type_index, type_index> array_types;
+
+    /**
+     *  @brief  Functions outside structures by their symbol ID.
+     */
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> functions;
+
+    /**
+     *  @brief  Builtin functions by their symbol ID.
+     */
+    std::unordered_map<std::uint32_t, builtin_function> builtins;
+
+    /**
+     *  @brief  Global variables by their symbol ID.
+     */
+    std::unordered_map<std::uint32_t, global_variable> globals;
+
+    /**
+     *  @brief  Global variables in the order they are declared.
+     */
+    std::vector<global_variable> global_order;
+
+    /**
+     *  @brief  Index to @c program::operator_symbols by symbol ID.
+     */
+    std::unordered_map<std::uint32_t, std::uint16_t> operator_indices;
+
+    /**
+     *  @brief  Constants by the bits of their value, to share them.
+     */
+    std::map<std::uint64_t, std::uint32_t> constants;
+
+    /**
+     *  @brief  Fields of each structure by their symbol ID.
+     */
+    std::vector<std::unordered_map<std::uint32_t, std::uint32_t>> fields;
+
+    /**
+     *  @brief  Methods of each structure by their symbol ID.
+     */
+    std::vector<std::unordered_map<std::uint32_t, std::vector<std::uint32_t>>>
+    methods;
+
+    /**
+     *  @brief  Constructors of each structure.
+     */
+    std::vector<std::vector<std::uint32_t>> constructors;
+
+    /**
+     *  @brief  Field declarations of each structure.
+     */
+    std::vector<std::vector<node_index>> field_declarations;
+
+    /**
+     *  @brief  How each structure is kept in registers, if it can be.
+     */
+    std::vector<std::optional<plain_struct>> plain;
+
+    /**
+     *  @brief  Functions whose body is compiled after the global scope.
+     */
+    std::vector<std::pair<std::uint32_t, node_index>> bodies;
+
+    /**
+     *  @brief  Expressions that are known not to fold, by their node, so
+     *          that each is only tried once.
+     */
+    std::vector<bool> opaque;
+
+    /**
+     *  @brief  Names of local variables that are not used after them in
+     *          the statement being compiled, by their node, so that their
+     *          value is moved instead of copied.
+     */
+    std::vector<bool> last_uses;
+
+    /**
+     *  @brief  Expressions whose value is already in a register, with its
+     *          type, by their node.
+     */
+    std::unordered_map<node_index, std::pair<std::uint16_t, type_index>>
+    hoisted;
+
+    /**
+     *  @brief  Functions that are small enough to compile in place of
+     *          their calls, with the function node and the number of
+     *          nodes of the returned expression, by their index.
+     */
+    std::unordered_map<std::uint32_t, std::pair<node_index, std::size_t>>
+    expansions;
+
+    /**
+     *  @brief  Operators found to call an overload directly that returns,
+     *          by their node, the function being compiled, the number of
+     *          local variables and of inlined calls.  The names that an
+     *          expression sees only change as local variables are declared
+     *          before it.
+     */
+    mutable std::map<
+        std::tuple<node_index, std::uint32_t, std::size_t, std::size_t>,
+        bool
+    > exact_overloads;
+
+    /**
+     *  @brief  Functions whose last statement returns a value, so that
+     *          they never end without one.
+     */
+    std::unordered_set<std::uint32_t> returning;
+
+    /**
+     *  @brief  Functions whose body is being compiled in place of a call,
+     *          the outermost first.
+     */
+    std::vector<inline_frame> inlined;
+
+    /**
+     *  @brief  Number of nodes that can still be inlined in the outermost
+     *          inlined call.
+     */
+    std::size_t budget = 0;
+
+    /**
+     *  @brief  The structure being compiled to registers, if any.
+     */
+    std::optional<unpack_target> unpack_into;
+
+    /**
+     *  @brief  The function being compiled.
+     */
+    std::uint32_t current = no_function;
+
+    /**
+     *  @brief  Local variables of the function being compiled.
+     */
+    std::vector<local_variable> locals;
+
+    /**
+     *  @brief  Scopes of the function being compiled.
+     */
+    std::vector<scope> scopes;
+
+    /**
+     *  @brief  First free register.
+     */
+    std::uint16_t top = 0;
+
+    /**
+     *  @brief  Position of the last jump target, where instructions must
+     *          not be changed by what follows.
+     */
+    std::size_t label = 0;
+
+    /**
+     *  @brief  Token of the instructions being emitted.
+     */
+    std::uint32_t token = 0;
+
+    /**
+     *  @brief  Number of errors.
+     */
+    std::size_t errors = 0;
+
+    /**
+     *  @brief  Set when the program is too large for the bytecode, to
+     *          report it once.
+     */
+    bool too_large = false;
+
+    /**
+     *  @brief  Creates the compiler over the syntax tree.
+     *  @param  dtn  The source code's information.
+     */
+    compiler(detronade &dtn);
+
+    /**
+     *  @brief  Get the function being compiled.
+     *  @return  The function.
+     */
+    [[nodiscard]] inline auto function() -> function_info &
+    {
+        return prog.functions[current];
+    }
+
+    /**
+     *  @brief  Get the structure of the method whose body is being
+     *          compiled, which can be inlined in another function.
+     *  @return  Index of the structure, or @c no_function .
+     */
+    [[nodiscard]] inline auto method_owner() const -> std::uint32_t
+    {
+        auto fn = inlined.empty() ? current : inlined.back().function;
+        return prog.functions[fn].owner;
+    }
+
+    /**
+     *  @brief  Get the register of the structure of the method whose body
+     *          is being compiled.
+     *  @return  The register.
+     */
+    [[nodiscard]] inline auto self() const -> std::uint16_t
+    {
+        return inlined.empty() ? 0 : inlined.back().self;
+    }
+
+    /**
+     *  @brief  Get the kind of the type.
+     *
+     *  @param  type  The type.
+     *  @return  The kind of the type.
+     */
+    [[nodiscard]] inline auto kind(type_index type) const
+    {
+        return prog.types[type].kind;
+    }
+
+    /**
+     *  @brief  Check if the type is `real`, `int`, `bool` or `char`.
+     *
+     *  @param  type  The type.
+     *  @return  True if the type is a number.
+     */
+    [[nodiscard]] inline auto is_scalar(type_index type) const
+    {
+        return type >= real_type && type <= char_type;
+    }
+
+    /**
+     *  @brief  Check if the type is `int`, `bool` or `char`.
+     *
+     *  @param  type  The type.
+     *  @return  True if the type is an integer.
+     */
+    [[nodiscard]] inline auto is_integral(type_index type) const
+    {
+        return type >= int_type && type <= char_type;
+    }
+
+    /**
+     *  @brief  Check if the expression refers to a stored value, which
+     *          has to be copied when stored elsewhere.
+     *
+     *  @param  n  The expression.
+     *  @return  True if it is a name, a member, a subscript or an
+     *           assignment.
+     */
+    [[nodiscard]] inline auto is_place(node_index n) const
+    {
+        auto kind = tree[n].kind;
+        return kind == node_kind::name || kind == node_kind::member
+            || kind == node_kind::subscript || kind == node_kind::assign;
+    }
+
+    /**
+     *  @brief  Check if the value of a local variable can be moved out of
+     *          it after its last use, instead of copied.
+     *
+     *  @param  local  The local variable.
+     *  @return  True if it is an array or a structure without a
+     *           destructor, which is not kept in registers.
+     */
+    [[nodiscard]] inline auto movable(const local_variable &local) const
+    {
+        auto k = kind(local.type);
+        return !local.unpacked && !needs_destroy(local.type)
+            && (k == type_kind::array || k == type_kind::struct_);
+    }
+
+    /**
+     *  @brief  Check if the expression is an assignment, an increment or a
+     *          decrement, which is compiled only for its side effect.
+     *
+     *  @param  e  The expression.
+     *  @return  True if the value of the expression is not needed.
+     */
+    [[nodiscard]] inline auto is_effect(const node &e) const
+    {
+        return e.kind == node_kind::assign
+            || ((e.kind == node_kind::unary || e.kind == node_kind::postfix)
+             && (e.op == operator_kind::increment
+              || e.op == operator_kind::decrement));
+    }
+
+    /**
+     *  @brief  Get the statements of a body, which is a block or a single
+     *          statement.
+     *
+     *  @param  n  The body, stored in the syntax tree.
+     *  @return  Indices of the statements.
+     */
+    [[nodiscard]] inline auto statements(const node_index &n) const
+    {
+        if (tree[n].kind == node_kind::block)
+        {
+            return tree.list(tree[n]);
+        }
+        return std::span<const std::uint32_t>(&n, 1);
+    }
+
+    /**
+     *  @brief  Get the expression that a function returns, if its body is
+     *          only that expression.
+     *
+     *  @param  n  The function node.
+     *  @return  The expression, or @c no_node if the body is anything
+     *           else.
+     */
+    [[nodiscard]] inline auto returned(node_index n) const
+    {
+        auto list = statements(tree.extra[tree[n].b + 1]);
+        if (list.size() != 1)
+        {
+            return no_node;
+        }
+
+        auto &s = tree[list[0]];
+        if (s.kind == node_kind::return_
+         || (s.kind == node_kind::expression && !is_effect(tree[s.a])))
+        {
+            return s.a;
+        }
+        return no_node;
+    }
+
+    /**
+     *  @brief  Get the nodes that a node contains.
+     *
+     *  @param  n  The node.
+     *  @return  The contained nodes, without @c no_node .
+     */
+    [[nodiscard]] inline auto children(node_index n) const
+    {
+        std::vector<node_index> result;
+
+        auto &t   = tree[n];
+        auto  add = [&](node_index c)
+        {
+            if (c != no_node)
+            {
+                result.emplace_back(c);
+            }
+        };
+
+        switch (t.kind)
+        {
+            case node_kind::unary:
+            case node_kind::postfix:
+            case node_kind::member:
+            case node_kind::expression:
+            case node_kind::return_: add(t.a); break;
+            case node_kind::binary:
+            case node_kind::assign:
+            case node_kind::subscript:
+            case node_kind::while_: add(t.a); add(t.b); break;
+            case node_kind::if_: add(t.a); add(t.b); add(t.c); break;
+            case node_kind::variable:
+            case node_kind::type_array: add(t.b); break;
+            case node_kind::for_:
+                add(tree.extra[t.a]);
+                add(tree.extra[t.a + 1]);
+                add(tree.extra[t.a + 2]);
+                add(t.b);
+                break;
+            case node_kind::call:
+                add(t.a);
+                [[fallthrough]];
+            case node_kind::array:
+            case node_kind::block:
+                for (auto c : tree.list(t))
+                {
+                    add(c);
+                }
+                break;
+            case node_kind::declaration:
+                add(t.a);
+                for (auto c : tree.list(t))
+                {
+                    add(c);
+                }
+                break;
+            default: break;
+        }
+        return result;
+    }
+
+    /**
+     *  @brief  Count the nodes of an expression.
+     *
+     *  @param  n  The expression.
+     *  @return  Number of nodes, with @p n .
+     */
+    [[nodiscard]] inline auto measure(node_index n) const -> std::size_t
+    {
+        std::size_t size = 1;
+        for (auto c : children(n))
+        {
+            size += measure(c);
+        }
+        return size;
+    }
+
+    /**
+     *  @brief  Report an error at the token.
+     *
+     *  @param  id   What the error is about.
+     *  @param  tok  Index of the token.
+     *  @param  arg  The argument of the message.
+     *  @return  @c unknown_type .
+     */
+    auto report(
+        message_id       id,
+        std::uint32_t    tok,
+        message_argument arg = {}
+    ) -> type_index;
+
+    /**
+     *  @brief  Report an error at the node.
+     *
+     *  @param  id   What the error is about.
+     *  @param  n    The node.
+     *  @param  arg  The argument of the message.
+     *  @return  @c unknown_type .
+     */
+    auto error(
+        message_id       id,
+        node_index       n,
+        message_argument arg = {}
+    ) -> type_index;
+
+    /**
+     *  @brief  Report that the program is too large for the bytecode, once.
+     */
+    auto overflow() -> void;
+
+    /**
+     *  @brief  Add an instruction to the function being compiled.
+     *
+     *  @param  op  The operation.
+     *  @param  a   First operand.
+     *  @param  b   Second operand.
+     *  @param  c   Third operand.
+     *  @return  Position of the instruction.
+     */
+    auto emit(
+        opcode        op,
+        std::uint16_t a = 0,
+        std::uint16_t b = 0,
+        std::uint16_t c = 0
+    ) -> std::size_t;
+
+    /**
+     *  @brief  Add an instruction with a 32-bit operand to the function being
+     *          compiled.
+     *
+     *  @param  op  The operation.
+     *  @param  a   First operand.
+     *  @param  bc  The 32-bit operand.
+     *  @return  Position of the instruction.
+     */
+    auto emit_bc(
+        opcode        op,
+        std::uint16_t a,
+        std::uint32_t bc
+    ) -> std::size_t;
+
+    /**
+     *  @brief  Make the jump continue from the next instruction.
+     *  @param  jump  Position of the jump.
+     */
+    auto patch(std::size_t jump) -> void;
+
+    /**
+     *  @brief  Mark the next instruction as a jump target.
+     *  @return  Position of the next instruction.
+     */
+    auto mark() -> std::uint32_t;
+
+    /**
+     *  @brief  Remove the instructions from the position onwards, which are
+     *          never run.
+     *
+     *  @param  from  Position of the first instruction to remove.
+     */
+    auto discard(std::size_t from) -> void;
+
+    /**
+     *  @brief  Make the last instruction store its result to another register,
+     *          instead of moving it there afterwards.
+     *
+     *  @param  from  The register that the last instruction stores to.
+     *  @param  to    The register to store to instead.
+     *  @return  True if the last instruction was changed.
+     */
+    auto retarget(std::uint16_t from, std::uint16_t to) -> bool;
+
+    /**
+     *  @brief  Take registers above the used ones.
+     *
+     *  @param  count  Number of registers.
+     *  @return  The first register.
+     */
+    auto allocate(std::size_t count = 1) -> std::uint16_t;
+
+    /**
+     *  @brief  Take consecutive registers at the top for a call.  The
+     *          destination is reused if it is the last register taken.
+     *
+     *  @param  dest  The destination of the call.
+     *  @param  size  Number of registers.
+     *  @return  The first register.
+     */
+    [[nodiscard]] auto window(std::uint16_t dest, std::size_t size)
+    -> std::uint16_t;
+
+    /**
+     *  @brief  Get the constant of the value, adding it if it is new.
+     *
+     *  @param  v  The value.
+     *  @return  Index of the constant.
+     */
+    [[nodiscard]] auto constant(const value &v) -> std::uint32_t;
+
+    /**
+     *  @brief  Load the value to the register.
+     *
+     *  @param  dest  The register.
+     *  @param  v     The value.
+     */
+    auto load(std::uint16_t dest, const value &v) -> void;
+
+    /**
+     *  @brief  Get the array type of the element type, adding it if it is new.
+     *
+     *  @param  element  The element type.
+     *  @return  The array type.
+     */
+    [[nodiscard]] auto array_of(type_index element) -> type_index;
+
+    /**
+     *  @brief  Resolve the type of a @c node_kind::type_name or
+     *          @c node_kind::type_array .
+     *
+     *  @param  n  The type node.
+     *  @return  The type, or @c unknown_type if it is not declared.
+     */
+    [[nodiscard]] auto resolve_type(node_index n) -> type_index;
+
+    /**
+     *  @brief  Check if the values of the type have destructors to call.
+     *
+     *  @param  type  The type.
+     *  @return  True if the structure, its fields or the elements have a
+     *           destructor.
+     */
+    [[nodiscard]] auto needs_destroy(type_index type) const -> bool;
+
+    /**
+     *  @brief  Get how the values of the type are kept in registers.
+     *
+     *  @param  type  The type.
+     *  @return  The structure, or @c nullptr if the type is not a plain
+     *           structure.
+     */
+    [[nodiscard]] auto plain_type(type_index type) const
+    -> const plain_struct *;
+
+    /**
+     *  @brief  Find the operator overload that the program calls for
+     *          operands of the types.
+     *
+     *  @param  op      The operator.
+     *  @param  form    Where the operator is written.
+     *  @param  symbol  Symbol ID of a custom operator.
+     *  @param  lhs     Type of the first operand.
+     *  @param  rhs     Type of the second operand, if there is one.
+     *  @return  The overload, or @c nullptr if it is only found when the
+     *           program runs.
+     */
+    [[nodiscard]] auto find_overload(
+        operator_kind op,
+        operator_form form,
+        std::uint32_t symbol,
+        type_index    lhs,
+        type_index    rhs
+    ) const -> const overload *;
+
+    /**
+     *  @brief  Get the type that an operator overload returns.
+     *
+     *  @param  op      The operator.
+     *  @param  form    Where the operator is written.
+     *  @param  symbol  Symbol ID of a custom operator.
+     *  @param  lhs     Type of the first operand.
+     *  @param  rhs     Type of the second operand, if there is one.
+     *  @return  The return type, or @c unknown_type if the overload is only
+     *           found when the program runs.
+     */
+    [[nodiscard]] auto overload_type(
+        operator_kind op,
+        operator_form form,
+        std::uint32_t symbol,
+        type_index    lhs,
+        type_index    rhs
+    ) const -> type_index;
+
+    /**
+     *  @brief  Get the type of the result of a regular binary operator.
+     *
+     *  @param  op   The operator.
+     *  @param  lhs  Type of the left operand.
+     *  @param  rhs  Type of the right operand.
+     *  @return  The type of the result, or @c unknown_type if it is only
+     *           known when the program runs.
+     */
+    [[nodiscard]] auto binary_type(
+        operator_kind op,
+        type_index    lhs,
+        type_index    rhs
+    ) const -> type_index;
+
+    /**
+     *  @brief  Get the index of a custom operator in
+     *          @c program::operator_symbols , adding it if it is new.
+     *
+     *  @param  symbol  Symbol ID of the operator.
+     *  @return  Index of the operator.
+     */
+    auto operator_index(std::uint32_t symbol) -> std::uint16_t;
+
+    /**
+     *  @brief  Declare a function, method, constructor, destructor or operator
+     *          overload, whose body is compiled later.
+     *
+     *  @param  n      The function node.
+     *  @param  owner  The structure, or @c no_function .
+     *  @return  Index of the function.
+     */
+    [[nodiscard]] auto declare_function(
+        node_index    n,
+        std::uint32_t owner
+    ) -> std::uint32_t;
+
+    /**
+     *  @brief  Add a function to the program.
+     *
+     *  @param  info  The function.
+     *  @return  Index of the function.
+     */
+    [[nodiscard]] auto add_function(function_info info) -> std::uint32_t;
+
+    /**
+     *  @brief  Declare the name of a structure, so that it can be used as a
+     *          type.
+     *
+     *  @param  n  The @c node_kind::struct_ .
+     *  @return  Index of the structure, or @c no_function if it is already
+     *           declared.
+     */
+    [[nodiscard]] auto declare_struct(node_index n) -> std::uint32_t;
+
+    /**
+     *  @brief  Declare the fields, methods, constructors and destructor of a
+     *          structure.
+     *
+     *  @param  s  Index of the structure.
+     *  @param  n  The @c node_kind::struct_ .
+     */
+    auto declare_members(std::uint32_t s, node_index n) -> void;
+
+    /**
+     *  @brief  Declare an operator overload.
+     *  @param  n  The @c node_kind::operator_ .
+     */
+    auto declare_operator(node_index n) -> void;
+
+    /**
+     *  @brief  Add the initializer and the constructors of a structure that
+     *          are not declared.
+     *
+     *  The initializer sets every field to its initial value, and is
+     *  compiled by @c compile_initializer .  A constructor without
+     *  parameters and a constructor with every field are added, unless a
+     *  constructor with the same number of parameters is declared.
+     *
+     *  @param  s  Index of the structure.
+     *  @param  n  The @c node_kind::struct_ .
+     */
+    auto synthesize(std::uint32_t s, node_index n) -> void;
+
+    /**
+     *  @brief  Begin compiling a function, whose parameters take the first
+     *          registers.
+     *
+     *  @param  index  Index of the function.
+     */
+    auto begin_function(std::uint32_t index) -> void;
+
+    /**
+     *  @brief  Finish compiling the function.
+     */
+    auto end_function() -> void;
+
+    /**
+     *  @brief  Compile the body of a function.
+     *
+     *  @param  index  Index of the function.
+     *  @param  n      The function node.
+     */
+    auto compile_function(std::uint32_t index, node_index n) -> void;
+
+    /**
+     *  @brief  Compile the initializer of a structure.  It is compiled after
+     *          the global scope, so that the initial values of the fields
+     *          can use every global variable.
+     *
+     *  @param  s  Index of the structure.
+     */
+    auto compile_initializer(std::uint32_t s) -> void;
+
+    /**
+     *  @brief  Compile the whole program.
+     */
+    auto compile_program() -> void;
+
+    /**
+     *  @brief  Begin a scope.
+     */
+    auto open_scope() -> void;
+
+    /**
+     *  @brief  End the scope, destroying its local variables.
+     */
+    auto close_scope() -> void;
+
+    /**
+     *  @brief  Destroy the local variables, from the last declared.
+     *  @param  from  Index of the first local variable to destroy.
+     */
+    auto destroy_locals(std::size_t from) -> void;
+
+    /**
+     *  @brief  Declare a local variable in the current scope.
+     *
+     *  @param  symbol    Symbol ID of the name.
+     *  @param  type      The declared type.
+     *  @param  reg       The register of the variable.
+     *  @param  constant  Whether the variable is declared `const`.
+     *  @param  n         The declaring node.
+     *  @param  known     The value of a `const` number, if it is known.
+     *  @param  unpacked  Whether the structure is kept in the registers of
+     *                    its fields from @p reg .
+     */
+    auto declare_local(
+        std::uint32_t        symbol,
+        type_index           type,
+        std::uint16_t        reg,
+        bool                 constant,
+        node_index           n,
+        std::optional<value> known    = std::nullopt,
+        bool                 unpacked = false
+    ) -> void;
+
+    /**
+     *  @brief  Return from the function being compiled, destroying every
+     *          local variable.  Returning from @c program::main destroys the
+     *          global variables too.
+     *
+     *  @param  result  The register of the returned value, or
+     *                  @c no_register .
+     *  @param  n       The returned expression.
+     *  @param  type    Type of the returned value.
+     */
+    auto exit_function(
+        std::uint16_t result,
+        node_index    n,
+        type_index    type
+    ) -> void;
+
+    /**
+     *  @brief  Compile the statements of a body in a new scope.
+     *
+     *  @param  n  The body, a block or a statement.
+     *  @return  True if the body never finishes without returning.
+     */
+    auto body(const node_index &n) -> bool;
+
+    /**
+     *  @brief  Compile statements one after another.  The statements after
+     *          one that never finishes are compiled for their messages, and
+     *          their instructions are removed.
+     *
+     *  @param  list    The statements.
+     *  @param  global  Whether the statements are in global scope.
+     *  @return  True if the statements never finish without returning.
+     */
+    auto sequence(std::span<const node_index> list, bool global) -> bool;
+
+    /**
+     *  @brief  Find the names used in a node.
+     *
+     *  @param  n       The node.
+     *  @param  names   The node of each name, or @c no_node for a name that
+     *                  is used more than once, in a loop or declared.
+     *  @param  looped  Whether the node is in a loop.
+     */
+    auto find_uses(
+        node_index                                      n,
+        std::unordered_map<std::uint32_t, node_index> &names,
+        bool                                            looped
+    ) const -> void;
+
+    /**
+     *  @brief  Compile a statement.
+     *
+     *  @param  n       The statement.
+     *  @param  global  Whether the statement is in global scope.
+     *  @param  rest    The statements after it in its block, which see the
+     *                  variables that it declares.
+     *  @return  True if the statement never finishes without returning,
+     *           like `return` and endless loops.
+     */
+    auto statement(
+        node_index                  n,
+        bool                        global,
+        std::span<const node_index> rest
+    ) -> bool;
+
+    /**
+     *  @brief  Compile a loop whose condition is known when compiling.  A
+     *          loop that never runs is compiled for its messages only.
+     *
+     *  @param  runs  Whether the loop runs, and never ends.
+     *  @param  n     The body.
+     *  @param  step  The step of a `for` statement, or @c no_node .
+     */
+    auto loop(bool runs, node_index n, node_index step) -> void;
+
+    /**
+     *  @brief  Compile a declaration of variables.  Declarations in global
+     *          scope declare global variables.
+     *
+     *  @param  n       The @c node_kind::declaration .
+     *  @param  global  Whether the declaration is in global scope.
+     *  @param  scope   The nodes after it that see its variables.
+     */
+    auto declaration(
+        node_index                  n,
+        bool                        global,
+        std::span<const node_index> scope
+    ) -> void;
+
+    /**
+     *  @brief  Compile an expression statement.  An uncaptured expression
+     *          returns from the function, or ends the program in global
+     *          scope, unless it is an assignment, an increment, a decrement
+     *          or a call of a function that returns nothing.
+     *
+     *  @param  n  The @c node_kind::expression .
+     *  @return  True if the expression returns.
+     */
+    auto expression_statement(node_index n) -> bool;
+
+    /**
+     *  @brief  Compile an expression only for its side effects, like the
+     *          initializer and the step of a `for` statement.
+     *
+     *  @param  n  The expression.
+     */
+    auto effect(node_index n) -> void;
+
+    /**
+     *  @brief  Store the initial value of a variable to the register.
+     *
+     *  @param  type       The declared type.
+     *  @param  type_node  The type node.
+     *  @param  init       The initializer, or @c no_node .
+     *  @param  dest       The register.
+     */
+    auto initialize(
+        type_index    type,
+        node_index    type_node,
+        node_index    init,
+        std::uint16_t dest
+    ) -> void;
+
+    /**
+     *  @brief  Store the value of a variable without an initializer.
+     *
+     *  Numbers are 0, arrays have the size in the type or are empty, and
+     *  structures are constructed without arguments.
+     *
+     *  @param  type       The type.
+     *  @param  type_node  The type node.
+     *  @param  dest       The register.
+     */
+    auto default_value(
+        type_index    type,
+        node_index    type_node,
+        std::uint16_t dest
+    ) -> void;
+
+    /**
+     *  @brief  Prepare a value in the register to be stored, converting it
+     *          to the type and copying it if it is stored elsewhere.
+     *
+     *  @param  n     The expression of the value.
+     *  @param  from  Type of the value.
+     *  @param  to    Type to store as.
+     *  @param  reg   The register of the value.
+     */
+    auto finish_store(
+        node_index    n,
+        type_index    from,
+        type_index    to,
+        std::uint16_t reg
+    ) -> void;
+
+    /**
+     *  @brief  Find a local variable, from the innermost scope.
+     *
+     *  @param  symbol  Symbol ID of the name.
+     *  @return  The local variable, or @c nullptr .
+     */
+    [[nodiscard]] auto find_local(std::uint32_t symbol) const
+    -> const local_variable *;
+
+    /**
+     *  @brief  Find where an expression stores its value, evaluating the
+     *          structure, array and index.
+     *
+     *  @param  n  The expression.
+     *  @return  The place, or nothing if the expression cannot be assigned to.
+     */
+    [[nodiscard]] auto find_place(node_index n) -> std::optional<place>;
+
+    /**
+     *  @brief  Find the register of a field of a local variable that is
+     *          kept in registers.
+     *
+     *  @param  n  The expression.
+     *  @return  The place of the field, or nothing if the expression is
+     *           not such a field.
+     */
+    [[nodiscard]] auto unpacked_field(node_index n) const
+    -> std::optional<place>;
+
+    /**
+     *  @brief  Load the value of the place to the register.
+     *
+     *  @param  dest  The register.
+     *  @param  p     The place.
+     */
+    auto load(std::uint16_t dest, const place &p) -> void;
+
+    /**
+     *  @brief  Store the value in the register to the place.
+     *
+     *  @param  p    The place.
+     *  @param  src  The register, which may not hold the value afterwards.
+     */
+    auto store(const place &p, std::uint16_t src) -> void;
+
+    /**
+     *  @brief  Compile an expression, storing its value to the register.
+     *
+     *  @param  n     The expression.
+     *  @param  dest  The register, or @c no_register for assignments,
+     *                increments and decrements whose value is not used.
+     *  @return  Type of the value, or @c unknown_type if it is only known
+     *           when the program runs.
+     */
+    auto expression(node_index n, std::uint16_t dest) -> type_index;
+
+    /**
+     *  @brief  Get the value of an expression that is known when compiling,
+     *          like `2 * pi` or `sqrt(2)`.  It has no side effects, and its
+     *          value is the one it has when the program runs.
+     *
+     *  @param  n  The expression.
+     *  @return  The value, or nothing if it is only known when the program
+     *           runs.
+     */
+    [[nodiscard]] auto fold(node_index n) -> std::optional<value>;
+
+    /**
+     *  @brief  Compute the value of an expression from its operands, for
+     *          @c fold .
+     *
+     *  @param  n  The expression.
+     *  @return  The value, or nothing if it is only known when the program
+     *           runs.
+     */
+    [[nodiscard]] auto compute(node_index n) -> std::optional<value>;
+
+    /**
+     *  @brief  Get the truth of a condition that is known when compiling.
+     *
+     *  @param  n  The condition.
+     *  @return  The truth, or nothing if it is only known when the program
+     *           runs.
+     */
+    [[nodiscard]] auto fold_condition(node_index n) -> std::optional<bool>;
+
+    /**
+     *  @brief  Find the conversion or the builtin function that a call is
+     *          compiled to, looking up the name like @c call does.
+     *
+     *  @param  n  The @c node_kind::call .
+     *  @return  The type of a conversion like `int(x)` or the builtin
+     *           function, or nothing if the call is compiled otherwise or
+     *           has the wrong number of arguments.
+     */
+    [[nodiscard]] auto intrinsic(node_index n) const
+    -> std::optional<std::variant<type_index, builtin_function>>;
+
+    /**
+     *  @brief  Find the function or the method that a call calls, looking
+     *          up the name like @c call and @c method do.
+     *
+     *  @param  n  The @c node_kind::call .
+     *  @return  The function, or @c no_function if the call is compiled
+     *           otherwise or the structure is not easily known.
+     */
+    [[nodiscard]] auto resolve_call(node_index n) const -> std::uint32_t;
+
+    /**
+     *  @brief  Get the type of an expression without compiling it.
+     *
+     *  @param  n  The expression.
+     *  @return  The type, or @c unknown_type if it is not easily known.
+     */
+    [[nodiscard]] auto static_type(node_index n) const -> type_index;
+
+    /**
+     *  @brief  Check if the value of an expression is always of its type
+     *          when the program runs, so that it needs no conversion or
+     *          check.
+     *
+     *  @param  n  The expression.
+     *  @return  True if the value is always of its type, or the program
+     *           stops with an error before it is used.
+     */
+    [[nodiscard]] auto exact(node_index n) const -> bool;
+
+    /**
+     *  @brief  Check if an operator calls an overload found when
+     *          compiling, which always returns a value of its type.
+     *
+     *  @param  n  The @c node_kind::unary , @c node_kind::postfix ,
+     *             @c node_kind::binary or @c node_kind::subscript .
+     *  @return  True if the overload is found when compiling and always
+     *           returns.
+     */
+    [[nodiscard]] auto exact_overload(node_index n) const -> bool;
+
+    /**
+     *  @brief  Find what the statements and expressions of a node can
+     *          change.
+     *
+     *  @param  n  The node.
+     *  @param  e  Receives the effects.
+     */
+    auto scan(node_index n, effects &e) const -> void;
+
+    /**
+     *  @brief  Find what a node can change, without the nodes that it
+     *          contains.
+     *
+     *  @param  n  The node.
+     *  @param  e  Receives the effects.
+     */
+    auto affect(node_index n, effects &e) const -> void;
+
+    /**
+     *  @brief  Check if an expression has no side effects, cannot fail when
+     *          the program runs, and has the same value anywhere in a region.
+     *
+     *  @param  n  The expression.
+     *  @param  e  The effects of the region.
+     *  @return  True if the expression can be evaluated once for the
+     *           region.
+     */
+    [[nodiscard]] auto pure(node_index n, const effects &e) const -> bool;
+
+    /**
+     *  @brief  Find the expressions in a node that can be evaluated once for
+     *          a region, the operands before the expressions using them.
+     *
+     *  @param  n        The node.
+     *  @param  e        The effects of the region.
+     *  @param  maximal  Whether to find only the largest expressions, and
+     *                   not their operands.
+     *  @param  found    Receives the expressions.
+     */
+    auto collect(
+        node_index               n,
+        const effects           &e,
+        bool                     maximal,
+        std::vector<node_index> &found
+    ) -> void;
+
+    /**
+     *  @brief  Check if two expressions are written the same.
+     *
+     *  @param  a  The first expression.
+     *  @param  b  The second expression.
+     *  @return  True if they have the same operators, names and values.
+     */
+    [[nodiscard]] auto same(node_index a, node_index b) const -> bool;
+
+    /**
+     *  @brief  Hash an expression, so that expressions written the same
+     *          have the same hash.
+     *
+     *  @param  n  The expression.
+     *  @return  The hash.
+     */
+    [[nodiscard]] auto fingerprint(node_index n) const -> std::size_t;
+
+    /**
+     *  @brief  Check if the value of a local variable, and not only its
+     *          fields, is used in a node.  Such a value escapes, and the
+     *          structure has to be created.
+     *
+     *  @param  n       The node, or @c no_node .
+     *  @param  symbol  Symbol ID of the variable.
+     *  @param  s       Index of the structure of the variable.
+     *  @param  passes  Whether the value can be passed to small functions
+     *                  and operator overloads that only use its fields.
+     *  @return  True if the node uses the value, calls a method on it or
+     *           declares another variable of the name.
+     */
+    [[nodiscard]] auto escapes(
+        node_index    n,
+        std::uint32_t symbol,
+        std::uint32_t s,
+        bool          passes
+    ) const -> bool;
+
+    /**
+     *  @brief  Check if an expression is a call of a constructor of the
+     *          type, or of a small function or operator overload that
+     *          returns one.
+     *
+     *  @param  n     The expression.
+     *  @param  type  The type.
+     *  @return  True if the expression is worth compiling with
+     *           @c unpack .
+     */
+    [[nodiscard]] auto constructs(node_index n, type_index type) const
+    -> bool;
+
+    /**
+     *  @brief  Evaluate the expressions whose value stays the same in a
+     *          region before it, each to a register that the region uses
+     *          instead of evaluating the expression again.
+     *
+     *  Loops hoist the largest such expressions out of the loop.  Blocks
+     *  hoist the expressions and operands that are written more than once,
+     *  to evaluate them once.
+     *
+     *  @param  region  The nodes of the region.
+     *  @param  uses    How many times an expression has to be written to be
+     *                  hoisted.
+     *  @return  The hoisted expressions, to @c release after the region.
+     */
+    auto hoist(std::span<const node_index> region, std::size_t uses)
+    -> std::vector<node_index>;
+
+    /**
+     *  @brief  Forget the hoisted expressions at the end of their region.
+     *  @param  hoisted_nodes  The expressions that @c hoist returned.
+     */
+    auto release(std::span<const node_index> hoisted_nodes) -> void;
+
+    /**
+     *  @brief  Remember how much has been emitted.
+     *  @return  The checkpoint.
+     */
+    [[nodiscard]] auto save() const -> checkpoint;
+
+    /**
+     *  @brief  Remove what has been emitted since the checkpoint, with the
+     *          messages.
+     *  @param  saved  The checkpoint.
+     */
+    auto restore(const checkpoint &saved) -> void;
+
+    /**
+     *  @brief  Choose the function that takes the number of arguments.
+     *
+     *  @param  candidates  The functions of the name.
+     *  @param  count       Number of arguments, with the implicit ones.
+     *  @return  The function, or @c no_function if none takes them.
+     */
+    [[nodiscard]] auto choose(
+        std::span<const std::uint32_t> candidates,
+        std::size_t                    count
+    ) const -> std::uint32_t;
+
+    /**
+     *  @brief  Check if a function can be compiled in place of a call,
+     *          and take its size from the budget.
+     *
+     *  @param  fn  Index of the function.
+     *  @return  The function node, or @c no_node if it is too large, is
+     *           being compiled, or does not only return an expression.
+     */
+    [[nodiscard]] auto expansion(std::uint32_t fn) -> node_index;
+
+    /**
+     *  @brief  Check if a parameter of an inlined function needs a copy
+     *          of its argument, because the expression changes it, keeps
+     *          it, or reads it after code that can change the argument.
+     *
+     *  @param  n        The expression.
+     *  @param  symbol   Symbol ID of the parameter.
+     *  @param  changed  Whether code that can change a structure or an
+     *                   array has run before the expression, updated to
+     *                   after it.
+     *  @return  True if the parameter needs its own value.
+     */
+    [[nodiscard]] auto needs_copy(
+        node_index    n,
+        std::uint32_t symbol,
+        bool         &changed
+    ) const -> bool;
+
+    /**
+     *  @brief  Find the parameters of a function that need their own
+     *          values when it is inlined.
+     *
+     *  @param  fn  Index of the function.
+     *  @param  n   The function node.
+     *  @return  Whether each written parameter needs its own value.
+     */
+    [[nodiscard]] auto owned(std::uint32_t fn, node_index n)
+    -> std::vector<bool>;
+
+    /**
+     *  @brief  Compile the expression that a function returns in place of
+     *          a call.
+     *
+     *  @param  fn        Index of the function.
+     *  @param  n         The function node.
+     *  @param  regs      The registers of the written parameters.
+     *  @param  unpacked  Whether each parameter is a structure kept in the
+     *                    registers of its fields, or empty if none is.
+     *  @param  obj       The register of the structure of a method.
+     *  @param  dest      The register of the result.
+     *  @return  Type of the value, or nothing if the body has errors or
+     *           does not give a value.
+     */
+    [[nodiscard]] auto substitute(
+        std::uint32_t                  fn,
+        node_index                     n,
+        std::span<const std::uint16_t> regs,
+        const std::vector<bool>       &unpacked,
+        std::uint16_t                  obj,
+        std::uint16_t                  dest
+    ) -> std::optional<type_index>;
+
+    /**
+     *  @brief  Compile a call of a small function or method in place,
+     *          instead of calling it.
+     *
+     *  @param  n         The @c node_kind::call .
+     *  @param  fn        Index of the function.
+     *  @param  receiver  The structure of a method, or @c no_node for
+     *                    the structure of the method being compiled.
+     *  @param  dest      The register.
+     *  @return  Type of the value, or nothing if nothing is emitted and
+     *           the function has to be called.
+     */
+    [[nodiscard]] auto expand_call(
+        node_index    n,
+        std::uint32_t fn,
+        node_index    receiver,
+        std::uint16_t dest
+    ) -> std::optional<type_index>;
+
+    /**
+     *  @brief  Compile a small operator overload in place, instead of
+     *          calling it when the program runs.
+     *
+     *  @param  ov        The overload, or @c nullptr .
+     *  @param  operands  The registers of the operands.
+     *  @param  known     Whether each operand is always of its type.
+     *  @param  unpacked  Whether each operand is a structure in the
+     *                    registers of its fields.
+     *  @param  dest      The register.
+     *  @return  Type of the value, or nothing if nothing is emitted and
+     *           the overload has to be called.
+     */
+    [[nodiscard]] auto expand_operator(
+        const overload                *ov,
+        std::span<const std::uint16_t> operands,
+        std::span<const bool>          known,
+        const std::vector<bool>       &unpacked,
+        std::uint16_t                  dest
+    ) -> std::optional<type_index>;
+
+    /**
+     *  @brief  Compile an operator whose overload is found when compiling,
+     *          in place if it is small, otherwise as a call of the
+     *          overload.
+     *
+     *  @param  ov        The overload, or @c nullptr .
+     *  @param  nodes     The operands.
+     *  @param  operands  The registers of the operands.
+     *  @param  types     Types of the operands.
+     *  @param  dest      The register.
+     *  @return  Type of the value, or nothing if nothing is emitted and
+     *           the overload is only found when the program runs.
+     */
+    [[nodiscard]] auto call_overload(
+        const overload                *ov,
+        std::span<const node_index>    nodes,
+        std::span<const std::uint16_t> operands,
+        std::span<const type_index>    types,
+        std::uint16_t                  dest
+    ) -> std::optional<type_index>;
+
+    /**
+     *  @brief  Compile an operator whose small overload is found when
+     *          compiling, with the structures it only reads the fields of
+     *          passed in registers instead of being created.
+     *
+     *  @param  n     The operator.
+     *  @param  dest  The register.
+     *  @return  Type of the value, or nothing if nothing is emitted.
+     */
+    [[nodiscard]] auto unpacked_operator(
+        node_index    n,
+        std::uint16_t dest
+    ) -> std::optional<type_index>;
+
+    /**
+     *  @brief  Compile a structure to the registers of its fields, if the
+     *          constructor that gives its value is compiled here or in an
+     *          inlined body, without creating the structure.
+     *
+     *  @param  n      The expression.
+     *  @param  type   A plain structure type.
+     *  @param  first  The register of the first field.
+     *  @return  True if the fields are compiled, false if nothing is
+     *           emitted.
+     */
+    [[nodiscard]] auto unpack(
+        node_index    n,
+        type_index    type,
+        std::uint16_t first
+    ) -> bool;
+
+    /**
+     *  @brief  Create a structure from the registers of its fields.
+     *
+     *  @param  first  The register of the first field.
+     *  @param  type   A plain structure type.
+     *  @param  dest   The register of the structure.
+     */
+    auto pack(std::uint16_t first, type_index type, std::uint16_t dest)
+    -> void;
+
+    /**
+     *  @brief  Get the register of a local variable, or compile the
+     *          expression to a new register.
+     *
+     *  @param  n  The expression.
+     *  @return  The register and the type of the value.
+     */
+    [[nodiscard]] auto operand(node_index n)
+    -> std::pair<std::uint16_t, type_index>;
+
+    /**
+     *  @brief  Compile an expression by its kind.
+     *
+     *  @param  n     The expression.
+     *  @param  dest  The register.
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto evaluate(node_index n, std::uint16_t dest) -> type_index;
+
+    /**
+     *  @brief  Compile a name: a local variable, a field of the structure of
+     *          the method, a global variable or `pi`.
+     *
+     *  @param  n     The @c node_kind::name .
+     *  @param  dest  The register.
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto name(node_index n, std::uint16_t dest) -> type_index;
+
+    /**
+     *  @brief  Compile a prefix or postfix operator.
+     *
+     *  @param  n     The @c node_kind::unary or @c node_kind::postfix .
+     *  @param  dest  The register.
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto unary(node_index n, std::uint16_t dest) -> type_index;
+
+    /**
+     *  @brief  Compile a binary operator.
+     *
+     *  @param  n     The @c node_kind::binary .
+     *  @param  dest  The register.
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto binary(node_index n, std::uint16_t dest) -> type_index;
+
+    /**
+     *  @brief  Apply a binary operator to the value in the register and the
+     *          expression.
+     *
+     *  @param  op     The operator.
+     *  @param  dest   The register of the result.
+     *  @param  lhs    The register of the left operand.
+     *  @param  type   Type of the left operand.
+     *  @param  left   The left operand.
+     *  @param  rhs    The right operand.
+     *  @return  Type of the result.
+     */
+    [[nodiscard]] auto combine(
+        operator_kind op,
+        std::uint16_t dest,
+        std::uint16_t lhs,
+        type_index    type,
+        node_index    left,
+        node_index    rhs
+    ) -> type_index;
+
+    /**
+     *  @brief  Apply a binary operator to numbers that are always of their
+     *          types, with the opcode of their type.  An `int` operand is
+     *          converted to `real` if the other is a `real`.
+     *
+     *  @param  op     The opcode, from @c opcode::add to
+     *                 @c opcode::not_equal .
+     *  @param  dest   The register of the result.
+     *  @param  lhs    The register of the left operand.
+     *  @param  left   Type of the left operand.
+     *  @param  rhs    The register of the right operand.
+     *  @param  right  Type of the right operand.
+     *  @return  True if the operator was emitted, false if the types have
+     *           no such opcode.
+     */
+    auto typed(
+        opcode        op,
+        std::uint16_t dest,
+        std::uint16_t lhs,
+        type_index    left,
+        std::uint16_t rhs,
+        type_index    right
+    ) -> bool;
+
+    /**
+     *  @brief  Make the `real` constant that was just loaded to the
+     *          register an `int`, if it is a whole number that fits.
+     *
+     *  @param  reg  The register.
+     *  @return  True if the constant was changed.
+     */
+    auto narrow(std::uint16_t reg) -> bool;
+
+    /**
+     *  @brief  Compile the right operand of `&&` or `||`, only if the left
+     *          operand in the register does not decide the result.
+     *
+     *  @param  op    @c operator_kind::logical_and or
+     *                @c operator_kind::logical_or .
+     *  @param  dest  The register of the left operand and the result.
+     *  @param  rhs   The right operand.
+     */
+    auto logical(
+        operator_kind op,
+        std::uint16_t dest,
+        node_index    rhs
+    ) -> void;
+
+    /**
+     *  @brief  Compile a custom operator, whose overload is found when the
+     *          program runs.
+     *
+     *  @param  n     The @c node_kind::unary , @c node_kind::postfix or
+     *                @c node_kind::binary .
+     *  @param  dest  The register.
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto custom(node_index n, std::uint16_t dest) -> type_index;
+
+    /**
+     *  @brief  Compile an assignment.
+     *
+     *  @param  n     The @c node_kind::assign .
+     *  @param  dest  The register, or @c no_register .
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto assign(node_index n, std::uint16_t dest) -> type_index;
+
+    /**
+     *  @brief  Compile an increment or a decrement.
+     *
+     *  @param  n     The @c node_kind::unary or @c node_kind::postfix .
+     *  @param  dest  The register, or @c no_register .
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto increment(node_index n, std::uint16_t dest)
+    -> type_index;
+
+    /**
+     *  @brief  Compile a call of a function, a method, a constructor, a
+     *          builtin function, an array method, or a conversion like
+     *          `int(x)`.
+     *
+     *  @param  n     The @c node_kind::call .
+     *  @param  dest  The register.
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto call(node_index n, std::uint16_t dest) -> type_index;
+
+    /**
+     *  @brief  Choose the function with the number of arguments, and compile
+     *          the arguments to the registers of the call.
+     *
+     *  @param  n           The @c node_kind::call .
+     *  @param  candidates  The functions of the name.
+     *  @param  base        The first register of the call.
+     *  @param  implicit    Number of arguments before the written ones, like
+     *                      the structure of a method.
+     *  @return  The function, or @c no_function if none takes the arguments.
+     */
+    [[nodiscard]] auto invoke(
+        node_index                     n,
+        std::span<const std::uint32_t> candidates,
+        std::uint16_t                  base,
+        std::size_t                    implicit
+    ) -> std::uint32_t;
+
+    /**
+     *  @brief  Compile a call of a method, or of `count`, `insert` and
+     *          `remove` of an array.
+     *
+     *  @param  n     The @c node_kind::call of a @c node_kind::member .
+     *  @param  dest  The register.
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto method(node_index n, std::uint16_t dest) -> type_index;
+
+    /**
+     *  @brief  Compile a member access of a structure.
+     *
+     *  @param  n     The @c node_kind::member .
+     *  @param  dest  The register.
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto member(node_index n, std::uint16_t dest) -> type_index;
+
+    /**
+     *  @brief  Compile a subscript of an array, or the subscript operator
+     *          overload of a structure.
+     *
+     *  @param  n     The @c node_kind::subscript .
+     *  @param  dest  The register.
+     *  @return  Type of the value.
+     */
+    [[nodiscard]] auto subscript(node_index n, std::uint16_t dest)
+    -> type_index;
+
+    /**
+     *  @brief  Compile an array literal.  The elements have the same type if
+     *          all of them do.
+     *
+     *  @param  n     The @c node_kind::array .
+     *  @param  dest  The register.
+     *  @return  Type of the array.
+     */
+    [[nodiscard]] auto array(node_index n, std::uint16_t dest) -> type_index;
+};
+
+/**
+ *  @brief  Creates the compiler over the syntax tree.
+ *  @param  dtn  The source code's information.
+ */
+compiler::compiler(detronade &dtn) : dtn(dtn), tree(dtn.tree)
+{
+    auto &symbols = dtn.symbols;
+    words = names {
+        .void_  = symbols.intern("void"),
+        .real   = symbols.intern("real"),
+        .int_   = symbols.intern("int"),
+        .bool_  = symbols.intern("bool"),
+        .char_  = symbols.intern("char"),
+        .pi     = symbols.intern("pi"),
+        .count  = symbols.intern("count"),
+        .insert = symbols.intern("insert"),
+        .remove = symbols.intern("remove")
+    };
+
+    prog.types = {
+        { .kind = type_kind::unknown },
+        { .kind = type_kind::void_ },
+        { .kind = type_kind::real },
+        { .kind = type_kind::int_ },
+        { .kind = type_kind::bool_ },
+        { .kind = type_kind::char_ }
+    };
+    type_names = {
+        { words.void_, void_type },
+        { words.real, real_type },
+        { words.int_, int_type },
+        { words.bool_, bool_type },
+        { words.char_, char_type }
+    };
+
+    for (std::size_t i = 0; i < plons::dtn::builtins().size(); i++)
+    {
+        auto function = static_cast<builtin_function>(i);
+        builtins.emplace(symbols.intern(to_string(function)), function);
+    }
+    opaque.assign(tree.nodes.size(), false);
+    last_uses.assign(tree.nodes.size(), false);
+}
+
+/**
+ *  @brief  Report an error at the token.
+ *
+ *  @param  id   What the error is about.
+ *  @param  tok  Index of the token.
+ *  @param  arg  The argument of the message.
+ *  @return  @c unknown_type .
+ */
+auto compiler::report(
+    message_id       id,
+    std::uint32_t    tok,
+    message_argument arg
+) -> type_index
+{
+    errors++;
+
+    auto &t = dtn.tokens[tok];
+    dtn.messages.emplace_back(message {
+        .id          = id,
+        .severity    = message_severity::error,
+        .pos         = {
+            .begin   = dtn.offset(tok),
+            .length  = t.length,
+            .pointer = 0
+        },
+        .args        = { arg }
+    });
+    return unknown_type;
+}
+
+/**
+ *  @brief  Report an error at the node.
+ *
+ *  @param  id   What the error is about.
+ *  @param  n    The node.
+ *  @param  arg  The argument of the message.
+ *  @return  @c unknown_type .
+ */
+auto compiler::error(
+    message_id       id,
+    node_index       n,
+    message_argument arg
+) -> type_index
+{
+    return report(id, tree[n].token, arg);
+}
+
+/**
+ *  @brief  Report that the program is too large for the bytecode, once.
+ */
+auto compiler::overflow() -> void
+{
+    if (!too_large)
+    {
+        too_large = true;
+        report(message_id::program_too_large, token);
+    }
+}
+
+/**
+ *  @brief  Add an instruction to the function being compiled.
+ *
+ *  @param  op  The operation.
+ *  @param  a   First operand.
+ *  @param  b   Second operand.
+ *  @param  c   Third operand.
+ *  @return  Position of the instruction.
+ */
+auto compiler::emit(
+    opcode        op,
+    std::uint16_t a,
+    std::uint16_t b,
+    std::uint16_t c
+) -> std::size_t
+{
+    auto &fn = function();
+    fn.code.emplace_back(instruction {
+        .op = op,
+        .a  = a,
+        .b  = b,
+        .c  = c
+    });
+    fn.tokens.emplace_back(token);
+    return fn.code.size() - 1;
+}
+
+/**
+ *  @brief  Add an instruction with a 32-bit operand to the function being
+ *          compiled.
+ *
+ *  @param  op  The operation.
+ *  @param  a   First operand.
+ *  @param  bc  The 32-bit operand.
+ *  @return  Position of the instruction.
+ */
+auto compiler::emit_bc(
+    opcode        op,
+    std::uint16_t a,
+    std::uint32_t bc
+) -> std::size_t
+{
+    auto at = emit(op, a);
+    function().code[at].set_bc(bc);
+    return at;
+}
+
+/**
+ *  @brief  Make the jump continue from the next instruction.
+ *  @param  jump  Position of the jump.
+ */
+auto compiler::patch(std::size_t jump) -> void
+{
+    auto &code = function().code;
+    code[jump].set_bc(static_cast<std::uint32_t>(code.size()));
+    label = code.size();
+}
+
+/**
+ *  @brief  Mark the next instruction as a jump target.
+ *  @return  Position of the next instruction.
+ */
+auto compiler::mark() -> std::uint32_t
+{
+    label = function().code.size();
+    return static_cast<std::uint32_t>(label);
+}
+
+/**
+ *  @brief  Remove the instructions from the position onwards, which are
+ *          never run.
+ *
+ *  @param  from  Position of the first instruction to remove.
+ */
+auto compiler::discard(std::size_t from) -> void
+{
+    auto &fn = function();
+    fn.code.resize(from);
+    fn.tokens.resize(from);
+    label = std::min(label, from);
+}
+
+/**
+ *  @brief  Make the last instruction store its result to another register,
+ *          instead of moving it there afterwards.
+ *
+ *  @param  from  The register that the last instruction stores to.
+ *  @param  to    The register to store to instead.
+ *  @return  True if the last instruction was changed.
+ */
+auto compiler::retarget(std::uint16_t from, std::uint16_t to) -> bool
+{
+    auto &code = function().code;
+    if (code.empty() || label >= code.size() || code.back().a != from
+     || !writes_only_a(code.back().op))
+    {
+        return false;
+    }
+
+    code.back().a = to;
+    return true;
+}
+
+/**
+ *  @brief  Take registers above the used ones.
+ *
+ *  @param  count  Number of registers.
+ *  @return  The first register.
+ */
+auto compiler::allocate(std::size_t count) -> std::uint16_t
+{
+    auto reg = top;
+    if (top + count >= no_register)
+    {
+        overflow();
+        return reg;
+    }
+
+    top                  = static_cast<std::uint16_t>(top + count);
+    function().registers = std::max(function().registers, top);
+    return reg;
+}
+
+/**
+ *  @brief  Take consecutive registers at the top for a call.  The
+ *          destination is reused if it is the last register taken.
+ *
+ *  @param  dest  The destination of the call.
+ *  @param  size  Number of registers.
+ *  @return  The first register.
+ */
+auto compiler::window(std::uint16_t dest, std::size_t size) -> std::uint16_t
+{
+    size = std::max<std::size_t>(size, 1);
+    if (dest != no_register && dest + 1 == top)
+    {
+        allocate(size - 1);
+        return dest;
+    }
+    return allocate(size);
+}
+
+/**
+ *  @brief  Get the constant of the value, adding it if it is new.
+ *
+ *  @param  v  The value.
+ *  @return  Index of the constant.
+ */
+auto compiler::constant(const value &v) -> std::uint32_t
+{
+    // Numbers are shared by their boxed bits, which tell their type too
+    if (v.is_object())
+    {
+        prog.constants.emplace_back(v);
+        return static_cast<std::uint32_t>(prog.constants.size() - 1);
+    }
+
+    auto [it, inserted] = constants.try_emplace(v.bits,
+        static_cast<std::uint32_t>(prog.constants.size()));
+    if (inserted)
+    {
+        prog.constants.emplace_back(v);
+    }
+    return it->second;
+}
+
+/**
+ *  @brief  Load the value to the register.
+ *
+ *  @param  dest  The register.
+ *  @param  v     The value.
+ */
+auto compiler::load(std::uint16_t dest, const value &v) -> void
+{
+    emit_bc(opcode::load_constant, dest, constant(v));
+}
+
+/**
+ *  @brief  Get the array type of the element type, adding it if it is new.
+ *
+ *  @param  element  The element type.
+ *  @return  The array type.
+ */
+auto compiler::array_of(type_index element) -> type_index
+{
+    auto [it, inserted] = array_types.try_emplace(element,
+        static_cast<type_index>(prog.types.size()));
+    if (inserted)
+    {
+        prog.types.emplace_back(type_info {
+            .kind  = type_kind::array,
+            .index = element
+        });
+        if (prog.types.size() > no_register)
+        {
+            overflow();
+        }
+    }
+    return it->second;
+}
+
+/**
+ *  @brief  Resolve the type of a @c node_kind::type_name or
+ *          @c node_kind::type_array .
+ *
+ *  @param  n  The type node.
+ *  @return  The type, or @c unknown_type if it is not declared.
+ */
+auto compiler::resolve_type(node_index n) -> type_index
+{
+    auto &type = tree[n];
+    if (type.kind == node_kind::type_array)
+    {
+        auto element = resolve_type(type.a);
+        if (element == void_type)
+        {
+            return error(message_id::unknown_type, n);
+        }
+        return array_of(element);
+    }
+
+    auto it = type_names.find(type.a);
+    if (it == type_names.end())
+    {
+        return error(message_id::unknown_type, n);
+    }
+    return it->second;
+}
+
+/**
+ *  @brief  Check if the values of the type have destructors to call.
+ *
+ *  @param  type  The type.
+ *  @return  True if the structure, its fields or the elements have a
+ *           destructor.
+ */
+auto compiler::needs_destroy(type_index type) const -> bool
+{
+    auto &info = prog.types[type];
+    switch (info.kind)
+    {
+        case type_kind::struct_: return prog.structs[info.index].needs_destroy;
+        case type_kind::array: return needs_destroy(info.index);
+        default: return false;
+    }
+}
+
+/**
+ *  @brief  Get how the values of the type are kept in registers.
+ *
+ *  @param  type  The type.
+ *  @return  The structure, or @c nullptr if the type is not a plain
+ *           structure.
+ */
+auto compiler::plain_type(type_index type) const -> const plain_struct *
+{
+    if (kind(type) != type_kind::struct_)
+    {
+        return nullptr;
+    }
+
+    // A destructor has to run on the structure itself
+    auto &info = plain[prog.types[type].index];
+    return info.has_value() && !needs_destroy(type) ? &info.value()
+         : nullptr;
+}
+
+/**
+ *  @brief  Find the operator overload that the program calls for
+ *          operands of the types.
+ *
+ *  @param  op      The operator.
+ *  @param  form    Where the operator is written.
+ *  @param  symbol  Symbol ID of a custom operator.
+ *  @param  lhs     Type of the first operand.
+ *  @param  rhs     Type of the second operand, if there is one.
+ *  @return  The overload, or @c nullptr if it is only found when the
+ *           program runs.
+ */
+auto compiler::find_overload(
+    operator_kind op,
+    operator_form form,
+    std::uint32_t symbol,
+    type_index    lhs,
+    type_index    rhs
+) const -> const overload *
+{
+    bool binary   = form == operator_form::binary
+                 || form == operator_form::subscript;
+    auto operands = std::array { lhs, rhs };
+    if (lhs == unknown_type || (binary && rhs == unknown_type))
+    {
+        return nullptr;
+    }
+    return match_overload(prog, op, form, symbol,
+        std::span(operands).first(binary ? 2 : 1));
+}
+
+/**
+ *  @brief  Get the type that an operator overload returns.
+ *
+ *  @param  op      The operator.
+ *  @param  form    Where the operator is written.
+ *  @param  symbol  Symbol ID of a custom operator.
+ *  @param  lhs     Type of the first operand.
+ *  @param  rhs     Type of the second operand, if there is one.
+ *  @return  The return type, or @c unknown_type if the overload is only
+ *           found when the program runs.
+ */
+auto compiler::overload_type(
+    operator_kind op,
+    operator_form form,
+    std::uint32_t symbol,
+    type_index    lhs,
+    type_index    rhs
+) const -> type_index
+{
+    auto ov = find_overload(op, form, symbol, lhs, rhs);
+    return ov ? prog.functions[ov->function].return_type : unknown_type;
+}
+
+/**
+ *  @brief  Get the type of the result of a regular binary operator.
+ *
+ *  @param  op   The operator.
+ *  @param  lhs  Type of the left operand.
+ *  @param  rhs  Type of the right operand.
+ *  @return  The type of the result, or @c unknown_type if it is only
+ *           known when the program runs.
+ */
+auto compiler::binary_type(
+    operator_kind op,
+    type_index    lhs,
+    type_index    rhs
+) const -> type_index
+{
+    if (kind(lhs) == type_kind::struct_ || kind(rhs) == type_kind::struct_)
+    {
+        return overload_type(op, operator_form::binary, 0, lhs, rhs);
+    }
+
+    switch (op)
+    {
+    using enum operator_kind;
+        case less:
+        case less_equal:
+        case greater:
+        case greater_equal:
+        case equal:
+        case not_equal: return bool_type;
+        case divide:
+        case power: return real_type;
+        case shift_left:
+        case shift_right:
+        case bitwise_and:
+        case bitwise_xor:
+        case bitwise_or: return int_type;
+        default: break;
+    }
+
+    if (op == operator_kind::add && kind(lhs) == type_kind::array)
+    {
+        return lhs;
+    }
+    if (is_integral(lhs) && is_integral(rhs))
+    {
+        return int_type;
+    }
+    if (is_scalar(lhs) && is_scalar(rhs))
+    {
+        return real_type;
+    }
+    return unknown_type;
+}
+
+/**
+ *  @brief  Get the index of a custom operator in
+ *          @c program::operator_symbols , adding it if it is new.
+ *
+ *  @param  symbol  Symbol ID of the operator.
+ *  @return  Index of the operator.
+ */
+auto compiler::operator_index(std::uint32_t symbol) -> std::uint16_t
+{
+    auto [it, inserted] = operator_indices.try_emplace(symbol,
+        static_cast<std::uint16_t>(prog.operator_symbols.size()));
+    if (inserted)
+    {
+        prog.operator_symbols.emplace_back(symbol);
+        if (prog.operator_symbols.size() > no_register)
+        {
+            overflow();
+        }
+    }
+    return it->second;
+}
+
+/**
+ *  @brief  Declare a function, method, constructor, destructor or operator
+ *          overload, whose body is compiled later.
+ *
+ *  @param  n      The function node.
+ *  @param  owner  The structure, or @c no_function .
+ *  @return  Index of the function.
+ */
+auto compiler::declare_function(
+    node_index    n,
+    std::uint32_t owner
+) -> std::uint32_t
+{
+    auto         &fn   = tree[n];
+    function_info info = {
+        .symbol = tree.function_symbol(fn),
+        .owner  = owner
+    };
+
+    if (owner != no_function)
+    {
+        info.parameters.emplace_back(prog.structs[owner].type);
+    }
+    for (auto param : tree.parameters(fn))
+    {
+        info.parameters.emplace_back(resolve_type(tree[param].a));
+    }
+    if (fn.a != no_node)
+    {
+        info.return_type = resolve_type(fn.a);
+    }
+
+    auto index = add_function(std::move(info));
+    bodies.emplace_back(index, n);
+    return index;
+}
+
+/**
+ *  @brief  Add a function to the program.
+ *
+ *  @param  info  The function.
+ *  @return  Index of the function.
+ */
+auto compiler::add_function(function_info info) -> std::uint32_t
+{
+    auto index = static_cast<std::uint32_t>(prog.functions.size());
+    if (index >= no_register)
+    {
+        overflow();
+    }
+
+    prog.functions.emplace_back(std::move(info));
+    return index;
+}
+
+/**
+ *  @brief  Declare the name of a structure, so that it can be used as a
+ *          type.
+ *
+ *  @param  n  The @c node_kind::struct_ .
+ *  @return  Index of the structure, or @c no_function if it is already
+ *           declared.
+ */
+auto compiler::declare_struct(node_index n) -> std::uint32_t
+{
+    auto symbol = tree[n].a;
+    if (type_names.contains(symbol))
+    {
+        error(message_id::redeclared_name, n);
+        return no_function;
+    }
+
+    auto index = static_cast<std::uint32_t>(prog.structs.size());
+    auto type  = static_cast<type_index>(prog.types.size());
+    prog.types.emplace_back(type_info {
+        .kind  = type_kind::struct_,
+        .index = index
+    });
+    prog.structs.emplace_back(struct_info {
+        .symbol = symbol,
+        .type   = type
+    });
+    type_names.emplace(symbol, type);
+
+    fields.emplace_back();
+    methods.emplace_back();
+    constructors.emplace_back();
+    field_declarations.emplace_back();
+    plain.emplace_back();
+    return index;
+}
+
+/**
+ *  @brief  Declare the fields, methods, constructors and destructor of a
+ *          structure.
+ *
+ *  @param  s  Index of the structure.
+ *  @param  n  The @c node_kind::struct_ .
+ */
+auto compiler::declare_members(std::uint32_t s, node_index n) -> void
+{
+    for (auto m : statements(tree[n].b))
+    {
+        auto &item = tree[m];
+        switch (item.kind)
+        {
+        using enum node_kind;
+            case declaration:
+            {
+                auto type = resolve_type(item.a);
+                for (auto v : tree.list(item))
+                {
+                    auto &st   = prog.structs[s];
+                    auto  slot = static_cast<std::uint32_t>(
+                        st.field_symbols.size());
+                    if (!fields[s].try_emplace(tree[v].a, slot).second)
+                    {
+                        error(message_id::redeclared_name, v);
+                        continue;
+                    }
+                    st.field_symbols.emplace_back(tree[v].a);
+                    st.field_types.emplace_back(type);
+                }
+                field_declarations[s].emplace_back(m);
+                break;
+            }
+            case function:
+            {
+                auto index = declare_function(m, s);
+                methods[s][tree.function_symbol(item)].emplace_back(index);
+                break;
+            }
+            case constructor:
+                constructors[s].emplace_back(declare_function(m, s));
+                break;
+            case destructor:
+                if (prog.structs[s].destructor != no_function)
+                {
+                    error(message_id::redeclared_name, m);
+                    break;
+                }
+                prog.structs[s].destructor = declare_function(m, s);
+                break;
+            case void_: break;
+            default: error(message_id::misplaced_declaration, m); break;
+        }
+    }
+}
+
+/**
+ *  @brief  Declare an operator overload.
+ *  @param  n  The @c node_kind::operator_ .
+ */
+auto compiler::declare_operator(node_index n) -> void
+{
+    auto &op       = tree[n];
+    auto  function = declare_function(n, no_function);
+    auto &params   = prog.functions[function].parameters;
+    auto  ov       = overload {
+        .op       = op.op,
+        .form     = static_cast<operator_form>(op.flags),
+        .symbol   = tree.function_symbol(op),
+        .function = function
+    };
+    for (std::size_t i = 0; i < params.size() && i < ov.operands.size(); i++)
+    {
+        ov.operands[i] = params[i];
+    }
+
+    if (ov.op == operator_kind::custom)
+    {
+        operator_index(ov.symbol);
+    }
+    prog.overload_table.try_emplace(
+        make_overload_key(ov.op, ov.form, ov.symbol, ov.operands),
+        static_cast<std::uint32_t>(prog.overloads.size()));
+    prog.overloads.emplace_back(ov);
+}
+
+/**
+ *  @brief  Add the initializer and the constructors of a structure that
+ *          are not declared.
+ *
+ *  The initializer sets every field to its initial value, and is
+ *  compiled by @c compile_initializer .  A constructor without
+ *  parameters and a constructor with every field are added, unless a
+ *  constructor with the same number of parameters is declared.
+ *
+ *  @param  s  Index of the structure.
+ *  @param  n  The @c node_kind::struct_ .
+ */
+auto compiler::synthesize(std::uint32_t s, node_index n) -> void
+{
+    token          = tree[n].token;
+    auto type      = prog.structs[s].type;
+    auto add_owned = [&](std::vector<type_index> parameters)
+    {
+        auto index = add_function(function_info {
+            .symbol     = prog.structs[s].symbol,
+            .owner      = s,
+            .parameters = std::move(parameters)
+        });
+        begin_function(index);
+        return index;
+    };
+
+    if (!field_declarations[s].empty())
+    {
+        prog.structs[s].initializer = add_function(function_info {
+            .symbol     = prog.structs[s].symbol,
+            .owner      = s,
+            .parameters = { type }
+        });
+    }
+
+    auto has = [&](std::size_t count)
+    {
+        return stdr::any_of(constructors[s], [&](std::uint32_t ctor)
+        {
+            return prog.functions[ctor].parameters.size() == count + 1;
+        });
+    };
+
+    auto info = plain_struct {};
+    token     = tree[n].token;
+    if (!has(0))
+    {
+        info.empty = add_owned({ type });
+        constructors[s].emplace_back(info.empty);
+        emit(opcode::return_void);
+        end_function();
+    }
+
+    auto &field_types = prog.structs[s].field_types;
+    if (!field_types.empty() && !has(field_types.size()))
+    {
+        std::vector<type_index> parameters = { type };
+        parameters.insert(parameters.end(), field_types.begin(),
+            field_types.end());
+        info.fieldwise = add_owned(std::move(parameters));
+        constructors[s].emplace_back(info.fieldwise);
+
+        for (std::size_t i = 0; i < field_types.size(); i++)
+        {
+            emit(opcode::set_field, 0, static_cast<std::uint16_t>(i),
+                static_cast<std::uint16_t>(i + 1));
+        }
+        emit(opcode::return_void);
+        end_function();
+    }
+
+    // A structure of numbers whose initial values are literals, which the
+    // initializer sets without side effects, can skip the constructors
+    // added here
+    auto literal = [&](node_index x)
+    {
+        if (tree[x].kind == node_kind::unary && !is_effect(tree[x])
+         && tree[x].op != operator_kind::custom)
+        {
+            x = tree[x].a;
+        }
+        auto kind = tree[x].kind;
+        return kind == node_kind::number || kind == node_kind::character
+            || kind == node_kind::boolean;
+    };
+
+    bool numbers = info.fieldwise != no_function
+                && stdr::all_of(field_types, [&](type_index field)
+                   {
+                       return is_scalar(field);
+                   });
+    info.initial.resize(field_types.size());
+    for (auto decl : field_declarations[s])
+    {
+        for (auto v : tree.list(tree[decl]))
+        {
+            auto &var  = tree[v];
+            auto  slot = fields[s][var.a];
+            auto  init = var.b == no_node ? std::optional(value(0.0))
+                       : numbers && literal(var.b) ? fold(var.b)
+                       : std::nullopt;
+            auto  initial = init.has_value() && slot < field_types.size()
+                ? convert_number(init.value(), field_types[slot])
+                : std::nullopt;
+            numbers = numbers && initial.has_value();
+            if (numbers)
+            {
+                info.initial[slot] = std::move(initial.value());
+            }
+        }
+    }
+    if (numbers)
+    {
+        plain[s] = std::move(info);
+    }
+
+    for (auto ctor : constructors[s])
+    {
+        if (prog.functions[ctor].parameters.size() == 1)
+        {
+            prog.structs[s].default_constructor = ctor;
+        }
+    }
+}
+
+/**
+ *  @brief  Begin compiling a function, whose parameters take the first
+ *          registers.
+ *
+ *  @param  index  Index of the function.
+ */
+auto compiler::begin_function(std::uint32_t index) -> void
+{
+    current = index;
+    locals.clear();
+    scopes.clear();
+    top   = 0;
+    label = 0;
+    allocate(function().parameters.size());
+    open_scope();
+}
+
+/**
+ *  @brief  Finish compiling the function.
+ */
+auto compiler::end_function() -> void
+{
+    // The result is always stored to the first register
+    function().registers = std::max<std::uint16_t>(function().registers, 1);
+    scopes.clear();
+    locals.clear();
+}
+
+/**
+ *  @brief  Compile the body of a function.
+ *
+ *  @param  index  Index of the function.
+ *  @param  n      The function node.
+ */
+auto compiler::compile_function(std::uint32_t index, node_index n) -> void
+{
+    auto &fn = tree[n];
+    token    = fn.token;
+    begin_function(index);
+
+    std::size_t implicit = function().owner != no_function;
+    auto        params   = tree.parameters(fn);
+    for (std::size_t i = 0; i < params.size(); i++)
+    {
+        auto &param = tree[params[i]];
+        declare_local(param.b, function().parameters[implicit + i],
+            static_cast<std::uint16_t>(implicit + i), false, params[i]);
+    }
+
+    // The body shares the scope of the parameters
+    auto list   = statements(tree.extra[fn.b + 1]);
+    auto common = hoist(list, 2);
+    if (!sequence(list, false))
+    {
+        token = fn.token;
+        exit_function(no_register, n, void_type);
+    }
+    release(common);
+    end_function();
+}
+
+/**
+ *  @brief  Compile the initializer of a structure.  It is compiled after
+ *          the global scope, so that the initial values of the fields
+ *          can use every global variable.
+ *
+ *  @param  s  Index of the structure.
+ */
+auto compiler::compile_initializer(std::uint32_t s) -> void
+{
+    begin_function(prog.structs[s].initializer);
+    for (auto decl : field_declarations[s])
+    {
+        auto &d = tree[decl];
+        for (auto v : tree.list(d))
+        {
+            auto &var   = tree[v];
+            auto  slot  = fields[s][var.a];
+            auto  field = prog.structs[s].field_types[slot];
+            auto  reg   = allocate();
+            token       = var.token;
+            initialize(field, d.a, var.b, reg);
+            emit(opcode::set_field, 0, static_cast<std::uint16_t>(slot), reg);
+            top = 1;
+        }
+    }
+    emit(opcode::return_void);
+    end_function();
+}
+
+/**
+ *  @brief  Compile the whole program.
+ */
+auto compiler::compile_program() -> void
+{
+    auto roots = tree.list(tree[tree.root]);
+
+    // Structures are declared first so that every type can be used
+    std::vector<std::pair<std::uint32_t, node_index>> structs;
+    for (auto n : roots)
+    {
+        if (tree[n].kind == node_kind::struct_)
+        {
+            auto s = declare_struct(n);
+            if (s != no_function)
+            {
+                structs.emplace_back(s, n);
+            }
+        }
+    }
+
+    for (auto [s, n] : structs)
+    {
+        declare_members(s, n);
+    }
+
+    for (auto n : roots)
+    {
+        auto &fn = tree[n];
+        if (fn.kind == node_kind::operator_)
+        {
+            declare_operator(n);
+        }
+        if (fn.kind != node_kind::function)
+        {
+            continue;
+        }
+
+        auto  index     = declare_function(n, no_function);
+        auto &overloads = functions[tree.function_symbol(fn)];
+        if (stdr::any_of(overloads, [&](std::uint32_t other)
+            {
+                return prog.functions[other].parameters.size()
+                    == prog.functions[index].parameters.size();
+            }))
+        {
+            error(message_id::redeclared_name, n);
+        }
+        overloads.emplace_back(index);
+    }
+
+    // A structure needs to be destroyed if any of its fields does
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (auto &st : prog.structs)
+        {
+            if (!st.needs_destroy && (st.destructor != no_function
+             || stdr::any_of(st.field_types, [&](type_index type)
+                {
+                    return needs_destroy(type);
+                })))
+            {
+                st.needs_destroy = true;
+                changed          = true;
+            }
+        }
+    }
+
+    for (auto [s, n] : structs)
+    {
+        synthesize(s, n);
+    }
+
+    // Functions that only return a small expression are compiled in place
+    // of their calls
+    for (auto [index, n] : bodies)
+    {
+        auto kind = tree[n].kind;
+        auto type = prog.functions[index].return_type;
+        if ((kind != node_kind::function && kind != node_kind::operator_)
+         || type == void_type || type == unknown_type)
+        {
+            continue;
+        }
+
+        // An uncaptured call may return nothing
+        auto  list = statements(tree.extra[tree[n].b + 1]);
+        auto &last = tree[list.empty() ? n : list.back()];
+        if (!list.empty() && last.a != no_node
+         && (last.kind == node_kind::return_
+          || (last.kind == node_kind::expression && !is_effect(tree[last.a])
+           && tree[last.a].kind != node_kind::call)))
+        {
+            returning.emplace(index);
+        }
+
+        auto body = returned(n);
+        auto size = body != no_node ? measure(body) : inline_budget + 1;
+        if (size <= inline_budget)
+        {
+            expansions.emplace(index, std::pair(n, size));
+        }
+    }
+
+    prog.main = add_function(function_info {
+        .return_type = unknown_type
+    });
+    begin_function(prog.main);
+    if (!sequence(roots, true))
+    {
+        token = tree[tree.root].token;
+        exit_function(no_register, tree.root, void_type);
+    }
+    end_function();
+
+    for (auto [s, n] : structs)
+    {
+        if (prog.structs[s].initializer != no_function)
+        {
+            compile_initializer(s);
+        }
+    }
+
+    for (auto [index, n] : bodies)
+    {
+        compile_function(index, n);
+    }
+}
+
+/**
+ *  @brief  Begin a scope.
+ */
+auto compiler::open_scope() -> void
+{
+    scopes.emplace_back(scope {
+        .locals = locals.size(),
+        .top    = top
+    });
+}
+
+/**
+ *  @brief  End the scope, destroying its local variables.
+ */
+auto compiler::close_scope() -> void
+{
+    auto s = scopes.back();
+    destroy_locals(s.locals);
+    locals.resize(s.locals);
+    top = s.top;
+    scopes.pop_back();
+}
+
+/**
+ *  @brief  Destroy the local variables, from the last declared.
+ *  @param  from  Index of the first local variable to destroy.
+ */
+auto compiler::destroy_locals(std::size_t from) -> void
+{
+    for (auto i = locals.size(); i-- > from;)
+    {
+        if (needs_destroy(locals[i].type))
+        {
+            emit(opcode::destroy, locals[i].reg);
+        }
+    }
+}
+
+/**
+ *  @brief  Declare a local variable in the current scope.
+ *
+ *  @param  symbol    Symbol ID of the name.
+ *  @param  type      The declared type.
+ *  @param  reg       The register of the variable.
+ *  @param  constant  Whether the variable is declared `const`.
+ *  @param  n         The declaring node.
+ *  @param  known     The value of a `const` number, if it is known.
+ *  @param  unpacked  Whether the structure is kept in the registers of its
+ *                    fields from @p reg .
+ */
+auto compiler::declare_local(
+    std::uint32_t        symbol,
+    type_index           type,
+    std::uint16_t        reg,
+    bool                 constant,
+    node_index           n,
+    std::optional<value> known,
+    bool                 unpacked
+) -> void
+{
+    for (auto i = scopes.back().locals; i < locals.size(); i++)
+    {
+        if (locals[i].symbol == symbol)
+        {
+            error(message_id::redeclared_name, n);
+            return;
+        }
+    }
+
+    locals.emplace_back(local_variable {
+        .symbol   = symbol,
+        .type     = type,
+        .reg      = reg,
+        .constant = constant,
+        .known    = std::move(known),
+        .unpacked = unpacked
+    });
+}
+
+/**
+ *  @brief  Return from the function being compiled, destroying every
+ *          local variable.  Returning from @c program::main destroys the
+ *          global variables too.
+ *
+ *  @param  result  The register of the returned value, or
+ *                  @c no_register .
+ *  @param  n       The returned expression.
+ *  @param  type    Type of the returned value.
+ */
+auto compiler::exit_function(
+    std::uint16_t result,
+    node_index    n,
+    type_index    type
+) -> void
+{
+    bool returns = result != no_register
+                && function().return_type != void_type;
+    if (returns)
+    {
+        finish_store(n, type, function().return_type, result);
+    }
+
+    destroy_locals(0);
+    if (current == prog.main)
+    {
+        auto saved = top;
+        auto reg   = allocate();
+        for (auto it = global_order.rbegin(); it != global_order.rend(); it++)
+        {
+            if (needs_destroy(it->type))
+            {
+                emit_bc(opcode::get_global, reg, it->slot);
+                emit(opcode::destroy, reg);
+            }
+        }
+        top = saved;
+    }
+
+    if (returns)
+    {
+        emit(opcode::return_, result);
+    }
+    else
+    {
+        emit(opcode::return_void);
+    }
+}
+
+/**
+ *  @brief  Compile the statements of a body in a new scope.
+ *
+ *  @param  n  The body, a block or a statement.
+ *  @return  True if the body never finishes without returning.
+ */
+auto compiler::body(const node_index &n) -> bool
+{
+    open_scope();
+    auto common = hoist(statements(n), 2);
+    auto exits  = sequence(statements(n), false);
+    release(common);
+    close_scope();
+    return exits;
+}
+
+/**
+ *  @brief  Compile statements one after another.  The statements after
+ *          one that never finishes are compiled for their messages, and
+ *          their instructions are removed.
+ *
+ *  @param  list    The statements.
+ *  @param  global  Whether the statements are in global scope.
+ *  @return  True if the statements never finish without returning.
+ */
+auto compiler::sequence(std::span<const node_index> list, bool global) -> bool
+{
+    // A name used once in a statement and not in the statements after it
+    // is the last use of a variable declared in the block
+    std::vector<std::vector<node_index>> last(list.size());
+    std::unordered_set<std::uint32_t>    later;
+    for (auto i = list.size(); i-- > 0;)
+    {
+        std::unordered_map<std::uint32_t, node_index> names;
+        find_uses(list[i], names, false);
+        for (auto [symbol, name] : names)
+        {
+            if (name != no_node && !later.contains(symbol))
+            {
+                last[i].emplace_back(name);
+            }
+        }
+        for (auto [symbol, name] : names)
+        {
+            later.insert(symbol);
+        }
+    }
+
+    std::optional<std::size_t> end;
+    for (std::size_t i = 0; i < list.size(); i++)
+    {
+        // The block ends after the last use of an array or a structure
+        // without a destructor, and nothing sees it after it is moved
+        std::vector<node_index> moved;
+        for (auto name : last[i])
+        {
+            auto local = find_local(tree[name].a);
+            auto index = local ? local - locals.data() : 0;
+            if (local && movable(*local)
+             && static_cast<std::size_t>(index) >= scopes.back().locals)
+            {
+                last_uses[name] = true;
+                moved.emplace_back(name);
+            }
+        }
+
+        if (statement(list[i], global, list.subspan(i + 1))
+         && !end.has_value())
+        {
+            end = function().code.size();
+        }
+        for (auto name : moved)
+        {
+            last_uses[name] = false;
+        }
+    }
+
+    if (end.has_value())
+    {
+        discard(end.value());
+    }
+    return end.has_value();
+}
+
+/**
+ *  @brief  Find the names used in a node.
+ *
+ *  @param  n       The node.
+ *  @param  names   The node of each name, or @c no_node for a name that is
+ *                  used more than once, in a loop or declared.
+ *  @param  looped  Whether the node is in a loop.
+ */
+auto compiler::find_uses(
+    node_index                                      n,
+    std::unordered_map<std::uint32_t, node_index> &names,
+    bool                                            looped
+) const -> void
+{
+    auto &t = tree[n];
+    if (t.kind == node_kind::name || t.kind == node_kind::variable)
+    {
+        auto [it, inserted] = names.try_emplace(t.a, n);
+        if (!inserted || looped || t.kind == node_kind::variable)
+        {
+            it->second = no_node;
+        }
+    }
+
+    looped = looped || t.kind == node_kind::while_
+          || t.kind == node_kind::for_;
+    for (auto c : children(n))
+    {
+        find_uses(c, names, looped);
+    }
+}
+
+/**
+ *  @brief  Compile a statement.
+ *
+ *  @param  n       The statement.
+ *  @param  global  Whether the statement is in global scope.
+ *  @param  rest    The statements after it in its block, which see the
+ *                  variables that it declares.
+ *  @return  True if the statement never finishes without returning,
+ *           like `return` and endless loops.
+ */
+auto compiler::statement(
+    node_index                  n,
+    bool                        global,
+    std::span<const node_index> rest
+) -> bool
+{
+    auto &s     = tree[n];
+    auto  saved = top;
+    bool  exits = false;
+    token       = s.token;
+
+    switch (s.kind)
+    {
+        case node_kind::declaration:
+            declaration(n, global, rest);
+            return false;
+        case node_kind::expression:
+            exits = expression_statement(n);
+            break;
+        case node_kind::if_:
+        {
+            if (auto known = fold_condition(s.a))
+            {
+                auto live = known.value() ? s.b : s.c;
+                auto dead = known.value() ? s.c : s.b;
+                if (dead != no_node)
+                {
+                    auto at = function().code.size();
+                    body(dead);
+                    discard(at);
+                }
+                exits = live != no_node && body(live);
+                break;
+            }
+
+            auto skip = emit_bc(opcode::jump_if_false, operand(s.a).first, 0);
+            top = saved;
+            auto then = body(s.b);
+            if (s.c == no_node)
+            {
+                patch(skip);
+                break;
+            }
+
+            auto end = emit_bc(opcode::jump, 0, 0);
+            patch(skip);
+            exits = body(s.c) && then;
+            patch(end);
+            break;
+        }
+        case node_kind::while_:
+        {
+            auto known = fold_condition(s.a);
+            if (known.has_value())
+            {
+                loop(known.value(), s.b, no_node);
+                exits = known.value();
+                break;
+            }
+
+            // The condition is checked at the end of each iteration
+            auto invariant = hoist(std::array { s.a, s.b }, 1);
+            auto enter     = emit_bc(opcode::jump, 0, 0);
+            auto start     = mark();
+            body(s.b);
+            patch(enter);
+            emit_bc(opcode::jump_if_true, operand(s.a).first, start);
+            release(invariant);
+            break;
+        }
+        case node_kind::for_:
+        {
+            auto init      = tree.extra[s.a];
+            auto condition = tree.extra[s.a + 1];
+            auto step      = tree.extra[s.a + 2];
+
+            open_scope();
+            if (init != no_node && tree[init].kind == node_kind::declaration)
+            {
+                declaration(init, false, std::array { condition, step, s.b });
+            }
+            else if (init != no_node)
+            {
+                effect(init);
+            }
+
+            auto inner = top;
+            auto known = condition == no_node
+                       ? std::optional(true) : fold_condition(condition);
+            if (known.has_value())
+            {
+                loop(known.value(), s.b, step);
+                exits = known.value();
+            }
+            else
+            {
+                auto invariant = hoist(std::array { condition, s.b, step }, 1);
+                auto enter     = emit_bc(opcode::jump, 0, 0);
+                auto start     = mark();
+                body(s.b);
+                if (step != no_node)
+                {
+                    effect(step);
+                }
+                patch(enter);
+                emit_bc(opcode::jump_if_true, operand(condition).first,
+                    start);
+                release(invariant);
+            }
+            top = inner;
+            close_scope();
+            break;
+        }
+        case node_kind::block:
+            exits = body(n);
+            break;
+        case node_kind::return_:
+        {
+            exits = true;
+            if (s.a == no_node)
+            {
+                exit_function(no_register, n, void_type);
+                break;
+            }
+
+            auto reg = allocate();
+            exit_function(reg, s.a, expression(s.a, reg));
+            break;
+        }
+        case node_kind::void_: break;
+        case node_kind::function:
+        case node_kind::operator_:
+        case node_kind::struct_:
+            if (!global)
+            {
+                error(message_id::misplaced_declaration, n);
+            }
+            break;
+        default:
+            error(message_id::misplaced_declaration, n);
+            break;
+    }
+
+    top = saved;
+    return exits;
+}
+
+/**
+ *  @brief  Compile a loop whose condition is known when compiling.  A
+ *          loop that never runs is compiled for its messages only.
+ *
+ *  @param  runs  Whether the loop runs, and never ends.
+ *  @param  n     The body.
+ *  @param  step  The step of a `for` statement, or @c no_node .
+ */
+auto compiler::loop(bool runs, node_index n, node_index step) -> void
+{
+    auto invariant = runs ? hoist(std::array { n, step }, 1)
+                          : std::vector<node_index>();
+    auto start     = mark();
+    body(n);
+    if (step != no_node)
+    {
+        effect(step);
+    }
+
+    if (runs)
+    {
+        emit_bc(opcode::jump, 0, start);
+    }
+    else
+    {
+        discard(start);
+    }
+    release(invariant);
+}
+
+/**
+ *  @brief  Compile a declaration of variables.  Declarations in global
+ *          scope declare global variables.
+ *
+ *  @param  n       The @c node_kind::declaration .
+ *  @param  global  Whether the declaration is in global scope.
+ *  @param  scope   The nodes after it that see its variables.
+ */
+auto compiler::declaration(
+    node_index                  n,
+    bool                        global,
+    std::span<const node_index> scope
+) -> void
+{
+    auto &d        = tree[n];
+    auto  type     = resolve_type(d.a);
+    bool  constant = d.flags & node::constant;
+    auto  info     = global ? nullptr : plain_type(type);
+    auto  list     = tree.list(d);
+    if (type == void_type)
+    {
+        error(message_id::unknown_type, d.a);
+    }
+
+    for (std::size_t i = 0; i < list.size(); i++)
+    {
+        auto  v   = list[i];
+        auto &var = tree[v];
+        token     = var.token;
+
+        // A structure whose value never escapes is kept in the registers
+        // of its fields, if it is constructed without being created
+        auto s    = info ? prog.types[type].index : 0;
+        auto uses = [&](node_index x)
+        {
+            return escapes(x, var.a, s, true);
+        };
+        if (info && (var.b == no_node ? info->empty != no_function
+                                      : constructs(var.b, type))
+         && stdr::none_of(list.subspan(i + 1), uses)
+         && stdr::none_of(scope, uses))
+        {
+            auto size  = prog.structs[s].field_types.size();
+            auto first = allocate(size);
+            if (var.b == no_node)
+            {
+                for (std::size_t f = 0; f < size; f++)
+                {
+                    load(static_cast<std::uint16_t>(first + f),
+                        info->initial[f]);
+                }
+            }
+            if (var.b == no_node || unpack(var.b, type, first))
+            {
+                declare_local(var.a, type, first, constant, v, std::nullopt,
+                    true);
+                continue;
+            }
+            top = first;
+        }
+
+        // The value of a constant number is used instead of the variable
+        std::optional<value> known;
+        if (constant && is_scalar(type))
+        {
+            auto init = var.b == no_node ? value(0.0) : fold(var.b);
+            if (init.has_value())
+            {
+                known = convert_number(init.value(), type);
+            }
+        }
+
+        if (!global)
+        {
+            auto reg = allocate();
+            initialize(type, d.a, var.b, reg);
+            declare_local(var.a, type, reg, constant, v, std::move(known));
+            continue;
+        }
+
+        auto saved = top;
+        auto reg   = allocate();
+        initialize(type, d.a, var.b, reg);
+        auto g = global_variable {
+            .type     = type,
+            .slot     = prog.globals,
+            .constant = constant,
+            .known    = std::move(known)
+        };
+        if (!globals.try_emplace(var.a, g).second)
+        {
+            error(message_id::redeclared_name, v);
+        }
+        else
+        {
+            prog.globals++;
+            global_order.emplace_back(g);
+            emit_bc(opcode::set_global, reg, g.slot);
+        }
+        top = saved;
+    }
+}
+
+/**
+ *  @brief  Compile an expression statement.  An uncaptured expression
+ *          returns from the function, or ends the program in global
+ *          scope, unless it is an assignment, an increment, a decrement
+ *          or a call of a function that returns nothing.
+ *
+ *  @param  n  The @c node_kind::expression .
+ *  @return  True if the expression returns.
+ */
+auto compiler::expression_statement(node_index n) -> bool
+{
+    auto  index = tree[n].a;
+    auto &e     = tree[index];
+    if (is_effect(e))
+    {
+        expression(index, no_register);
+        return false;
+    }
+
+    auto reg  = allocate();
+    auto type = expression(index, reg);
+    if (e.kind == node_kind::call && type == void_type)
+    {
+        return false;
+    }
+    exit_function(reg, index, type);
+    return true;
+}
+
+/**
+ *  @brief  Compile an expression only for its side effects, like the
+ *          initializer and the step of a `for` statement.
+ *
+ *  @param  n  The expression.
+ */
+auto compiler::effect(node_index n) -> void
+{
+    if (tree[n].kind == node_kind::expression)
+    {
+        n = tree[n].a;
+    }
+
+    auto saved = top;
+    expression(n, is_effect(tree[n]) ? no_register : allocate());
+    top = saved;
+}
+
+/**
+ *  @brief  Store the initial value of a variable to the register.
+ *
+ *  @param  type       The declared type.
+ *  @param  type_node  The type node.
+ *  @param  init       The initializer, or @c no_node .
+ *  @param  dest       The register.
+ */
+auto compiler::initialize(
+    type_index    type,
+    node_index    type_node,
+    node_index    init,
+    std::uint16_t dest
+) -> void
+{
+    if (init == no_node)
+    {
+        default_value(type, type_node, dest);
+        return;
+    }
+
+    finish_store(init, expression(init, dest), type, dest);
+}
+
+/**
+ *  @brief  Store the value of a variable without an initializer.
+ *
+ *  Numbers are 0, arrays have the size in the type or are empty, and
+ *  structures are constructed without arguments.
+ *
+ *  @param  type       The type.
+ *  @param  type_node  The type node.
+ *  @param  dest       The register.
+ */
+auto compiler::default_value(
+    type_index    type,
+    node_index    type_node,
+    std::uint16_t dest
+) -> void
+{
+    auto &info = prog.types[type];
+    switch (info.kind)
+    {
+        case type_kind::real: load(dest, 0.0); break;
+        case type_kind::int_: load(dest, std::int32_t(0)); break;
+        case type_kind::bool_: load(dest, false); break;
+        case type_kind::char_: load(dest, '\0'); break;
+        case type_kind::array:
+        {
+            auto &t = tree[type_node];
+            if (t.kind != node_kind::type_array || t.b == no_node)
+            {
+                emit(opcode::new_array, dest, 0,
+                    static_cast<std::uint16_t>(type));
+                break;
+            }
+
+            auto saved = top;
+            emit(opcode::new_array_sized, dest, operand(t.b).first,
+                static_cast<std::uint16_t>(type));
+            top = saved;
+            break;
+        }
+        case type_kind::struct_:
+        {
+            auto ctor = prog.structs[info.index].default_constructor;
+            auto base = window(dest, 1);
+            emit(opcode::construct, base, 0, static_cast<std::uint16_t>(ctor));
+            if (base != dest)
+            {
+                emit(opcode::move, dest, base);
+            }
+            break;
+        }
+        default: load(dest, std::monostate {}); break;
+    }
+}
+
+/**
+ *  @brief  Prepare a value in the register to be stored, converting it
+ *          to the type and copying it if it is stored elsewhere.
+ *
+ *  @param  n     The expression of the value.
+ *  @param  from  Type of the value.
+ *  @param  to    Type to store as.
+ *  @param  reg   The register of the value.
+ */
+auto compiler::finish_store(
+    node_index    n,
+    type_index    from,
+    type_index    to,
+    std::uint16_t reg
+) -> void
+{
+    // A number that may not be of its type is checked even if the types
+    // are the same
+    auto &code  = function().code;
+    bool  known = !is_scalar(to) || exact(n);
+    if (to != unknown_type && to != void_type && (from != to || !known))
+    {
+        // A constant that was just loaded is converted when compiling
+        if (is_scalar(to) && label < code.size()
+         && code.back().op == opcode::load_constant && code.back().a == reg)
+        {
+            auto converted = convert_number(
+                prog.constants[code.back().bc()], to);
+            if (converted.has_value())
+            {
+                code.back().set_bc(constant(converted.value()));
+                return;
+            }
+        }
+
+        if (known && from == int_type && to == real_type)
+        {
+            emit(opcode::int_to_real, reg, reg);
+        }
+        else if (known && from == real_type && to == int_type)
+        {
+            emit(opcode::real_to_int, reg, reg);
+        }
+        else
+        {
+            emit(opcode::convert, reg, reg, static_cast<std::uint16_t>(to));
+        }
+    }
+
+    // The value of a variable that is not used after it is moved, so that
+    // the array or structure has no other reference to be changed
+    bool  moved = last_uses[n] && inlined.empty();
+    auto *local = moved ? find_local(tree[n].a) : nullptr;
+    if (local && label < code.size() && code.back().op == opcode::move
+     && code.back().a == reg && code.back().b == local->reg)
+    {
+        code.back().op = opcode::take;
+    }
+    if (!is_scalar(to) && !is_scalar(from) && is_place(n) && !moved)
+    {
+        emit(opcode::copy, reg, reg);
+    }
+}
+
+/**
+ *  @brief  Find a local variable, from the innermost scope.
+ *
+ *  @param  symbol  Symbol ID of the name.
+ *  @return  The local variable, or @c nullptr .
+ */
+auto compiler::find_local(std::uint32_t symbol) const
+-> const local_variable *
+{
+    // The body of an inlined function cannot see the caller's variables
+    auto first = inlined.empty() ? 0 : inlined.back().locals;
+    for (auto i = locals.size(); i-- > first;)
+    {
+        if (locals[i].symbol == symbol)
+        {
+            return &locals[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ *  @brief  Find where an expression stores its value, evaluating the
+ *          structure, array and index.
+ *
+ *  @param  n  The expression.
+ *  @return  The place, or nothing if the expression cannot be assigned to.
+ */
+auto compiler::find_place(node_index n) -> std::optional<place>
+{
+    auto &t = tree[n];
+    switch (t.kind)
+    {
+        case node_kind::name:
+        {
+            if (auto local = find_local(t.a))
+            {
+                if (local->constant)
+                {
+                    error(message_id::assign_to_constant, n);
+                }
+                return place {
+                    .kind = place_kind::local,
+                    .type = local->type,
+                    .reg  = local->reg
+                };
+            }
+
+            auto owner = method_owner();
+            if (owner != no_function)
+            {
+                auto it = fields[owner].find(t.a);
+                if (it != fields[owner].end())
+                {
+                    return place {
+                        .kind = place_kind::field,
+                        .type = prog.structs[owner].field_types[it->second],
+                        .reg  = self(),
+                        .slot = it->second
+                    };
+                }
+            }
+
+            auto it = globals.find(t.a);
+            if (it == globals.end())
+            {
+                error(message_id::undeclared_name, n);
+                return std::nullopt;
+            }
+
+            if (it->second.constant)
+            {
+                error(message_id::assign_to_constant, n);
+            }
+            return place {
+                .kind = place_kind::global,
+                .type = it->second.type,
+                .slot = it->second.slot
+            };
+        }
+        case node_kind::member:
+        {
+            if (auto field = unpacked_field(n))
+            {
+                return field;
+            }
+
+            auto [object, type] = operand(t.a);
+            if (kind(type) != type_kind::struct_)
+            {
+                error(message_id::unknown_member, n);
+                return std::nullopt;
+            }
+
+            auto s  = prog.types[type].index;
+            auto it = fields[s].find(t.b);
+            if (it == fields[s].end())
+            {
+                error(message_id::unknown_member, n);
+                return std::nullopt;
+            }
+            return place {
+                .kind = place_kind::field,
+                .type = prog.structs[s].field_types[it->second],
+                .reg  = object,
+                .slot = it->second
+            };
+        }
+        case node_kind::subscript:
+        {
+            auto [object, type] = operand(t.a);
+            if (kind(type) == type_kind::struct_ || t.b == no_node)
+            {
+                error(message_id::not_assignable, n);
+                return std::nullopt;
+            }
+
+            auto index = operand(t.b).first;
+            return place {
+                .kind  = place_kind::element,
+                .type  = kind(type) == type_kind::array
+                       ? prog.types[type].index : unknown_type,
+                .reg   = object,
+                .index = index
+            };
+        }
+        default:
+            error(message_id::not_assignable, n);
+            return std::nullopt;
+    }
+}
+
+/**
+ *  @brief  Find the register of a field of a local variable that is kept
+ *          in registers.
+ *
+ *  @param  n  The expression.
+ *  @return  The place of the field, or nothing if the expression is not
+ *           such a field.
+ */
+auto compiler::unpacked_field(node_index n) const -> std::optional<place>
+{
+    auto &t = tree[n];
+    if (t.kind != node_kind::member || tree[t.a].kind != node_kind::name)
+    {
+        return std::nullopt;
+    }
+
+    auto local = find_local(tree[t.a].a);
+    if (!local || !local->unpacked)
+    {
+        return std::nullopt;
+    }
+
+    auto s  = prog.types[local->type].index;
+    auto it = fields[s].find(t.b);
+    if (it == fields[s].end())
+    {
+        return std::nullopt;
+    }
+    return place {
+        .kind = place_kind::local,
+        .type = prog.structs[s].field_types[it->second],
+        .reg  = static_cast<std::uint16_t>(local->reg + it->second)
+    };
+}
+
+/**
+ *  @brief  Load the value of the place to the register.
+ *
+ *  @param  dest  The register.
+ *  @param  p     The place.
+ */
+auto compiler::load(std::uint16_t dest, const place &p) -> void
+{
+    auto slot = static_cast<std::uint16_t>(p.slot);
+    switch (p.kind)
+    {
+        case place_kind::local:
+            if (dest != p.reg)
+            {
+                emit(opcode::move, dest, p.reg);
+            }
+            break;
+        case place_kind::global: emit_bc(opcode::get_global, dest, p.slot);
+            break;
+        case place_kind::field: emit(opcode::get_field, dest, p.reg, slot);
+            break;
+        case place_kind::element:
+            emit(opcode::get_index, dest, p.reg, p.index);
+            break;
+    }
+}
+
+/**
+ *  @brief  Store the value in the register to the place.
+ *
+ *  @param  p    The place.
+ *  @param  src  The register, which may not hold the value afterwards.
+ */
+auto compiler::store(const place &p, std::uint16_t src) -> void
+{
+    auto slot = static_cast<std::uint16_t>(p.slot);
+    switch (p.kind)
+    {
+        case place_kind::local:
+            if (src != p.reg && !retarget(src, p.reg))
+            {
+                emit(opcode::move, p.reg, src);
+            }
+            break;
+        case place_kind::global: emit_bc(opcode::set_global, src, p.slot);
+            break;
+        case place_kind::field: emit(opcode::set_field, p.reg, slot, src);
+            break;
+        case place_kind::element:
+            emit(opcode::set_index, p.reg, p.index, src);
+            break;
+    }
+}
+
+/**
+ *  @brief  Compile an expression, storing its value to the register.
+ *
+ *  @param  n     The expression.
+ *  @param  dest  The register, or @c no_register for assignments,
+ *                increments and decrements whose value is not used.
+ *  @return  Type of the value, or @c unknown_type if it is only known
+ *           when the program runs.
+ */
+auto compiler::expression(node_index n, std::uint16_t dest) -> type_index
+{
+    if (auto it = hoisted.find(n); it != hoisted.end())
+    {
+        auto [reg, type] = it->second;
+        if (dest != no_register && dest != reg)
+        {
+            emit(opcode::move, dest, reg);
+        }
+        return type;
+    }
+
+    auto previous = std::exchange(token, tree[n].token);
+    auto saved    = top;
+    auto folded   = dest != no_register ? fold(n) : std::nullopt;
+    auto type     = unknown_type;
+    if (folded.has_value())
+    {
+        load(dest, folded.value());
+        type = constant_type(folded.value());
+    }
+    else
+    {
+        type = evaluate(n, dest);
+    }
+    top   = saved;
+    token = previous;
+    return type;
+}
+
+/**
+ *  @brief  Get the value of an expression that is known when compiling,
+ *          like `2 * pi` or `sqrt(2)`.  It has no side effects, and its
+ *          value is the one it has when the program runs.
+ *
+ *  @param  n  The expression.
+ *  @return  The value, or nothing if it is only known when the program
+ *           runs.
+ */
+auto compiler::fold(node_index n) -> std::optional<value>
+{
+    if (opaque[n])
+    {
+        return std::nullopt;
+    }
+
+    auto result = compute(n);
+    opaque[n]   = !result.has_value();
+    return result;
+}
+
+/**
+ *  @brief  Compute the value of an expression from its operands, for
+ *          @c fold .
+ *
+ *  @param  n  The expression.
+ *  @return  The value, or nothing if it is only known when the program
+ *           runs.
+ */
+auto compiler::compute(node_index n) -> std::optional<value>
+{
+    auto &t     = tree[n];
+    auto  owner = method_owner();
+    switch (t.kind)
+    {
+        case node_kind::number:
+        {
+            auto num = dtn.numbers[t.a];
+            return std::holds_alternative<double>(num)
+                 ? std::get<double>(num)
+                 : static_cast<double>(std::get<std::uint64_t>(num));
+        }
+        case node_kind::character: return static_cast<char>(t.a);
+        case node_kind::boolean: return t.a != 0;
+        case node_kind::name:
+        {
+            // Looked up like `name` does
+            if (auto local = find_local(t.a))
+            {
+                return local->known;
+            }
+            if (owner != no_function && fields[owner].contains(t.a))
+            {
+                return std::nullopt;
+            }
+            if (auto it = globals.find(t.a); it != globals.end())
+            {
+                return it->second.known;
+            }
+            if (t.a == words.pi)
+            {
+                return std::numbers::pi;
+            }
+            return std::nullopt;
+        }
+        case node_kind::unary:
+        {
+            auto op = operator_opcode(t.op, operator_form::prefix);
+            if (op == opcode::max)
+            {
+                return std::nullopt;
+            }
+
+            auto operand = fold(t.a);
+            if (!operand.has_value() || op == opcode::move)
+            {
+                return operand;
+            }
+            return apply_operator(op, operand.value());
+        }
+        case node_kind::binary:
+        {
+            if (t.op == operator_kind::logical_and
+             || t.op == operator_kind::logical_or)
+            {
+                auto lhs = fold_condition(t.a);
+                auto rhs = lhs.has_value() ? fold_condition(t.b) : std::nullopt;
+                if (!rhs.has_value())
+                {
+                    return std::nullopt;
+                }
+                return t.op == operator_kind::logical_and
+                     ? lhs.value() && rhs.value()
+                     : lhs.value() || rhs.value();
+            }
+
+            auto op = operator_opcode(t.op, operator_form::binary);
+            if (op == opcode::max)
+            {
+                return std::nullopt;
+            }
+
+            auto lhs = fold(t.a);
+            auto rhs = lhs.has_value() ? fold(t.b) : std::nullopt;
+            if (!rhs.has_value())
+            {
+                return std::nullopt;
+            }
+            return apply_operator(op, lhs.value(), rhs.value());
+        }
+        case node_kind::call: break;
+        default: return std::nullopt;
+    }
+
+    // Only conversions like `int(x)` and builtin functions are folded
+    auto target = intrinsic(n);
+    auto args   = tree.list(t);
+    if (!target.has_value())
+    {
+        return std::nullopt;
+    }
+
+    if (auto type = std::get_if<type_index>(&target.value()))
+    {
+        auto arg = fold(args[0]);
+        if (!arg.has_value())
+        {
+            return std::nullopt;
+        }
+        return convert_number(arg.value(), *type);
+    }
+
+    std::array<double, 2> reals = {};
+    for (std::size_t i = 0; i < args.size(); i++)
+    {
+        auto arg = fold(args[i]);
+        if (!arg.has_value())
+        {
+            return std::nullopt;
+        }
+
+        auto real = convert_number(arg.value(), real_type);
+        reals[i]  = real->get<double>();
+    }
+    return apply_builtin(std::get<builtin_function>(target.value()),
+        std::span(reals).first(args.size()));
+}
+
+/**
+ *  @brief  Get the truth of a condition that is known when compiling.
+ *
+ *  @param  n  The condition.
+ *  @return  The truth, or nothing if it is only known when the program
+ *           runs.
+ */
+auto compiler::fold_condition(node_index n) -> std::optional<bool>
+{
+    auto known = fold(n);
+    if (!known.has_value())
+    {
+        return std::nullopt;
+    }
+    return convert_number(known.value(), bool_type)->get<bool>();
+}
+
+/**
+ *  @brief  Find the conversion or the builtin function that a call is
+ *          compiled to, looking up the name like @c call does.
+ *
+ *  @param  n  The @c node_kind::call .
+ *  @return  The type of a conversion like `int(x)` or the builtin
+ *           function, or nothing if the call is compiled otherwise or
+ *           has the wrong number of arguments.
+ */
+auto compiler::intrinsic(node_index n) const
+-> std::optional<std::variant<type_index, builtin_function>>
+{
+    auto &t      = tree[n];
+    auto &callee = tree[t.a];
+    auto  count  = tree.list(t).size();
+    auto  symbol = callee.a;
+    auto  owner  = method_owner();
+    if (callee.kind != node_kind::name || find_local(symbol)
+     || globals.contains(symbol)
+     || (owner != no_function && fields[owner].contains(symbol)))
+    {
+        return std::nullopt;
+    }
+
+    if (auto it = type_names.find(symbol); it != type_names.end())
+    {
+        if (!is_scalar(it->second) || count != 1)
+        {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    auto it = builtins.find(symbol);
+    if ((owner != no_function && methods[owner].contains(symbol))
+     || functions.contains(symbol) || it == builtins.end())
+    {
+        return std::nullopt;
+    }
+
+    auto &function = plons::dtn::builtins()[
+        static_cast<std::size_t>(it->second)];
+    if (count < function.least || count > function.most)
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+/**
+ *  @brief  Find the function or the method that a call calls, looking
+ *          up the name like @c call and @c method do.
+ *
+ *  @param  n  The @c node_kind::call .
+ *  @return  The function, or @c no_function if the call is compiled
+ *           otherwise or the structure is not easily known.
+ */
+auto compiler::resolve_call(node_index n) const -> std::uint32_t
+{
+    auto &t      = tree[n];
+    auto &callee = tree[t.a];
+    auto  count  = tree.list(t).size();
+    if (callee.kind == node_kind::member)
+    {
+        auto type = static_type(callee.a);
+        if (kind(type) != type_kind::struct_)
+        {
+            return no_function;
+        }
+
+        auto &candidates = methods[prog.types[type].index];
+        auto  it         = candidates.find(callee.b);
+        return it == candidates.end() ? no_function
+             : choose(it->second, count + 1);
+    }
+
+    auto symbol = callee.a;
+    auto owner  = method_owner();
+    if (callee.kind != node_kind::name || find_local(symbol)
+     || globals.contains(symbol) || type_names.contains(symbol)
+     || (owner != no_function && fields[owner].contains(symbol)))
+    {
+        return no_function;
+    }
+
+    if (owner != no_function)
+    {
+        auto it = methods[owner].find(symbol);
+        if (it != methods[owner].end())
+        {
+            return choose(it->second, count + 1);
+        }
+    }
+
+    auto it = functions.find(symbol);
+    return it == functions.end() ? no_function : choose(it->second, count);
+}
+
+/**
+ *  @brief  Get the type of an expression without compiling it.
+ *
+ *  @param  n  The expression.
+ *  @return  The type, or @c unknown_type if it is not easily known.
+ */
+auto compiler::static_type(node_index n) const -> type_index
+{
+    auto &t     = tree[n];
+    auto  owner = method_owner();
+    switch (t.kind)
+    {
+        case node_kind::number: return real_type;
+        case node_kind::character: return char_type;
+        case node_kind::boolean: return bool_type;
+        case node_kind::name:
+        {
+            if (auto local = find_local(t.a))
+            {
+                return local->type;
+            }
+            if (owner != no_function)
+            {
+                auto it = fields[owner].find(t.a);
+                if (it != fields[owner].end())
+                {
+                    return prog.structs[owner].field_types[it->second];
+                }
+            }
+            if (auto it = globals.find(t.a); it != globals.end())
+            {
+                return it->second.type;
+            }
+            return t.a == words.pi ? real_type : unknown_type;
+        }
+        case node_kind::unary:
+        case node_kind::postfix:
+        {
+            auto type = static_type(t.a);
+            auto form = t.kind == node_kind::unary
+                      ? operator_form::prefix : operator_form::postfix;
+            if (t.op == operator_kind::increment
+             || t.op == operator_kind::decrement)
+            {
+                return type;
+            }
+            if (t.op == operator_kind::custom)
+            {
+                return overload_type(t.op, form, t.b, type, unknown_type);
+            }
+            if (form == operator_form::prefix
+             && kind(type) == type_kind::struct_)
+            {
+                return t.op == operator_kind::add ? type
+                     : overload_type(t.op, form, 0, type, unknown_type);
+            }
+            if (form == operator_form::postfix || !is_scalar(type))
+            {
+                return unknown_type;
+            }
+
+            switch (operator_opcode(t.op, operator_form::prefix))
+            {
+                case opcode::move: return type;
+                case opcode::negate:
+                    return is_integral(type) ? int_type : real_type;
+                case opcode::logical_not: return bool_type;
+                case opcode::bitwise_not: return int_type;
+                default: return unknown_type;
+            }
+        }
+        case node_kind::binary:
+        {
+            if (t.op == operator_kind::logical_and
+             || t.op == operator_kind::logical_or)
+            {
+                return bool_type;
+            }
+
+            auto lhs = static_type(t.a);
+            auto rhs = static_type(t.b);
+            if (t.op == operator_kind::custom)
+            {
+                return overload_type(t.op, operator_form::binary, t.c, lhs,
+                    rhs);
+            }
+            if (kind(lhs) == type_kind::struct_
+             || kind(rhs) == type_kind::struct_)
+            {
+                return overload_type(t.op, operator_form::binary, 0, lhs,
+                    rhs);
+            }
+            if (!is_scalar(lhs) || !is_scalar(rhs))
+            {
+                return unknown_type;
+            }
+            return binary_type(t.op, lhs, rhs);
+        }
+        case node_kind::assign: return static_type(t.a);
+        case node_kind::call:
+        {
+            auto target = intrinsic(n);
+            if (target.has_value())
+            {
+                auto type = std::get_if<type_index>(&target.value());
+                return type ? *type : real_type;
+            }
+
+            // A constructor gives its structure
+            auto &callee = tree[t.a];
+            if (auto it = type_names.find(callee.a);
+                callee.kind == node_kind::name && it != type_names.end())
+            {
+                return kind(it->second) == type_kind::struct_ ? it->second
+                     : unknown_type;
+            }
+
+            auto fn = resolve_call(n);
+            return fn == no_function ? unknown_type
+                 : prog.functions[fn].return_type;
+        }
+        case node_kind::member:
+        {
+            auto type = static_type(t.a);
+            if (kind(type) != type_kind::struct_)
+            {
+                return unknown_type;
+            }
+
+            auto s  = prog.types[type].index;
+            auto it = fields[s].find(t.b);
+            return it == fields[s].end() ? unknown_type
+                 : prog.structs[s].field_types[it->second];
+        }
+        case node_kind::subscript:
+        {
+            auto type = static_type(t.a);
+            if (kind(type) == type_kind::struct_ && t.b != no_node)
+            {
+                return overload_type(operator_kind::subscript_begin,
+                    operator_form::subscript, 0, type, static_type(t.b));
+            }
+            return kind(type) == type_kind::array ? prog.types[type].index
+                 : unknown_type;
+        }
+        default: return unknown_type;
+    }
+}
+
+/**
+ *  @brief  Check if the value of an expression is always of its type
+ *          when the program runs, so that it needs no conversion or
+ *          check.
+ *
+ *  Variables, fields and elements are converted when they are stored,
+ *  and fields are 0 until they are initialized.  A global variable may
+ *  still be read by a function before it is declared, and a function
+ *  may end without returning.
+ *
+ *  @param  n  The expression.
+ *  @return  True if the value is always of its type, or the program
+ *           stops with an error before it is used.
+ */
+auto compiler::exact(node_index n) const -> bool
+{
+    auto &t = tree[n];
+    switch (t.kind)
+    {
+        case node_kind::name:
+        {
+            auto owner = method_owner();
+            return find_local(t.a)
+                || (owner != no_function && fields[owner].contains(t.a))
+                || !globals.contains(t.a) || current == prog.main;
+        }
+        case node_kind::unary:
+        case node_kind::postfix:
+        {
+            if (t.op == operator_kind::custom)
+            {
+                return exact_overload(n);
+            }
+            if (t.op == operator_kind::increment
+             || t.op == operator_kind::decrement)
+            {
+                return t.kind == node_kind::unary || exact(t.a);
+            }
+            if (t.op == operator_kind::add)
+            {
+                return exact(t.a);
+            }
+
+            auto type = static_type(t.a);
+            return is_scalar(type)
+                || (kind(type) == type_kind::struct_ && exact_overload(n));
+        }
+        case node_kind::binary:
+        case node_kind::assign:
+        {
+            if (t.op == operator_kind::logical_and
+             || t.op == operator_kind::logical_or
+             || t.op == operator_kind::assign)
+            {
+                return true;
+            }
+
+            // Anything else than numbers may call an overload
+            auto lhs = static_type(t.a);
+            auto rhs = static_type(t.b);
+            if (t.op != operator_kind::custom && is_scalar(lhs)
+             && is_scalar(rhs))
+            {
+                return true;
+            }
+            return t.kind == node_kind::binary
+                && (t.op == operator_kind::custom
+                 || kind(lhs) == type_kind::struct_
+                 || kind(rhs) == type_kind::struct_)
+                && exact_overload(n);
+        }
+        case node_kind::call:
+        {
+            auto &callee = tree[t.a];
+            if (intrinsic(n).has_value() || (callee.kind == node_kind::member
+             && kind(static_type(callee.a)) == type_kind::array))
+            {
+                return true;
+            }
+            return returning.contains(resolve_call(n));
+        }
+        case node_kind::member:
+            return kind(static_type(t.a)) == type_kind::struct_;
+        case node_kind::subscript:
+            return kind(static_type(t.a)) == type_kind::array
+                || (kind(static_type(t.a)) == type_kind::struct_
+                 && exact_overload(n));
+        default: return true;
+    }
+}
+
+/**
+ *  @brief  Check if an operator calls an overload found when
+ *          compiling, which always returns a value of its type.
+ *
+ *  @param  n  The @c node_kind::unary , @c node_kind::postfix ,
+ *             @c node_kind::binary or @c node_kind::subscript .
+ *  @return  True if the overload is found when compiling and always
+ *           returns.
+ */
+auto compiler::exact_overload(node_index n) const -> bool
+{
+    auto &t      = tree[n];
+    bool  binary = t.kind == node_kind::binary
+                || t.kind == node_kind::subscript;
+    auto  form   = t.kind == node_kind::binary ? operator_form::binary
+                 : t.kind == node_kind::subscript ? operator_form::subscript
+                 : t.kind == node_kind::unary ? operator_form::prefix
+                 : operator_form::postfix;
+    auto  op     = t.kind == node_kind::subscript
+                 ? operator_kind::subscript_begin : t.op;
+    auto  symbol = t.kind == node_kind::binary ? t.c : t.b;
+    if (t.a == no_node || (binary && t.b == no_node))
+    {
+        return false;
+    }
+
+    // Operators on the left of a long chain are asked again by each one
+    auto key = std::tuple(n, current, locals.size(), inlined.size());
+    if (auto it = exact_overloads.find(key); it != exact_overloads.end())
+    {
+        return it->second;
+    }
+
+    auto ov     = find_overload(op, form, symbol, static_type(t.a),
+        binary ? static_type(t.b) : unknown_type);
+    bool result = ov && returning.contains(ov->function) && exact(t.a)
+               && (!binary || exact(t.b));
+    exact_overloads.emplace(key, result);
+    return result;
+}
+
+/**
+ *  @brief  Find what the statements and expressions of a node can
+ *          change.
+ *
+ *  @param  n  The node.
+ *  @param  e  Receives the effects.
+ */
+auto compiler::scan(node_index n, effects &e) const -> void
+{
+    affect(n, e);
+    for (auto c : children(n))
+    {
+        scan(c, e);
+    }
+}
+
+/**
+ *  @brief  Find what a node can change, without the nodes that it
+ *          contains.
+ *
+ *  @param  n  The node.
+ *  @param  e  Receives the effects.
+ */
+auto compiler::affect(node_index n, effects &e) const -> void
+{
+    auto &t = tree[n];
+
+    // Operators on structures call their overloads
+    auto overloads = [&](node_index operand)
+    {
+        auto type = static_type(operand);
+        return type == unknown_type || kind(type) == type_kind::struct_;
+    };
+    auto assigned = [&](node_index target)
+    {
+        auto &x = tree[target];
+        if (x.kind == node_kind::name)
+        {
+            e.symbols.emplace(x.a);
+        }
+        else if (x.kind == node_kind::member)
+        {
+            e.stores = true;
+        }
+        else if (x.kind == node_kind::subscript)
+        {
+            e.elements = true;
+        }
+        e.calls = e.calls || !is_scalar(static_type(target));
+    };
+
+    switch (t.kind)
+    {
+        case node_kind::assign: assigned(t.a); break;
+        case node_kind::unary:
+        case node_kind::postfix:
+            if (t.op == operator_kind::increment
+             || t.op == operator_kind::decrement)
+            {
+                assigned(t.a);
+                break;
+            }
+            e.calls = e.calls || t.op == operator_kind::custom
+                   || overloads(t.a);
+            break;
+        case node_kind::binary:
+            if (t.op == operator_kind::logical_and
+             || t.op == operator_kind::logical_or)
+            {
+                break;
+            }
+            e.calls = e.calls || t.op == operator_kind::custom
+                   || overloads(t.a) || overloads(t.b);
+            break;
+        case node_kind::call:
+            e.calls = e.calls || !intrinsic(n).has_value();
+            break;
+        case node_kind::subscript:
+            e.calls = e.calls || overloads(t.a);
+            break;
+        case node_kind::declaration:
+        {
+            for (auto v : tree.list(t))
+            {
+                e.symbols.emplace(tree[v].a);
+            }
+
+            // Structures are constructed, and destroyed with their scope
+            auto &type = tree[t.a];
+            auto  it   = type_names.find(type.a);
+            e.calls = e.calls || type.kind != node_kind::type_name
+                   || it == type_names.end() || !is_scalar(it->second);
+            break;
+        }
+        default: break;
+    }
+}
+
+/**
+ *  @brief  Check if an expression has no side effects, cannot fail when
+ *          the program runs, and has the same value anywhere in a region.
+ *
+ *  @param  n  The expression.
+ *  @param  e  The effects of the region.
+ *  @return  True if the expression can be evaluated once for the
+ *           region.
+ */
+auto compiler::pure(node_index n, const effects &e) const -> bool
+{
+    auto &t     = tree[n];
+    auto  owner = method_owner();
+    switch (t.kind)
+    {
+        case node_kind::number:
+        case node_kind::character:
+        case node_kind::boolean: return true;
+        case node_kind::name:
+        {
+            if (e.symbols.contains(t.a))
+            {
+                return false;
+            }
+            if (auto local = find_local(t.a))
+            {
+                return is_scalar(local->type);
+            }
+            if (owner != no_function && fields[owner].contains(t.a))
+            {
+                return !e.calls && !e.stores && is_scalar(static_type(n));
+            }
+
+            // Functions can be called before a global variable is set
+            if (globals.contains(t.a))
+            {
+                return current == prog.main && !e.calls
+                    && is_scalar(static_type(n));
+            }
+            return t.a == words.pi;
+        }
+        case node_kind::unary:
+            return operator_opcode(t.op, operator_form::prefix) != opcode::max
+                && pure(t.a, e);
+        case node_kind::binary:
+        {
+            auto op      = operator_opcode(t.op, operator_form::binary);
+            bool logical = t.op == operator_kind::logical_and
+                        || t.op == operator_kind::logical_or;
+            if ((!logical && op == opcode::max) || !pure(t.a, e)
+             || !pure(t.b, e))
+            {
+                return false;
+            }
+
+            // Integer division by zero fails
+            return (op != opcode::floor_divide && op != opcode::modulo)
+                || !is_integral(static_type(t.a))
+                || !is_integral(static_type(t.b));
+        }
+        case node_kind::call:
+            return intrinsic(n).has_value()
+                && stdr::all_of(tree.list(t), [&](node_index arg)
+            {
+                return pure(arg, e);
+            });
+        default: return false;
+    }
+}
+
+/**
+ *  @brief  Find the expressions in a node that can be evaluated once for
+ *          a region, the operands before the expressions using them.
+ *
+ *  @param  n        The node.
+ *  @param  e        The effects of the region.
+ *  @param  maximal  Whether to find only the largest expressions, and
+ *                   not their operands.
+ *  @param  found    Receives the expressions.
+ */
+auto compiler::collect(
+    node_index               n,
+    const effects           &e,
+    bool                     maximal,
+    std::vector<node_index> &found
+) -> void
+{
+    auto &t = tree[n];
+    if (hoisted.contains(n))
+    {
+        return;
+    }
+
+    // Names and constants are as cheap as a hoisted value
+    bool candidate = (t.kind == node_kind::unary
+                   || t.kind == node_kind::binary
+                   || t.kind == node_kind::call) && pure(n, e);
+    if (candidate && fold(n).has_value())
+    {
+        return;
+    }
+
+    if (!candidate || !maximal)
+    {
+        for (auto c : children(n))
+        {
+            collect(c, e, maximal, found);
+        }
+    }
+    if (candidate)
+    {
+        found.emplace_back(n);
+    }
+}
+
+/**
+ *  @brief  Check if two expressions are written the same.
+ *
+ *  @param  a  The first expression.
+ *  @param  b  The second expression.
+ *  @return  True if they have the same operators, names and values.
+ */
+auto compiler::same(node_index a, node_index b) const -> bool
+{
+    auto &x = tree[a];
+    auto &y = tree[b];
+    if (x.kind != y.kind || x.op != y.op)
+    {
+        return false;
+    }
+
+    switch (x.kind)
+    {
+        case node_kind::number: return dtn.numbers[x.a] == dtn.numbers[y.a];
+        case node_kind::character:
+        case node_kind::boolean:
+        case node_kind::name: return x.a == y.a;
+        case node_kind::unary: return same(x.a, y.a);
+        case node_kind::binary: return same(x.a, y.a) && same(x.b, y.b);
+        case node_kind::call:
+            return same(x.a, y.a) && stdr::equal(tree.list(x), tree.list(y),
+                [&](node_index i, node_index j)
+            {
+                return same(i, j);
+            });
+        default: return false;
+    }
+}
+
+/**
+ *  @brief  Hash an expression, so that expressions written the same
+ *          have the same hash.
+ *
+ *  @param  n  The expression.
+ *  @return  The hash.
+ */
+auto compiler::fingerprint(node_index n) const -> std::size_t
+{
+    auto       &t    = tree[n];
+    std::size_t hash = static_cast<std::size_t>(t.kind) * 31
+                     + static_cast<std::size_t>(t.op);
+    switch (t.kind)
+    {
+        case node_kind::number:
+            return hash * 31 + std::hash<number>()(dtn.numbers[t.a]);
+        case node_kind::character:
+        case node_kind::boolean:
+        case node_kind::name: return hash * 31 + t.a;
+        default: break;
+    }
+
+    for (auto c : children(n))
+    {
+        hash = hash * 31 + fingerprint(c);
+    }
+    return hash;
+}
+
+/**
+ *  @brief  Check if the value of a local variable, and not only its
+ *          fields, is used in a node.  Such a value escapes, and the
+ *          structure has to be created.
+ *
+ *  @param  n       The node, or @c no_node .
+ *  @param  symbol  Symbol ID of the variable.
+ *  @param  s       Index of the structure of the variable.
+ *  @param  passes  Whether the value can be passed to small functions and
+ *                  operator overloads that only use its fields.
+ *  @return  True if the node uses the value, calls a method on it or
+ *           declares another variable of the name.
+ */
+auto compiler::escapes(
+    node_index    n,
+    std::uint32_t symbol,
+    std::uint32_t s,
+    bool          passes
+) const -> bool
+{
+    if (n == no_node)
+    {
+        return false;
+    }
+
+    auto &t     = tree[n];
+    auto  type  = prog.structs[s].type;
+    auto  named = [&](node_index x)
+    {
+        return x != no_node && tree[x].kind == node_kind::name
+            && tree[x].a == symbol;
+    };
+
+    // The value passed to the parameter of an inlined body stays in
+    // registers if the body only uses the fields of the parameter
+    auto passed = [&](std::uint32_t fn, std::span<const node_index> args,
+        std::size_t implicit)
+    {
+        auto it = expansions.find(fn);
+        if (it == expansions.end())
+        {
+            return false;
+        }
+
+        auto params = tree.parameters(tree[it->second.first]);
+        for (std::size_t i = 0; i < args.size(); i++)
+        {
+            if (named(args[i])
+             && (prog.functions[fn].parameters[implicit + i] != type
+              || escapes(returned(it->second.first), tree[params[i]].b, s,
+                     false)))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    switch (t.kind)
+    {
+        case node_kind::name: return t.a == symbol;
+        case node_kind::variable:
+            if (t.a == symbol)
+            {
+                return true;
+            }
+            break;
+        case node_kind::member:
+            if (named(t.a))
+            {
+                return !fields[s].contains(t.b);
+            }
+            break;
+        case node_kind::call:
+        {
+            // A method works on the structure itself
+            auto &callee = tree[t.a];
+            auto  args   = tree.list(t);
+            if (callee.kind == node_kind::member && named(callee.a))
+            {
+                return true;
+            }
+            if (passes && stdr::any_of(args, named))
+            {
+                auto fn = resolve_call(n);
+                if (fn == no_function
+                 || !passed(fn, args, prog.functions[fn].owner != no_function))
+                {
+                    return true;
+                }
+                return stdr::any_of(args, [&](node_index arg)
+                {
+                    return !named(arg) && escapes(arg, symbol, s, passes);
+                }) || escapes(t.a, symbol, s, passes);
+            }
+            break;
+        }
+        case node_kind::unary:
+        case node_kind::postfix:
+        case node_kind::binary:
+        {
+            bool binary   = t.kind == node_kind::binary;
+            auto operands = std::array { t.a, binary ? t.b : no_node };
+            if (!passes || is_effect(t) || !stdr::any_of(operands, named))
+            {
+                break;
+            }
+
+            auto form   = binary ? operator_form::binary
+                        : t.kind == node_kind::unary ? operator_form::prefix
+                        : operator_form::postfix;
+            auto custom = t.op != operator_kind::custom ? 0
+                        : binary ? t.c : t.b;
+            auto types  = std::array { unknown_type, unknown_type };
+            for (std::size_t i = 0; i < 2; i++)
+            {
+                types[i] = named(operands[i]) ? type
+                         : operands[i] != no_node ? static_type(operands[i])
+                         : unknown_type;
+            }
+
+            auto ov = find_overload(t.op, form, custom, types[0], types[1]);
+            if (!ov || !passed(ov->function,
+                std::span(operands).first(binary ? 2 : 1), 0))
+            {
+                return true;
+            }
+            return stdr::any_of(operands, [&](node_index x)
+            {
+                return !named(x) && escapes(x, symbol, s, passes);
+            });
+        }
+        default: break;
+    }
+
+    return stdr::any_of(children(n), [&](node_index c)
+    {
+        return escapes(c, symbol, s, passes);
+    });
+}
+
+/**
+ *  @brief  Check if an expression is a call of a constructor of the type,
+ *          or of a small function or operator overload that returns one.
+ *
+ *  @param  n     The expression.
+ *  @param  type  The type.
+ *  @return  True if the expression is worth compiling with @c unpack .
+ */
+auto compiler::constructs(node_index n, type_index type) const -> bool
+{
+    auto creates = [&](node_index x)
+    {
+        if (x == no_node || tree[x].kind != node_kind::call
+         || tree[tree[x].a].kind != node_kind::name)
+        {
+            return false;
+        }
+
+        auto it = type_names.find(tree[tree[x].a].a);
+        return it != type_names.end() && it->second == type;
+    };
+    if (creates(n))
+    {
+        return true;
+    }
+
+    auto &t  = tree[n];
+    auto  fn = no_function;
+    if (t.kind == node_kind::call)
+    {
+        fn = resolve_call(n);
+    }
+    else if ((t.kind == node_kind::binary || t.kind == node_kind::unary
+           || t.kind == node_kind::postfix) && !is_effect(t))
+    {
+        bool binary = t.kind == node_kind::binary;
+        auto form   = binary ? operator_form::binary
+                    : t.kind == node_kind::unary ? operator_form::prefix
+                    : operator_form::postfix;
+        auto symbol = t.op != operator_kind::custom ? 0 : binary ? t.c : t.b;
+        auto ov     = find_overload(t.op, form, symbol, static_type(t.a),
+            binary ? static_type(t.b) : unknown_type);
+        fn = ov ? ov->function : no_function;
+    }
+
+    auto it = expansions.find(fn);
+    return it != expansions.end() && creates(returned(it->second.first));
+}
+
+/**
+ *  @brief  Evaluate the expressions whose value stays the same in a
+ *          region before it, each to a register that the region uses
+ *          instead of evaluating the expression again.
+ *
+ *  Loops hoist the largest such expressions out of the loop.  Blocks
+ *  hoist the expressions and operands that are written more than once,
+ *  to evaluate them once.
+ *
+ *  @param  region  The nodes of the region.
+ *  @param  uses    How many times an expression has to be written to be
+ *                  hoisted.
+ *  @return  The hoisted expressions, to @c release after the region.
+ */
+auto compiler::hoist(std::span<const node_index> region, std::size_t uses)
+-> std::vector<node_index>
+{
+    if (!dtn.options.hoist_expressions)
+    {
+        return {};
+    }
+
+    effects                 e;
+    std::vector<node_index> found;
+    for (auto n : region)
+    {
+        if (n != no_node)
+        {
+            scan(n, e);
+        }
+    }
+    for (auto n : region)
+    {
+        if (n != no_node)
+        {
+            collect(n, e, uses == 1, found);
+        }
+    }
+
+    // Expressions written the same share a register
+    std::vector<std::vector<node_index>>                         groups;
+    std::unordered_map<std::size_t, std::vector<std::size_t>> by_hash;
+    for (auto n : found)
+    {
+        auto &candidates = by_hash[fingerprint(n)];
+        auto  it         = stdr::find_if(candidates, [&](std::size_t g)
+        {
+            return same(groups[g].front(), n);
+        });
+        if (it != candidates.end())
+        {
+            groups[*it].emplace_back(n);
+            continue;
+        }
+        candidates.emplace_back(groups.size());
+        groups.emplace_back(std::vector { n });
+    }
+
+    std::vector<node_index> result;
+    for (auto &group : groups)
+    {
+        if (group.size() < uses)
+        {
+            continue;
+        }
+
+        auto reg  = allocate();
+        auto type = expression(group.front(), reg);
+        for (auto n : group)
+        {
+            hoisted.emplace(n, std::pair(reg, type));
+            result.emplace_back(n);
+        }
+    }
+    return result;
+}
+
+/**
+ *  @brief  Forget the hoisted expressions at the end of their region.
+ *  @param  hoisted_nodes  The expressions that @c hoist returned.
+ */
+auto compiler::release(std::span<const node_index> hoisted_nodes) -> void
+{
+    for (auto n : hoisted_nodes)
+    {
+        hoisted.erase(n);
+    }
+}
+
+/**
+ *  @brief  Remember how much has been emitted.
+ *  @return  The checkpoint.
+ */
+auto compiler::save() const -> checkpoint
+{
+    return checkpoint {
+        .code      = prog.functions[current].code.size(),
+        .messages  = dtn.messages.size(),
+        .errors    = errors,
+        .top       = top,
+        .too_large = too_large
+    };
+}
+
+/**
+ *  @brief  Remove what has been emitted since the checkpoint, with the
+ *          messages.
+ *  @param  saved  The checkpoint.
+ */
+auto compiler::restore(const checkpoint &saved) -> void
+{
+    discard(saved.code);
+    dtn.messages.erase(dtn.messages.begin()
+        + static_cast<std::ptrdiff_t>(saved.messages), dtn.messages.end());
+    errors    = saved.errors;
+    top       = saved.top;
+    too_large = saved.too_large;
+}
+
+/**
+ *  @brief  Choose the function that takes the number of arguments.
+ *
+ *  @param  candidates  The functions of the name.
+ *  @param  count       Number of arguments, with the implicit ones.
+ *  @return  The function, or @c no_function if none takes them.
+ */
+auto compiler::choose(
+    std::span<const std::uint32_t> candidates,
+    std::size_t                    count
+) const -> std::uint32_t
+{
+    auto it = stdr::find_if(candidates, [&](std::uint32_t fn)
+    {
+        return prog.functions[fn].parameters.size() == count;
+    });
+    return it == candidates.end() ? no_function : *it;
+}
+
+/**
+ *  @brief  Check if a function can be compiled in place of a call,
+ *          and take its size from the budget.
+ *
+ *  @param  fn  Index of the function.
+ *  @return  The function node, or @c no_node if it is too large, is
+ *           being compiled, or does not only return an expression.
+ */
+auto compiler::expansion(std::uint32_t fn) -> node_index
+{
+    auto it = expansions.find(fn);
+    if (it == expansions.end() || fn == current
+     || stdr::any_of(inlined, [&](const inline_frame &frame)
+        {
+            return frame.function == fn;
+        }))
+    {
+        return no_node;
+    }
+
+    // The budget is shared by the calls inlined in an inlined body
+    if (inlined.empty())
+    {
+        budget = inline_budget;
+    }
+
+    auto [n, size] = it->second;
+    if (size > budget)
+    {
+        return no_node;
+    }
+    budget -= size;
+    return n;
+}
+
+/**
+ *  @brief  Check if a parameter of an inlined function needs a copy
+ *          of its argument, because the expression changes it, keeps
+ *          it, or reads it after code that can change the argument.
+ *
+ *  @param  n        The expression.
+ *  @param  symbol   Symbol ID of the parameter.
+ *  @param  changed  Whether code that can change a structure or an
+ *                   array has run before the expression, updated to
+ *                   after it.
+ *  @return  True if the parameter needs its own value.
+ */
+auto compiler::needs_copy(
+    node_index    n,
+    std::uint32_t symbol,
+    bool         &changed
+) const -> bool
+{
+    auto &t    = tree[n];
+    auto  root = [&](node_index x)
+    {
+        while (tree[x].kind == node_kind::member
+            || tree[x].kind == node_kind::subscript)
+        {
+            x = tree[x].a;
+        }
+        return tree[x].kind == node_kind::name && tree[x].a == symbol;
+    };
+
+    if (is_effect(t) && root(t.a))
+    {
+        return true;
+    }
+
+    // A number read through the parameter only needs the argument to stay
+    // the same until it is read
+    if ((t.kind == node_kind::member || t.kind == node_kind::subscript)
+     && root(n) && is_scalar(static_type(n)))
+    {
+        for (auto x = n; tree[x].kind != node_kind::name; x = tree[x].a)
+        {
+            auto &step = tree[x];
+            if (step.kind == node_kind::subscript && step.b != no_node
+             && needs_copy(step.b, symbol, changed))
+            {
+                return true;
+            }
+        }
+        return changed;
+    }
+
+    if (t.kind == node_kind::name && t.a == symbol)
+    {
+        return !is_scalar(static_type(n));
+    }
+
+    for (auto c : children(n))
+    {
+        if (needs_copy(c, symbol, changed))
+        {
+            return true;
+        }
+    }
+
+    effects e;
+    affect(n, e);
+    changed = changed || e.calls || e.stores || e.elements;
+    return false;
+}
+
+/**
+ *  @brief  Find the parameters of a function that need their own
+ *          values when it is inlined.
+ *
+ *  @param  fn  Index of the function.
+ *  @param  n   The function node.
+ *  @return  Whether each written parameter needs its own value.
+ */
+auto compiler::owned(std::uint32_t fn, node_index n) -> std::vector<bool>
+{
+    auto        params   = tree.parameters(tree[n]);
+    std::size_t implicit = prog.functions[fn].owner != no_function;
+
+    // The parameters are declared only for the types in the body
+    inlined.emplace_back(inline_frame {
+        .function = fn,
+        .locals   = locals.size(),
+        .self     = 0
+    });
+    for (std::size_t i = 0; i < params.size(); i++)
+    {
+        locals.emplace_back(local_variable {
+            .symbol   = tree[params[i]].b,
+            .type     = prog.functions[fn].parameters[implicit + i],
+            .reg      = no_register,
+            .constant = false
+        });
+    }
+
+    std::vector<bool> result;
+    for (auto param : params)
+    {
+        bool changed = false;
+        result.emplace_back(needs_copy(returned(n), tree[param].b, changed));
+    }
+
+    locals.resize(inlined.back().locals);
+    inlined.pop_back();
+    return result;
+}
+
+/**
+ *  @brief  Compile the expression that a function returns in place of
+ *          a call.
+ *
+ *  @param  fn        Index of the function.
+ *  @param  n         The function node.
+ *  @param  regs      The registers of the written parameters.
+ *  @param  unpacked  Whether each parameter is a structure kept in the
+ *                    registers of its fields, or empty if none is.
+ *  @param  obj       The register of the structure of a method.
+ *  @param  dest      The register of the result.
+ *  @return  Type of the value, or nothing if the body has errors or
+ *           does not give a value.
+ */
+auto compiler::substitute(
+    std::uint32_t                  fn,
+    node_index                     n,
+    std::span<const std::uint16_t> regs,
+    const std::vector<bool>       &unpacked,
+    std::uint16_t                  obj,
+    std::uint16_t                  dest
+) -> std::optional<type_index>
+{
+    auto        params   = tree.parameters(tree[n]);
+    auto        result   = prog.functions[fn].return_type;
+    std::size_t implicit = prog.functions[fn].owner != no_function;
+    auto        before   = errors;
+
+    open_scope();
+    inlined.emplace_back(inline_frame {
+        .function = fn,
+        .locals   = locals.size(),
+        .self     = obj
+    });
+    for (std::size_t i = 0; i < params.size(); i++)
+    {
+        declare_local(tree[params[i]].b,
+            prog.functions[fn].parameters[implicit + i], regs[i], false,
+            params[i], std::nullopt, i < unpacked.size() && unpacked[i]);
+    }
+
+    // A call of a function without a value leaves nothing to return, and
+    // errors are reported once when the function itself is compiled
+    auto body  = returned(n);
+    auto type  = expression(body, dest);
+    bool fails = errors > before || type == void_type;
+    if (!fails)
+    {
+        finish_store(body, type, result, dest);
+    }
+
+    inlined.pop_back();
+    close_scope();
+    if (fails)
+    {
+        return std::nullopt;
+    }
+    return result;
+}
+
+/**
+ *  @brief  Compile a call of a small function or method in place,
+ *          instead of calling it.
+ *
+ *  A parameter takes the register of its argument if it neither changes
+ *  nor keeps it, instead of a copy.  A structure constructed for a
+ *  parameter that only reads and writes its fields is kept in registers.
+ *
+ *  @param  n         The @c node_kind::call .
+ *  @param  fn        Index of the function.
+ *  @param  receiver  The structure of a method, or @c no_node for
+ *                    the structure of the method being compiled.
+ *  @param  dest      The register.
+ *  @return  Type of the value, or nothing if nothing is emitted and
+ *           the function has to be called.
+ */
+auto compiler::expand_call(
+    node_index    n,
+    std::uint32_t fn,
+    node_index    receiver,
+    std::uint16_t dest
+) -> std::optional<type_index>
+{
+    auto definition = dest != no_register ? expansion(fn) : no_node;
+    if (definition == no_node)
+    {
+        return std::nullopt;
+    }
+
+    auto        saved    = save();
+    auto        copies   = owned(fn, definition);
+    auto        args     = tree.list(tree[n]);
+    std::size_t implicit = prog.functions[fn].owner != no_function;
+
+    // A method works on the structure itself, not on a copy
+    auto obj = receiver != no_node ? operand(receiver).first : self();
+    if (implicit != 0 && obj == dest)
+    {
+        auto reg = allocate();
+        emit(opcode::move, reg, obj);
+        obj = reg;
+    }
+
+    auto                       params = tree.parameters(tree[definition]);
+    std::vector<std::uint16_t> regs;
+    std::vector<bool>          unpacked(args.size());
+    for (std::size_t i = 0; i < args.size(); i++)
+    {
+        effects later;
+        for (auto j = i + 1; j < args.size(); j++)
+        {
+            scan(args[j], later);
+        }
+
+        auto &arg   = tree[args[i]];
+        auto  param = prog.functions[fn].parameters[implicit + i];
+        if (plain_type(param) && constructs(args[i], param)
+         && !escapes(returned(definition), tree[params[i]].b,
+                prog.types[param].index, false))
+        {
+            auto size  = prog.structs[prog.types[param].index]
+                .field_types.size();
+            auto first = allocate(size);
+            if (unpack(args[i], param, first))
+            {
+                regs.emplace_back(first);
+                unpacked[i] = true;
+                continue;
+            }
+            top = first;
+        }
+
+        auto  local = arg.kind == node_kind::name ? find_local(arg.a)
+                    : nullptr;
+        bool  own   = copies[i] || needs_destroy(param)
+                   || (!is_scalar(param)
+                    && (later.calls || later.stores || later.elements));
+        if (local && local->unpacked && local->type == param)
+        {
+            // The registers of the fields are passed instead of the value
+            auto size = prog.structs[prog.types[param].index]
+                .field_types.size();
+            auto reg  = local->reg;
+            if (own || later.symbols.contains(arg.a))
+            {
+                reg = allocate(size);
+                for (std::size_t f = 0; f < size; f++)
+                {
+                    emit(opcode::move, static_cast<std::uint16_t>(reg + f),
+                        static_cast<std::uint16_t>(local->reg + f));
+                }
+            }
+            regs.emplace_back(reg);
+            unpacked[i] = true;
+            continue;
+        }
+        if (!own && local && !local->unpacked && local->type == param
+         && local->reg != dest && !later.symbols.contains(arg.a))
+        {
+            regs.emplace_back(local->reg);
+            continue;
+        }
+
+        auto reg  = allocate();
+        auto type = expression(args[i], reg);
+        if (own || type != param || (is_scalar(param) && !exact(args[i])))
+        {
+            finish_store(args[i], type, param, reg);
+        }
+        regs.emplace_back(reg);
+    }
+
+    auto type = substitute(fn, definition, regs, unpacked, obj, dest);
+    if (!type.has_value())
+    {
+        restore(saved);
+    }
+    return type;
+}
+
+/**
+ *  @brief  Compile a small operator overload in place, instead of
+ *          calling it when the program runs.
+ *
+ *  @param  ov        The overload, or @c nullptr .
+ *  @param  operands  The registers of the operands.
+ *  @param  known     Whether each operand is always of its type.
+ *  @param  unpacked  Whether each operand is a structure in the registers
+ *                    of its fields.
+ *  @param  dest      The register.
+ *  @return  Type of the value, or nothing if nothing is emitted and
+ *           the overload has to be called.
+ */
+auto compiler::expand_operator(
+    const overload                *ov,
+    std::span<const std::uint16_t> operands,
+    std::span<const bool>          known,
+    const std::vector<bool>       &unpacked,
+    std::uint16_t                  dest
+) -> std::optional<type_index>
+{
+    auto fn         = ov ? ov->function : no_function;
+    auto definition = dest != no_register ? expansion(fn) : no_node;
+    if (definition == no_node)
+    {
+        return std::nullopt;
+    }
+
+    // Operands are passed by value, which only matters to an overload
+    // that changes or keeps them
+    auto saved  = save();
+    auto copies = owned(fn, definition);
+    std::vector<std::uint16_t> regs;
+    for (std::size_t i = 0; i < operands.size(); i++)
+    {
+        auto param = prog.functions[fn].parameters[i];
+        auto reg   = operands[i];
+        bool own   = (copies[i] || needs_destroy(param)) && !is_scalar(param);
+        if (i < unpacked.size() && unpacked[i])
+        {
+            // The registers of the fields are copied to be changed
+            auto size = prog.structs[prog.types[param].index]
+                .field_types.size();
+            if (copies[i])
+            {
+                reg = allocate(size);
+                for (std::size_t f = 0; f < size; f++)
+                {
+                    emit(opcode::move, static_cast<std::uint16_t>(reg + f),
+                        static_cast<std::uint16_t>(operands[i] + f));
+                }
+            }
+        }
+        else if (is_scalar(param) && !known[i])
+        {
+            reg = allocate();
+            emit(opcode::convert, reg, operands[i],
+                static_cast<std::uint16_t>(param));
+        }
+        else if (own || copies[i] || reg == dest)
+        {
+            reg = allocate();
+            emit(own ? opcode::copy : opcode::move, reg, operands[i]);
+        }
+        regs.emplace_back(reg);
+    }
+
+    auto type = substitute(fn, definition, regs, unpacked, 0, dest);
+    if (!type.has_value())
+    {
+        restore(saved);
+    }
+    return type;
+}
+
+/**
+ *  @brief  Compile an operator whose overload is found when compiling,
+ *          in place if it is small, otherwise as a call of the
+ *          overload.
+ *
+ *  @param  ov        The overload, or @c nullptr .
+ *  @param  nodes     The operands.
+ *  @param  operands  The registers of the operands.
+ *  @param  types     Types of the operands.
+ *  @param  dest      The register.
+ *  @return  Type of the value, or nothing if nothing is emitted and
+ *           the overload is only found when the program runs.
+ */
+auto compiler::call_overload(
+    const overload                *ov,
+    std::span<const node_index>    nodes,
+    std::span<const std::uint16_t> operands,
+    std::span<const type_index>    types,
+    std::uint16_t                  dest
+) -> std::optional<type_index>
+{
+    if (!ov)
+    {
+        return std::nullopt;
+    }
+
+    // An operand that may not be of its type when the program runs may
+    // call another overload, unless the overload takes exactly its type
+    auto &fn     = prog.functions[ov->function];
+    auto  known  = std::array { false, false };
+    bool  exacts = true;
+    bool  same   = true;
+    for (std::size_t i = 0; i < operands.size(); i++)
+    {
+        bool sure = exact(nodes[i]);
+        known[i]  = types[i] == fn.parameters[i] && sure;
+        exacts    = exacts && sure;
+        same      = same && types[i] == fn.parameters[i];
+    }
+    if (!exacts && !same)
+    {
+        return std::nullopt;
+    }
+    if (auto result = expand_operator(ov, operands,
+        std::span(known).first(operands.size()), {}, dest))
+    {
+        return result;
+    }
+    if (!exacts)
+    {
+        return std::nullopt;
+    }
+
+    // Operands are passed by value, like the arguments of a call
+    auto base = allocate(operands.size());
+    for (std::size_t i = 0; i < operands.size(); i++)
+    {
+        auto reg = static_cast<std::uint16_t>(base + i);
+        emit(opcode::move, reg, operands[i]);
+        finish_store(nodes[i], types[i], fn.parameters[i], reg);
+    }
+    emit(opcode::call, base, static_cast<std::uint16_t>(operands.size()),
+        static_cast<std::uint16_t>(ov->function));
+    if (dest != no_register)
+    {
+        emit(opcode::move, dest, base);
+    }
+    return fn.return_type;
+}
+
+/**
+ *  @brief  Compile an operator whose small overload is found when
+ *          compiling, with the structures it only reads the fields of
+ *          passed in registers instead of being created.
+ *
+ *  @param  n     The operator.
+ *  @param  dest  The register.
+ *  @return  Type of the value, or nothing if nothing is emitted.
+ */
+auto compiler::unpacked_operator(
+    node_index    n,
+    std::uint16_t dest
+) -> std::optional<type_index>
+{
+    // `+` copies a structure without calling an overload
+    auto &t      = tree[n];
+    bool  binary = t.kind == node_kind::binary;
+    if (dest == no_register || is_effect(t)
+     || (!binary && t.op == operator_kind::add))
+    {
+        return std::nullopt;
+    }
+
+    auto form   = binary ? operator_form::binary
+                : t.kind == node_kind::unary ? operator_form::prefix
+                : operator_form::postfix;
+    auto symbol = t.op != operator_kind::custom ? 0 : binary ? t.c : t.b;
+    auto nodes  = std::array { t.a, binary ? t.b : no_node };
+    auto count  = binary ? 2uz : 1uz;
+    auto types  = std::array { static_type(t.a), unknown_type };
+    if (binary)
+    {
+        types[1] = static_type(t.b);
+    }
+
+    auto ov = find_overload(t.op, form, symbol, types[0], types[1]);
+    auto it = ov ? expansions.find(ov->function) : expansions.end();
+    if (it == expansions.end())
+    {
+        return std::nullopt;
+    }
+
+    // An operand is passed in registers if it is a structure in registers
+    // or is constructed, and the overload only uses its fields
+    auto             &fn     = prog.functions[ov->function];
+    auto              params = tree.parameters(tree[it->second.first]);
+    std::vector<bool> unpacked(count);
+    auto              local  = [&](std::size_t i)
+    {
+        auto &x = tree[nodes[i]];
+        auto *l = x.kind == node_kind::name ? find_local(x.a) : nullptr;
+        return l && l->unpacked ? l : nullptr;
+    };
+    for (std::size_t i = 0; i < count; i++)
+    {
+        auto param  = fn.parameters[i];
+        unpacked[i] = plain_type(param) && types[i] == param
+                   && ((local(i) && local(i)->type == param)
+                    || constructs(nodes[i], param))
+                   && !escapes(returned(it->second.first), tree[params[i]].b,
+                          prog.types[param].index, false);
+    }
+    if (stdr::none_of(unpacked, std::identity {}))
+    {
+        return std::nullopt;
+    }
+
+    auto saved    = save();
+    auto spent    = budget;
+    auto regs     = std::array<std::uint16_t, 2> {};
+    auto known    = std::array { true, true };
+    auto fallback = [&]
+    {
+        restore(saved);
+        budget = spent;
+        return std::nullopt;
+    };
+    for (std::size_t i = 0; i < count; i++)
+    {
+        auto param = fn.parameters[i];
+        if (!unpacked[i])
+        {
+            auto [reg, type] = operand(nodes[i]);
+            bool sure        = exact(nodes[i]);
+            if (type != types[i] || (!sure && type != param))
+            {
+                return fallback();
+            }
+            regs[i]  = reg;
+            known[i] = type == param && sure;
+            continue;
+        }
+
+        auto size = prog.structs[prog.types[param].index].field_types.size();
+        if (auto *l = local(i))
+        {
+            // The fields are copied if the next operand can change them
+            effects later;
+            if (i + 1 < count)
+            {
+                scan(nodes[i + 1], later);
+            }
+            regs[i] = l->reg;
+            if (later.calls || later.stores
+             || later.symbols.contains(tree[nodes[i]].a))
+            {
+                regs[i] = allocate(size);
+                for (std::size_t f = 0; f < size; f++)
+                {
+                    emit(opcode::move, static_cast<std::uint16_t>(regs[i] + f),
+                        static_cast<std::uint16_t>(l->reg + f));
+                }
+            }
+            continue;
+        }
+
+        regs[i] = allocate(size);
+        if (!unpack(nodes[i], param, regs[i]))
+        {
+            return fallback();
+        }
+    }
+
+    auto result = expand_operator(ov, std::span(regs).first(count),
+        std::span(known).first(count), unpacked, dest);
+    if (!result.has_value())
+    {
+        return fallback();
+    }
+    return result;
+}
+
+/**
+ *  @brief  Compile a structure to the registers of its fields, if the
+ *          constructor that gives its value is compiled here or in an
+ *          inlined body, without creating the structure.
+ *
+ *  The expression is compiled to a register that @c call recognizes at
+ *  the constructor.  It is undone if anything uses that register after
+ *  the constructor, like a conversion of the value.
+ *
+ *  @param  n      The expression.
+ *  @param  type   A plain structure type.
+ *  @param  first  The register of the first field.
+ *  @return  True if the fields are compiled, false if nothing is emitted.
+ */
+auto compiler::unpack(
+    node_index    n,
+    type_index    type,
+    std::uint16_t first
+) -> bool
+{
+    // The register is not the last one taken, so that calls do not start
+    // at it and only the value of the expression goes there
+    auto saved  = save();
+    auto spent  = budget;
+    auto reg    = allocate(2);
+    auto outer  = std::exchange(unpack_into, unpack_target {
+        .reg   = reg,
+        .first = first,
+        .type  = type
+    });
+    auto result = expression(n, reg);
+    auto target = std::exchange(unpack_into, outer);
+    if (result != type || target->end != function().code.size())
+    {
+        restore(saved);
+        budget = spent;
+        return false;
+    }
+
+    top = saved.top;
+    return true;
+}
+
+/**
+ *  @brief  Create a structure from the registers of its fields.
+ *
+ *  @param  first  The register of the first field.
+ *  @param  type   A plain structure type.
+ *  @param  dest   The register of the structure.
+ */
+auto compiler::pack(std::uint16_t first, type_index type, std::uint16_t dest)
+-> void
+{
+    auto size = prog.structs[prog.types[type].index].field_types.size();
+    auto base = window(dest, size + 1);
+    for (std::size_t i = 0; i < size; i++)
+    {
+        emit(opcode::move, static_cast<std::uint16_t>(base + 1 + i),
+            static_cast<std::uint16_t>(first + i));
+    }
+    emit(opcode::construct, base, static_cast<std::uint16_t>(size),
+        static_cast<std::uint16_t>(plain_type(type)->fieldwise));
+    if (base != dest)
+    {
+        emit(opcode::move, dest, base);
+    }
+}
+
+/**
+ *  @brief  Get the register of a local variable, or compile the
+ *          expression to a new register.
+ *
+ *  @param  n  The expression.
+ *  @return  The register and the type of the value.
+ */
+auto compiler::operand(node_index n) -> std::pair<std::uint16_t, type_index>
+{
+    auto &t = tree[n];
+    if (auto it = hoisted.find(n); it != hoisted.end())
+    {
+        return it->second;
+    }
+    if (t.kind == node_kind::name)
+    {
+        if (auto local = find_local(t.a); local && !local->unpacked)
+        {
+            return { local->reg, local->type };
+        }
+    }
+    if (auto field = unpacked_field(n))
+    {
+        return { field->reg, field->type };
+    }
+
+    auto reg = allocate();
+    return { reg, expression(n, reg) };
+}
+
+/**
+ *  @brief  Compile an expression by its kind.
+ *
+ *  @param  n     The expression.
+ *  @param  dest  The register.
+ *  @return  Type of the value.
+ */
+auto compiler::evaluate(node_index n, std::uint16_t dest) -> type_index
+{
+    auto &t = tree[n];
+    switch (t.kind)
+    {
+        case node_kind::number:
+        {
+            auto num = dtn.numbers[t.a];
+            load(dest, std::holds_alternative<double>(num)
+                ? std::get<double>(num)
+                : static_cast<double>(std::get<std::uint64_t>(num)));
+            return real_type;
+        }
+        case node_kind::character:
+            load(dest, static_cast<char>(t.a));
+            return char_type;
+        case node_kind::boolean:
+            load(dest, t.a != 0);
+            return bool_type;
+        case node_kind::string:
+        {
+            auto text = dtn.string_value(t.token);
+            load(dest, value::make_array(array_of(char_type), true,
+                std::vector<value>(text.begin(), text.end())));
+            return array_of(char_type);
+        }
+        case node_kind::name: return name(n, dest);
+        case node_kind::unary:
+        case node_kind::postfix: return unary(n, dest);
+        case node_kind::binary: return binary(n, dest);
+        case node_kind::assign: return assign(n, dest);
+        case node_kind::call: return call(n, dest);
+        case node_kind::member: return member(n, dest);
+        case node_kind::subscript: return subscript(n, dest);
+        case node_kind::array: return array(n, dest);
+        default: return error(message_id::unexpected_token, n);
+    }
+}
+
+/**
+ *  @brief  Compile a name: a local variable, a field of the structure of
+ *          the method, a global variable or `pi`.
+ *
+ *  @param  n     The @c node_kind::name .
+ *  @param  dest  The register.
+ *  @return  Type of the value.
+ */
+auto compiler::name(node_index n, std::uint16_t dest) -> type_index
+{
+    auto symbol = tree[n].a;
+    if (auto local = find_local(symbol))
+    {
+        if (local->unpacked)
+        {
+            pack(local->reg, local->type, dest);
+        }
+        else if (dest != local->reg)
+        {
+            emit(opcode::move, dest, local->reg);
+        }
+        return local->type;
+    }
+
+    auto owner = method_owner();
+    if (owner != no_function)
+    {
+        auto it = fields[owner].find(symbol);
+        if (it != fields[owner].end())
+        {
+            emit(opcode::get_field, dest, self(),
+                static_cast<std::uint16_t>(it->second));
+            return prog.structs[owner].field_types[it->second];
+        }
+    }
+
+    auto it = globals.find(symbol);
+    if (it != globals.end())
+    {
+        emit_bc(opcode::get_global, dest, it->second.slot);
+        return it->second.type;
+    }
+
+    if (symbol == words.pi)
+    {
+        load(dest, std::numbers::pi);
+        return real_type;
+    }
+    return error(message_id::undeclared_name, n);
+}
+
+/**
+ *  @brief  Compile a prefix or postfix operator.
+ *
+ *  @param  n     The @c node_kind::unary or @c node_kind::postfix .
+ *  @param  dest  The register.
+ *  @return  Type of the value.
+ */
+auto compiler::unary(node_index n, std::uint16_t dest) -> type_index
+{
+    auto &t = tree[n];
+    if (t.op == operator_kind::increment || t.op == operator_kind::decrement)
+    {
+        return increment(n, dest);
+    }
+    if (t.op == operator_kind::custom)
+    {
+        return custom(n, dest);
+    }
+
+    auto form = t.kind == node_kind::unary
+              ? operator_form::prefix : operator_form::postfix;
+    auto op   = operator_opcode(t.op, form);
+    if (op == opcode::max || form == operator_form::postfix)
+    {
+        return error(message_id::unknown_operator, n);
+    }
+
+    if (auto result = unpacked_operator(n, dest))
+    {
+        return result.value();
+    }
+
+    // `+` copies a structure without calling an overload
+    auto [reg, type] = operand(t.a);
+    bool known       = exact(t.a);
+    if (kind(type) == type_kind::struct_ && op != opcode::move)
+    {
+        auto ov = find_overload(t.op, form, 0, type, unknown_type);
+        if (auto result = call_overload(ov, std::span(&t.a, 1),
+            std::span(&reg, 1), std::span(&type, 1), dest))
+        {
+            return result.value();
+        }
+    }
+
+    auto specific = known ? typed_opcode(op, type) : opcode::max;
+    if (specific != opcode::max)
+    {
+        emit(specific, dest, reg);
+        return type;
+    }
+
+    emit(op == opcode::move ? opcode::copy : op, dest, reg);
+    if (kind(type) == type_kind::struct_)
+    {
+        return overload_type(t.op, form, 0, type, unknown_type);
+    }
+
+    switch (op)
+    {
+        case opcode::move: return type;
+        case opcode::negate:
+            return is_integral(type) ? int_type
+                 : type == real_type ? real_type : unknown_type;
+        case opcode::logical_not: return bool_type;
+        default: return int_type;
+    }
+}
+
+/**
+ *  @brief  Compile a binary operator.
+ *
+ *  @param  n     The @c node_kind::binary .
+ *  @param  dest  The register.
+ *  @return  Type of the value.
+ */
+auto compiler::binary(node_index n, std::uint16_t dest) -> type_index
+{
+    auto &t = tree[n];
+    if (t.op == operator_kind::custom)
+    {
+        return custom(n, dest);
+    }
+
+    if (t.op == operator_kind::logical_and || t.op == operator_kind::logical_or)
+    {
+        // The right operand is compiled for its messages only if the left
+        // operand is known and decides the result
+        auto lhs     = fold_condition(t.a);
+        bool decides = lhs.has_value()
+                    && lhs.value() == (t.op == operator_kind::logical_or);
+        if (decides)
+        {
+            auto at = function().code.size();
+            expression(t.b, dest);
+            discard(at);
+            load(dest, lhs.value());
+            return bool_type;
+        }
+        if (lhs.has_value())
+        {
+            finish_store(t.b, expression(t.b, dest), bool_type, dest);
+            return bool_type;
+        }
+
+        finish_store(t.a, expression(t.a, dest), bool_type, dest);
+        logical(t.op, dest, t.b);
+        return bool_type;
+    }
+
+    if (auto result = unpacked_operator(n, dest))
+    {
+        return result.value();
+    }
+
+    auto [lhs, type] = operand(t.a);
+    return combine(t.op, dest, lhs, type, t.a, t.b);
+}
+
+/**
+ *  @brief  Apply a binary operator to the value in the register and the
+ *          expression.
+ *
+ *  @param  op     The operator.
+ *  @param  dest   The register of the result.
+ *  @param  lhs    The register of the left operand.
+ *  @param  type   Type of the left operand.
+ *  @param  left   The left operand.
+ *  @param  rhs    The right operand.
+ *  @return  Type of the result.
+ */
+auto compiler::combine(
+    operator_kind op,
+    std::uint16_t dest,
+    std::uint16_t lhs,
+    type_index    type,
+    node_index    left,
+    node_index    rhs
+) -> type_index
+{
+    if (op == operator_kind::logical_and || op == operator_kind::logical_or)
+    {
+        emit(opcode::convert, dest, lhs, bool_type);
+        logical(op, dest, rhs);
+        return bool_type;
+    }
+
+    auto code = operator_opcode(op, operator_form::binary);
+    if (code == opcode::max)
+    {
+        return error(message_id::unknown_operator, rhs);
+    }
+
+    auto fresh        = top;
+    auto [reg, other] = operand(rhs);
+    auto exacts       = std::array { exact(left), exact(rhs) };
+    if (kind(type) == type_kind::struct_ || kind(other) == type_kind::struct_)
+    {
+        auto ov = find_overload(op, operator_form::binary, 0, type, other);
+        if (auto result = call_overload(ov, std::array { left, rhs },
+            std::array { lhs, reg }, std::array { type, other }, dest))
+        {
+            return result.value();
+        }
+    }
+
+    // An `int` compared to a whole constant is compared as an `int`
+    bool compares = code >= opcode::less && code <= opcode::not_equal;
+    if (compares && type == int_type && other == real_type && reg >= fresh
+     && exacts[0] && exacts[1] && narrow(reg))
+    {
+        other = int_type;
+    }
+
+    if (!exacts[0] || !exacts[1] || !typed(code, dest, lhs, type, reg, other))
+    {
+        emit(code, dest, lhs, reg);
+    }
+    return binary_type(op, type, other);
+}
+
+/**
+ *  @brief  Apply a binary operator to numbers that are always of their
+ *          types, with the opcode of their type.  An `int` operand is
+ *          converted to `real` if the other is a `real`.
+ *
+ *  @param  op     The opcode, from @c opcode::add to
+ *                 @c opcode::not_equal .
+ *  @param  dest   The register of the result.
+ *  @param  lhs    The register of the left operand.
+ *  @param  left   Type of the left operand.
+ *  @param  rhs    The register of the right operand.
+ *  @param  right  Type of the right operand.
+ *  @return  True if the operator was emitted, false if the types have
+ *           no such opcode.
+ */
+auto compiler::typed(
+    opcode        op,
+    std::uint16_t dest,
+    std::uint16_t lhs,
+    type_index    left,
+    std::uint16_t rhs,
+    type_index    right
+) -> bool
+{
+    // `a > b` is `b < a`, which is also false for NaN
+    if (op == opcode::greater || op == opcode::greater_equal)
+    {
+        op = op == opcode::greater ? opcode::less : opcode::less_equal;
+        std::swap(lhs, rhs);
+        std::swap(left, right);
+    }
+
+    auto numeric = [](type_index type)
+    {
+        return type == int_type || type == real_type;
+    };
+    auto type = left == right ? left : real_type;
+    auto code = typed_opcode(op, type);
+    if (!numeric(left) || !numeric(right) || code == opcode::max)
+    {
+        return false;
+    }
+
+    for (auto [reg, from] : { std::pair(&lhs, left), std::pair(&rhs, right) })
+    {
+        if (from != type)
+        {
+            auto converted = allocate();
+            emit(opcode::int_to_real, converted, *reg);
+            *reg = converted;
+        }
+    }
+    emit(code, dest, lhs, rhs);
+    return true;
+}
+
+/**
+ *  @brief  Make the `real` constant that was just loaded to the
+ *          register an `int`, if it is a whole number that fits.
+ *
+ *  @param  reg  The register.
+ *  @return  True if the constant was changed.
+ */
+auto compiler::narrow(std::uint16_t reg) -> bool
+{
+    using limits = std::numeric_limits<std::int32_t>;
+
+    auto &code = function().code;
+    if (label >= code.size() || code.back().op != opcode::load_constant
+     || code.back().a != reg)
+    {
+        return false;
+    }
+
+    auto real = prog.constants[code.back().bc()].get_if<double>();
+    if (!real || !(*real >= limits::min() && *real <= limits::max())
+     || static_cast<std::int32_t>(*real) != *real)
+    {
+        return false;
+    }
+
+    code.back().set_bc(constant(static_cast<std::int32_t>(*real)));
+    return true;
+}
+
+/**
+ *  @brief  Compile the right operand of `&&` or `||`, only if the left
+ *          operand in the register does not decide the result.
+ *
+ *  @param  op    @c operator_kind::logical_and or
+ *                @c operator_kind::logical_or .
+ *  @param  dest  The register of the left operand and the result.
+ *  @param  rhs   The right operand.
+ */
+auto compiler::logical(
+    operator_kind op,
+    std::uint16_t dest,
+    node_index    rhs
+) -> void
+{
+    auto skip = emit_bc(op == operator_kind::logical_and
+        ? opcode::jump_if_false : opcode::jump_if_true, dest, 0);
+    finish_store(rhs, expression(rhs, dest), bool_type, dest);
+    patch(skip);
+}
+
+/**
+ *  @brief  Compile a custom operator, whose overload is found when the
+ *          program runs.
+ *
+ *  @param  n     The @c node_kind::unary , @c node_kind::postfix or
+ *                @c node_kind::binary .
+ *  @param  dest  The register.
+ *  @return  Type of the value.
+ */
+auto compiler::custom(node_index n, std::uint16_t dest) -> type_index
+{
+    auto &t      = tree[n];
+    bool  binary = t.kind == node_kind::binary;
+    auto  form   = binary ? operator_form::binary
+                 : t.kind == node_kind::unary ? operator_form::prefix
+                 : operator_form::postfix;
+    auto  symbol = binary ? t.c : t.b;
+    if (auto result = unpacked_operator(n, dest))
+    {
+        return result.value();
+    }
+
+    auto base     = window(dest, binary ? 2 : 1);
+    auto lhs      = expression(t.a, base);
+    auto rhs      = binary ? expression(t.b, base + 1) : unknown_type;
+    auto ov       = find_overload(operator_kind::custom, form, symbol, lhs,
+        rhs);
+    auto nodes    = std::array { t.a, t.b };
+    auto operands = std::array { base, static_cast<std::uint16_t>(base + 1) };
+    auto types    = std::array { lhs, rhs };
+    auto count    = binary ? 2 : 1;
+    if (auto result = call_overload(ov, std::span(nodes).first(count),
+        std::span(operands).first(count), std::span(types).first(count),
+        dest))
+    {
+        return result.value();
+    }
+
+    emit(opcode::call_operator, base, static_cast<std::uint16_t>(form),
+        operator_index(symbol));
+    if (base != dest)
+    {
+        emit(opcode::move, dest, base);
+    }
+    return overload_type(operator_kind::custom, form, symbol, lhs, rhs);
+}
+
+/**
+ *  @brief  Compile an assignment.
+ *
+ *  @param  n     The @c node_kind::assign .
+ *  @param  dest  The register, or @c no_register .
+ *  @return  Type of the value.
+ */
+auto compiler::assign(node_index n, std::uint16_t dest) -> type_index
+{
+    auto &t = tree[n];
+    auto  p = find_place(t.a);
+    if (!p)
+    {
+        return unknown_type;
+    }
+
+    // An array that is concatenated to itself is the result, which
+    // appends in place to the capacity it already has
+    auto &rhs   = tree[t.b];
+    auto  right = t.op == operator_kind::add ? t.b : no_node;
+    if (t.op == operator_kind::assign && rhs.kind == node_kind::binary
+     && rhs.op == operator_kind::add && tree[rhs.a].kind == node_kind::name
+     && tree[rhs.a].a == tree[t.a].a)
+    {
+        right = rhs.b;
+    }
+    if (right != no_node && p->kind == place_kind::local
+     && tree[t.a].kind == node_kind::name
+     && kind(p->type) == type_kind::array
+     && (tree[right].kind == node_kind::string
+      || kind(static_type(right)) == type_kind::array))
+    {
+        auto type = combine(operator_kind::add, p->reg, p->reg, p->type, t.a,
+            right);
+        if (type != p->type)
+        {
+            emit(opcode::convert, p->reg, p->reg,
+                static_cast<std::uint16_t>(p->type));
+        }
+        if (dest != no_register)
+        {
+            load(dest, *p);
+        }
+        return p->type;
+    }
+
+    // The value of a variable that is assigned is moved where the
+    // expression uses it once
+    auto moved = no_node;
+    auto local = tree[t.a].kind == node_kind::name ? find_local(tree[t.a].a)
+               : nullptr;
+    if (t.op == operator_kind::assign && local && movable(*local))
+    {
+        std::unordered_map<std::uint32_t, node_index> names;
+        find_uses(t.b, names, false);
+        auto it = names.find(tree[t.a].a);
+        if (it != names.end() && it->second != no_node
+         && !last_uses[it->second])
+        {
+            moved            = it->second;
+            last_uses[moved] = true;
+        }
+    }
+
+    auto reg = allocate();
+    if (t.op == operator_kind::assign)
+    {
+        finish_store(t.b, expression(t.b, reg), p->type, reg);
+    }
+    else
+    {
+        auto current = p->reg;
+        if (p->kind != place_kind::local)
+        {
+            current = allocate();
+            load(current, *p);
+        }
+
+        auto type = combine(t.op, reg, current, p->type, t.a, t.b);
+        finish_store(n, type, p->type, reg);
+    }
+
+    if (moved != no_node)
+    {
+        last_uses[moved] = false;
+    }
+
+    store(*p, reg);
+    if (dest != no_register)
+    {
+        load(dest, *p);
+    }
+    return p->type;
+}
+
+/**
+ *  @brief  Compile an increment or a decrement.
+ *
+ *  @param  n     The @c node_kind::unary or @c node_kind::postfix .
+ *  @param  dest  The register, or @c no_register .
+ *  @return  Type of the value.
+ */
+auto compiler::increment(node_index n, std::uint16_t dest) -> type_index
+{
+    auto &t      = tree[n];
+    bool  prefix = t.kind == node_kind::unary;
+    auto  p      = find_place(t.a);
+    if (!p)
+    {
+        return unknown_type;
+    }
+
+    auto current = p->reg;
+    if (p->kind != place_kind::local)
+    {
+        current = allocate();
+        load(current, *p);
+    }
+    if (!prefix && dest != no_register)
+    {
+        emit(opcode::move, dest, current);
+    }
+
+    auto one    = allocate();
+    auto result = allocate();
+    load(one, p->type == int_type ? value(std::int32_t(1)) : value(1.0));
+    auto op       = t.op == operator_kind::increment ? opcode::add
+                  : opcode::subtract;
+    auto specific = exact(t.a) ? typed_opcode(op, p->type) : opcode::max;
+    emit(specific != opcode::max ? specific : op, result, current, one);
+    if (p->type != int_type && p->type != real_type
+     && p->type != unknown_type)
+    {
+        emit(opcode::convert, result, result,
+            static_cast<std::uint16_t>(p->type));
+    }
+
+    store(*p, result);
+    if (prefix && dest != no_register)
+    {
+        load(dest, *p);
+    }
+    return p->type;
+}
+
+/**
+ *  @brief  Compile a call of a function, a method, a constructor, a
+ *          builtin function, an array method, or a conversion like
+ *          `int(x)`.
+ *
+ *  @param  n     The @c node_kind::call .
+ *  @param  dest  The register.
+ *  @return  Type of the value.
+ */
+auto compiler::call(node_index n, std::uint16_t dest) -> type_index
+{
+    auto &t      = tree[n];
+    auto &callee = tree[t.a];
+    auto  args   = tree.list(t);
+    auto  count  = static_cast<std::uint16_t>(args.size());
+    auto  finish = [&](std::uint16_t base, type_index type)
+    {
+        if (base != dest)
+        {
+            emit(opcode::move, dest, base);
+        }
+        return type;
+    };
+
+    if (callee.kind == node_kind::member)
+    {
+        return method(n, dest);
+    }
+
+    // `int[5]()` makes an array of the size
+    if (callee.kind == node_kind::subscript
+     && tree[callee.a].kind == node_kind::name
+     && type_names.contains(tree[callee.a].a))
+    {
+        auto type = array_of(type_names[tree[callee.a].a]);
+        if (count != 0)
+        {
+            return error(message_id::no_matching_function, n,
+                std::uint32_t(count));
+        }
+        if (callee.b == no_node)
+        {
+            emit(opcode::new_array, dest, 0, static_cast<std::uint16_t>(type));
+            return type;
+        }
+        emit(opcode::new_array_sized, dest, operand(callee.b).first,
+            static_cast<std::uint16_t>(type));
+        return type;
+    }
+
+    if (callee.kind != node_kind::name)
+    {
+        return error(message_id::not_callable, t.a);
+    }
+
+    auto symbol = callee.a;
+    auto owner  = method_owner();
+    if (find_local(symbol) || globals.contains(symbol)
+     || (owner != no_function && fields[owner].contains(symbol)))
+    {
+        return error(message_id::not_callable, t.a);
+    }
+
+    if (auto it = type_names.find(symbol); it != type_names.end())
+    {
+        auto type = it->second;
+        if (kind(type) == type_kind::struct_)
+        {
+            auto &candidates = constructors[prog.types[type].index];
+            auto &st         = prog.structs[prog.types[type].index];
+            auto  info       = plain_type(type);
+            auto  ctor       = choose(candidates, count + 1);
+            if (info && unpack_into && unpack_into->reg == dest
+             && unpack_into->type == type && !unpack_into->end
+             && ctor != no_function
+             && (ctor == info->fieldwise || ctor == info->empty))
+            {
+                // The constructors only set the fields, which are compiled
+                // to the registers of the unpacked structure instead
+                auto target = *std::exchange(unpack_into, std::nullopt);
+                for (std::size_t i = 0; i < st.field_types.size(); i++)
+                {
+                    auto reg = static_cast<std::uint16_t>(target.first + i);
+                    if (count == 0)
+                    {
+                        load(reg, info->initial[i]);
+                        continue;
+                    }
+                    finish_store(args[i], expression(args[i], reg),
+                        st.field_types[i], reg);
+                }
+                target.end  = function().code.size();
+                unpack_into = target;
+                return type;
+            }
+
+            auto base = window(dest, count + 1);
+            ctor      = invoke(n, candidates, base, 1);
+            emit(opcode::construct, base, count,
+                static_cast<std::uint16_t>(ctor));
+            return finish(base, type);
+        }
+        if (!is_scalar(type) || count != 1)
+        {
+            return error(message_id::no_matching_function, n,
+                std::uint32_t(count));
+        }
+
+        finish_store(args[0], expression(args[0], dest), type, dest);
+        return type;
+    }
+
+    if (owner != no_function)
+    {
+        auto it = methods[owner].find(symbol);
+        if (it != methods[owner].end())
+        {
+            auto fn = choose(it->second, count + 1);
+            if (auto type = expand_call(n, fn, no_node, dest))
+            {
+                return type.value();
+            }
+
+            auto base = window(dest, count + 1);
+            emit(opcode::move, base, self());
+            fn = invoke(n, it->second, base, 1);
+            emit(opcode::call, base, count + 1, static_cast<std::uint16_t>(fn));
+            return finish(base, fn == no_function ? unknown_type
+                : prog.functions[fn].return_type);
+        }
+    }
+
+    if (auto it = functions.find(symbol); it != functions.end())
+    {
+        if (auto type = expand_call(n, choose(it->second, count), no_node,
+            dest))
+        {
+            return type.value();
+        }
+
+        auto base = window(dest, count);
+        auto fn   = invoke(n, it->second, base, 0);
+        emit(opcode::call, base, count, static_cast<std::uint16_t>(fn));
+        return finish(base, fn == no_function ? unknown_type
+            : prog.functions[fn].return_type);
+    }
+
+    auto it = builtins.find(symbol);
+    if (it == builtins.end())
+    {
+        return error(message_id::undeclared_name, t.a);
+    }
+
+    auto &function = plons::dtn::builtins()[
+        static_cast<std::size_t>(it->second)];
+    if (count < function.least || count > function.most)
+    {
+        return error(message_id::no_matching_function, n,
+            std::uint32_t(count));
+    }
+
+    auto base = window(dest, count);
+    for (std::uint16_t i = 0; i < count; i++)
+    {
+        expression(args[i], base + i);
+    }
+    emit(opcode::call_builtin, base, count,
+        static_cast<std::uint16_t>(it->second));
+    return finish(base, real_type);
+}
+
+/**
+ *  @brief  Choose the function with the number of arguments, and compile
+ *          the arguments to the registers of the call.
+ *
+ *  @param  n           The @c node_kind::call .
+ *  @param  candidates  The functions of the name.
+ *  @param  base        The first register of the call.
+ *  @param  implicit    Number of arguments before the written ones, like
+ *                      the structure of a method.
+ *  @return  The function, or @c no_function if none takes the arguments.
+ */
+auto compiler::invoke(
+    node_index                     n,
+    std::span<const std::uint32_t> candidates,
+    std::uint16_t                  base,
+    std::size_t                    implicit
+) -> std::uint32_t
+{
+    auto args = tree.list(tree[n]);
+    auto fn   = choose(candidates, args.size() + implicit);
+    if (fn == no_function)
+    {
+        error(message_id::no_matching_function, n,
+            static_cast<std::uint32_t>(args.size()));
+        return no_function;
+    }
+
+    auto &params = prog.functions[fn].parameters;
+    for (std::size_t i = 0; i < args.size(); i++)
+    {
+        auto reg = static_cast<std::uint16_t>(base + implicit + i);
+        finish_store(args[i], expression(args[i], reg), params[implicit + i],
+            reg);
+    }
+    return fn;
+}
+
+/**
+ *  @brief  Compile a call of a method, or of `count`, `insert` and
+ *          `remove` of an array.
+ *
+ *  @param  n     The @c node_kind::call of a @c node_kind::member .
+ *  @param  dest  The register.
+ *  @return  Type of the value.
+ */
+auto compiler::method(node_index n, std::uint16_t dest) -> type_index
+{
+    auto &t      = tree[n];
+    auto &callee = tree[t.a];
+    auto  args   = tree.list(t);
+    auto  count  = static_cast<std::uint16_t>(args.size());
+
+    // A small method is compiled in place, on the structure itself
+    if (auto type = expand_call(n, resolve_call(n), callee.a, dest))
+    {
+        return type.value();
+    }
+
+    auto base   = window(dest, count + 1);
+    auto type   = expression(callee.a, base);
+    auto result = unknown_type;
+
+    if (kind(type) == type_kind::struct_)
+    {
+        auto s  = prog.types[type].index;
+        auto it = methods[s].find(callee.b);
+        if (it == methods[s].end())
+        {
+            return error(message_id::unknown_member, t.a);
+        }
+
+        auto fn = invoke(n, it->second, base, 1);
+        emit(opcode::call, base, count + 1, static_cast<std::uint16_t>(fn));
+        result = fn == no_function ? unknown_type
+               : prog.functions[fn].return_type;
+    }
+    else
+    {
+        auto symbol = callee.b;
+        auto arity  = symbol == words.count ? 0
+                    : symbol == words.insert ? 2
+                    : symbol == words.remove ? 1 : -1;
+        if (arity < 0 || (kind(type) != type_kind::array
+         && kind(type) != type_kind::unknown))
+        {
+            return error(message_id::unknown_member, t.a);
+        }
+        if (count != arity)
+        {
+            return error(message_id::no_matching_function, n,
+                std::uint32_t(count));
+        }
+
+        for (std::uint16_t i = 0; i < count; i++)
+        {
+            auto reg  = static_cast<std::uint16_t>(base + 1 + i);
+            auto from = expression(args[i], reg);
+            finish_store(args[i], from, unknown_type, reg);
+        }
+
+        auto element = kind(type) == type_kind::array
+                     ? prog.types[type].index : unknown_type;
+        if (symbol == words.count)
+        {
+            emit(opcode::count, base, base);
+            result = int_type;
+        }
+        else
+        {
+            emit(symbol == words.insert ? opcode::insert : opcode::remove,
+                base, base, base + 1);
+            result = element;
+        }
+    }
+
+    if (base != dest)
+    {
+        emit(opcode::move, dest, base);
+    }
+    return result;
+}
+
+/**
+ *  @brief  Compile a member access of a structure.
+ *
+ *  @param  n     The @c node_kind::member .
+ *  @param  dest  The register.
+ *  @return  Type of the value.
+ */
+auto compiler::member(node_index n, std::uint16_t dest) -> type_index
+{
+    auto &t = tree[n];
+    if (auto field = unpacked_field(n))
+    {
+        load(dest, field.value());
+        return field->type;
+    }
+
+    // A structure that is only constructed to read a field is kept in the
+    // registers of its fields
+    auto created = static_type(t.a);
+    if (plain_type(created) && constructs(t.a, created))
+    {
+        auto  s     = prog.types[created].index;
+        auto &st    = prog.structs[s];
+        auto  it    = fields[s].find(t.b);
+        auto  first = allocate(st.field_types.size());
+        if (it != fields[s].end() && unpack(t.a, created, first))
+        {
+            emit(opcode::move, dest,
+                static_cast<std::uint16_t>(first + it->second));
+            return st.field_types[it->second];
+        }
+        top = first;
+    }
+
+    auto [object, type] = operand(t.a);
+    if (kind(type) != type_kind::struct_)
+    {
+        return error(message_id::unknown_member, n);
+    }
+
+    auto s  = prog.types[type].index;
+    auto it = fields[s].find(t.b);
+    if (it == fields[s].end())
+    {
+        return error(message_id::unknown_member, n);
+    }
+
+    emit(opcode::get_field, dest, object,
+        static_cast<std::uint16_t>(it->second));
+    return prog.structs[s].field_types[it->second];
+}
+
+/**
+ *  @brief  Compile a subscript of an array, or the subscript operator
+ *          overload of a structure.
+ *
+ *  @param  n     The @c node_kind::subscript .
+ *  @param  dest  The register.
+ *  @return  Type of the value.
+ */
+auto compiler::subscript(node_index n, std::uint16_t dest) -> type_index
+{
+    auto &t = tree[n];
+    if (t.b == no_node)
+    {
+        return error(message_id::expected_expression, n);
+    }
+
+    auto [object, type] = operand(t.a);
+    auto [index, other] = operand(t.b);
+    if (kind(type) == type_kind::struct_)
+    {
+        auto ov = find_overload(operator_kind::subscript_begin,
+            operator_form::subscript, 0, type, other);
+        if (auto result = call_overload(ov, std::array { t.a, t.b },
+            std::array { object, index }, std::array { type, other }, dest))
+        {
+            return result.value();
+        }
+    }
+
+    emit(opcode::get_index, dest, object, index);
+
+    switch (kind(type))
+    {
+        case type_kind::array: return prog.types[type].index;
+        case type_kind::struct_:
+            return overload_type(operator_kind::subscript_begin,
+                operator_form::subscript, 0, type, other);
+        default: return unknown_type;
+    }
+}
+
+/**
+ *  @brief  Compile an array literal.  The elements have the same type if
+ *          all of them do.
+ *
+ *  @param  n     The @c node_kind::array .
+ *  @param  dest  The register.
+ *  @return  Type of the array.
+ */
+auto compiler::array(node_index n, std::uint16_t dest) -> type_index
+{
+    auto elements = tree.list(tree[n]);
+    auto base     = window(dest, elements.size());
+    auto element  = unknown_type;
+    for (std::size_t i = 0; i < elements.size(); i++)
+    {
+        auto reg  = static_cast<std::uint16_t>(base + i);
+        auto type = expression(elements[i], reg);
+        finish_store(elements[i], type, unknown_type, reg);
+        element = i == 0 || type == element ? type : unknown_type;
+    }
+
+    auto type = array_of(element);
+    emit(opcode::new_array, base, static_cast<std::uint16_t>(elements.size()),
+        static_cast<std::uint16_t>(type));
+    if (base != dest)
+    {
+        emit(opcode::move, dest, base);
+    }
+    return type;
+}
+
+/**
+ *  @brief  Compile the syntax tree into bytecode.
+ *  @return  The compiled program.
+ */
+auto detronade::generate() -> std::optional<program>
+{
+    compiler c(*this);
+    c.compile_program();
+    if (c.errors > 0)
+    {
+        return std::nullopt;
+    }
+    return std::move(c.prog);
+}
@@ -0,0 +1,2065 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Parser of Detronade, implementations of @c detronade::parse
+ *           from @c plons_detronade.hpp .
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "plons_detronade.hpp"
+
+using namespace plons::dtn;
+
+namespace stdr = std::ranges;
+
+/**
+ *  @brief  Spelling of a regular operator.
+ */
+struct operator_spelling {
+
+    /**
+     *  @brief  The operator as written in the source code.
+     */
+    std::string_view text;
+
+    /**
+     *  @brief  The operator.
+     */
+    operator_kind kind;
+
+    /**
+     *  @brief  Whether it is the compound assignment of the operator.
+     */
+    bool compound;
+};
+
+/**
+ *  @brief  Every regular operator.
+ */
+static constexpr auto operator_spellings = std::to_array<operator_spelling>({
+    { "+", operator_kind::add, false },
+    { "-", operator_kind::subtract, false },
+    { "*", operator_kind::multiply, false },
+    { "/", operator_kind::divide, false },
+    { "//", operator_kind::floor_divide, false },
+    { "%", operator_kind::modulo, false },
+    { "**", operator_kind::power, false },
+    { "<<", operator_kind::shift_left, false },
+    { ">>", operator_kind::shift_right, false },
+    { "<", operator_kind::less, false },
+    { "<=", operator_kind::less_equal, false },
+    { ">", operator_kind::greater, false },
+    { ">=", operator_kind::greater_equal, false },
+    { "==", operator_kind::equal, false },
+    { "!=", operator_kind::not_equal, false },
+    { "&", operator_kind::bitwise_and, false },
+    { "^", operator_kind::bitwise_xor, false },
+    { "|", operator_kind::bitwise_or, false },
+    { "&&", operator_kind::logical_and, false },
+    { "||", operator_kind::logical_or, false },
+    { "!", operator_kind::logical_not, false },
+    { "~", operator_kind::bitwise_not, false },
+    { "++", operator_kind::increment, false },
+    { "--", operator_kind::decrement, false },
+    { "=", operator_kind::assign, false },
+    { "[", operator_kind::subscript_begin, false },
+    { "]", operator_kind::subscript_end, false },
+    { "+=", operator_kind::add, true },
+    { "-=", operator_kind::subtract, true },
+    { "*=", operator_kind::multiply, true },
+    { "/=", operator_kind::divide, true },
+    { "//=", operator_kind::floor_divide, true },
+    { "%=", operator_kind::modulo, true },
+    { "**=", operator_kind::power, true },
+    { "<<=", operator_kind::shift_left, true },
+    { ">>=", operator_kind::shift_right, true },
+    { "&=", operator_kind::bitwise_and, true },
+    { "^=", operator_kind::bitwise_xor, true },
+    { "|=", operator_kind::bitwise_or, true },
+    { "&&=", operator_kind::logical_and, true },
+    { "||=", operator_kind::logical_or, true }
+});
+
+// Binding powers, from the loosest
+static constexpr std::uint8_t assign_power = 2;
+static constexpr std::uint8_t custom_power = 4;
+static constexpr std::uint8_t unary_power  = 26;
+
+/**
+ *  @brief  Get the binding power of a regular binary operator.
+ *
+ *  @param  kind  The operator.
+ *  @return  The binding power, or 0 if it is not a binary operator.
+ */
+[[nodiscard]] static inline constexpr auto binary_power(operator_kind kind)
+-> std::uint8_t
+{
+    switch (kind)
+    {
+    using enum operator_kind;
+        case assign: return assign_power;
+        case custom: return custom_power;
+        case logical_or: return 6;
+        case logical_and: return 8;
+        case bitwise_or: return 10;
+        case bitwise_xor: return 12;
+        case bitwise_and: return 14;
+        case equal:
+        case not_equal: return 16;
+        case less:
+        case less_equal:
+        case greater:
+        case greater_equal: return 18;
+        case shift_left:
+        case shift_right: return 20;
+        case add:
+        case subtract: return 22;
+        case multiply:
+        case divide:
+        case floor_divide:
+        case modulo: return 24;
+        case power: return 28;
+        default: return 0;
+    }
+}
+
+/**
+ *  @brief  Operator that a symbol refers to.
+ */
+struct operator_info {
+
+    /**
+     *  @brief  The operator, or @c operator_kind::unknown if the symbol is
+     *          not an operator.
+     */
+    operator_kind kind = operator_kind::unknown;
+
+    /**
+     *  @brief  Whether it is the compound assignment of the operator.
+     */
+    bool compound = false;
+
+    /**
+     *  @brief  Bits of the @c operator_form in which a custom operator is
+     *          declared.
+     */
+    std::uint8_t forms = 0;
+};
+
+/**
+ *  @brief  An operator that can be split from an operator token.
+ */
+struct known_operator {
+
+    /**
+     *  @brief  The operator as written in the source code.
+     */
+    std::string_view text;
+
+    /**
+     *  @brief  Symbol ID of the operator.
+     */
+    std::uint32_t symbol;
+};
+
+/**
+ *  @brief  Operator at the current position of the parser.
+ */
+struct operator_match {
+
+    /**
+     *  @brief  The operator, or @c operator_kind::unknown .
+     */
+    operator_kind kind;
+
+    /**
+     *  @brief  Whether it is the compound assignment of the operator.
+     */
+    bool compound;
+
+    /**
+     *  @brief  Symbol ID of the operator.
+     */
+    std::uint32_t symbol;
+
+    /**
+     *  @brief  Length of the operator in the token.
+     */
+    std::uint32_t length;
+};
+
+/**
+ *  @brief  Symbol IDs of the keywords.
+ */
+struct keywords {
+    std::uint32_t if_;
+    std::uint32_t else_;
+    std::uint32_t while_;
+    std::uint32_t for_;
+    std::uint32_t return_;
+    std::uint32_t void_;
+    std::uint32_t const_;
+    std::uint32_t struct_;
+    std::uint32_t construct;
+    std::uint32_t destruct;
+    std::uint32_t operator_;
+    std::uint32_t true_;
+    std::uint32_t false_;
+};
+
+/**
+ *  @brief  Pratt parser over the tokens, building the syntax tree.
+ *
+ *  Operator tokens are split as they are parsed, since the lexer joins
+ *  adjacent operator characters such as `]=` in `a[0]=-1`.  The longest
+ *  regular or declared operator is taken each time.
+ *
+ *  Statements end at the end of the line, except inside parentheses or
+ *  brackets.  Blocks are made of the lines with the same indentation.
+ */
+struct parser {
+
+    /**
+     *  @brief  The source code's information, receives the messages.
+     */
+    detronade &dtn;
+
+    /**
+     *  @brief  The source code.
+     */
+    const char *text;
+
+    /**
+     *  @brief  The tokens.
+     */
+    std::span<const token> tokens;
+
+    /**
+     *  @brief  The syntax tree being built.
+     */
+    syntax_tree tree;
+
+    /**
+     *  @brief  Stack of the elements of the lists being parsed.
+     */
+    std::vector<std::uint32_t> scratch;
+
+    /**
+     *  @brief  Symbol IDs of the keywords.
+     */
+    keywords words;
+
+    /**
+     *  @brief  Operators indexed by symbol ID.
+     */
+    std::vector<operator_info> symbol_operators;
+
+    /**
+     *  @brief  Regular and declared operators, from the longest.
+     */
+    std::vector<known_operator> operators;
+
+    /**
+     *  @brief  Index of the current token.
+     */
+    std::size_t pos = 0;
+
+    /**
+     *  @brief  Number of characters of the current operator token that are
+     *          already parsed.
+     */
+    std::uint32_t offset = 0;
+
+    /**
+     *  @brief  Index of the first token of the current statement.
+     */
+    std::size_t statement_begin = 0;
+
+    /**
+     *  @brief  Depth of parentheses and brackets, in which newlines are
+     *          ignored.
+     */
+    std::size_t nesting = 0;
+
+    /**
+     *  @brief  Number of syntax errors.
+     */
+    std::size_t errors = 0;
+
+    /**
+     *  @brief  Set when parsing stopped after too many errors.
+     */
+    bool stopped = false;
+
+    /**
+     *  @brief  Creates the parser over the tokens of the source code.
+     *  @param  dtn  The source code's information.
+     */
+    parser(detronade &dtn);
+
+    /**
+     *  @brief  Check if every token is parsed.
+     *  @return  True if there are no more tokens.
+     */
+    [[nodiscard]] inline auto at_end() const
+    {
+        return pos >= tokens.size();
+    }
+
+    /**
+     *  @brief  Get the indentation of the line of the token.
+     *
+     *  @param  index  Index of the token.
+     *  @return  Number of spaces and tabs before the token, if it is the
+     *           first in its line.
+     */
+    [[nodiscard]] inline auto indentation(std::size_t index) const
+    -> std::size_t
+    {
+        std::size_t begin = dtn.offset(index);
+        std::size_t line  = begin;
+        while (line > 0 && (text[line - 1] == ' ' || text[line - 1] == '\t'))
+        {
+            line--;
+        }
+        return begin - line;
+    }
+
+    /**
+     *  @brief  Check if the token is the first in its line.
+     *
+     *  @param  index  Index of the token.
+     *  @return  True if only whitespaces are before the token in its line.
+     */
+    [[nodiscard]] inline auto starts_line(std::size_t index) const
+    {
+        std::size_t line = dtn.offset(index) - indentation(index);
+        return line == 0 || text[line - 1] == '\n';
+    }
+
+    /**
+     *  @brief  Check if the current statement ended.
+     *  @return  True at the end of the line, outside parentheses and
+     *           brackets.
+     */
+    [[nodiscard]] inline auto at_statement_end() const
+    {
+        return at_end() || (nesting == 0 && offset == 0
+            && pos != statement_begin && starts_line(pos));
+    }
+
+    /**
+     *  @brief  Check if the current token is the punctuation.
+     *
+     *  @param  c  The punctuation.
+     *  @return  True if the current token is the punctuation.
+     */
+    [[nodiscard]] inline auto is_punctuation(char c) const
+    {
+        return !at_end() && tokens[pos].type == token_type::punctuation
+            && std::get<char>(tokens[pos].value) == c;
+    }
+
+    /**
+     *  @brief  Check if the token is an identifier.
+     *
+     *  @param  index  Index of the token.
+     *  @return  True if the token is an identifier.
+     */
+    [[nodiscard]] inline auto is_identifier(std::size_t index) const
+    {
+        return index < tokens.size()
+            && tokens[index].type == token_type::identifier;
+    }
+
+    /**
+     *  @brief  Check if the current token is the keyword.
+     *
+     *  @param  keyword  Symbol ID of the keyword.
+     *  @return  True if the current token is the keyword.
+     */
+    [[nodiscard]] inline auto is_keyword(std::uint32_t keyword) const
+    {
+        return is_identifier(pos) && dtn.symbol(tokens[pos]) == keyword;
+    }
+
+    /**
+     *  @brief  Check if the symbol is a keyword that cannot be a name.
+     *
+     *  @param  symbol  The symbol ID.
+     *  @return  True if the symbol is reserved.
+     */
+    [[nodiscard]] inline auto is_reserved(std::uint32_t symbol) const
+    {
+        return symbol == words.if_ || symbol == words.else_
+            || symbol == words.while_ || symbol == words.for_
+            || symbol == words.return_ || symbol == words.void_
+            || symbol == words.const_ || symbol == words.struct_
+            || symbol == words.construct || symbol == words.destruct
+            || symbol == words.operator_;
+    }
+
+    /**
+     *  @brief  Find the operator at the current position.
+     *  @return  The longest operator, or nothing if the current token is not
+     *           an operator.
+     */
+    [[nodiscard]] auto match_operator() const -> std::optional<operator_match>;
+
+    /**
+     *  @brief  Check if the operator at the current position is the regular
+     *          operator.
+     *
+     *  @param  kind  The operator.
+     *  @return  True if the operator is at the current position.
+     */
+    [[nodiscard]] inline auto is_operator(operator_kind kind) const
+    {
+        auto match = match_operator();
+        return match && match->kind == kind && !match->compound;
+    }
+
+    /**
+     *  @brief  Move past the operator at the current position.
+     *  @param  match  The operator.
+     */
+    inline auto consume(const operator_match &match)
+    {
+        offset += match.length;
+        if (offset >= tokens[pos].length)
+        {
+            pos++;
+            offset = 0;
+        }
+    }
+
+    /**
+     *  @brief  Skip the type name and the array brackets after it.
+     *
+     *  @param  index  Index of the type name.
+     *  @return  Index of the token after the type, or nothing if the tokens
+     *           do not form a type.
+     */
+    [[nodiscard]] auto skip_type(std::size_t index) const
+    -> std::optional<std::size_t>;
+
+    /**
+     *  @brief  Check if a declaration begins at the token, that is, a type
+     *          followed by a name.
+     *
+     *  @param  index  Index of the token.
+     *  @return  True if a declaration begins at the token.
+     */
+    [[nodiscard]] auto is_declaration(std::size_t index) const -> bool;
+
+    /**
+     *  @brief  Record the operators declared in the source code, so that
+     *          they can be split from operator tokens.
+     */
+    auto declare_operators() -> void;
+
+    /**
+     *  @brief  Report a syntax error at the current position.
+     *
+     *  @param  id   What the error is about.
+     *  @param  arg  The argument of the message.
+     *  @return  @c no_node .
+     */
+    auto error(message_id id, message_argument arg = {}) -> node_index;
+
+    /**
+     *  @brief  Check whether to continue parsing after an error, and skip to
+     *          the next line if so.
+     *
+     *  @param  begin   Index of the first token of the erroneous statement.
+     *  @param  indent  Indentation of the block of the statement.
+     *  @return  True if parsing continues.
+     */
+    [[nodiscard]] auto recover(std::size_t begin, std::size_t indent)
+    -> bool;
+
+    /**
+     *  @brief  Move past the punctuation, or report it missing.
+     *
+     *  @param  c  The punctuation.
+     *  @return  True if the punctuation was there.
+     */
+    [[nodiscard]] inline auto expect_punctuation(char c)
+    {
+        if (!is_punctuation(c))
+        {
+            error(message_id::expected_character, c);
+            return false;
+        }
+        pos++;
+        return true;
+    }
+
+    /**
+     *  @brief  Move past the regular operator, or report it missing.
+     *
+     *  @param  kind  The operator.
+     *  @param  c     The operator's character, for the message.
+     *  @return  True if the operator was there.
+     */
+    [[nodiscard]] inline auto expect_operator(operator_kind kind, char c)
+    {
+        auto match = match_operator();
+        if (!match || match->kind != kind || match->compound)
+        {
+            error(message_id::expected_character, c);
+            return false;
+        }
+        consume(match.value());
+        return true;
+    }
+
+    /**
+     *  @brief  Move past the name, or report it missing.
+     *  @return  Symbol ID of the name.
+     */
+    [[nodiscard]] inline auto expect_name() -> std::optional<std::uint32_t>
+    {
+        if (!is_identifier(pos) || offset != 0
+         || is_reserved(dtn.symbol(tokens[pos])))
+        {
+            error(message_id::expected_name);
+            return std::nullopt;
+        }
+        return dtn.symbol(tokens[pos++]);
+    }
+
+    /**
+     *  @brief  Add a node with the list from the scratch stack.
+     *
+     *  @param  n     The node, whose b and c are set to the list.
+     *  @param  mark  Size of the scratch stack before the list.
+     *  @return  Index of the node.
+     */
+    inline auto add_list(node n, std::size_t mark) -> node_index
+    {
+        n.b = static_cast<std::uint32_t>(tree.extra.size());
+        n.c = static_cast<std::uint32_t>(scratch.size() - mark);
+        tree.extra.insert(tree.extra.end(), scratch.begin() + mark,
+            scratch.end());
+        scratch.resize(mark);
+        return tree.add(n);
+    }
+
+    /**
+     *  @brief  Add a function-like node with the parameters from the
+     *          scratch stack.
+     *
+     *  @param  n       The node, whose b and c are set.
+     *  @param  symbol  Symbol ID of the name or the operator.
+     *  @param  body    The body.
+     *  @param  mark    Size of the scratch stack before the parameters.
+     *  @return  Index of the node.
+     */
+    inline auto add_function(
+        node          n,
+        std::uint32_t symbol,
+        node_index    body,
+        std::size_t   mark
+    ) -> node_index
+    {
+        n.b = static_cast<std::uint32_t>(tree.extra.size());
+        n.c = static_cast<std::uint32_t>(scratch.size() - mark);
+        tree.extra.emplace_back(symbol);
+        tree.extra.emplace_back(body);
+        tree.extra.insert(tree.extra.end(), scratch.begin() + mark,
+            scratch.end());
+        scratch.resize(mark);
+        return tree.add(n);
+    }
+
+    /**
+     *  @brief  Parse the statements with the indentation.
+     *
+     *  @param  indent  Indentation of the block.
+     *  @return  The @c node_kind::block .
+     */
+    [[nodiscard]] auto parse_block(std::size_t indent) -> node_index;
+
+    /**
+     *  @brief  Parse an indented block, or a statement in the same line.
+     *
+     *  @param  indent  Indentation of the enclosing block.
+     *  @return  The body.
+     */
+    [[nodiscard]] auto parse_body(std::size_t indent) -> node_index;
+
+    /**
+     *  @brief  Parse a statement.
+     *
+     *  @param  indent  Indentation of the enclosing block.
+     *  @return  The statement.
+     */
+    [[nodiscard]] auto parse_statement(std::size_t indent) -> node_index;
+
+    /**
+     *  @brief  Parse a declaration of variables, a function or an operator
+     *          overload.
+     *
+     *  @param  indent  Indentation of the enclosing block.
+     *  @return  The declaration.
+     */
+    [[nodiscard]] auto parse_declaration(std::size_t indent) -> node_index;
+
+    /**
+     *  @brief  Parse a function, constructor or destructor from its name.
+     *
+     *  @param  indent       Indentation of the enclosing block.
+     *  @param  kind         The kind of function.
+     *  @param  return_type  The return type, or @c no_node .
+     *  @return  The function.
+     */
+    [[nodiscard]] auto parse_function(
+        std::size_t indent,
+        node_kind   kind,
+        node_index  return_type
+    ) -> node_index;
+
+    /**
+     *  @brief  Parse an operator overload from `operator`.
+     *
+     *  @param  indent       Indentation of the enclosing block.
+     *  @param  return_type  The return type.
+     *  @return  The operator overload.
+     */
+    [[nodiscard]] auto parse_operator(
+        std::size_t indent,
+        node_index  return_type
+    ) -> node_index;
+
+    /**
+     *  @brief  Parse a type.
+     *  @return  The type.
+     */
+    [[nodiscard]] auto parse_type() -> node_index;
+
+    /**
+     *  @brief  Parse a parameter.
+     *  @return  The parameter.
+     */
+    [[nodiscard]] auto parse_parameter() -> node_index;
+
+    /**
+     *  @brief  Parse an expression, as long as its operators bind at least
+     *          as tightly as the binding power.
+     *
+     *  @param  min_power  The minimum binding power.
+     *  @return  The expression.
+     */
+    [[nodiscard]] auto parse_expression(std::uint8_t min_power = 0)
+    -> node_index;
+
+    /**
+     *  @brief  Parse a literal, a name, a parenthesized expression or a
+     *          prefix operator.
+     *
+     *  @return  The expression.
+     */
+    [[nodiscard]] auto parse_prefix() -> node_index;
+
+    /**
+     *  @brief  Parse comma-separated expressions onto the scratch stack,
+     *          until the closing punctuation or operator.
+     *
+     *  @param  is_close  Checks for the end of the list.
+     *  @return  True if every expression was parsed.
+     */
+    [[nodiscard]] auto parse_list(auto is_close) -> bool;
+};
+
+/**
+ *  @brief  Creates the parser over the tokens of the source code.
+ *  @param  dtn  The source code's information.
+ */
+parser::parser(detronade &dtn)
+    : dtn(dtn), text(dtn.source().data()), tokens(dtn.tokens)
+{
+    auto &symbols = dtn.symbols;
+    words = keywords {
+        .if_       = symbols.intern("if"),
+        .else_     = symbols.intern("else"),
+        .while_    = symbols.intern("while"),
+        .for_      = symbols.intern("for"),
+        .return_   = symbols.intern("return"),
+        .void_     = symbols.intern("void"),
+        .const_    = symbols.intern("const"),
+        .struct_   = symbols.intern("struct"),
+        .construct = symbols.intern("construct"),
+        .destruct  = symbols.intern("destruct"),
+        .operator_ = symbols.intern("operator"),
+        .true_     = symbols.intern("true"),
+        .false_    = symbols.intern("false")
+    };
+
+    operators.reserve(operator_spellings.size());
+    for (auto &spelling : operator_spellings)
+    {
+        operators.emplace_back(known_operator {
+            .text   = spelling.text,
+            .symbol = symbols.intern(spelling.text)
+        });
+    }
+
+    symbol_operators.resize(symbols.names.size());
+    for (std::size_t i = 0; i < operator_spellings.size(); i++)
+    {
+        symbol_operators[operators[i].symbol] = operator_info {
+            .kind     = operator_spellings[i].kind,
+            .compound = operator_spellings[i].compound
+        };
+    }
+
+    declare_operators();
+    stdr::stable_sort(operators, stdr::greater {},
+        [&](const known_operator &op) { return op.text.size(); });
+
+    // Every token is usually a node, besides the root
+    tree.nodes.reserve(tokens.size() + 1);
+    tree.extra.reserve(tokens.size() / 2);
+}
+
+/**
+ *  @brief  Find the operator at the current position.
+ *  @return  The longest operator, or nothing if the current token is not an
+ *           operator.
+ */
+auto parser::match_operator() const -> std::optional<operator_match>
+{
+    if (at_end() || tokens[pos].type != token_type::operator_)
+    {
+        return std::nullopt;
+    }
+
+    auto &tok    = tokens[pos];
+    auto  symbol = dtn.symbol(tok);
+    if (offset == 0 && symbol_operators[symbol].kind != operator_kind::unknown)
+    {
+        auto &info = symbol_operators[symbol];
+        return operator_match {
+            .kind     = info.kind,
+            .compound = info.compound,
+            .symbol   = symbol,
+            .length   = tok.length
+        };
+    }
+
+    auto rest = std::string_view(text + dtn.offset(pos) + offset,
+        tok.length - offset);
+    for (auto &op : operators)
+    {
+        if (rest.starts_with(op.text))
+        {
+            auto &info = symbol_operators[op.symbol];
+            return operator_match {
+                .kind     = info.kind,
+                .compound = info.compound,
+                .symbol   = op.symbol,
+                .length   = static_cast<std::uint32_t>(op.text.size())
+            };
+        }
+    }
+
+    return operator_match {
+        .kind     = operator_kind::unknown,
+        .compound = false,
+        .symbol   = symbol,
+        .length   = static_cast<std::uint32_t>(rest.size())
+    };
+}
+
+/**
+ *  @brief  Skip the type name and the array brackets after it.
+ *
+ *  @param  index  Index of the type name.
+ *  @return  Index of the token after the type, or nothing if the tokens do
+ *           not form a type.
+ */
+auto parser::skip_type(std::size_t index) const -> std::optional<std::size_t>
+{
+    if (!is_identifier(index))
+    {
+        return std::nullopt;
+    }
+
+    // Brackets may be joined in operator tokens like `[]` or `][`
+    std::size_t depth = 0;
+    for (index++; index < tokens.size(); index++)
+    {
+        auto &tok = tokens[index];
+        if (tok.type != token_type::operator_)
+        {
+            if (depth == 0)
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (depth == 0 && text[dtn.offset(index)] != '[')
+        {
+            break;
+        }
+
+        for (auto c : dtn.text(index))
+        {
+            if (c == '[')
+            {
+                depth++;
+            }
+            else if (c == ']' && depth > 0)
+            {
+                depth--;
+            }
+            else if (depth == 0 || c == ']')
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    if (depth != 0)
+    {
+        return std::nullopt;
+    }
+    return index;
+}
+
+/**
+ *  @brief  Check if a declaration begins at the token, that is, a type
+ *          followed by a name.
+ *
+ *  @param  index  Index of the token.
+ *  @return  True if a declaration begins at the token.
+ */
+auto parser::is_declaration(std::size_t index) const -> bool
+{
+    if (!is_identifier(index))
+    {
+        return false;
+    }
+
+    auto symbol = dtn.symbol(tokens[index]);
+    if (symbol == words.const_)
+    {
+        return true;
+    }
+
+    if (is_reserved(symbol) && symbol != words.void_)
+    {
+        return false;
+    }
+
+    auto name = skip_type(index);
+    if (!name || !is_identifier(name.value()) || starts_line(name.value()))
+    {
+        return false;
+    }
+
+    auto name_symbol = dtn.symbol(tokens[name.value()]);
+    return !is_reserved(name_symbol) || name_symbol == words.operator_;
+}
+
+/**
+ *  @brief  Record the operators declared in the source code, so that they
+ *          can be split from operator tokens.
+ */
+auto parser::declare_operators() -> void
+{
+    auto is_open = [&](std::size_t index)
+    {
+        return index < tokens.size()
+            && tokens[index].type == token_type::punctuation
+            && std::get<char>(tokens[index].value) == '(';
+    };
+
+    auto is_operator_token = [&](std::size_t index)
+    {
+        return index < tokens.size()
+            && tokens[index].type == token_type::operator_;
+    };
+
+    auto declare = [&](std::size_t index, operator_form form)
+    {
+        auto  symbol = dtn.symbol(tokens[index]);
+        auto &info   = symbol_operators[symbol];
+        if (info.kind != operator_kind::unknown
+         && info.kind != operator_kind::custom)
+        {
+            return;
+        }
+
+        if (info.kind == operator_kind::unknown)
+        {
+            info.kind = operator_kind::custom;
+            operators.emplace_back(known_operator {
+                .text   = dtn.text(index),
+                .symbol = symbol
+            });
+        }
+        info.forms |= 1 << static_cast<std::uint8_t>(form);
+    };
+
+    for (std::size_t i = 0; i + 1 < tokens.size(); i++)
+    {
+        if (!is_identifier(i) || dtn.symbol(tokens[i]) != words.operator_
+         || !is_open(i + 1))
+        {
+            continue;
+        }
+
+        // Prefix operator `operator(^-^vec2 v)`
+        std::size_t index = i + 2;
+        if (is_operator_token(index))
+        {
+            declare(index, operator_form::prefix);
+            continue;
+        }
+
+        // Binary or postfix operator `operator(vec2 a |/ vec2 b)`
+        auto name = skip_type(index);
+        if (!name || !is_identifier(name.value())
+         || !is_operator_token(name.value() + 1))
+        {
+            continue;
+        }
+
+        index = name.value() + 1;
+        auto close = index + 1 < tokens.size()
+                  && tokens[index + 1].type == token_type::punctuation
+                  && std::get<char>(tokens[index + 1].value) == ')';
+        declare(index, close ? operator_form::postfix : operator_form::binary);
+    }
+}
+
+/**
+ *  @brief  Report a syntax error at the current position.
+ *
+ *  @param  id   What the error is about.
+ *  @param  arg  The argument of the message.
+ *  @return  @c no_node .
+ */
+auto parser::error(message_id id, message_argument arg) -> node_index
+{
+    errors++;
+
+    if (at_end())
+    {
+        dtn.messages.emplace_back(message {
+            .id          = message_id::unexpected_eof,
+            .severity    = message_severity::error,
+            .pos         = {
+                .begin   = dtn.source().size(),
+                .length  = 1,
+                .pointer = 0
+            }
+        });
+        return no_node;
+    }
+
+    auto &tok = tokens[pos];
+    dtn.messages.emplace_back(message {
+        .id          = id,
+        .severity    = message_severity::error,
+        .pos         = {
+            .begin   = dtn.offset(pos) + offset,
+            .length  = tok.length - offset,
+            .pointer = 0
+        },
+        .args        = { arg }
+    });
+    return no_node;
+}
+
+/**
+ *  @brief  Check whether to continue parsing after an error, and skip to the
+ *          next line if so.
+ *
+ *  @param  begin   Index of the first token of the erroneous statement.
+ *  @param  indent  Indentation of the block of the statement.
+ *  @return  True if parsing continues.
+ */
+auto parser::recover(std::size_t begin, std::size_t indent) -> bool
+{
+    if (!dtn.options.recover_errors || stopped)
+    {
+        return false;
+    }
+
+    if (errors >= dtn.options.max_errors)
+    {
+        dtn.messages.emplace_back(message {
+            .id       = message_id::too_many_errors,
+            .severity = message_severity::note,
+            .pos      = dtn.messages.back().pos,
+            .args     = { static_cast<std::uint32_t>(errors) }
+        });
+        stopped = true;
+        return false;
+    }
+
+    // Continue from the next line, skipping the lines indented under the
+    // erroneous statement
+    nesting = 0;
+    offset  = 0;
+    pos     = std::max(pos, begin + 1);
+    while (!at_end() && (!starts_line(pos) || indentation(pos) > indent))
+    {
+        pos++;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Parse the statements with the indentation.
+ *
+ *  @param  indent  Indentation of the block.
+ *  @return  The @c node_kind::block .
+ */
+auto parser::parse_block(std::size_t indent) -> node_index
+{
+    auto        first = static_cast<std::uint32_t>(pos);
+    std::size_t mark  = scratch.size();
+
+    while (!at_end())
+    {
+        std::size_t current = indentation(pos);
+        if (current < indent)
+        {
+            break;
+        }
+
+        std::size_t begin = pos;
+        statement_begin   = pos;
+
+        auto statement = current > indent
+                       ? error(message_id::unexpected_indentation)
+                       : parse_statement(indent);
+        if (statement != no_node && !at_statement_end())
+        {
+            statement = error(message_id::expected_end_of_line);
+        }
+
+        if (statement == no_node)
+        {
+            if (!recover(begin, indent))
+            {
+                scratch.resize(mark);
+                return no_node;
+            }
+            continue;
+        }
+        scratch.emplace_back(statement);
+    }
+
+    return add_list(node {
+        .kind  = node_kind::block,
+        .token = first
+    }, mark);
+}
+
+/**
+ *  @brief  Parse an indented block, or a statement in the same line.
+ *
+ *  @param  indent  Indentation of the enclosing block.
+ *  @return  The body.
+ */
+auto parser::parse_body(std::size_t indent) -> node_index
+{
+    if (at_end())
+    {
+        return error(message_id::expected_body);
+    }
+
+    if (!at_statement_end())
+    {
+        return parse_statement(indent);
+    }
+
+    std::size_t current = indentation(pos);
+    if (current <= indent)
+    {
+        return error(message_id::expected_body);
+    }
+    return parse_block(current);
+}
+
+/**
+ *  @brief  Parse a statement.
+ *
+ *  @param  indent  Indentation of the enclosing block.
+ *  @return  The statement.
+ */
+auto parser::parse_statement(std::size_t indent) -> node_index
+{
+    auto first = static_cast<std::uint32_t>(pos);
+
+    if (is_declaration(pos))
+    {
+        return parse_declaration(indent);
+    }
+
+    if (is_keyword(words.if_) || is_keyword(words.while_))
+    {
+        bool is_if = is_keyword(words.if_);
+        pos++;
+
+        nesting++;
+        if (!expect_punctuation('('))
+        {
+            return no_node;
+        }
+
+        auto condition = parse_expression();
+        if (condition == no_node || !expect_punctuation(')'))
+        {
+            return no_node;
+        }
+        nesting--;
+
+        auto body = parse_body(indent);
+        if (body == no_node)
+        {
+            return no_node;
+        }
+
+        if (!is_if)
+        {
+            return tree.add(node {
+                .kind  = node_kind::while_,
+                .token = first,
+                .a     = condition,
+                .b     = body
+            });
+        }
+
+        // `else` continues in the same line, or in the line after the body
+        // with the indentation of `if`
+        auto else_body = no_node;
+        if (is_keyword(words.else_)
+         && (!starts_line(pos) || indentation(pos) == indent))
+        {
+            pos++;
+            else_body = parse_body(indent);
+            if (else_body == no_node)
+            {
+                return no_node;
+            }
+        }
+
+        return tree.add(node {
+            .kind  = node_kind::if_,
+            .token = first,
+            .a     = condition,
+            .b     = body,
+            .c     = else_body
+        });
+    }
+
+    if (is_keyword(words.for_))
+    {
+        pos++;
+
+        nesting++;
+        if (!expect_punctuation('('))
+        {
+            return no_node;
+        }
+
+        std::array<node_index, 3> clauses = { no_node, no_node, no_node };
+        if (!is_punctuation(';'))
+        {
+            if (is_declaration(pos))
+            {
+                clauses[0] = parse_declaration(indent);
+            }
+            else if (auto value = parse_expression(); value != no_node)
+            {
+                clauses[0] = tree.add(node {
+                    .kind  = node_kind::expression,
+                    .token = tree[value].token,
+                    .a     = value
+                });
+            }
+
+            if (clauses[0] == no_node)
+            {
+                return no_node;
+            }
+        }
+
+        if (!expect_punctuation(';'))
+        {
+            return no_node;
+        }
+
+        if (!is_punctuation(';'))
+        {
+            clauses[1] = parse_expression();
+            if (clauses[1] == no_node)
+            {
+                return no_node;
+            }
+        }
+
+        if (!expect_punctuation(';'))
+        {
+            return no_node;
+        }
+
+        if (!is_punctuation(')'))
+        {
+            clauses[2] = parse_expression();
+            if (clauses[2] == no_node)
+            {
+                return no_node;
+            }
+        }
+
+        if (!expect_punctuation(')'))
+        {
+            return no_node;
+        }
+        nesting--;
+
+        auto body = parse_body(indent);
+        if (body == no_node)
+        {
+            return no_node;
+        }
+
+        auto extra = static_cast<std::uint32_t>(tree.extra.size());
+        tree.extra.insert(tree.extra.end(), clauses.begin(), clauses.end());
+        return tree.add(node {
+            .kind  = node_kind::for_,
+            .token = first,
+            .a     = extra,
+            .b     = body
+        });
+    }
+
+    if (is_keyword(words.return_))
+    {
+        pos++;
+
+        auto value = no_node;
+        if (!at_statement_end() && !is_keyword(words.else_))
+        {
+            value = parse_expression();
+            if (value == no_node)
+            {
+                return no_node;
+            }
+        }
+
+        return tree.add(node {
+            .kind  = node_kind::return_,
+            .token = first,
+            .a     = value
+        });
+    }
+
+    if (is_keyword(words.void_))
+    {
+        pos++;
+        return tree.add(node {
+            .kind  = node_kind::void_,
+            .token = first
+        });
+    }
+
+    if (is_keyword(words.struct_))
+    {
+        pos++;
+
+        auto name_token = static_cast<std::uint32_t>(pos);
+        auto name       = expect_name();
+        if (!name)
+        {
+            return no_node;
+        }
+
+        auto body = parse_body(indent);
+        if (body == no_node)
+        {
+            return no_node;
+        }
+
+        return tree.add(node {
+            .kind  = node_kind::struct_,
+            .token = name_token,
+            .a     = name.value(),
+            .b     = body
+        });
+    }
+
+    if ((is_keyword(words.construct) || is_keyword(words.destruct))
+     && pos + 1 < tokens.size()
+     && tokens[pos + 1].type == token_type::punctuation
+     && std::get<char>(tokens[pos + 1].value) == '(')
+    {
+        auto kind = is_keyword(words.construct)
+                  ? node_kind::constructor
+                  : node_kind::destructor;
+        return parse_function(indent, kind, no_node);
+    }
+
+    auto value = parse_expression();
+    if (value == no_node)
+    {
+        return no_node;
+    }
+
+    return tree.add(node {
+        .kind  = node_kind::expression,
+        .token = first,
+        .a     = value
+    });
+}
+
+/**
+ *  @brief  Parse a declaration of variables, a function or an operator
+ *          overload.
+ *
+ *  @param  indent  Indentation of the enclosing block.
+ *  @return  The declaration.
+ */
+auto parser::parse_declaration(std::size_t indent) -> node_index
+{
+    auto          first = static_cast<std::uint32_t>(pos);
+    std::uint16_t flags = 0;
+    if (is_keyword(words.const_))
+    {
+        pos++;
+        flags = node::constant;
+    }
+
+    auto type = parse_type();
+    if (type == no_node)
+    {
+        return no_node;
+    }
+
+    if (flags == 0 && is_keyword(words.operator_))
+    {
+        return parse_operator(indent, type);
+    }
+
+    if (flags == 0 && is_identifier(pos) && pos + 1 < tokens.size()
+     && tokens[pos + 1].type == token_type::punctuation
+     && std::get<char>(tokens[pos + 1].value) == '(')
+    {
+        return parse_function(indent, node_kind::function, type);
+    }
+
+    std::size_t mark = scratch.size();
+    while (true)
+    {
+        auto variable_token = static_cast<std::uint32_t>(pos);
+        auto name           = expect_name();
+        if (!name)
+        {
+            scratch.resize(mark);
+            return no_node;
+        }
+
+        auto initializer = no_node;
+        if (is_operator(operator_kind::assign))
+        {
+            consume(match_operator().value());
+            initializer = parse_expression();
+            if (initializer == no_node)
+            {
+                scratch.resize(mark);
+                return no_node;
+            }
+        }
+
+        scratch.emplace_back(tree.add(node {
+            .kind  = node_kind::variable,
+            .token = variable_token,
+            .a     = name.value(),
+            .b     = initializer
+        }));
+
+        if (!is_punctuation(','))
+        {
+            break;
+        }
+        pos++;
+    }
+
+    return add_list(node {
+        .kind  = node_kind::declaration,
+        .flags = flags,
+        .token = first,
+        .a     = type
+    }, mark);
+}
+
+/**
+ *  @brief  Parse a function, constructor or destructor from its name.
+ *
+ *  @param  indent       Indentation of the enclosing block.
+ *  @param  kind         The kind of function.
+ *  @param  return_type  The return type, or @c no_node .
+ *  @return  The function.
+ */
+auto parser::parse_function(
+    std::size_t indent,
+    node_kind   kind,
+    node_index  return_type
+) -> node_index
+{
+    auto name_token = static_cast<std::uint32_t>(pos);
+    auto symbol     = dtn.symbol(tokens[pos]);
+    pos++;
+
+    nesting++;
+    if (!expect_punctuation('('))
+    {
+        return no_node;
+    }
+
+    std::size_t mark = scratch.size();
+    while (!is_punctuation(')'))
+    {
+        auto param = parse_parameter();
+        if (param == no_node)
+        {
+            scratch.resize(mark);
+            return no_node;
+        }
+        scratch.emplace_back(param);
+
+        if (!is_punctuation(','))
+        {
+            break;
+        }
+        pos++;
+    }
+
+    if (!expect_punctuation(')'))
+    {
+        scratch.resize(mark);
+        return no_node;
+    }
+    nesting--;
+
+    auto body = parse_body(indent);
+    if (body == no_node)
+    {
+        scratch.resize(mark);
+        return no_node;
+    }
+
+    return add_function(node {
+        .kind  = kind,
+        .token = name_token,
+        .a     = return_type
+    }, symbol, body, mark);
+}
+
+/**
+ *  @brief  Parse an operator overload from `operator`.
+ *
+ *  @param  indent       Indentation of the enclosing block.
+ *  @param  return_type  The return type.
+ *  @return  The operator overload.
+ */
+auto parser::parse_operator(
+    std::size_t indent,
+    node_index  return_type
+) -> node_index
+{
+    pos++;
+
+    nesting++;
+    if (!expect_punctuation('('))
+    {
+        return no_node;
+    }
+
+    std::size_t mark           = scratch.size();
+    auto        operator_token = static_cast<std::uint32_t>(pos);
+    auto        form           = operator_form::prefix;
+
+    auto push_parameter = [&]()
+    {
+        auto param = parse_parameter();
+        if (param == no_node)
+        {
+            return false;
+        }
+        scratch.emplace_back(param);
+        return true;
+    };
+
+    // The whole token is the operator
+    auto take_operator = [&]()
+    {
+        if (at_end() || tokens[pos].type != token_type::operator_
+         || offset != 0)
+        {
+            error(message_id::unexpected_token);
+            return false;
+        }
+
+        operator_token = static_cast<std::uint32_t>(pos++);
+        return true;
+    };
+
+    if (!at_end() && tokens[pos].type == token_type::operator_)
+    {
+        if (!take_operator() || !push_parameter())
+        {
+            scratch.resize(mark);
+            return no_node;
+        }
+    }
+    else
+    {
+        if (!push_parameter() || !take_operator())
+        {
+            scratch.resize(mark);
+            return no_node;
+        }
+
+        auto kind = symbol_operators[dtn.symbol(tokens[operator_token])].kind;
+        if (kind == operator_kind::subscript_begin)
+        {
+            form = operator_form::subscript;
+            if (!push_parameter()
+             || !expect_operator(operator_kind::subscript_end, ']'))
+            {
+                scratch.resize(mark);
+                return no_node;
+            }
+        }
+        else if (is_punctuation(')'))
+        {
+            form = operator_form::postfix;
+        }
+        else
+        {
+            form = operator_form::binary;
+            if (!push_parameter())
+            {
+                scratch.resize(mark);
+                return no_node;
+            }
+        }
+    }
+
+    if (!expect_punctuation(')'))
+    {
+        scratch.resize(mark);
+        return no_node;
+    }
+    nesting--;
+
+    auto body = parse_body(indent);
+    if (body == no_node)
+    {
+        scratch.resize(mark);
+        return no_node;
+    }
+
+    auto  symbol = dtn.symbol(tokens[operator_token]);
+    auto &info   = symbol_operators[symbol];
+    return add_function(node {
+        .kind  = node_kind::operator_,
+        .op    = info.compound ? operator_kind::unknown : info.kind,
+        .flags = static_cast<std::uint16_t>(form),
+        .token = operator_token,
+        .a     = return_type
+    }, symbol, body, mark);
+}
+
+/**
+ *  @brief  Parse a type.
+ *  @return  The type.
+ */
+auto parser::parse_type() -> node_index
+{
+    auto first = static_cast<std::uint32_t>(pos);
+    if (!is_identifier(pos) || (is_reserved(dtn.symbol(tokens[pos]))
+     && !is_keyword(words.void_)))
+    {
+        return error(message_id::expected_name);
+    }
+
+    auto type = tree.add(node {
+        .kind  = node_kind::type_name,
+        .token = first,
+        .a     = dtn.symbol(tokens[pos++])
+    });
+
+    while (is_operator(operator_kind::subscript_begin))
+    {
+        auto bracket = static_cast<std::uint32_t>(pos);
+        consume(match_operator().value());
+        nesting++;
+
+        auto size = no_node;
+        if (!is_operator(operator_kind::subscript_end))
+        {
+            size = parse_expression();
+            if (size == no_node)
+            {
+                return no_node;
+            }
+        }
+
+        if (!expect_operator(operator_kind::subscript_end, ']'))
+        {
+            return no_node;
+        }
+        nesting--;
+
+        type = tree.add(node {
+            .kind  = node_kind::type_array,
+            .token = bracket,
+            .a     = type,
+            .b     = size
+        });
+    }
+
+    return type;
+}
+
+/**
+ *  @brief  Parse a parameter.
+ *  @return  The parameter.
+ */
+auto parser::parse_parameter() -> node_index
+{
+    auto type = parse_type();
+    if (type == no_node)
+    {
+        return no_node;
+    }
+
+    auto name_token = static_cast<std::uint32_t>(pos);
+    auto name       = expect_name();
+    if (!name)
+    {
+        return no_node;
+    }
+
+    return tree.add(node {
+        .kind  = node_kind::parameter,
+        .token = name_token,
+        .a     = type,
+        .b     = name.value()
+    });
+}
+
+/**
+ *  @brief  Parse comma-separated expressions onto the scratch stack, until
+ *          the closing punctuation or operator.
+ *
+ *  @param  is_close  Checks for the end of the list.
+ *  @return  True if every expression was parsed.
+ */
+auto parser::parse_list(auto is_close) -> bool
+{
+    while (!is_close())
+    {
+        auto element = parse_expression();
+        if (element == no_node)
+        {
+            return false;
+        }
+        scratch.emplace_back(element);
+
+        if (!is_punctuation(','))
+        {
+            break;
+        }
+        pos++;
+    }
+    return true;
+}
+
+/**
+ *  @brief  Parse an expression, as long as its operators bind at least as
+ *          tightly as the binding power.
+ *
+ *  @param  min_power  The minimum binding power.
+ *  @return  The expression.
+ */
+auto parser::parse_expression(std::uint8_t min_power) -> node_index
+{
+    auto lhs = parse_prefix();
+    while (lhs != no_node && !at_statement_end())
+    {
+        auto first = static_cast<std::uint32_t>(pos);
+
+        if (is_punctuation('('))
+        {
+            pos++;
+            nesting++;
+
+            std::size_t mark = scratch.size();
+            if (!parse_list([&]() { return is_punctuation(')'); })
+             || !expect_punctuation(')'))
+            {
+                scratch.resize(mark);
+                return no_node;
+            }
+            nesting--;
+
+            lhs = add_list(node {
+                .kind  = node_kind::call,
+                .token = first,
+                .a     = lhs
+            }, mark);
+            continue;
+        }
+
+        if (is_punctuation('.'))
+        {
+            pos++;
+
+            auto name = expect_name();
+            if (!name)
+            {
+                return no_node;
+            }
+
+            lhs = tree.add(node {
+                .kind  = node_kind::member,
+                .token = first,
+                .a     = lhs,
+                .b     = name.value()
+            });
+            continue;
+        }
+
+        auto match = match_operator();
+        if (!match)
+        {
+            break;
+        }
+
+        if (match->kind == operator_kind::unknown)
+        {
+            return error(message_id::unknown_operator);
+        }
+
+        auto &info    = symbol_operators[match->symbol];
+        bool  custom  = match->kind == operator_kind::custom;
+        auto  postfix = 1 << static_cast<std::uint8_t>(operator_form::postfix);
+        auto  binary  = 1 << static_cast<std::uint8_t>(operator_form::binary);
+
+        if (match->kind == operator_kind::subscript_begin && !match->compound)
+        {
+            consume(match.value());
+            nesting++;
+
+            auto index = parse_expression();
+            if (index == no_node
+             || !expect_operator(operator_kind::subscript_end, ']'))
+            {
+                return no_node;
+            }
+            nesting--;
+
+            lhs = tree.add(node {
+                .kind  = node_kind::subscript,
+                .token = first,
+                .a     = lhs,
+                .b     = index
+            });
+            continue;
+        }
+
+        if (!match->compound && (match->kind == operator_kind::increment
+         || match->kind == operator_kind::decrement
+         || (custom && (info.forms & postfix) && !(info.forms & binary))))
+        {
+            consume(match.value());
+            lhs = tree.add(node {
+                .kind  = node_kind::postfix,
+                .op    = match->kind,
+                .token = first,
+                .a     = lhs,
+                .b     = custom ? match->symbol : no_node
+            });
+            continue;
+        }
+
+        // Binary operators are left associative, besides `**` and
+        // assignments
+        auto power = match->compound ? assign_power : binary_power(match->kind);
+        if (power == 0 || power < min_power)
+        {
+            break;
+        }
+
+        bool right = match->compound || match->kind == operator_kind::assign
+                  || match->kind == operator_kind::power;
+        consume(match.value());
+
+        auto rhs = parse_expression(right ? power : power + 1);
+        if (rhs == no_node)
+        {
+            return no_node;
+        }
+
+        if (match->compound || match->kind == operator_kind::assign)
+        {
+            lhs = tree.add(node {
+                .kind  = node_kind::assign,
+                .op    = match->kind,
+                .token = first,
+                .a     = lhs,
+                .b     = rhs
+            });
+            continue;
+        }
+
+        lhs = tree.add(node {
+            .kind  = node_kind::binary,
+            .op    = match->kind,
+            .token = first,
+            .a     = lhs,
+            .b     = rhs,
+            .c     = custom ? match->symbol : no_node
+        });
+    }
+
+    return lhs;
+}
+
+/**
+ *  @brief  Parse a literal, a name, a parenthesized expression or a prefix
+ *          operator.
+ *
+ *  @return  The expression.
+ */
+auto parser::parse_prefix() -> node_index
+{
+    if (at_statement_end())
+    {
+        return error(message_id::expected_expression);
+    }
+
+    auto  first = static_cast<std::uint32_t>(pos);
+    auto &tok   = tokens[pos];
+    switch (tok.type)
+    {
+        case token_type::numerical_literal:
+            pos++;
+            return tree.add(node {
+                .kind  = node_kind::number,
+                .token = first,
+                .a     = std::get<std::uint32_t>(tok.value)
+            });
+
+        case token_type::char_literal:
+            pos++;
+            return tree.add(node {
+                .kind  = node_kind::character,
+                .token = first,
+                .a     = static_cast<unsigned char>(std::get<char>(tok.value))
+            });
+
+        case token_type::string_literal:
+            pos++;
+            return tree.add(node {
+                .kind  = node_kind::string,
+                .token = first
+            });
+
+        case token_type::identifier:
+        {
+            auto symbol = dtn.symbol(tok);
+            if (symbol == words.true_ || symbol == words.false_)
+            {
+                pos++;
+                return tree.add(node {
+                    .kind  = node_kind::boolean,
+                    .token = first,
+                    .a     = symbol == words.true_ ? 1u : 0u
+                });
+            }
+
+            if (is_reserved(symbol))
+            {
+                return error(message_id::unexpected_token);
+            }
+
+            pos++;
+            return tree.add(node {
+                .kind  = node_kind::name,
+                .token = first,
+                .a     = symbol
+            });
+        }
+
+        case token_type::punctuation:
+        {
+            if (!is_punctuation('('))
+            {
+                return error(message_id::expected_expression);
+            }
+
+            pos++;
+            nesting++;
+            auto value = parse_expression();
+            if (value == no_node || !expect_punctuation(')'))
+            {
+                return no_node;
+            }
+            nesting--;
+            return value;
+        }
+
+        case token_type::operator_:
+        {
+            auto match = match_operator().value();
+            if (match.compound)
+            {
+                return error(message_id::expected_expression);
+            }
+
+            switch (match.kind)
+            {
+            using enum operator_kind;
+                case unknown: return error(message_id::unknown_operator);
+
+                case subscript_begin:
+                {
+                    consume(match);
+                    nesting++;
+
+                    std::size_t mark     = scratch.size();
+                    auto        is_close = [&]()
+                    {
+                        return is_operator(subscript_end);
+                    };
+                    if (!parse_list(is_close)
+                     || !expect_operator(subscript_end, ']'))
+                    {
+                        scratch.resize(mark);
+                        return no_node;
+                    }
+                    nesting--;
+
+                    return add_list(node {
+                        .kind  = node_kind::array,
+                        .token = first
+                    }, mark);
+                }
+
+                case add:
+                case subtract:
+                case logical_not:
+                case bitwise_not:
+                case increment:
+                case decrement:
+                case custom:
+                {
+                    auto prefix = 1
+                        << static_cast<std::uint8_t>(operator_form::prefix);
+                    if (match.kind == custom
+                     && !(symbol_operators[match.symbol].forms & prefix))
+                    {
+                        return error(message_id::expected_expression);
+                    }
+
+                    // Custom operators are evaluated after regular operators
+                    consume(match);
+                    auto operand = parse_expression(match.kind == custom
+                                 ? custom_power + 1
+                                 : unary_power);
+                    if (operand == no_node)
+                    {
+                        return no_node;
+                    }
+
+                    return tree.add(node {
+                        .kind  = node_kind::unary,
+                        .op    = match.kind,
+                        .token = first,
+                        .a     = operand,
+                        .b     = match.kind == custom ? match.symbol : no_node
+                    });
+                }
+
+                default: return error(message_id::expected_expression);
+            }
+        }
+    }
+
+    return error(message_id::unexpected_token);
+}
+
+/**
+ *  @brief  Parse the tokens into the syntax tree.
+ *  @return  The syntax tree of the tokens.
+ */
+auto detronade::parse() -> std::optional<syntax_tree>
+{
+    parser p(*this);
+
+    // The global scope has the indentation of the first line
+    std::size_t indent = tokens.empty() ? 0 : p.indentation(0);
+    auto        root   = p.parse_block(indent);
+    if (root != no_node && !p.at_end())
+    {
+        root = p.error(message_id::unexpected_indentation);
+    }
+
+    if (root == no_node || p.errors > 0)
+    {
+        return std::nullopt;
+    }
+
+    p.tree.root = root;
+    return std::move(p.tree);
+}
@@ -0,0 +1,2157 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Virtual machine of Detronade, implementations of
+ *           @c detronade::run from @c plons_detronade.hpp .
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "plons_detronade.hpp"
+
+using namespace plons::dtn;
+using namespace std::string_literals;
+
+namespace stdr = std::ranges;
+
+// Threaded dispatch jumps to the next handler through a table of label
+// addresses, a GNU extension.  Other compilers dispatch with a switch.
+// Computed goto does not destroy the objects in scope, so handlers end the
+// scope of every object with a destructor before the next dispatch
+#if defined(__GNUC__) || defined(__clang__)
+#define PLONS_LIBRARY_DTN_THREADED 1
+#else
+#define PLONS_LIBRARY_DTN_THREADED 0
+#endif
+
+#if PLONS_LIBRARY_DTN_THREADED
+#define PLONS_LIBRARY_DTN_OP(name) op_##name:
+#define PLONS_LIBRARY_DTN_NEXT()                                             \
+    do                                                                       \
+    {                                                                        \
+        in = *ip++;                                                          \
+        goto *labels[static_cast<std::size_t>(in.op)];                       \
+    }                                                                        \
+    while (false)
+#else
+#define PLONS_LIBRARY_DTN_OP(name) case opcode::name:
+#define PLONS_LIBRARY_DTN_NEXT() continue
+#endif
+
+// Binary operator with a fast path for two reals
+#define PLONS_LIBRARY_DTN_ARITHMETIC(name, expr)                             \
+    PLONS_LIBRARY_DTN_OP(name)                                               \
+    {                                                                        \
+        if (r[in.b].holds<double>() && r[in.c].holds<double>())              \
+        {                                                                    \
+            auto x = r[in.b].get<double>();                                  \
+            auto y = r[in.c].get<double>();                                  \
+            r[in.a] = (expr);                                                \
+            PLONS_LIBRARY_DTN_NEXT();                                        \
+        }                                                                    \
+        goto slow_binary;                                                    \
+    }
+
+// Binary operator on operands that are always of the type
+#define PLONS_LIBRARY_DTN_TYPED(name, type, expr)                            \
+    PLONS_LIBRARY_DTN_OP(name)                                               \
+    {                                                                        \
+        auto x  = type##_of(r[in.b]);                                        \
+        auto y  = type##_of(r[in.c]);                                        \
+        r[in.a] = (expr);                                                    \
+        PLONS_LIBRARY_DTN_NEXT();                                            \
+    }
+
+/**
+ *  @brief  Check if the value is a `real`, `int`, `bool` or `char`.
+ *
+ *  @param  v  The value.
+ *  @return  True if the value is a number.
+ */
+[[nodiscard]] static inline auto is_number(const value &v)
+{
+    return !v.is_object() && !v.holds<std::monostate>();
+}
+
+/**
+ *  @brief  Convert a number to `real`.
+ *
+ *  @param  v  The number.
+ *  @return  The real.
+ */
+[[nodiscard]] static inline auto to_real(const value &v) -> double
+{
+    if (auto real = v.get_if<double>())
+    {
+        return *real;
+    }
+    if (auto integer = v.get_if<std::int32_t>())
+    {
+        return *integer;
+    }
+    if (auto boolean = v.get_if<bool>())
+    {
+        return *boolean;
+    }
+    if (auto character = v.get_if<char>())
+    {
+        return static_cast<unsigned char>(*character);
+    }
+    return 0.0;
+}
+
+/**
+ *  @brief  Convert a real to `int`, flooring and saturating it.  NaN is
+ *          converted to 0.
+ *
+ *  @param  x  The real.
+ *  @return  The int.
+ */
+[[nodiscard]] static inline auto real_to_int(double x) -> std::int32_t
+{
+    using limits = std::numeric_limits<std::int32_t>;
+    if (std::isnan(x))
+    {
+        return 0;
+    }
+
+    x = std::floor(x);
+    if (x <= limits::min())
+    {
+        return limits::min();
+    }
+    if (x >= limits::max())
+    {
+        return limits::max();
+    }
+    return static_cast<std::int32_t>(x);
+}
+
+/**
+ *  @brief  Convert a number to `int`.
+ *
+ *  @param  v  The number.
+ *  @return  The int.
+ */
+[[nodiscard]] static inline auto to_int(const value &v) -> std::int32_t
+{
+    if (auto real = v.get_if<double>())
+    {
+        return real_to_int(*real);
+    }
+    if (auto integer = v.get_if<std::int32_t>())
+    {
+        return *integer;
+    }
+    if (auto boolean = v.get_if<bool>())
+    {
+        return *boolean;
+    }
+    if (auto character = v.get_if<char>())
+    {
+        return static_cast<unsigned char>(*character);
+    }
+    return 0;
+}
+
+/**
+ *  @brief  Convert a number to `bool`.  A real is floored first.
+ *
+ *  @param  v  The number.
+ *  @return  The bool.
+ */
+[[nodiscard]] static inline auto to_bool(const value &v) -> bool
+{
+    if (auto real = v.get_if<double>())
+    {
+        return std::floor(*real) != 0.0;
+    }
+    return to_int(v) != 0;
+}
+
+/**
+ *  @brief  Wrap an integer to `int`.
+ *
+ *  @param  x  The integer.
+ *  @return  The lower 32 bits of the integer.
+ */
+[[nodiscard]] static inline auto wrap(std::int64_t x) -> std::int32_t
+{
+    return static_cast<std::int32_t>(static_cast<std::uint32_t>(x));
+}
+
+/**
+ *  @brief  Divide integers, flooring the quotient.
+ *
+ *  @param  i  The dividend.
+ *  @param  j  The divisor, not 0.
+ *  @return  The quotient, wrapped to `int`.
+ */
+[[nodiscard]] static inline auto floor_quotient(std::int64_t i, std::int64_t j)
+-> std::int32_t
+{
+    auto q = i / j;
+    if (i % j != 0 && (i < 0) != (j < 0))
+    {
+        q--;
+    }
+    return wrap(q);
+}
+
+/**
+ *  @brief  Get the remainder of a flooring division of integers, which
+ *          has the sign of the divisor.
+ *
+ *  @param  i  The dividend.
+ *  @param  j  The divisor, not 0.
+ *  @return  The remainder, wrapped to `int`.
+ */
+[[nodiscard]] static inline auto floor_remainder(
+    std::int64_t i,
+    std::int64_t j
+) -> std::int32_t
+{
+    auto m = i % j;
+    if (m != 0 && (m < 0) != (j < 0))
+    {
+        m += j;
+    }
+    return wrap(m);
+}
+
+/**
+ *  @brief  Get the real of a value that is always a `real`, without
+ *          checking it.
+ *
+ *  @param  v  The value.
+ *  @return  The real.
+ */
+[[nodiscard]] static inline auto real_of(const value &v) -> double
+{
+    if (!v.holds<double>())
+    {
+        std::unreachable();
+    }
+    return v.get<double>();
+}
+
+/**
+ *  @brief  Get the int of a value that is always an `int`, without
+ *          checking it.
+ *
+ *  @param  v  The value.
+ *  @return  The int.
+ */
+[[nodiscard]] static inline auto int_of(const value &v) -> std::int32_t
+{
+    if (!v.holds<std::int32_t>())
+    {
+        std::unreachable();
+    }
+    return v.get<std::int32_t>();
+}
+
+/**
+ *  @brief  Copy a value, including the arrays and structures in it.  A
+ *          copy of an array of numbers shares its elements until one of
+ *          the arrays is changed.
+ *
+ *  @param  v  The value.
+ *  @return  The copy.
+ */
+[[nodiscard]] static auto deep_copy(const value &v) -> value
+{
+    if (auto array = v.get_if<array_object>())
+    {
+        if (array->flat)
+        {
+            return value::make_array(*array);
+        }
+
+        std::vector<value> elements;
+        elements.reserve(array->elements().size());
+        for (auto &element : array->elements())
+        {
+            elements.emplace_back(deep_copy(element));
+        }
+        return value::make_array(array->type, false, std::move(elements));
+    }
+
+    if (auto object = v.get_if<struct_object>())
+    {
+        auto copy   = value::make_struct(object->type, object->size);
+        auto fields = copy.get_if<struct_object>()->fields();
+        for (std::size_t i = 0; i < fields.size(); i++)
+        {
+            fields[i] = deep_copy(object->fields()[i]);
+        }
+        return copy;
+    }
+    return v;
+}
+
+/**
+ *  @brief  Delete the object of the bits, which has no references left.
+ *          It is not inline, so that the values copied in the hot paths do
+ *          not carry the destructors of the objects.
+ *
+ *  @param  bits  The bits of a value that refers to an object.
+ */
+auto value::delete_object(std::uint64_t bits) noexcept -> void
+{
+    auto address = bits & payload;
+    if (bits >> tag_shift == tag<array_object>)
+    {
+        auto array = reinterpret_cast<array_object *>(address);
+        if (--array->buffer->shares == 0)
+        {
+            delete array->buffer;
+        }
+        delete array;
+    }
+    else
+    {
+        auto object = reinterpret_cast<struct_object *>(address);
+        std::destroy_n(object->fields().data(), object->size);
+        std::destroy_at(object);
+        ::operator delete(object);
+    }
+}
+
+/**
+ *  @brief  Get the operator of a regular operator's opcode.
+ *
+ *  @param  op  The opcode.
+ *  @return  The operator.
+ */
+[[nodiscard]] static inline constexpr auto opcode_operator(opcode op)
+-> operator_kind
+{
+    switch (op)
+    {
+    using enum opcode;
+        case add: return operator_kind::add;
+        case subtract:
+        case negate: return operator_kind::subtract;
+        case multiply: return operator_kind::multiply;
+        case divide: return operator_kind::divide;
+        case floor_divide: return operator_kind::floor_divide;
+        case modulo: return operator_kind::modulo;
+        case power: return operator_kind::power;
+        case shift_left: return operator_kind::shift_left;
+        case shift_right: return operator_kind::shift_right;
+        case bitwise_and: return operator_kind::bitwise_and;
+        case bitwise_xor: return operator_kind::bitwise_xor;
+        case bitwise_or: return operator_kind::bitwise_or;
+        case less: return operator_kind::less;
+        case less_equal: return operator_kind::less_equal;
+        case greater: return operator_kind::greater;
+        case greater_equal: return operator_kind::greater_equal;
+        case equal: return operator_kind::equal;
+        case not_equal: return operator_kind::not_equal;
+        case logical_not: return operator_kind::logical_not;
+        case bitwise_not: return operator_kind::bitwise_not;
+        default: return operator_kind::unknown;
+    }
+}
+
+/**
+ *  @brief  Apply a regular operator to numbers, the way the program
+ *          does when it runs.  Integers stay integers except for `/`
+ *          and `**`, and wrap around.
+ *
+ *  @param  op   The opcode, from @c opcode::add to
+ *               @c opcode::bitwise_not .
+ *  @param  lhs  The operand, or the left operand.
+ *  @param  rhs  The right operand, unused by prefix operators.
+ *  @return  The result, or nothing if an operand is not a number or on
+ *           integer division by zero.
+ */
+auto plons::dtn::apply_operator(
+    opcode       op,
+    const value &lhs,
+    const value &rhs
+) -> std::optional<value>
+{
+    if (!is_number(lhs))
+    {
+        return std::nullopt;
+    }
+
+    switch (op)
+    {
+        case opcode::negate:
+            if (auto real = lhs.get_if<double>())
+            {
+                return -*real;
+            }
+            return wrap(-std::int64_t(to_int(lhs)));
+        case opcode::logical_not: return !to_bool(lhs);
+        case opcode::bitwise_not: return ~to_int(lhs);
+        default: break;
+    }
+
+    if (!is_number(rhs))
+    {
+        return std::nullopt;
+    }
+
+    bool integral = !lhs.holds<double>()
+                 && !rhs.holds<double>();
+    auto x        = to_real(lhs);
+    auto y        = to_real(rhs);
+    std::int64_t i = to_int(lhs);
+    std::int64_t j = to_int(rhs);
+
+    switch (op)
+    {
+    using enum opcode;
+        case add: return integral ? value(wrap(i + j)) : value(x + y);
+        case subtract: return integral ? value(wrap(i - j)) : value(x - y);
+        case multiply: return integral ? value(wrap(i * j)) : value(x * y);
+        case divide: return x / y;
+        case power: return std::pow(x, y);
+        case floor_divide:
+        {
+            if (!integral)
+            {
+                return std::floor(x / y);
+            }
+            if (j == 0)
+            {
+                return std::nullopt;
+            }
+            return floor_quotient(i, j);
+        }
+        case modulo:
+        {
+            if (!integral)
+            {
+                return x - y * std::floor(x / y);
+            }
+            if (j == 0)
+            {
+                return std::nullopt;
+            }
+            return floor_remainder(i, j);
+        }
+        case shift_left: return wrap(i << (j & 31));
+        case shift_right: return wrap(i >> (j & 31));
+        case bitwise_and: return wrap(i & j);
+        case bitwise_xor: return wrap(i ^ j);
+        case bitwise_or: return wrap(i | j);
+        case less: return integral ? i < j : x < y;
+        case less_equal: return integral ? i <= j : x <= y;
+        case greater: return integral ? i > j : x > y;
+        case greater_equal: return integral ? i >= j : x >= y;
+        case equal: return integral ? i == j : x == y;
+        case not_equal: return integral ? i != j : x != y;
+        default: return std::nullopt;
+    }
+}
+
+/**
+ *  @brief  Convert a number to a scalar type.  Reals are floored and
+ *          saturated when converted to `int`, and integers are clamped
+ *          when converted to `char`.
+ *
+ *  @param  v     The number.
+ *  @param  type  `real`, `int`, `bool` or `char`.
+ *  @return  The converted number, or nothing if @p v is not a number or
+ *           @p type is not a scalar type.
+ */
+auto plons::dtn::convert_number(const value &v, type_index type)
+-> std::optional<value>
+{
+    if (!is_number(v))
+    {
+        return std::nullopt;
+    }
+
+    if (type == real_type)
+    {
+        return to_real(v);
+    }
+    if (type == int_type)
+    {
+        return to_int(v);
+    }
+    if (type == bool_type)
+    {
+        return to_bool(v);
+    }
+    if (type == char_type)
+    {
+        auto c = std::clamp<std::int32_t>(to_int(v), 0, 255);
+        return static_cast<char>(static_cast<unsigned char>(c));
+    }
+    return std::nullopt;
+}
+
+/**
+ *  @brief  Check if two values are equal, comparing arrays element by
+ *          element.
+ *
+ *  @param  lhs  The left value.
+ *  @param  rhs  The right value.
+ *  @return  True if equal, or nothing if the values cannot be compared.
+ */
+[[nodiscard]] static auto equal_values(const value &lhs, const value &rhs)
+-> std::optional<bool>
+{
+    if (is_number(lhs) && is_number(rhs))
+    {
+        return apply_operator(opcode::equal, lhs, rhs)->get<bool>();
+    }
+
+    auto left  = lhs.get_if<array_object>();
+    auto right = rhs.get_if<array_object>();
+    if (!left || !right)
+    {
+        return std::nullopt;
+    }
+    if (left->elements().size() != right->elements().size())
+    {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < left->elements().size(); i++)
+    {
+        auto same = equal_values(left->elements()[i], right->elements()[i]);
+        if (!same.has_value() || !same.value())
+        {
+            return same;
+        }
+    }
+    return true;
+}
+
+/**
+ *  @brief  Evaluate a builtin function.
+ *
+ *  @param  function  The builtin function.
+ *  @param  args      The arguments.
+ *  @return  The result.
+ */
+auto plons::dtn::apply_builtin(
+    builtin_function        function,
+    std::span<const double> args
+) -> double
+{
+    auto x      = args.empty() ? 0.0 : args[0];
+    auto result = 0.0;
+    builtins()[static_cast<std::size_t>(function)].scalar(&result, &x,
+        args.size() < 2 ? nullptr : &args[1], 1);
+    return result;
+}
+
+/**
+ *  @brief  Find the operator overload that accepts operands of some
+ *          types, the way the program does when it runs.  An overload
+ *          that takes exactly the types is preferred, otherwise the first
+ *          overload declared that accepts the numbers converted.
+ *
+ *  @param  prog      The program.
+ *  @param  op        The operator.
+ *  @param  form      Where the operator is written.
+ *  @param  symbol    Symbol ID of a custom operator.
+ *  @param  operands  Types of the operands.
+ *  @return  The overload, or @c nullptr if none accepts the operands.
+ */
+auto plons::dtn::match_overload(
+    const program              &prog,
+    operator_kind               op,
+    operator_form               form,
+    std::uint32_t               symbol,
+    std::span<const type_index> operands
+) -> const overload *
+{
+    auto types = std::array { unknown_type, unknown_type };
+    stdr::copy(operands, types.begin());
+
+    auto key = make_overload_key(op, form, symbol, types);
+    if (auto it = prog.overload_table.find(key);
+        it != prog.overload_table.end())
+    {
+        return &prog.overloads[it->second];
+    }
+
+    auto is_scalar = [](type_index type)
+    {
+        return type >= real_type && type <= char_type;
+    };
+    for (auto &ov : prog.overloads)
+    {
+        if (ov.op != op || ov.form != form
+         || (op == operator_kind::custom && ov.symbol != symbol))
+        {
+            continue;
+        }
+
+        bool matches = true;
+        for (std::size_t i = 0; i < operands.size(); i++)
+        {
+            auto type = ov.operands[i];
+            matches   = matches && (operands[i] == type
+                || type == unknown_type
+                || (is_scalar(operands[i]) && is_scalar(type)));
+        }
+        if (matches)
+        {
+            return &ov;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ *  @brief  The operator overload that an instruction called last, for
+ *          the types of its operands.
+ */
+struct overload_cache {
+
+    /**
+     *  @brief  Types of the operands.
+     */
+    std::array<type_index, 2> operands = { unknown_type, unknown_type };
+
+    /**
+     *  @brief  The overload, or @c nullptr before the first call.
+     */
+    const overload *target = nullptr;
+};
+
+/**
+ *  @brief  Runs a @c program .
+ *
+ *  Each call has a frame of @c function_info::registers registers on the
+ *  stack, beginning at the register of the call in the caller's frame.
+ *  Calls that the bytecode does not make, like operator overloads,
+ *  destructors and initializers, put their frame above the caller's.
+ */
+struct machine {
+
+    /**
+     *  @brief  The source code's information, receives the messages.
+     */
+    detronade &dtn;
+
+    /**
+     *  @brief  The program.
+     */
+    const program &prog;
+
+    /**
+     *  @brief  Registers of all the frames.
+     */
+    std::vector<value> stack;
+
+    /**
+     *  @brief  The global variables.
+     */
+    std::vector<value> globals;
+
+    /**
+     *  @brief  Number of nested calls.
+     */
+    std::size_t depth = 0;
+
+    /**
+     *  @brief  Overload caches of the instructions that call operator
+     *          overloads, by function, created when the function first
+     *          calls an overload.
+     */
+    std::vector<std::vector<overload_cache>> caches;
+
+    /**
+     *  @brief  The builtin functions, called by @c opcode::call_builtin
+     *          through their scalar kernels.
+     */
+    std::span<const builtin_info> functions;
+
+    /**
+     *  @brief  Creates the machine for the program.
+     *
+     *  @param  dtn   The source code's information.
+     *  @param  prog  The program.
+     */
+    machine(detronade &dtn, const program &prog);
+
+    /**
+     *  @brief  Report a runtime error at the token.
+     *
+     *  @param  id   What the error is about.
+     *  @param  tok  Index of the token.
+     *  @param  arg  The argument of the message.
+     *  @return  False.
+     */
+    auto fail(message_id id, std::uint32_t tok, message_argument arg = {})
+    -> bool;
+
+    /**
+     *  @brief  Make the stack hold at least the number of registers.
+     *  @param  size  Number of registers.
+     */
+    auto ensure(std::size_t size) -> void;
+
+    /**
+     *  @brief  Get the type of the value.
+     *
+     *  @param  v  The value.
+     *  @return  The type.
+     */
+    [[nodiscard]] auto type_of(const value &v) const -> type_index;
+
+    /**
+     *  @brief  Convert the value to the type.
+     *
+     *  @param  v     The value, replaced by the converted value.
+     *  @param  type  The type.
+     *  @return  True if the value can be converted.
+     */
+    [[nodiscard]] auto convert(value &v, type_index type) const -> bool;
+
+    /**
+     *  @brief  Check if the values of the type have destructors to call.
+     *
+     *  @param  type  The type.
+     *  @return  True if the structure, its fields or the elements have a
+     *           destructor.
+     */
+    [[nodiscard]] auto needs_destroy(type_index type) const -> bool;
+
+    /**
+     *  @brief  Check if the elements of arrays of the type are numbers,
+     *          `bool`s or `char`s, which copies of an array can share.
+     *
+     *  @param  type  The type of the array.
+     *  @return  True if the elements are numbers.
+     */
+    [[nodiscard]] auto flat(type_index type) const -> bool;
+
+    /**
+     *  @brief  Get the overload cache of an instruction.
+     *
+     *  @param  function  Index of the function.
+     *  @param  at        Index of the instruction.
+     *  @return  The cache.
+     */
+    [[nodiscard]] auto cache_of(std::uint32_t function, std::size_t at)
+    -> overload_cache &;
+
+    /**
+     *  @brief  Call a function.
+     *
+     *  @param  function  Index of the function.
+     *  @param  base      First register of the frame, holding the
+     *                    arguments.
+     *  @param  tok       Token of the call.
+     *  @return  True if the function returned without an error.
+     */
+    [[nodiscard]] auto call(
+        std::uint32_t function,
+        std::size_t   base,
+        std::uint32_t tok
+    ) -> bool;
+
+    /**
+     *  @brief  Create a structure, set its fields to their initial values
+     *          and call the constructor.
+     *
+     *  @param  ctor  Index of the constructor.
+     *  @param  base  The register of the structure, followed by the
+     *                arguments.
+     *  @param  tok   Token of the construction.
+     *  @return  True if the constructor returned without an error.
+     */
+    [[nodiscard]] auto construct(
+        std::uint32_t ctor,
+        std::size_t   base,
+        std::uint32_t tok
+    ) -> bool;
+
+    /**
+     *  @brief  Call the destructor of the value, then of its fields or
+     *          elements.
+     *
+     *  @param  v    The value.
+     *  @param  top  First free register.
+     *  @param  tok  Token of the destruction.
+     *  @return  True if the destructors returned without an error.
+     */
+    [[nodiscard]] auto destroy(
+        const value  &v,
+        std::size_t   top,
+        std::uint32_t tok
+    ) -> bool;
+
+    /**
+     *  @brief  Get the value of a variable without an initializer.
+     *
+     *  @param  type  The type.
+     *  @param  top   First free register.
+     *  @param  tok   Token of the variable.
+     *  @return  The value, or nothing if the constructor failed.
+     */
+    [[nodiscard]] auto default_value(
+        type_index    type,
+        std::size_t   top,
+        std::uint32_t tok
+    ) -> std::optional<value>;
+
+    /**
+     *  @brief  Call the operator overload that accepts the values.  An
+     *          overload that takes exactly the types is preferred over
+     *          one that needs a number converted.
+     *
+     *  @param  op      The operator.
+     *  @param  form    Where the operator is written.
+     *  @param  symbol  Symbol ID of a custom operator.
+     *  @param  args    The operands.
+     *  @param  cache   Overload cache of the instruction.
+     *  @param  top     First free register.
+     *  @param  tok     Token of the operator.
+     *  @return  The result, or nothing on error.
+     */
+    [[nodiscard]] auto call_overload(
+        operator_kind           op,
+        operator_form           form,
+        std::uint32_t           symbol,
+        std::span<const value>  args,
+        overload_cache         &cache,
+        std::size_t             top,
+        std::uint32_t           tok
+    ) -> std::optional<value>;
+
+    /**
+     *  @brief  Apply a binary operator to values that are not both reals.
+     *
+     *  @param  op     The opcode.
+     *  @param  lhs    The left value.
+     *  @param  rhs    The right value.
+     *  @param  cache  Overload cache of the instruction.
+     *  @param  top    First free register.
+     *  @param  tok    Token of the operator.
+     *  @return  The result, or nothing on error.
+     */
+    [[nodiscard]] auto binary(
+        opcode          op,
+        value           lhs,
+        value           rhs,
+        overload_cache &cache,
+        std::size_t     top,
+        std::uint32_t   tok
+    ) -> std::optional<value>;
+
+    /**
+     *  @brief  Apply a prefix operator to a value that is not a real.
+     *
+     *  @param  op       The opcode.
+     *  @param  operand  The value.
+     *  @param  cache    Overload cache of the instruction.
+     *  @param  top      First free register.
+     *  @param  tok      Token of the operator.
+     *  @return  The result, or nothing on error.
+     */
+    [[nodiscard]] auto unary(
+        opcode          op,
+        value           operand,
+        overload_cache &cache,
+        std::size_t     top,
+        std::uint32_t   tok
+    ) -> std::optional<value>;
+
+    /**
+     *  @brief  Get the index of an array element.
+     *
+     *  @param  array  The array.
+     *  @param  index  The index value.
+     *  @param  end    Whether the index may be the size of the array.
+     *  @param  tok    Token of the subscript.
+     *  @return  The index, or nothing if it is out of range.
+     */
+    [[nodiscard]] auto element_index(
+        const array_object &array,
+        const value        &index,
+        bool                end,
+        std::uint32_t       tok
+    ) -> std::optional<std::size_t>;
+
+    /**
+     *  @brief  Execute a function.
+     *
+     *  @param  function  Index of the function.
+     *  @param  base      First register of the frame.
+     *  @return  True if the function returned without an error.
+     */
+    [[nodiscard]] auto execute(std::uint32_t function, std::size_t base)
+    -> bool;
+};
+
+/**
+ *  @brief  Creates the machine for the program.
+ *
+ *  @param  dtn   The source code's information.
+ *  @param  prog  The program.
+ */
+machine::machine(detronade &dtn, const program &prog)
+    : dtn(dtn), prog(prog), globals(prog.globals),
+      caches(prog.functions.size()), functions(builtins())
+{
+}
+
+/**
+ *  @brief  Report a runtime error at the token.
+ *
+ *  @param  id   What the error is about.
+ *  @param  tok  Index of the token.
+ *  @param  arg  The argument of the message.
+ *  @return  False.
+ */
+auto machine::fail(message_id id, std::uint32_t tok, message_argument arg)
+-> bool
+{
+    auto &t = dtn.tokens[tok];
+    dtn.messages.emplace_back(message {
+        .id          = id,
+        .severity    = message_severity::error,
+        .pos         = {
+            .begin   = dtn.offset(tok),
+            .length  = t.length,
+            .pointer = 0
+        },
+        .args        = { arg }
+    });
+    return false;
+}
+
+/**
+ *  @brief  Make the stack hold at least the number of registers.
+ *  @param  size  Number of registers.
+ */
+auto machine::ensure(std::size_t size) -> void
+{
+    if (stack.size() < size)
+    {
+        stack.resize(std::max(size, stack.size() * 2));
+    }
+}
+
+/**
+ *  @brief  Get the type of the value.
+ *
+ *  @param  v  The value.
+ *  @return  The type.
+ */
+auto machine::type_of(const value &v) const -> type_index
+{
+    if (auto array = v.get_if<array_object>())
+    {
+        return array->type;
+    }
+    if (auto object = v.get_if<struct_object>())
+    {
+        return object->type;
+    }
+    if (v.holds<double>())
+    {
+        return real_type;
+    }
+    if (v.holds<std::int32_t>())
+    {
+        return int_type;
+    }
+    if (v.holds<bool>())
+    {
+        return bool_type;
+    }
+    return v.holds<char>() ? char_type : unknown_type;
+}
+
+/**
+ *  @brief  Convert the value to the type.
+ *
+ *  Reals are floored when converted to `int`, `bool` and `char`, and
+ *  `char` is clamped between 0 and 255.  Arrays are converted element by
+ *  element to a new array, and a structure is only its own type.
+ *
+ *  @param  v     The value, replaced by the converted value.
+ *  @param  type  The type.
+ *  @return  True if the value can be converted.
+ */
+auto machine::convert(value &v, type_index type) const -> bool
+{
+    auto &info = prog.types[type];
+    switch (info.kind)
+    {
+    using enum type_kind;
+        case unknown: return true;
+        case real:
+        case int_:
+        case bool_:
+        case char_:
+        {
+            auto converted = convert_number(v, type);
+            if (!converted.has_value())
+            {
+                return false;
+            }
+
+            v = std::move(converted.value());
+            return true;
+        }
+        case array:
+        {
+            auto source = v.get_if<array_object>();
+            if (!source)
+            {
+                return false;
+            }
+            if (source->type == type)
+            {
+                return true;
+            }
+
+            auto elements = source->elements();
+            for (auto &element : elements)
+            {
+                if (!convert(element, info.index))
+                {
+                    return false;
+                }
+            }
+            v = value::make_array(type, flat(type), std::move(elements));
+            return true;
+        }
+        case struct_:
+        {
+            auto object = v.get_if<struct_object>();
+            return object && object->type == type;
+        }
+        default: return false;
+    }
+}
+
+/**
+ *  @brief  Check if the values of the type have destructors to call.
+ *
+ *  @param  type  The type.
+ *  @return  True if the structure, its fields or the elements have a
+ *           destructor.
+ */
+auto machine::needs_destroy(type_index type) const -> bool
+{
+    auto &info = prog.types[type];
+    switch (info.kind)
+    {
+        case type_kind::struct_: return prog.structs[info.index].needs_destroy;
+        case type_kind::array: return needs_destroy(info.index);
+        default: return false;
+    }
+}
+
+/**
+ *  @brief  Check if the elements of arrays of the type are numbers,
+ *          `bool`s or `char`s, which copies of an array can share.
+ *
+ *  @param  type  The type of the array.
+ *  @return  True if the elements are numbers.
+ */
+auto machine::flat(type_index type) const -> bool
+{
+    switch (prog.types[prog.types[type].index].kind)
+    {
+    using enum type_kind;
+        case real:
+        case int_:
+        case bool_:
+        case char_: return true;
+        default: return false;
+    }
+}
+
+/**
+ *  @brief  Get the overload cache of an instruction.
+ *
+ *  @param  function  Index of the function.
+ *  @param  at        Index of the instruction.
+ *  @return  The cache.
+ */
+auto machine::cache_of(std::uint32_t function, std::size_t at)
+-> overload_cache &
+{
+    auto &cache = caches[function];
+    if (cache.empty())
+    {
+        cache.resize(prog.functions[function].code.size());
+    }
+    return cache[at];
+}
+
+/**
+ *  @brief  Call a function.
+ *
+ *  @param  function  Index of the function.
+ *  @param  base      First register of the frame, holding the
+ *                    arguments.
+ *  @param  tok       Token of the call.
+ *  @return  True if the function returned without an error.
+ */
+auto machine::call(
+    std::uint32_t function,
+    std::size_t   base,
+    std::uint32_t tok
+) -> bool
+{
+    if (depth >= dtn.options.max_call_depth)
+    {
+        return fail(message_id::stack_overflow, tok);
+    }
+
+    depth++;
+    auto returned = execute(function, base);
+    depth--;
+    return returned;
+}
+
+/**
+ *  @brief  Create a structure, set its fields to their initial values
+ *          and call the constructor.
+ *
+ *  @param  ctor  Index of the constructor.
+ *  @param  base  The register of the structure, followed by the
+ *                arguments.
+ *  @param  tok   Token of the construction.
+ *  @return  True if the constructor returned without an error.
+ */
+auto machine::construct(
+    std::uint32_t ctor,
+    std::size_t   base,
+    std::uint32_t tok
+) -> bool
+{
+    auto &fn     = prog.functions[ctor];
+    auto &st     = prog.structs[fn.owner];
+    auto  object = value::make_struct(st.type,
+        static_cast<std::uint32_t>(st.field_types.size()));
+    auto  fields = object.get_if<struct_object>()->fields();
+
+    // A number field is 0 until it is initialized, so that it is always of
+    // its type
+    for (std::size_t i = 0; i < st.field_types.size(); i++)
+    {
+        if (auto zero = convert_number(0.0, st.field_types[i]))
+        {
+            fields[i] = std::move(zero.value());
+        }
+    }
+
+    // The initializer runs above the arguments of the constructor
+    if (st.initializer != no_function)
+    {
+        auto above = base + fn.parameters.size();
+        ensure(above + 1);
+        stack[above] = object;
+        if (!call(st.initializer, above, tok))
+        {
+            return false;
+        }
+    }
+
+    stack[base] = object;
+    if (!call(ctor, base, tok))
+    {
+        return false;
+    }
+    stack[base] = std::move(object);
+    return true;
+}
+
+/**
+ *  @brief  Call the destructor of the value, then of its fields or
+ *          elements.
+ *
+ *  @param  v    The value.
+ *  @param  top  First free register.
+ *  @param  tok  Token of the destruction.
+ *  @return  True if the destructors returned without an error.
+ */
+auto machine::destroy(
+    const value  &v,
+    std::size_t   top,
+    std::uint32_t tok
+) -> bool
+{
+    if (auto array = v.get_if<array_object>())
+    {
+        if (!needs_destroy(array->type))
+        {
+            return true;
+        }
+
+        auto elements = array->elements();
+        return stdr::all_of(elements, [&](const value &element)
+        {
+            return destroy(element, top, tok);
+        });
+    }
+
+    auto object = v.get_if<struct_object>();
+    if (!object || !needs_destroy(object->type))
+    {
+        return true;
+    }
+
+    auto &st = prog.structs[prog.types[object->type].index];
+    if (st.destructor != no_function)
+    {
+        ensure(top + 1);
+        stack[top] = v;
+        if (!call(st.destructor, top, tok))
+        {
+            return false;
+        }
+    }
+
+    auto fields = std::vector<value>(object->fields().begin(),
+                                     object->fields().end());
+    return stdr::all_of(fields, [&](const value &field)
+    {
+        return destroy(field, top, tok);
+    });
+}
+
+/**
+ *  @brief  Get the value of a variable without an initializer.
+ *
+ *  @param  type  The type.
+ *  @param  top   First free register.
+ *  @param  tok   Token of the variable.
+ *  @return  The value, or nothing if the constructor failed.
+ */
+auto machine::default_value(
+    type_index    type,
+    std::size_t   top,
+    std::uint32_t tok
+) -> std::optional<value>
+{
+    auto &info = prog.types[type];
+    switch (info.kind)
+    {
+    using enum type_kind;
+        case real: return 0.0;
+        case int_: return std::int32_t(0);
+        case bool_: return false;
+        case char_: return '\0';
+        case array:
+            return value::make_array(type, flat(type), {});
+        case struct_:
+        {
+            ensure(top + 1);
+            auto ctor = prog.structs[info.index].default_constructor;
+            if (!construct(ctor, top, tok))
+            {
+                return std::nullopt;
+            }
+            return std::move(stack[top]);
+        }
+        default: return value {};
+    }
+}
+
+/**
+ *  @brief  Call the operator overload that accepts the values.  An
+ *          overload that takes exactly the types is preferred over
+ *          one that needs a number converted.
+ *
+ *  @param  op      The operator.
+ *  @param  form    Where the operator is written.
+ *  @param  symbol  Symbol ID of a custom operator.
+ *  @param  args    The operands.
+ *  @param  cache   Overload cache of the instruction.
+ *  @param  top     First free register.
+ *  @param  tok     Token of the operator.
+ *  @return  The result, or nothing on error.
+ */
+auto machine::call_overload(
+    operator_kind           op,
+    operator_form           form,
+    std::uint32_t           symbol,
+    std::span<const value>  args,
+    overload_cache         &cache,
+    std::size_t             top,
+    std::uint32_t           tok
+) -> std::optional<value>
+{
+    auto types = std::array { unknown_type, unknown_type };
+    for (std::size_t i = 0; i < args.size(); i++)
+    {
+        types[i] = type_of(args[i]);
+    }
+
+    // An instruction mostly sees operands of the same types every time
+    if (!cache.target || cache.operands != types)
+    {
+        auto target = match_overload(prog, op, form, symbol,
+            std::span(types).first(args.size()));
+        if (!target)
+        {
+            fail(message_id::no_matching_overload, tok);
+            return std::nullopt;
+        }
+        cache = { types, target };
+    }
+
+    // Operands are passed by value, like the arguments of a call
+    auto                  function = cache.target->function;
+    auto                 &fn       = prog.functions[function];
+    std::array<value, 2>  operands;
+    for (std::size_t i = 0; i < args.size(); i++)
+    {
+        operands[i] = deep_copy(args[i]);
+        if (!convert(operands[i], fn.parameters[i]))
+        {
+            fail(message_id::invalid_conversion, tok);
+            return std::nullopt;
+        }
+    }
+
+    ensure(top + args.size());
+    for (std::size_t i = 0; i < args.size(); i++)
+    {
+        stack[top + i] = std::move(operands[i]);
+    }
+    if (!call(function, top, tok))
+    {
+        return std::nullopt;
+    }
+    return std::move(stack[top]);
+}
+
+/**
+ *  @brief  Apply a binary operator to values that are not both reals.
+ *
+ *  @param  op     The opcode.
+ *  @param  lhs    The left value.
+ *  @param  rhs    The right value.
+ *  @param  cache  Overload cache of the instruction.
+ *  @param  top    First free register.
+ *  @param  tok    Token of the operator.
+ *  @return  The result, or nothing on error.
+ */
+auto machine::binary(
+    opcode          op,
+    value           lhs,
+    value           rhs,
+    overload_cache &cache,
+    std::size_t     top,
+    std::uint32_t   tok
+) -> std::optional<value>
+{
+    if (is_number(lhs) && is_number(rhs))
+    {
+        auto result = apply_operator(op, lhs, rhs);
+        if (!result.has_value())
+        {
+            fail(message_id::division_by_zero, tok);
+        }
+        return result;
+    }
+
+    if (lhs.holds<struct_object>()
+     || rhs.holds<struct_object>())
+    {
+        auto operands = std::array { std::move(lhs), std::move(rhs) };
+        return call_overload(opcode_operator(op), operator_form::binary, 0,
+            operands, cache, top, tok);
+    }
+
+    auto left  = lhs.get_if<array_object>();
+    auto right = rhs.get_if<array_object>();
+    if (op == opcode::add && left && right)
+    {
+        // The elements are appended to a left array that nothing else
+        // refers to, which keeps the capacity it grew to
+        auto  element  = prog.types[left->type].index;
+        auto  result   = left->references == 1 ? std::move(lhs)
+                       : value::make_array(left->type, left->flat, {});
+        auto  target   = result.get_if<array_object>();
+        auto  size     = right->elements().size();
+        auto &elements = target->change();
+        if (target != left)
+        {
+            elements.reserve(left->elements().size() + size);
+            for (auto &e : left->elements())
+            {
+                elements.emplace_back(deep_copy(e));
+            }
+        }
+        for (std::size_t i = 0; i < size; i++)
+        {
+            elements.emplace_back(deep_copy(right->elements()[i]));
+            if (!convert(elements.back(), element))
+            {
+                fail(message_id::invalid_conversion, tok);
+                return std::nullopt;
+            }
+        }
+        return result;
+    }
+
+    if (op == opcode::equal || op == opcode::not_equal)
+    {
+        auto same = equal_values(lhs, rhs);
+        if (same.has_value())
+        {
+            return same.value() == (op == opcode::equal);
+        }
+    }
+
+    fail(message_id::invalid_operands, tok);
+    return std::nullopt;
+}
+
+/**
+ *  @brief  Apply a prefix operator to a value that is not a real.
+ *
+ *  @param  op       The opcode.
+ *  @param  operand  The value.
+ *  @param  cache    Overload cache of the instruction.
+ *  @param  top      First free register.
+ *  @param  tok      Token of the operator.
+ *  @return  The result, or nothing on error.
+ */
+auto machine::unary(
+    opcode          op,
+    value           operand,
+    overload_cache &cache,
+    std::size_t     top,
+    std::uint32_t   tok
+) -> std::optional<value>
+{
+    if (operand.holds<struct_object>())
+    {
+        return call_overload(opcode_operator(op), operator_form::prefix, 0,
+            std::span(&operand, 1), cache, top, tok);
+    }
+    if (!is_number(operand))
+    {
+        fail(message_id::invalid_operands, tok);
+        return std::nullopt;
+    }
+
+    return apply_operator(op, operand);
+}
+
+/**
+ *  @brief  Get the index of an array element.
+ *
+ *  @param  array  The array.
+ *  @param  index  The index value.
+ *  @param  end    Whether the index may be the size of the array.
+ *  @param  tok    Token of the subscript.
+ *  @return  The index, or nothing if it is out of range.
+ */
+auto machine::element_index(
+    const array_object &array,
+    const value        &index,
+    bool                end,
+    std::uint32_t       tok
+) -> std::optional<std::size_t>
+{
+    if (!is_number(index))
+    {
+        fail(message_id::invalid_operands, tok);
+        return std::nullopt;
+    }
+
+    auto i = std::floor(to_real(index));
+    if (!(i >= 0.0 && i < array.elements().size() + end))
+    {
+        fail(message_id::index_out_of_range, tok, i);
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(i);
+}
+
+/**
+ *  @brief  Execute a function.
+ *
+ *  @param  function  Index of the function.
+ *  @param  base      First register of the frame.
+ *  @return  True if the function returned without an error.
+ */
+auto machine::execute(std::uint32_t function, std::size_t base) -> bool
+{
+    auto &fn  = prog.functions[function];
+    auto  top = base + fn.registers;
+    ensure(top);
+
+    // Registers are found again after anything that may grow the stack
+    auto        r     = stack.data() + base;
+    auto        code  = fn.code.data();
+    auto        ip    = code;
+    instruction in    = {};
+    auto        where = [&]
+    {
+        return fn.tokens[ip - code - 1];
+    };
+    auto        cache = [&] -> overload_cache &
+    {
+        return cache_of(function, ip - code - 1);
+    };
+
+#if PLONS_LIBRARY_DTN_THREADED
+    // In the order of opcode
+    static const void *const labels[] = {
+        &&op_move, &&op_copy, &&op_take, &&op_load_constant,
+        &&op_get_global, &&op_set_global, &&op_get_field, &&op_set_field,
+        &&op_get_index, &&op_set_index, &&op_new_array, &&op_new_array_sized,
+        &&op_count, &&op_insert, &&op_remove, &&op_convert, &&op_add,
+        &&op_subtract,
+        &&op_multiply, &&op_divide, &&op_floor_divide, &&op_modulo,
+        &&op_power, &&op_shift_left, &&op_shift_right, &&op_bitwise_and,
+        &&op_bitwise_xor, &&op_bitwise_or, &&op_less, &&op_less_equal,
+        &&op_greater, &&op_greater_equal, &&op_equal, &&op_not_equal,
+        &&op_negate, &&op_logical_not, &&op_bitwise_not, &&op_int_to_real,
+        &&op_real_to_int, &&op_add_int, &&op_add_real, &&op_subtract_int,
+        &&op_subtract_real, &&op_multiply_int, &&op_multiply_real,
+        &&op_divide_int, &&op_divide_real, &&op_floor_divide_int,
+        &&op_floor_divide_real, &&op_modulo_int, &&op_modulo_real,
+        &&op_less_int, &&op_less_real, &&op_less_equal_int,
+        &&op_less_equal_real, &&op_equal_int, &&op_equal_real,
+        &&op_not_equal_int, &&op_not_equal_real, &&op_negate_int,
+        &&op_negate_real, &&op_jump, &&op_jump_if_false, &&op_jump_if_true,
+        &&op_call, &&op_call_builtin, &&op_call_operator, &&op_construct,
+        &&op_destroy, &&op_return_, &&op_return_void
+    };
+    static_assert(std::size(labels) == static_cast<std::size_t>(opcode::max),
+        "Every opcode needs a handler");
+
+    PLONS_LIBRARY_DTN_NEXT();
+#else
+    for (;;)
+    {
+    in = *ip++;
+    switch (in.op)
+    {
+#endif
+
+    PLONS_LIBRARY_DTN_OP(move)
+    {
+        r[in.a] = r[in.b];
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(copy)
+    {
+        r[in.a] = deep_copy(r[in.b]);
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(take)
+    {
+        r[in.a] = std::move(r[in.b]);
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(load_constant)
+    {
+        auto &k = prog.constants[in.bc()];
+        r[in.a] = k.holds<array_object>() ? deep_copy(k) : k;
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(get_global)
+    {
+        r[in.a] = globals[in.bc()];
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(set_global)
+    {
+        globals[in.bc()] = r[in.a];
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(get_field)
+    {
+        auto object = r[in.b].get_if<struct_object>();
+        if (!object)
+        {
+            return fail(message_id::invalid_operands, where());
+        }
+
+        r[in.a] = value(object->fields()[in.c]);
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(set_field)
+    {
+        auto object = r[in.a].get_if<struct_object>();
+        if (!object)
+        {
+            return fail(message_id::invalid_operands, where());
+        }
+
+        object->fields()[in.b] = r[in.c];
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(get_index)
+    {
+        if (auto array = r[in.b].get_if<array_object>())
+        {
+            auto i = element_index(*array, r[in.c], false, where());
+            if (!i.has_value())
+            {
+                return false;
+            }
+
+            r[in.a] = value(array->elements()[i.value()]);
+            PLONS_LIBRARY_DTN_NEXT();
+        }
+
+        if (!r[in.b].holds<struct_object>())
+        {
+            return fail(message_id::invalid_operands, where());
+        }
+
+        {
+            auto operands = std::array { r[in.b], r[in.c] };
+            auto result   = call_overload(operator_kind::subscript_begin,
+                operator_form::subscript, 0, operands, cache(), top,
+                where());
+            if (!result.has_value())
+            {
+                return false;
+            }
+            r       = stack.data() + base;
+            r[in.a] = std::move(result.value());
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(set_index)
+    {
+        auto array = r[in.a].get_if<array_object>();
+        if (!array)
+        {
+            return fail(message_id::invalid_operands, where());
+        }
+
+        auto i = element_index(*array, r[in.b], false, where());
+        if (!i.has_value())
+        {
+            return false;
+        }
+
+        {
+            auto element = r[in.c];
+            if (!convert(element, prog.types[array->type].index))
+            {
+                return fail(message_id::invalid_conversion, where());
+            }
+            array->change()[i.value()] = std::move(element);
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(new_array)
+    {
+        {
+            std::vector<value> elements;
+            auto               element = prog.types[in.c].index;
+            elements.reserve(in.b);
+            for (std::size_t i = 0; i < in.b; i++)
+            {
+                elements.emplace_back(std::move(r[in.a + i]));
+                if (!convert(elements.back(), element))
+                {
+                    return fail(message_id::invalid_conversion, where());
+                }
+            }
+            r[in.a] = value::make_array(in.c, flat(in.c), std::move(elements));
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(new_array_sized)
+    {
+        if (!is_number(r[in.b]))
+        {
+            return fail(message_id::invalid_operands, where());
+        }
+
+        auto size = std::floor(to_real(r[in.b]));
+        if (!(size >= 0.0 && size <= std::numeric_limits<std::int32_t>::max()))
+        {
+            return fail(message_id::index_out_of_range, where(), size);
+        }
+
+        {
+            std::vector<value> elements;
+            auto               element = prog.types[in.c].index;
+            elements.reserve(static_cast<std::size_t>(size));
+            for (std::size_t i = 0; i < static_cast<std::size_t>(size); i++)
+            {
+                auto v = default_value(element, top, where());
+                if (!v.has_value())
+                {
+                    return false;
+                }
+                elements.emplace_back(std::move(v.value()));
+            }
+
+            r       = stack.data() + base;
+            r[in.a] = value::make_array(in.c, flat(in.c), std::move(elements));
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(count)
+    {
+        auto array = r[in.b].get_if<array_object>();
+        if (!array)
+        {
+            return fail(message_id::invalid_operands, where());
+        }
+
+        r[in.a] = static_cast<std::int32_t>(array->elements().size());
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(insert)
+    {
+        auto array = r[in.b].get_if<array_object>();
+        if (!array)
+        {
+            return fail(message_id::invalid_operands, where());
+        }
+
+        auto i = element_index(*array, r[in.c], true, where());
+        if (!i.has_value())
+        {
+            return false;
+        }
+
+        {
+            auto element = r[in.c + 1];
+            if (!convert(element, prog.types[array->type].index))
+            {
+                return fail(message_id::invalid_conversion, where());
+            }
+
+            auto &elements = array->change();
+            auto  result   = deep_copy(element);
+            elements.insert(elements.begin() + i.value(), std::move(element));
+            r[in.a] = std::move(result);
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(remove)
+    {
+        auto array = r[in.b].get_if<array_object>();
+        if (!array)
+        {
+            return fail(message_id::invalid_operands, where());
+        }
+
+        auto i = element_index(*array, r[in.c], false, where());
+        if (!i.has_value())
+        {
+            return false;
+        }
+
+        {
+            auto &elements = array->change();
+            auto  element  = std::move(elements[i.value()]);
+            elements.erase(elements.begin() + i.value());
+            r[in.a] = std::move(element);
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(convert)
+    {
+        {
+            auto v = r[in.b];
+            if (!convert(v, in.c))
+            {
+                return fail(message_id::invalid_conversion, where());
+            }
+            r[in.a] = std::move(v);
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_ARITHMETIC(add, x + y)
+    PLONS_LIBRARY_DTN_ARITHMETIC(subtract, x - y)
+    PLONS_LIBRARY_DTN_ARITHMETIC(multiply, x * y)
+    PLONS_LIBRARY_DTN_ARITHMETIC(divide, x / y)
+    PLONS_LIBRARY_DTN_ARITHMETIC(floor_divide, std::floor(x / y))
+    PLONS_LIBRARY_DTN_ARITHMETIC(modulo, x - y * std::floor(x / y))
+    PLONS_LIBRARY_DTN_ARITHMETIC(power, std::pow(x, y))
+    PLONS_LIBRARY_DTN_ARITHMETIC(shift_left,
+        wrap(std::int64_t(real_to_int(x)) << (real_to_int(y) & 31)))
+    PLONS_LIBRARY_DTN_ARITHMETIC(shift_right,
+        real_to_int(x) >> (real_to_int(y) & 31))
+    PLONS_LIBRARY_DTN_ARITHMETIC(bitwise_and, real_to_int(x) & real_to_int(y))
+    PLONS_LIBRARY_DTN_ARITHMETIC(bitwise_xor, real_to_int(x) ^ real_to_int(y))
+    PLONS_LIBRARY_DTN_ARITHMETIC(bitwise_or, real_to_int(x) | real_to_int(y))
+    PLONS_LIBRARY_DTN_ARITHMETIC(less, x < y)
+    PLONS_LIBRARY_DTN_ARITHMETIC(less_equal, x <= y)
+    PLONS_LIBRARY_DTN_ARITHMETIC(greater, x > y)
+    PLONS_LIBRARY_DTN_ARITHMETIC(greater_equal, x >= y)
+    PLONS_LIBRARY_DTN_ARITHMETIC(equal, x == y)
+    PLONS_LIBRARY_DTN_ARITHMETIC(not_equal, x != y)
+
+    PLONS_LIBRARY_DTN_OP(negate)
+    {
+        if (r[in.b].holds<double>())
+        {
+            r[in.a] = -r[in.b].get<double>();
+            PLONS_LIBRARY_DTN_NEXT();
+        }
+        goto slow_unary;
+    }
+
+    PLONS_LIBRARY_DTN_OP(logical_not)
+    PLONS_LIBRARY_DTN_OP(bitwise_not)
+        goto slow_unary;
+
+    PLONS_LIBRARY_DTN_OP(int_to_real)
+    {
+        r[in.a] = static_cast<double>(int_of(r[in.b]));
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(real_to_int)
+    {
+        r[in.a] = real_to_int(real_of(r[in.b]));
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_TYPED(add_int, int, wrap(std::int64_t(x) + y))
+    PLONS_LIBRARY_DTN_TYPED(add_real, real, x + y)
+    PLONS_LIBRARY_DTN_TYPED(subtract_int, int, wrap(std::int64_t(x) - y))
+    PLONS_LIBRARY_DTN_TYPED(subtract_real, real, x - y)
+    PLONS_LIBRARY_DTN_TYPED(multiply_int, int, wrap(std::int64_t(x) * y))
+    PLONS_LIBRARY_DTN_TYPED(multiply_real, real, x * y)
+    PLONS_LIBRARY_DTN_TYPED(divide_int, int, static_cast<double>(x) / y)
+    PLONS_LIBRARY_DTN_TYPED(divide_real, real, x / y)
+    PLONS_LIBRARY_DTN_TYPED(floor_divide_real, real, std::floor(x / y))
+    PLONS_LIBRARY_DTN_TYPED(modulo_real, real, x - y * std::floor(x / y))
+    PLONS_LIBRARY_DTN_TYPED(less_int, int, x < y)
+    PLONS_LIBRARY_DTN_TYPED(less_real, real, x < y)
+    PLONS_LIBRARY_DTN_TYPED(less_equal_int, int, x <= y)
+    PLONS_LIBRARY_DTN_TYPED(less_equal_real, real, x <= y)
+    PLONS_LIBRARY_DTN_TYPED(equal_int, int, x == y)
+    PLONS_LIBRARY_DTN_TYPED(equal_real, real, x == y)
+    PLONS_LIBRARY_DTN_TYPED(not_equal_int, int, x != y)
+    PLONS_LIBRARY_DTN_TYPED(not_equal_real, real, x != y)
+
+    PLONS_LIBRARY_DTN_OP(floor_divide_int)
+    PLONS_LIBRARY_DTN_OP(modulo_int)
+    {
+        auto x = int_of(r[in.b]);
+        auto y = int_of(r[in.c]);
+        if (y == 0)
+        {
+            return fail(message_id::division_by_zero, where());
+        }
+
+        r[in.a] = in.op == opcode::floor_divide_int ? floor_quotient(x, y)
+                : floor_remainder(x, y);
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(negate_int)
+    {
+        r[in.a] = wrap(-std::int64_t(int_of(r[in.b])));
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(negate_real)
+    {
+        r[in.a] = -real_of(r[in.b]);
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(jump)
+    {
+        ip = code + in.bc();
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(jump_if_false)
+    PLONS_LIBRARY_DTN_OP(jump_if_true)
+    {
+        auto condition = r[in.a].get_if<bool>();
+        bool truth     = condition ? *condition : to_bool(r[in.a]);
+        if (!condition && !is_number(r[in.a]))
+        {
+            return fail(message_id::invalid_conversion, where());
+        }
+
+        if (truth == (in.op == opcode::jump_if_true))
+        {
+            ip = code + in.bc();
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(call)
+    {
+        if (!call(in.c, base + in.a, where()))
+        {
+            return false;
+        }
+        r = stack.data() + base;
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(call_builtin)
+    {
+        std::array<double, 2> args = {};
+        for (std::size_t i = 0; i < in.b; i++)
+        {
+            if (!is_number(r[in.a + i]))
+            {
+                return fail(message_id::invalid_operands, where());
+            }
+            args[i] = to_real(r[in.a + i]);
+        }
+
+        auto result = 0.0;
+        functions[in.c].scalar(&result, &args[0],
+            in.b < 2 ? nullptr : &args[1], 1);
+        r[in.a] = result;
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(call_operator)
+    {
+        {
+            auto form   = static_cast<operator_form>(in.b);
+            auto count  = form == operator_form::binary ? 2 : 1;
+            auto result = call_overload(operator_kind::custom, form,
+                prog.operator_symbols[in.c],
+                std::span<const value>(r + in.a, count), cache(), top,
+                where());
+            if (!result.has_value())
+            {
+                return false;
+            }
+            r       = stack.data() + base;
+            r[in.a] = std::move(result.value());
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(construct)
+    {
+        if (!construct(in.c, base + in.a, where()))
+        {
+            return false;
+        }
+        r = stack.data() + base;
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(destroy)
+    {
+        if (!destroy(value(r[in.a]), top, where()))
+        {
+            return false;
+        }
+        r = stack.data() + base;
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+    PLONS_LIBRARY_DTN_OP(return_)
+    {
+        if (in.a != 0)
+        {
+            r[0] = std::move(r[in.a]);
+        }
+        return true;
+    }
+
+    PLONS_LIBRARY_DTN_OP(return_void)
+    {
+        r[0] = std::monostate {};
+        return true;
+    }
+
+slow_binary:
+    {
+        {
+            // An array that is replaced by the result is moved, so that
+            // concatenation can append to it
+            auto rhs    = r[in.c];
+            auto lhs    = in.a == in.b && r[in.b].holds<array_object>()
+                        ? std::move(r[in.b]) : r[in.b];
+            auto result = binary(in.op, std::move(lhs), std::move(rhs),
+                cache(), top, where());
+            if (!result.has_value())
+            {
+                return false;
+            }
+            r       = stack.data() + base;
+            r[in.a] = std::move(result.value());
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+slow_unary:
+    {
+        {
+            auto result = unary(in.op, r[in.b], cache(), top, where());
+            if (!result.has_value())
+            {
+                return false;
+            }
+            r       = stack.data() + base;
+            r[in.a] = std::move(result.value());
+        }
+        PLONS_LIBRARY_DTN_NEXT();
+    }
+
+#if !PLONS_LIBRARY_DTN_THREADED
+        default: return false;
+    }
+    }
+#endif
+}
+
+/**
+ *  @brief  Run the compiled program.
+ *  @return  The result of the uncaptured expression that ended the
+ *           program, @c std::monostate if there was none, or
+ *           @c std::nullopt if a runtime error occurred.
+ *  @note  Requires a successful compilation.  The program is rebuilt
+ *         first if @c edit left it @c stale .
+ */
+auto detronade::run() -> std::optional<value>
+{
+    if (!rebuild() || !bytecode)
+    {
+        return std::nullopt;
+    }
+
+    // Keep the program alive even if the source code is edited meanwhile
+    auto    code = bytecode;
+    machine vm(*this, *code);
+    if (!vm.execute(code->main, 0))
+    {
+        return std::nullopt;
+    }
+    return std::move(vm.stack[0]);
+}
+
+/**
+ *  @brief  Convert @c value to string.  A nonempty array of chars is
+ *          converted to its characters, other arrays to `[a, b]` and
+ *          structures to `{a, b}`.
+ *
+ *  @param  v  The value.
+ *  @return  String representing the value.
+ */
+auto plons::dtn::to_string(const value &v) -> std::string
+{
+    if (auto real = v.get_if<double>())
+    {
+        return std::format("{}", *real);
+    }
+    if (auto integer = v.get_if<std::int32_t>())
+    {
+        return std::to_string(*integer);
+    }
+    if (auto boolean = v.get_if<bool>())
+    {
+        return *boolean ? "true"s : "false"s;
+    }
+    if (auto character = v.get_if<char>())
+    {
+        return std::string(1, *character);
+    }
+
+    auto join = [](std::span<const value> values, char open, char close)
+    {
+        auto result = std::string(1, open);
+        for (std::size_t i = 0; i < values.size(); i++)
+        {
+            result += (i == 0 ? ""s : ", "s) + to_string(values[i]);
+        }
+        return result + close;
+    };
+
+    if (auto array = v.get_if<array_object>())
+    {
+        auto &elements = array->elements();
+        if (!elements.empty() && stdr::all_of(elements, [](const value &e)
+            {
+                return e.holds<char>();
+            }))
+        {
+            std::string text;
+            for (auto &e : elements)
+            {
+                text += e.get<char>();
+            }
+            return text;
+        }
+        return join(elements, '[', ']');
+    }
+    if (auto object = v.get_if<struct_object>())
+    {
+        return join(object->fields(), '{', '}');
+    }
+    return ""s;
+}
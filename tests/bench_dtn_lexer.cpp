@@ -0,0 +1,857 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Compare the throughput of the Detronade lexer with the lexer it
+ *           replaced.
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "alce_string_manipulators.hpp"
+#include "plons_detronade.hpp"
+
+namespace dtn = plons::dtn;
+
+/**
+ *  @brief  The replaced lexer, copied verbatim from the version before the
+ *          character classes were tables.  Each byte is classified by
+ *          searching strings of characters.
+ */
+namespace baseline {
+
+using namespace alce;
+using namespace aec;
+using namespace aec_operators;
+using namespace sm_operators;
+using namespace std::string_literals;
+
+/**
+ *  @brief  Represent a position in the source code.
+ */
+struct position {
+    /**
+     *  @brief  The beginning.
+     */
+    std::size_t begin;
+
+    /**
+     *  @brief  The length.
+     */
+    std::size_t length;
+
+    /**
+     *  @brief  The pointer (0..length).
+     */
+    std::size_t pointer;
+};
+
+/**
+ *  @brief  Type or severity of message.
+ */
+enum class message_severity {
+    /**
+     *  @brief  Uninitialized.
+     */
+    unknown,
+    /**
+     *  @brief  A note message.
+     */
+    note,
+    /**
+     *  @brief  A warning message.
+     */
+    warning,
+    /**
+     *  @brief  An error message.
+     */
+    error
+};
+
+/**
+ *  @brief  The information.
+ */
+struct message {
+
+    /**
+     *  @brief  The message (multi-line string).
+     */
+    std::string msg;
+
+    /**
+     *  @brief  The severity of the message.
+     */
+    message_severity severity;
+
+    /**
+     *  @brief  The position of the fault.
+     */
+    position pos;
+
+};
+
+/**
+ *  @brief  The type of token.
+ */
+enum class token_type {
+    /**
+     *  @brief  Numerical literal starts with 0-9 and can contain `.` or
+     *          `'`.
+     *
+     *  Numerical literal starts with 0-9 and can contain `.` or `'`.
+     *  There cannot be more than one `.`.
+     *
+     *  Numerical literals can be represented in 4 different types:
+     *  - Decimal: `123`, `4.56`, etc.
+     *  - Decimal (alternative): `0d123`, `0d4.56`, etc.
+     *  - Binary: `0b101`, `0b110.011`, etc.
+     *  - Octal: `0o174`, `0o23.5`, etc.
+     *  - Hexadecimal: `0x14b`, `3d.7a`, etc.
+     */
+    numerical_literal,
+    /**
+     *  @brief  Single character enclosed in `'` (unless it is an escape
+     *          sequence).
+     *
+     *  Single character enclosed in `'` (unless it is an escape sequence).
+     *
+     *  Escape sequences:
+     *  - '\\': Escape `\`.
+     *  - '\'': Escape `'`.
+     *  - '\"': Escape `"`.
+     *  - '\a': Bell (Ascii: 7).
+     *  - '\b': Backspace (Ascii: 8).
+     *  - '\e': Escape (Ascii: 27).
+     *  - '\f': Form Feed (Ascii: 12).
+     *  - '\n': New Line (Ascii: 10).
+     *  - '\r': Carriage Return (Ascii: 13).
+     *  - '\t': Horizontal Tab (Ascii: 9).
+     *  - '\v': Vertical Tab (Ascii: 11).
+     *
+     *  Incorporating numbers in characters:
+     *  - '\NNN': Decimal number.
+     *  - '\dNNN': Alternative way for decimal number.
+     *  - '\iNNN': Binary number.
+     *  - '\oNNN': Octal number.
+     *  - '\xNNN': Hexadecimal number.
+     *
+     *  Empty character: '\;'.  Represents nothing, has nothing, not even null
+     *  character.  It's just, nothing.  Hence actually writing '\;' will result
+     *  in a syntax error.  But doing 'a\;' results in 'a'.
+     */
+    char_literal,
+    /**
+     *  @brief  Multiple characters enclosed in `"`.
+     */
+    string_literal,
+    /**
+     *  @brief  Character or group of characters that are valid operators.
+     *
+     *  Valid operators are character or group of character that are any of
+     *  `~`, `!`, `%`, `^`, `&`, `*`, `-`, `+`, `=`, `[`, `]`, `\`, `|`,
+     *  `:`, `<`, `>`, `/` or `?`.
+     */
+    operator_,
+    /**
+     *  @brief  A single character that is of a valid punctuation.
+     *
+     *  Valid punctuation is a character that is any of `@`, `$`, `(`, `)`,
+     *  `{`, `}`, `;`, `,` or `.`.
+     */
+    punctuation,
+    /**
+     *  @brief  A name of variable, function, structure, or even keywords.
+     *
+     *  Identifier must start with a-z, A-Z or _, and can have 0-9 in the
+     *  continuation.
+     */
+    identifier
+};
+
+/**
+ *  @brief  The smallest unit, besides a character.
+ */
+struct token {
+
+    /**
+     *  @brief  The type of token.
+     */
+    token_type type;
+
+    /**
+     *  @brief  The value of the token.
+     */
+    std::variant<std::monostate, float, std::string, char> value;
+};
+
+/**
+ *  @brief  The part of the replaced @c detronade that the lexer uses.
+ */
+struct detronade {
+
+    /**
+     *  @brief  The entire source code.
+     */
+    std::string source_code;
+
+    /**
+     *  @brief  All the messages regarding the source code.
+     */
+    std::vector<message> messages;
+
+    /**
+     *  @brief  Tokenize the source.
+     *  @return  Individual tokens of the source.
+     */
+    [[nodiscard]] auto tokenize() -> std::optional<std::vector<token>>;
+};
+
+/**
+ *  @brief  Convert the string to a real.
+ *
+ *  @param  messages        The list of messages to append to.
+ *  @param  begin           The beginning of the string.
+ *  @param  string          The string to convert to a real.
+ *  @param  is_escape_code  Whether the string is from an escape code.
+ *  @return  Real number converted from string.
+ */
+[[nodiscard]] static inline constexpr auto parse_number(
+    std::vector<message> &messages,
+    std::size_t           begin,
+    std::string           string,
+    bool                  is_escape_code = false
+) -> std::optional<float>
+{
+    std::size_t start = 0;
+    float       base  = 10;
+
+    string = sm::to_lower(string);
+
+    if (is_escape_code)
+    {
+        if (string.starts_with("\\d"))
+        {
+            start = 2;
+        }
+        else if (string.starts_with("\\i"))
+        {
+            base  = 2;
+            start = 2;
+        }
+        else if (string.starts_with("\\o"))
+        {
+            base  = 8;
+            start = 2;
+        }
+        else if (string.starts_with("\\x"))
+        {
+            base  = 16;
+            start = 2;
+        }
+        else if (string.starts_with("\\"))
+        {
+            start = 1;
+        }
+    }
+    else
+    {
+        if (string.starts_with("0d"))
+        {
+            start = 2;
+        }
+        else if (string.starts_with("0b"))
+        {
+            base  = 2;
+            start = 2;
+        }
+        else if (string.starts_with("0o"))
+        {
+            base  = 8;
+            start = 2;
+        }
+        else if (string.starts_with("0x"))
+        {
+            base  = 16;
+            start = 2;
+        }
+    }
+
+    std::string base_name;
+
+    switch ((int)std::round(base))
+    {
+        case 2: base_name  = "binary"; break;
+        case 8: base_name  = "octal"; break;
+        case 10: base_name = "decimal"; break;
+        case 16: base_name = "hexadecimal"; break;
+        default: base_name = "unknown";
+    }
+
+    // Eliminate invalid digits
+    std::string digits   = "0123456789abcdef"s.substr(0, base);
+    std::string filtered = "";
+    std::size_t point    = std::string::npos;
+
+    for (std::size_t i = start; i < string.size(); i++)
+    {
+        auto pos = digits.find(string[i]);
+        if (pos != std::string::npos)
+        {
+            filtered += string[i];
+            continue;
+        }
+
+        if (!is_escape_code && string[i] == '.')
+        {
+            if (point == std::string::npos)
+            {
+                point = filtered.size();
+                continue;
+            }
+
+            auto msg = std::format("Multiple decimal points in {}",
+                is_escape_code
+                ? base_name + " escape code"
+                : base_name + " numerical literal");
+            messages.emplace_back(message {
+                .msg         = msg,
+                .severity    = message_severity::error,
+                .pos         = {
+                    .begin   = begin,
+                    .length  = string.length(),
+                    .pointer = i
+                }
+            });
+            return std::nullopt;
+        }
+
+        if (!is_escape_code && string[i] == '\'')
+        {
+            continue;
+        }
+
+        auto msg = std::format("Invalid character {}`{}`{} in {}",
+            bold + white, string[i], !(bold + white),
+            is_escape_code
+            ? base_name + " escape code"
+            : base_name + " numerical literal");
+        messages.emplace_back(message {
+            .msg         = msg,
+            .severity    = message_severity::error,
+            .pos         = {
+                .begin   = begin,
+                .length  = string.length(),
+                .pointer = i
+            }
+        });
+        return std::nullopt;
+    }
+
+    float result = 0;
+    for (auto &c : filtered)
+    {
+        auto pos = digits.find(c);
+        result  *= base;
+        result  += pos;
+    }
+
+    if (!is_escape_code && point != std::string::npos)
+    {
+        auto exp = filtered.size() - point;
+        result  /= std::pow<float>(base, exp);
+    }
+
+    return result;
+}
+
+/**
+ *  @brief  Evaluate the escape code.
+ *
+ *  @param  messages   The list of messages to append to.
+ *  @param  src        The boundless source code.
+ *  @param  index      The current char in the source code that has `\`.
+ *  @return  Character representing the escape code.
+ */
+[[nodiscard]] static inline constexpr auto parse_escape_code(
+    std::vector<message>      &messages,
+    cu::boundless_string_view &src,
+    std::size_t               &index
+) -> std::optional<std::variant<std::monostate, char>>
+{
+    std::size_t begin = index;
+    index++;
+    char c = src[index];
+    index++;
+
+    switch (c)
+    {
+        case '\\':
+        case '\'':
+        case '\"':
+            return c;
+        case ';':
+            return std::monostate {};
+
+        case 'a': return '\a';
+        case 'b': return '\b';
+        case 'e': return '\e';
+        case 'f': return '\f';
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 't': return '\t';
+        case 'v': return '\v';
+        default:
+        {
+            auto msg = std::format("Unexpected EOF");
+            messages.emplace_back(message {
+                .msg         = msg,
+                .severity    = message_severity::error,
+                .pos         = {
+                    .begin   = begin,
+                    .length  = index - begin + 1,
+                    .pointer = index - begin
+                }
+            });
+            return std::nullopt;
+        }
+    }
+
+    int base = 0;
+
+    switch (c)
+    {
+        case 'd':
+        case '0' ... '9':
+            base = 10;
+            break;
+
+        case 'i': base = 2; break;
+        case 'o': base = 8; break;
+        case 'x': base = 16; break;
+    }
+
+    if (base == 0)
+    {
+        auto msg = std::format("Invalid character {}`{}`{} in escape code",
+            bold + white, src[index], !(bold + white));
+        messages.emplace_back(message {
+            .msg         = msg,
+            .severity    = message_severity::error,
+            .pos         = {
+                .begin   = begin,
+                .length  = index - begin + 1,
+                .pointer = index - begin
+            }
+        });
+        return std::nullopt;
+    }
+
+    std::string digits = "0123456789abcdef"s.substr(0, base);
+    while (digits.contains(std::tolower(src[index])))
+    {
+        index++;
+    }
+
+    auto result = parse_number(messages, begin,
+        std::string(src.substr(begin, index - begin)), true);
+
+    if (!result.has_value())
+    {
+        return std::nullopt;
+    }
+
+    auto value = result.value();
+    if (value > 255)
+    {
+        auto msg = std::format("Number {}`{}`{} too large for character",
+            bold + white, value, !(bold + white));
+        messages.emplace_back(message {
+            .msg         = msg,
+            .severity    = message_severity::warning,
+            .pos         = {
+                .begin   = begin,
+                .length  = index - begin,
+                .pointer = 0
+            }
+        });
+    }
+
+    return (char)value;
+}
+
+/**
+ *  @brief  Parse string literal.
+ *
+ *  @param  messages   The list of messages to append to.
+ *  @param  src        The boundless source code.
+ *  @param  index      The current char (enclosing char) in the source code.
+ *  @param  encloser   The character that encloses a string.
+ *  @return constexpr auto
+ */
+[[nodiscard]] static inline constexpr auto parse_string(
+    std::vector<message>      &messages,
+    cu::boundless_string_view &src,
+    std::size_t               &index,
+    char                       encloser
+) -> std::optional<std::string>
+{
+    std::size_t begin = index;
+    std::string value = "";
+    index++;
+
+    while (src[index] != encloser)
+    {
+        if (src[index] == '\0')
+        {
+            auto msg = std::format("Unexpected EOF");
+            messages.emplace_back(message {
+                .msg         = msg,
+                .severity    = message_severity::error,
+                .pos         = {
+                    .begin   = begin,
+                    .length  = index - begin + 1,
+                    .pointer = index - begin
+                }
+            });
+            return std::nullopt;
+        }
+
+        if (src[index] == '\\')
+        {
+            auto escape_code = parse_escape_code(messages, src, index);
+            if (!escape_code.has_value())
+            {
+                return std::nullopt;
+            }
+
+            // No character
+            if (std::holds_alternative<std::monostate>(
+                escape_code.value()))
+            {
+                continue;
+            }
+            value += std::get<char>(escape_code.value());
+        }
+        else
+        {
+            value += src[index];
+            index++;
+        }
+    }
+    index++;
+
+    return value;
+}
+
+/**
+ *  @brief  Tokenize the source code.
+ *  @return  Individual tokens of the source code.
+ */
+[[nodiscard]] auto detronade::tokenize()
+-> std::optional<std::vector<token>>
+{
+    std::vector<token>        tokens = {};
+    cu::boundless_string_view src    = std::string_view(source_code);
+
+    const std::string whitespaces  = " \t\n\r\f\v";
+    const std::string operators    = "~!%^&*-+=[]\\|:<>/?";
+    const std::string punctuations = "@$(){};,.";
+
+    // Is this inefficient?  Yes.  Does it matter?  No
+    const std::string id_start
+        = "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    const std::string num_start    = "0123456789";
+    const std::string id_continue  = id_start + num_start;
+    const std::string num_continue = num_start + id_continue + ".'";
+
+    // Do not need to worry about out of bounds in boundless sv!
+    std::size_t index = 0;
+    while (src[index] != '\0')
+    {
+        if (whitespaces.contains(src[index]))
+        {
+            while (whitespaces.contains(src[index]))
+            {
+                index++;
+            }
+        }
+        // Skip comment
+        else if (src[index] == '#')
+        {
+            do
+            {
+                index++;
+            }
+            while (src[index] != '\n' && src[index] != '\0');
+            index++;
+        }
+        else if (src[index] == '\'')
+        {
+            std::size_t begin  = index;
+            auto        string = parse_string(messages, src, index, '\'');
+            if (!string.has_value())
+            {
+                return std::nullopt;
+            }
+
+            if (string.value().size() > 1)
+            {
+                auto msg = std::format("Too many characters in char literal");
+                messages.emplace_back(message {
+                    .msg         = msg,
+                    .severity    = message_severity::error,
+                    .pos         = {
+                        .begin   = begin,
+                        .length  = index,
+                        .pointer = 2
+                    }
+                });
+                return std::nullopt;
+            }
+
+            if (string.value().size() < 1)
+            {
+                auto msg = std::format("Char literal cannot be empty");
+                messages.emplace_back(message {
+                    .msg         = msg,
+                    .severity    = message_severity::error,
+                    .pos         = {
+                        .begin   = begin,
+                        .length  = 2,
+                        .pointer = 1
+                    }
+                });
+                return std::nullopt;
+            }
+
+            tokens.emplace_back(token {
+                .type  = token_type::char_literal,
+                .value = string.value().front()
+            });
+        }
+        else if (src[index] == '\"')
+        {
+            auto string = parse_string(messages, src, index, '\"');
+            if (!string.has_value())
+            {
+                return std::nullopt;
+            }
+
+            tokens.emplace_back(token {
+                .type  = token_type::string_literal,
+                .value = string.value()
+            });
+        }
+        else if (num_start.contains(src[index]))
+        {
+            std::size_t begin = index;
+            index++;
+
+            while (num_continue.contains(src[index]))
+            {
+                index++;
+            }
+
+            auto parsed_num = parse_number(messages, begin,
+                std::string(src.substr(begin, index - begin)));
+            if (!parsed_num.has_value())
+            {
+                return std::nullopt;
+            }
+
+            tokens.emplace_back(token {
+                .type  = token_type::numerical_literal,
+                .value = parsed_num.value()
+            });
+        }
+        else if (id_start.contains(src[index]))
+        {
+            std::size_t begin = index;
+            index++;
+
+            while (id_continue.contains(src[index]))
+            {
+                index++;
+            }
+
+            tokens.emplace_back(token {
+                .type  = token_type::identifier,
+                .value = std::string(src.substr(begin, index - begin))
+            });
+        }
+        else if (operators.contains(src[index]))
+        {
+            std::size_t begin = index;
+            index++;
+
+            while (operators.contains(src[index]))
+            {
+                index++;
+            }
+
+            tokens.emplace_back(token {
+                .type  = token_type::operator_,
+                .value = std::string(src.substr(begin, index - begin))
+            });
+        }
+        else if (punctuations.contains(src[index]))
+        {
+            while (punctuations.contains(src[index]))
+            {
+                tokens.emplace_back(token {
+                    .type  = token_type::punctuation,
+                    .value = src[index]
+                });
+                index++;
+            }
+        }
+        else
+        {
+            auto msg = std::format("Invalid character {}`{}`{} in source code",
+                bold + white, src[index], !(bold + white));
+            messages.emplace_back(message {
+                .msg         = msg,
+                .severity    = message_severity::error,
+                .pos         = {
+                    .begin   = index,
+                    .length  = 1,
+                    .pointer = 0
+                }
+            });
+            return std::nullopt;
+        }
+    }
+
+    return tokens;
+}
+
+} // namespace baseline
+
+/**
+ *  @brief  Make a layout script of about the size.
+ *
+ *  @param  size  The size of the script in bytes.
+ *  @return  The script.
+ */
+[[nodiscard]] static auto make_script(std::size_t size)
+{
+    std::string script = {};
+    for (std::size_t i = 0; script.size() < size; i++)
+    {
+        script += std::format(
+            "real column_{} = parent_width * 0.{} + margin[{}] # column\n"
+            "char[] label_{} = \"Item\\t{}\"\n"
+            "if (column_{} >= 120.5 && visible)\n"
+            "    offset_{} += (spacing - 4) ** 2 // 3\n",
+            i, i % 10, i % 7, i, i, i, i);
+    }
+    return script;
+}
+
+/**
+ *  @brief  Measure the fastest of a few runs of the function.
+ *
+ *  @param  function  The function to run.
+ *  @return  The time of the fastest run in seconds, and the number of
+ *           tokens it made.
+ */
+template <typename F>
+[[nodiscard]] static auto measure(F function)
+{
+    double      best   = 1e30;
+    std::size_t tokens = 0;
+    for (std::size_t run = 0; run < 5; run++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        tokens     = function();
+        auto end   = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - begin)
+            .count());
+    }
+    return std::pair { best, tokens };
+}
+
+/**
+ *  @brief  Compare the lexers on a large layout script.
+ *  @return  Zero on success.
+ */
+auto main() -> int
+{
+    auto script    = make_script(16 * 1024 * 1024);
+    auto megabytes = static_cast<double>(script.size()) / (1024 * 1024);
+
+    auto [old_time, old_tokens] = measure([&]()
+    {
+        baseline::detronade dtn = { .source_code = script };
+        auto tokens = dtn.tokenize();
+        return tokens.has_value() ? tokens->size() : 0;
+    });
+
+    auto lex = [&](std::size_t threads)
+    {
+        return measure([&]()
+        {
+            dtn::detronade dtn("bench", script);
+            dtn.options.threads = threads;
+            auto tokens = dtn.tokenize();
+            return tokens.has_value() ? tokens->size() : 0;
+        });
+    };
+    auto [serial_time, serial_tokens]     = lex(1);
+    auto [parallel_time, parallel_tokens] = lex(0);
+
+    std::println("Script: {:.1f} MB", megabytes);
+    std::println("Replaced lexer:     {:8.1f} MB/s, {} tokens",
+        megabytes / old_time, old_tokens);
+    std::println("Lexer:              {:8.1f} MB/s, {} tokens, {:.1f}x",
+        megabytes / serial_time, serial_tokens, old_time / serial_time);
+    std::println("Lexer (threads):    {:8.1f} MB/s, {} tokens, {:.1f}x",
+        megabytes / parallel_time, parallel_tokens,
+        old_time / parallel_time);
+
+    return serial_tokens == parallel_tokens && serial_tokens != 0 ? 0 : 1;
+}
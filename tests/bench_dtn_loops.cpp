@@ -0,0 +1,151 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Measure what hoisting expressions out of loops saves in Detronade
+ *           scripts.
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <print>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "plons_detronade.hpp"
+
+namespace dtn = plons::dtn;
+
+using namespace std::string_literals;
+
+/**
+ *  @brief  Loop-heavy scripts, with their names.
+ */
+static constexpr auto scripts = std::to_array<
+    std::pair<std::string_view, std::string_view>>({
+    {
+        "Invariant builtin call",
+        "real k = 3\n"
+        "real m = 4\n"
+        "real sum = 0\n"
+        "for (int i = 0; i < 2000000; i++)\n"
+        "    sum += sqrt(k * k + m * m) * (k + m) + i\n"
+        "sum"
+    },
+    {
+        "Repeated subexpression",
+        "real x = 1.5\n"
+        "real y = 2.5\n"
+        "real total = 0\n"
+        "for (int i = 0; i < 2000000; i++)\n"
+        "    total += sqrt(x * i + y * y) + sqrt(x * i + y * y) * y\n"
+        "total"
+    },
+    {
+        "Nested layout loops",
+        "real width = 800\n"
+        "real margin = 12\n"
+        "int columns = 7\n"
+        "real offset = 0\n"
+        "int row = 0\n"
+        "while (row < 300000)\n"
+        "    for (int c = 0; c < columns; c++)\n"
+        "        offset += ((width - margin * (columns + 1)) / columns * c\n"
+        "                   + margin * (c + 1))\n"
+        "    row++\n"
+        "offset"
+    }
+});
+
+/**
+ *  @brief  Measure the fastest of a few runs of the script.
+ *
+ *  @param  script  The script.
+ *  @param  hoist   Whether to hoist expressions.
+ *  @return  The time of the fastest run in seconds, and the result.
+ */
+[[nodiscard]] static auto measure(std::string_view script, bool hoist)
+{
+    dtn::detronade dtn("bench", script);
+    dtn.options.hoist_expressions = hoist;
+    dtn.compile();
+    if (!dtn.compilation_successful)
+    {
+        dtn.print_messages();
+        return std::pair { 0.0, ""s };
+    }
+
+    double      best   = 1e30;
+    std::string result = {};
+    for (std::size_t run = 0; run < 3; run++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        auto value = dtn.run();
+        auto end   = std::chrono::steady_clock::now();
+        best   = std::min(best, std::chrono::duration<double>(end - begin)
+            .count());
+        result = value.has_value() ? dtn::to_string(value.value()) : ""s;
+    }
+    return std::pair { best, result };
+}
+
+/**
+ *  @brief  Run the scripts with and without hoisting expressions.
+ *  @return  Zero on success.
+ */
+auto main() -> int
+{
+    int status = 0;
+    for (auto [name, script] : scripts)
+    {
+        auto [plain_time, plain_result]     = measure(script, false);
+        auto [hoisted_time, hoisted_result] = measure(script, true);
+        if (plain_result.empty() || plain_result != hoisted_result)
+        {
+            std::println("{}: results differ ({} and {})", name,
+                plain_result, hoisted_result);
+            status = 1;
+            continue;
+        }
+
+        std::println("{}: {:.1f} ms -> {:.1f} ms, {:.2f}x", name,
+            plain_time * 1000, hoisted_time * 1000,
+            plain_time / hoisted_time);
+    }
+    return status;
+}
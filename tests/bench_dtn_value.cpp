@@ -0,0 +1,193 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Compare the NaN-boxed value of Detronade with a value based on
+ *           std::variant.
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <print>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "plons_detronade.hpp"
+
+namespace dtn = plons::dtn;
+
+/**
+ *  @brief  A value in the style of @c dtn::token , which holds numbers in a
+ *          @c std::variant and refers to arrays with a @c std::shared_ptr .
+ */
+struct variant_value {
+    /**
+     *  @brief  The value.
+     */
+    std::variant<std::monostate, double, std::int32_t, bool, char,
+        std::shared_ptr<std::vector<variant_value>>> data = {};
+};
+
+/**
+ *  @brief  Number of values in each benchmark.
+ */
+static constexpr std::size_t count = 1 << 20;
+
+/**
+ *  @brief  Keeps the results of the benchmarks from being optimized away.
+ */
+static volatile double sink = 0.0;
+
+/**
+ *  @brief  Measure the fastest of a few runs of the function.
+ *
+ *  @param  function  The function to run over @c count values.
+ *  @return  The time of the fastest run in nanoseconds per value.
+ */
+template <typename F>
+[[nodiscard]] static auto measure(F function)
+{
+    double best = 1e30;
+    for (std::size_t run = 0; run < 5; run++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        function();
+        auto end   = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(
+            end - begin).count());
+    }
+    return best / count;
+}
+
+/**
+ *  @brief  Print the times of a benchmark.
+ *
+ *  @param  name          Name of the benchmark.
+ *  @param  boxed_time    Time of the NaN-boxed value.
+ *  @param  variant_time  Time of the variant-based value.
+ */
+static auto report(const char *name, double boxed_time, double variant_time)
+{
+    std::println("{:<18} {:6.2f} ns {:6.2f} ns {:6.2f}x", name, boxed_time,
+        variant_time, variant_time / boxed_time);
+}
+
+/**
+ *  @brief  Run the microbenchmarks for both values.
+ *  @return  Zero on success.
+ */
+auto main() -> int
+{
+    std::println("{:<18} {:>9} {:>9}", "", "NaN-boxed", "variant");
+    std::println("{:<18} {:7} B {:7} B", "Size", sizeof(dtn::value),
+        sizeof(variant_value));
+    std::println("{:<18} {:>9} {:>9}", "Trivially copyable",
+        std::is_trivially_copyable_v<dtn::value>,
+        std::is_trivially_copyable_v<variant_value>);
+
+    std::vector<dtn::value>    boxed(count);
+    std::vector<variant_value> variants(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        boxed[i]         = dtn::value(static_cast<double>(i));
+        variants[i].data = static_cast<double>(i);
+    }
+
+    // Registers and stack slots are copied around
+    std::vector<dtn::value>    boxed_copy(count);
+    std::vector<variant_value> variant_copy(count);
+    report("Copy reals", measure([&]()
+    {
+        std::ranges::copy(boxed, boxed_copy.begin());
+    }), measure([&]()
+    {
+        std::ranges::copy(variants, variant_copy.begin());
+    }));
+
+    // Arithmetic checks the type of both operands and stores the result
+    report("Add reals", measure([&]()
+    {
+        for (std::size_t i = 1; i < count; i++)
+        {
+            auto x = boxed[i - 1].get_if<double>();
+            auto y = boxed[i].get_if<double>();
+            if (x.has_value() && y.has_value())
+            {
+                boxed_copy[i] = dtn::value(x.value() + y.value());
+            }
+        }
+        sink = boxed_copy.back().get<double>();
+    }), measure([&]()
+    {
+        for (std::size_t i = 1; i < count; i++)
+        {
+            auto x = std::get_if<double>(&variants[i - 1].data);
+            auto y = std::get_if<double>(&variants[i].data);
+            if (x && y)
+            {
+                variant_copy[i].data = *x + *y;
+            }
+        }
+        sink = std::get<double>(variant_copy.back().data);
+    }));
+
+    // Arrays are shared by reference counting.  The type does not matter
+    // here
+    auto boxed_array   = dtn::value::make_array(dtn::unknown_type, true,
+        std::vector<dtn::value>(4, dtn::value(1.0)));
+    auto variant_array = variant_value {
+        std::make_shared<std::vector<variant_value>>(4,
+            variant_value { 1.0 })
+    };
+    report("Copy arrays", measure([&]()
+    {
+        for (auto &element : boxed_copy)
+        {
+            element = boxed_array;
+        }
+    }), measure([&]()
+    {
+        for (auto &element : variant_copy)
+        {
+            element = variant_array;
+        }
+    }));
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Test the compile cache of Detronade.
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+#include "tester.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <format>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "plons_detronade.hpp"
+
+/**
+ *  @brief  A program with string and array constants, which copies and
+ *          changes them.
+ */
+static constexpr std::string_view cache_source =
+    "char[] s = \"hello\"\n"
+    "char[] t = s\n"
+    "t[0] = 'j'\n"
+    "real[] a = [1.5, 2.5]\n"
+    "a[0] = 3.5\n"
+    "s + t";
+
+/**
+ *  @brief  Compile and run the source code with the compile cache.
+ *
+ *  @param  source  The source code.
+ *  @return  The result as a string, or empty if it did not run.
+ */
+[[nodiscard]] static auto run_cached(std::string_view source)
+{
+    dtn::detronade dtn("test", source);
+    dtn.options.cache = true;
+    dtn.compile();
+    if (!dtn.compilation_successful)
+    {
+        return ""s;
+    }
+
+    auto result = dtn.run();
+    return result.has_value() ? dtn::to_string(result.value()) : ""s;
+}
+
+/**
+ *  @brief  Test the compile cache.
+ *  @return  Number of errors.
+ */
+[[nodiscard]] auto test_dtn_cache() -> std::size_t
+{
+    T_BEGIN;
+
+    auto &cache = dtn::compile_cache::global();
+    cache.clear();
+    cache.set_budget(dtn::compile_cache::default_budget);
+
+    // The second compilation is found, and runs the same
+    T_ASSERT(run_cached(cache_source), "hellojello"s, "First compilation");
+    T_ASSERT(run_cached(cache_source), "hellojello"s, "Cached compilation");
+
+    auto stats = cache.statistics();
+    T_ASSERT(stats.misses, 1uz, "Misses after two compilations");
+    T_ASSERT(stats.hits, 1uz, "Hits after two compilations");
+    T_ASSERT(stats.entries, 1uz, "Entries after two compilations");
+
+    // An instance compiled before keeps its symbols without the cache
+    dtn::detronade again("test", cache_source);
+    again.options.cache = true;
+    again.compile();
+    again.compile();
+    T_ASSERT(again.compilation_successful, true, "Recompilation");
+    T_ASSERT(cache.statistics().hits, 2uz, "Hits after a recompilation");
+
+    // Options that change the program are part of the key
+    dtn::detronade unhoisted("test", cache_source);
+    unhoisted.options.cache             = true;
+    unhoisted.options.hoist_expressions = false;
+    unhoisted.compile();
+    T_ASSERT(unhoisted.compilation_successful, true, "Other options");
+    T_ASSERT(cache.statistics().hits, 2uz, "Hits after other options");
+    T_ASSERT(cache.statistics().entries, 2uz, "Entries of other options");
+
+    // Runtime errors are located with the tokens found in the cache
+    T_ASSERT(run_cached("int[] a = [1]\na[5]"), ""s, "Runtime error");
+    dtn::detronade failing("test", "int[] a = [1]\na[5]");
+    failing.options.cache = true;
+    failing.compile();
+    T_ASSERT(failing.run().has_value(), false, "Cached runtime error");
+    T_ASSERT(failing.messages.size(), 1uz, "Messages of the runtime error");
+    auto out_of_range = failing.messages[0].id
+                     == dtn::message_id::index_out_of_range;
+    T_ASSERT(out_of_range, true, "Message of the runtime error");
+    T_ASSERT(failing.messages[0].pos.begin, 15uz, "Position of the error");
+
+    // The least recently used compilations are evicted
+    for (std::size_t i = 0; i < 16; i++)
+    {
+        T_ASSERT(run_cached(std::format("{}.5 * 2", i)),
+            std::format("{}", i * 2 + 1), "Distinct compilation");
+    }
+    stats = cache.statistics();
+    cache.set_budget(stats.size / 2);
+    auto evicted = cache.statistics();
+    auto fewer   = evicted.entries < stats.entries;
+    auto within  = evicted.size <= evicted.budget;
+    T_ASSERT(fewer, true, "Eviction by budget");
+    T_ASSERT(within, true, "Size within budget");
+
+    cache.set_budget(0);
+    T_ASSERT(cache.statistics().entries, 0uz, "Eviction of everything");
+
+    // Unrelated instances of the same source run on different threads
+    cache.set_budget(dtn::compile_cache::default_budget);
+    std::atomic<std::size_t>  wrong   = 0;
+    std::vector<std::jthread> threads = {};
+    for (std::size_t t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&]()
+        {
+            for (std::size_t i = 0; i < 100; i++)
+            {
+                if (run_cached(cache_source) != "hellojello")
+                {
+                    wrong++;
+                }
+            }
+        });
+    }
+    threads.clear();
+    T_ASSERT(wrong.load(), 0uz, "Results on many threads");
+
+    cache.clear();
+    T_END;
+}
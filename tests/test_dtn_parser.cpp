@@ -0,0 +1,580 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Test the lexer and the parser of Detronade.
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+#include "tester.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "plons_detronade.hpp"
+
+/**
+ *  @brief  Examples from `Detronade.md`, with the variables that they use
+ *          declared before them.
+ */
+static constexpr auto documented_examples = std::to_array<std::string_view>({
+    "1 + 1 # This evaluates to 3, of course!",
+    "3 + 4 * 5 + (6 + 7) * (8 - (9 + 10)) # Parenthesis",
+    "sqrt(11) + log(12, 2) # Functions",
+    "real x = 3\n"
+    "const int y = x + 2\n"
+    "x + y",
+    "7 / 2",
+    "3 ** 2",
+    "7 // 2",
+    "bool is_division_by_zero = false",
+    "char convert_to_number = '2'",
+    "char[] string = \"21455\"",
+    "real a = 6\n"
+    "real b = 3\n"
+    "real c = 0\n"
+    "if (b != 0)\n"
+    "    c = a / b",
+    "real a = 1\n"
+    "real b = 3\n"
+    "real c = 0\n"
+    "if (a > 0)\n"
+    "    c = a - b\n"
+    "else\n"
+    "    c = b - a",
+    "real d = -3\n"
+    "real c = 0\n"
+    "if (d == 0)\n"
+    "    c = 0\n"
+    "else if (d > 0)\n"
+    "    c = sqrt(d)\n"
+    "else\n"
+    "    c = d * d",
+    "real a = 3\n"
+    "real b = 0\n"
+    "while (a > 0)\n"
+    "    b = a * a\n"
+    "    a--",
+    "int j = 0\n"
+    "for (int i = 0; i < 10; i++)\n"
+    "    j = i * i + 2 * i + 3",
+    "int add(int a, int b)\n"
+    "    a + b # Uncaptured expression returns from function\n"
+    "int result = add(2, 4)",
+    "int sub(int a, int b) a - b",
+    "int[5] array # 5 Elements\n"
+    "array[0] = 4 # 0-indexed\n"
+    "\n"
+    "int[] auto_sized_array = [1, 2, 3, 4, 5]",
+    "struct vec2 # Vector 2\n"
+    "    real x # Data\n"
+    "    real y\n"
+    "\n"
+    "    # Method\n"
+    "    real magnitude() sqrt(x * x + y * y)\n"
+    "\n"
+    "    vec2 rotated(real angle)\n"
+    "        vec2(x * cos(angle) - y * sin(angle),\n"
+    "             x * sin(angle) + y * cos(angle))\n"
+    "vec2 position = vec2(1, 5)\n"
+    "position.x += 2\n"
+    "position.y -= 1\n"
+    "real distance_from_center = position.magnitude() # 5",
+    "struct vec2\n"
+    "    real x, y\n"
+    "\n"
+    "    construct()\n"
+    "        void\n"
+    "\n"
+    "    construct(real _x, real _y)\n"
+    "        x = _x\n"
+    "        y = _y\n"
+    "\n"
+    "    construct(real z)\n"
+    "        x = z\n"
+    "        y = z\n"
+    "\n"
+    "    destruct()\n"
+    "        void",
+    "struct vec2\n"
+    "    real x, y\n"
+    "    real magnitude() sqrt(x * x + y * y)\n"
+    "vec2 operator(vec2 a + vec2 b) vec2(a.x + b.x, a.y + b.y)\n"
+    "vec2 operator(vec2 a - vec2 b) vec2(a.x - b.x, a.y - b.y)\n"
+    "real operator(^-^vec2 v) return v.magnitude()\n"
+    "vec2 a = vec2(3, 5)\n"
+    "vec2 b = vec2(1, 7)\n"
+    "vec2 c = a + b\n"
+    "real speed = ^-^c",
+    "struct int_arr\n"
+    "    int[] array\n"
+    "\n"
+    "    construct(int count)\n"
+    "        array = int[5]()\n"
+    "\n"
+    "    int count() array.count()\n"
+    "\n"
+    "int operator(int_arr array [ int index ]) array.array[index]\n"
+    "int_arr array = int_arr(5)\n"
+    "int length = array.count()\n"
+    "array[length - 1]"
+});
+
+/**
+ *  @brief  A source code with every kind of token, which is repeated to
+ *          make larger sources.
+ */
+static constexpr std::string_view token_source =
+    "real x = 3.25 # comment\n"
+    "int y = x + 2\n"
+    "char c = 'a'\n"
+    "char[] s = \"ab\\ncd\" + \"xy\"\n"
+    "while (x > 0)\n"
+    "    y = x ** 2 // 3\n"
+    "    x--\n";
+
+/**
+ *  @brief  Check if the tokens of two compilations are the same, including
+ *          their positions, symbols and literals.
+ *
+ *  @param  a  A compilation.
+ *  @param  b  Another compilation.
+ *  @return  True if the tokens are the same.
+ */
+[[nodiscard]] static auto same_tokens(
+    const dtn::detronade &a,
+    const dtn::detronade &b
+)
+{
+    if (a.tokens.size() != b.tokens.size())
+    {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < a.tokens.size(); i++)
+    {
+        auto &x = a.tokens[i];
+        auto &y = b.tokens[i];
+        if (x.type != y.type || x.length != y.length
+         || a.offset(i) != b.offset(i))
+        {
+            return false;
+        }
+
+        switch (x.type)
+        {
+            using enum dtn::token_type;
+            case identifier:
+            case operator_:
+                if (a.symbols.name(a.symbol(x)) != b.symbols.name(b.symbol(y)))
+                {
+                    return false;
+                }
+                break;
+            case numerical_literal:
+                if (a.number_value(x) != b.number_value(y))
+                {
+                    return false;
+                }
+                break;
+            case string_literal:
+                if (a.string_value(i) != b.string_value(i))
+                {
+                    return false;
+                }
+                break;
+            default:
+                if (x.value != y.value)
+                {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ *  @brief  Tokenize the source code with a cursor, which recovers from
+ *          lexical errors as @c dtn::detronade::edit does.
+ *
+ *  @param  dtn  The source code's information.
+ *  @return  The tokens that were lexed.
+ */
+[[nodiscard]] static auto recovered_tokens(dtn::detronade &dtn)
+{
+    std::vector<dtn::token> tokens = {};
+    dtn::token_cursor       cursor(dtn);
+    while (auto tok = cursor.next())
+    {
+        tokens.emplace_back(tok.value());
+    }
+    return tokens;
+}
+
+/**
+ *  @brief  Check if the messages of two compilations are the same,
+ *          including their positions and arguments.
+ *
+ *  @param  a  A compilation.
+ *  @param  b  Another compilation.
+ *  @return  True if the messages are the same.
+ */
+[[nodiscard]] static auto same_messages(
+    const dtn::detronade &a,
+    const dtn::detronade &b
+)
+{
+    return stdr::equal(a.messages, b.messages,
+        [](const dtn::message &x, const dtn::message &y)
+        {
+            return x.id == y.id && x.severity == y.severity
+                && x.pos.begin == y.pos.begin && x.pos.length == y.pos.length
+                && x.pos.pointer == y.pos.pointer && x.args == y.args;
+        });
+}
+
+/**
+ *  @brief  Count the literals that the tokens refer to, and check that
+ *          every other slot of the literals is free.
+ *
+ *  @param  dtn  The compilation.
+ *  @return  True if no literal slot is lost.
+ */
+[[nodiscard]] static auto literals_reclaimed(const dtn::detronade &dtn)
+{
+    std::size_t numbers = 0;
+    std::size_t strings = 0;
+    for (auto &tok : dtn.tokens)
+    {
+        if (tok.type == dtn::token_type::numerical_literal)
+        {
+            numbers++;
+        }
+        else if (tok.type == dtn::token_type::string_literal
+              && std::holds_alternative<std::uint32_t>(tok.value))
+        {
+            strings++;
+        }
+    }
+
+    return dtn.numbers.size() == numbers + dtn.free_numbers.size()
+        && dtn.decoded_strings.size() == strings + dtn.free_strings.size();
+}
+
+/**
+ *  @brief  Write a node and the nodes it contains as nested lists, like
+ *          `(add a (multiply b c))`.
+ *
+ *  @param  dtn  The parsed source code.
+ *  @param  n    The node.
+ *  @return  The node as a string.
+ */
+[[nodiscard]] static auto render(
+    const dtn::detronade &dtn,
+    dtn::node_index       n
+) -> std::string
+{
+    auto &t    = dtn.tree[n];
+    auto  list = [&](std::string text, auto nodes)
+    {
+        for (auto c : nodes)
+        {
+            text += " " + render(dtn, c);
+        }
+        return "(" + text + ")";
+    };
+
+    switch (t.kind)
+    {
+        using enum dtn::node_kind;
+        case name: return std::string(dtn.symbols.name(t.a));
+        case number: return std::string(dtn.text(t.token));
+        case unary:
+            return list("prefix " + dtn::to_string(t.op), std::array { t.a });
+        case postfix:
+            return list("postfix " + dtn::to_string(t.op), std::array { t.a });
+        case binary:
+            return list(dtn::to_string(t.op), std::array { t.a, t.b });
+        case assign: return list("assign"s, std::array { t.a, t.b });
+        case call:
+            return list("call " + render(dtn, t.a), dtn.tree.list(t));
+        case subscript: return list("subscript"s, std::array { t.a, t.b });
+        case member:
+            return "(member " + render(dtn, t.a) + " "
+                 + std::string(dtn.symbols.name(t.b)) + ")";
+        default: return dtn::to_string(t.kind);
+    }
+}
+
+/**
+ *  @brief  Parse a source code of one expression statement.
+ *
+ *  @param  source  The source code.
+ *  @return  The expression from @c render , or empty if it did not parse.
+ */
+[[nodiscard]] static auto parse_tree(std::string_view source)
+{
+    dtn::detronade dtn("test", source);
+    dtn.line_starts = dtn::index_lines(dtn.source());
+    auto tokens     = dtn.tokenize();
+    if (!tokens.has_value())
+    {
+        return ""s;
+    }
+
+    dtn.tokens = std::move(tokens.value());
+    auto tree  = dtn.parse();
+    if (!tree.has_value())
+    {
+        return ""s;
+    }
+
+    dtn.tree        = std::move(tree.value());
+    auto statements = dtn.tree.list(dtn.tree[dtn.tree.root]);
+    if (statements.size() != 1
+     || dtn.tree[statements[0]].kind != dtn::node_kind::expression)
+    {
+        return ""s;
+    }
+    return render(dtn, dtn.tree[statements[0]].a);
+}
+
+/**
+ *  @brief  Compile the source code and collect the IDs of its messages.
+ *
+ *  @param  source          The source code.
+ *  @param  recover_errors  Whether to recover from errors.
+ *  @param  max_errors      Maximum number of errors.
+ *  @return  IDs of the messages, separated by spaces.
+ */
+[[nodiscard]] static auto message_ids(
+    std::string_view source,
+    bool             recover_errors,
+    std::size_t      max_errors = 100
+)
+{
+    dtn::detronade dtn("test", source);
+    dtn.options.recover_errors = recover_errors;
+    dtn.options.max_errors     = max_errors;
+    dtn.compile();
+
+    std::string ids = {};
+    for (auto &msg : dtn.messages)
+    {
+        ids += (ids.empty() ? "" : " ") + dtn::to_string(msg.id);
+    }
+    return ids;
+}
+
+/**
+ *  @brief  Test the lexer and the parser.
+ *  @return  Number of errors.
+ */
+[[nodiscard]] auto test_dtn_parser() -> std::size_t
+{
+    T_BEGIN;
+
+    // The documented examples are valid
+    for (auto example : documented_examples)
+    {
+        dtn::detronade dtn("test", example);
+        dtn.compile();
+        T_ASSERT_FMT(dtn.compilation_successful, true,
+            "Documented example does not compile: {}", example);
+    }
+
+    // Operators bind by their precedence and associativity
+    T_ASSERT(parse_tree("a + b * c"), "(add a (multiply b c))"s,
+        "Precedence of multiplication");
+    T_ASSERT(parse_tree("(a + b) * c"), "(multiply (add a b) c)"s,
+        "Parenthesized addition");
+    T_ASSERT(parse_tree("a - b - c"), "(subtract (subtract a b) c)"s,
+        "Left associativity");
+    T_ASSERT(parse_tree("a ** b ** c"), "(power a (power b c))"s,
+        "Right associativity of power");
+    T_ASSERT(parse_tree("a = b = c"), "(assign a (assign b c))"s,
+        "Right associativity of assignment");
+    T_ASSERT(parse_tree("a < b == c && d"),
+        "(logical_and (equal (less a b) c) d)"s, "Precedence of comparisons");
+    T_ASSERT(parse_tree("-a * b"), "(multiply (prefix subtract a) b)"s,
+        "Prefix operator before multiplication");
+    T_ASSERT(parse_tree("-a ** b"), "(prefix subtract (power a b))"s,
+        "Prefix operator after power");
+    T_ASSERT(parse_tree("-a++"), "(prefix subtract (postfix increment a))"s,
+        "Postfix operator before prefix operator");
+
+    // Calls, subscripts and members apply to what is before them
+    T_ASSERT(parse_tree("f()"), "(call f)"s, "Call without arguments");
+    T_ASSERT(parse_tree("f(x, y + 1)"), "(call f x (add y 1))"s,
+        "Call with arguments");
+    T_ASSERT(parse_tree("a[i + 1]"), "(subscript a (add i 1))"s,
+        "Subscript");
+    T_ASSERT(parse_tree("a.b(c)[d].e"),
+        "(member (subscript (call (member a b) c) d) e)"s,
+        "Chain of members, calls and subscripts");
+    T_ASSERT(parse_tree("-f(x).y"), "(prefix subtract (member (call f x) y))"s,
+        "Prefix operator before a chain");
+
+    // Errors are recovered from, up to the maximum
+    constexpr std::string_view syntax_errors =
+        "real x = 1 +\n"
+        "real y = * 2\n"
+        "real z = )\n"
+        "x";
+    T_ASSERT(message_ids(syntax_errors, false), "expected_expression"s,
+        "Syntax errors without recovery");
+    T_ASSERT(message_ids(syntax_errors, true),
+        "expected_expression expected_expression expected_expression"s,
+        "Syntax errors with recovery");
+    T_ASSERT(message_ids(syntax_errors, true, 2),
+        "expected_expression expected_expression too_many_errors"s,
+        "Syntax errors beyond the maximum");
+
+    constexpr std::string_view lexical_errors =
+        "char c = ''\n"
+        "real y = 1.2.3\n"
+        "char d = 'ab'";
+    T_ASSERT(message_ids(lexical_errors, false), "empty_char_literal"s,
+        "Lexical errors without recovery");
+    T_ASSERT(message_ids(lexical_errors, true),
+        "empty_char_literal multiple_decimal_points too_many_characters"s,
+        "Lexical errors with recovery");
+    T_ASSERT(message_ids(lexical_errors, true, 2),
+        "empty_char_literal multiple_decimal_points too_many_errors"s,
+        "Lexical errors beyond the maximum");
+
+    // Numeric escape codes need digits after their base
+    T_ASSERT(message_ids("'\\x'", false), "invalid_escape_digit"s,
+        "Escape code without digits");
+    T_ASSERT(message_ids("\"\\ig\"", false), "invalid_escape_digit"s,
+        "Escape code with an invalid digit");
+    T_ASSERT(message_ids("'\\x41'", false), ""s, "Escape code with digits");
+
+    // Chunks tokenized on many threads make the same tokens
+    std::string large = {};
+    for (std::size_t i = 0; i < 500; i++)
+    {
+        large += token_source;
+    }
+
+    dtn::detronade serial("test", large);
+    dtn::detronade chunked("test", large);
+    chunked.options.threads    = 4;
+    chunked.options.chunk_size = 256;
+    auto serial_tokens  = serial.tokenize();
+    auto chunked_tokens = chunked.tokenize();
+    T_ASSERT(serial_tokens.has_value(), true, "Serial tokens");
+    T_ASSERT(chunked_tokens.has_value(), true, "Chunked tokens");
+    if (serial_tokens.has_value() && chunked_tokens.has_value())
+    {
+        serial.tokens  = std::move(serial_tokens.value());
+        chunked.tokens = std::move(chunked_tokens.value());
+        T_ASSERT(same_tokens(serial, chunked), true, "Chunked tokens");
+    }
+
+    // A cursor over a compiled source code keeps the literals of its tokens
+    dtn::detronade literals("test", "\"a\\tb\"");
+    literals.compile();
+    dtn::token_cursor cursor(literals);
+    T_ASSERT(cursor.next().has_value(), true, "Token of a cursor");
+    T_ASSERT(literals.decoded_strings.size(), std::size_t {2},
+        "Literals after a cursor");
+    T_ASSERT(literals.string_value(0), "a\tb"sv, "Literal after a cursor");
+
+    // Edits make the same tokens as compiling the edited source code
+    constexpr auto pieces = std::to_array<std::string_view>({
+        "x", " ", "\n", "#", "\"", "'", "1", "2.5", "+", "**", "(", ")",
+        "abc", "\\n", "'q'", "\"s\\t\"", "\t", "'\\400'", "\"\\777\""
+    });
+
+    std::mt19937 random(42);
+    for (std::size_t round = 0; round < 20; round++)
+    {
+        // Some rounds begin without valid tokens
+        auto source = round % 4 == 0 ? "'"s + std::string(token_source)
+                                     : std::string(token_source);
+
+        dtn::detronade edited("test", source);
+        edited.options.recover_errors = true;
+        edited.options.max_errors     =
+            std::numeric_limits<std::size_t>::max();
+        edited.compile();
+        for (std::size_t i = 0; i < 30; i++)
+        {
+            auto size  = edited.source_code.size();
+            auto begin = random() % (size + 1);
+            auto end   = begin + random() % 4;
+            auto text  = std::string {};
+            for (auto count = random() % 3; count > 0; count--)
+            {
+                text += pieces[random() % pieces.size()];
+            }
+
+            auto valid = edited.edit(begin, end, text) && edited.rebuild();
+            dtn::detronade full("test", edited.source_code);
+            full.options = edited.options;
+            full.compile();
+            T_ASSERT_FMT(valid, full.compilation_successful,
+                "Validity after editing: {}", edited.source_code);
+            T_ASSERT_FMT(same_messages(edited, full), true,
+                "Messages after editing: {}", edited.source_code);
+
+            // Tokens are patched across lexical errors too
+            dtn::detronade lexed("test", edited.source_code);
+            lexed.options = edited.options;
+            lexed.tokens  = recovered_tokens(lexed);
+
+            auto location = edited.locate(edited.source_code.size());
+            auto expected = full.locate(full.source_code.size());
+            T_ASSERT_FMT(same_tokens(edited, lexed), true,
+                "Tokens after editing: {}", edited.source_code);
+            T_ASSERT_FMT(literals_reclaimed(edited), true,
+                "Literals after editing: {}", edited.source_code);
+            T_ASSERT_FMT(location.line, expected.line,
+                "Lines after editing: {}", edited.source_code);
+        }
+    }
+
+    T_END;
+}
@@ -0,0 +1,541 @@
+/**
+ *  @author  Anstro Pleuton (https://github.com/anstropleuton)
+ *  @brief   Test the bytecode compiler and the VM of Detronade.
+ *
+ *  @copyright  Copyright (c) 2024 Anstro Pleuton
+ *
+ *   ____  _
+ *  |  _ \| | ___  _ __  ___    _    ___ ___ ___    _   _____   __
+ *  | |_) | |/ _ \| '_ \/ __|  | |  |_ _| _ ) _ \  /_\ | _ \ \ / /
+ *  |  __/| | (_) | | | \__ \  | |__ | || _ \   / / _ \|   /\ V /
+ *  |_|   |_|\___/|_| |_|___/  |____|___|___/_|_\/_/ \_\_|_\ |_|
+ *
+ *  Plons Library is a collection of frameworks for Anstro Pleuton's programs.
+ *
+ *  This software is licensed under the terms of MIT License.
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to
+ *  deal in the Software without restriction, including without limitation the
+ *  rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ *  Credits where credit's due:
+ *  - ASCII Art generated using https://www.patorjk.com/software/taag with font
+ *    "Standard" (for "Plons") and "Small" (for "LIBRARY").
+ */
+
+#include "tester.hpp"
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <limits>
+#include <random>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "plons_detronade.hpp"
+
+/**
+ *  @brief  Examples from `Detronade.md` with the results they document.
+ */
+static constexpr auto documented_results = std::to_array<
+    std::pair<std::string_view, std::string_view>>({
+    { "1 + 1", "2" },
+    { "3 + 4 * 5 + (6 + 7) * (8 - (9 + 10))", "-120" },
+    { "real x = 3\nconst int y = x + 2\nx + y", "8" },
+    { "7 / 2", "3.5" },
+    { "3 ** 2", "9" },
+    { "7 // 2", "3" },
+    { "1 / 0", "inf" },
+    { "-1 / 0", "-inf" },
+    { "char[] string = \"21455\"\nstring", "21455" },
+    {
+        "real d = -3\n"
+        "real c = 0\n"
+        "if (d == 0)\n"
+        "    c = 0\n"
+        "else if (d > 0)\n"
+        "    c = sqrt(d)\n"
+        "else\n"
+        "    c = d * d\n"
+        "c",
+        "9"
+    },
+    {
+        "int j = 0\n"
+        "for (int i = 0; i < 10; i++)\n"
+        "    j = i * i + 2 * i + 3\n"
+        "j",
+        "102"
+    },
+    { "int add(int a, int b)\n    a + b\nadd(2, 4)", "6" },
+    { "int sub(int a, int b) a - b\nsub(2, 4)", "-2" },
+    {
+        "int[] array = [1, 2, 3]\n"
+        "int inserted = array.insert(1, 7)\n"
+        "int removed = array.remove(0)\n"
+        "array.count() * 100 + inserted * 10 + removed",
+        "371"
+    },
+    {
+        "struct vec2\n"
+        "    real x\n"
+        "    real y\n"
+        "    real magnitude() sqrt(x * x + y * y)\n"
+        "vec2 position = vec2(1, 5)\n"
+        "position.x += 2\n"
+        "position.y -= 1\n"
+        "position.magnitude()",
+        "5"
+    },
+    {
+        "struct vec2\n"
+        "    real x, y\n"
+        "    real magnitude() sqrt(x * x + y * y)\n"
+        "vec2 operator(vec2 a + vec2 b) vec2(a.x + b.x, a.y + b.y)\n"
+        "vec2 c = vec2(3, 5) + vec2(1, 7)\n"
+        "c.x * 100 + c.y",
+        "412"
+    },
+    {
+        "struct vec2\n"
+        "    real x, y\n"
+        "    real magnitude() sqrt(x * x + y * y)\n"
+        "real operator(^-^vec2 v) return v.magnitude()\n"
+        "vec2 velocity = vec2(20, 21)\n"
+        "^-^velocity",
+        "29"
+    }
+});
+
+/**
+ *  @brief  A function that can be evaluated in batches.
+ */
+static constexpr std::string_view batch_source =
+    "real f(real x, real y) sqrt(x * x + y * y) + sin(x) * y - floor(y / 3)";
+
+/**
+ *  @brief  Compile and run the source code.
+ *
+ *  @param  source     The source code.
+ *  @param  max_depth  Maximum depth of function calls.
+ *  @return  The result as a string, or the ID of the first message if it
+ *           did not run.
+ */
+[[nodiscard]] static auto run_source(
+    std::string_view source,
+    std::size_t      max_depth = 1000
+)
+{
+    dtn::detronade dtn("test", source);
+    dtn.options.max_call_depth = max_depth;
+    dtn.compile();
+
+    auto result = dtn.compilation_successful ? dtn.run() : std::nullopt;
+    if (result.has_value())
+    {
+        return dtn::to_string(result.value());
+    }
+    return dtn.messages.empty() ? ""s : dtn::to_string(dtn.messages[0].id);
+}
+
+/**
+ *  @brief  Compile the source code and list the instructions of a
+ *          function, with the numbers that they load.
+ *
+ *  @param  source   The source code.
+ *  @param  name     The name of the function, or empty for the global
+ *                   scope.
+ *  @param  options  Options for compiling the source code.
+ *  @return  The opcodes separated by spaces, like
+ *           `load_constant(20) return_`, or empty if there is no such
+ *           function.
+ */
+[[nodiscard]] static auto disassemble(
+    std::string_view            source,
+    std::string_view            name    = {},
+    const dtn::compile_options &options = {}
+)
+{
+    dtn::detronade dtn("test", source);
+    dtn.options = options;
+    dtn.compile();
+    if (!dtn.compilation_successful)
+    {
+        return ""s;
+    }
+
+    auto &prog   = *dtn.bytecode;
+    auto  symbol = dtn.symbols.find(name);
+    auto  index  = name.empty() ? prog.main : dtn::no_function;
+    for (std::size_t f = 0; f < prog.functions.size(); f++)
+    {
+        if (!name.empty() && symbol.has_value()
+         && prog.functions[f].symbol == symbol.value()
+         && prog.functions[f].owner == dtn::no_function)
+        {
+            index = static_cast<std::uint32_t>(f);
+        }
+    }
+    if (index == dtn::no_function)
+    {
+        return ""s;
+    }
+
+    std::string listing = {};
+    for (auto &in : prog.functions[index].code)
+    {
+        listing += (listing.empty() ? ""s : " "s) + dtn::to_string(in.op);
+        if (in.op == dtn::opcode::load_constant
+         && !prog.constants[in.bc()].is_object())
+        {
+            listing += std::format("({})",
+                dtn::to_string(prog.constants[in.bc()]));
+        }
+    }
+    return listing;
+}
+
+/**
+ *  @brief  Count the instructions in a listing from @c disassemble .
+ *
+ *  @param  listing      The listing.
+ *  @param  instruction  The instruction, like `add_int` or
+ *                       `load_constant(20)`.
+ *  @return  Number of the instructions.
+ */
+[[nodiscard]] static auto count_of(
+    std::string_view listing,
+    std::string_view instruction
+)
+{
+    std::size_t count = 0;
+    for (auto word : std::views::split(listing, ' '))
+    {
+        if (std::string_view(word) == instruction)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ *  @brief  Write the real as a literal that reads back as the same real.
+ *
+ *  @param  real  The real.
+ *  @return  The literal, with a minus sign if the real is negative.
+ */
+[[nodiscard]] static auto real_literal(double real)
+{
+    std::array<char, 32> buffer = {};
+    auto [end, error] = std::to_chars(buffer.data(),
+        buffer.data() + buffer.size(), real, std::chars_format::fixed);
+    return std::string(buffer.data(), end);
+}
+
+/**
+ *  @brief  Compile and run the source code that results in a real.
+ *
+ *  @param  source  The source code.
+ *  @return  The result, or NaN if it did not run.
+ */
+[[nodiscard]] static auto run_real(std::string_view source)
+{
+    dtn::detronade dtn("test", source);
+    dtn.compile();
+
+    auto result = dtn.compilation_successful ? dtn.run() : std::nullopt;
+    if (result.has_value() && result->get_if<double>())
+    {
+        return *result->get_if<double>();
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+/**
+ *  @brief  Get the difference of two reals in units in the last place of
+ *          the expected one.
+ *
+ *  @param  value     The real.
+ *  @param  expected  The expected real.
+ *  @return  The difference, or infinity if only one of them is not finite.
+ */
+[[nodiscard]] static auto ulps_between(double value, double expected)
+{
+    if (value == expected || (std::isnan(value) && std::isnan(expected)))
+    {
+        return 0.0;
+    }
+
+    if (!std::isfinite(value) || !std::isfinite(expected))
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    auto magnitude = std::abs(expected);
+    auto ulp       = std::nextafter(magnitude,
+        std::numeric_limits<double>::infinity()) - magnitude;
+    return std::abs(value - expected) / ulp;
+}
+
+/**
+ *  @brief  Test the bytecode compiler and the VM.
+ *  @return  Number of errors.
+ */
+[[nodiscard]] auto test_dtn_vm() -> std::size_t
+{
+    T_BEGIN;
+
+    // The documented examples give the documented results
+    for (auto [source, expected] : documented_results)
+    {
+        T_ASSERT_FMT(run_source(source), std::string(expected),
+            "Result of documented example: {}", source);
+    }
+
+    // Constant expressions are folded into one constant, and only the
+    // branch of a known condition is compiled
+    T_ASSERT(disassemble("3 + 4 * 5 + (6 + 7) * (8 - (9 + 10))"),
+        "load_constant(-120) return_"s, "Folded constant expression");
+
+    auto propagated = disassemble("const int y = 2 + 3\ny * 4");
+    T_ASSERT(propagated.ends_with("load_constant(20) return_"), true,
+        "Propagated constant variable");
+    T_ASSERT(propagated.contains("multiply"), false,
+        "Arithmetic of a constant variable");
+
+    auto branches = disassemble("real x = 1\n"
+                                "if (2 > 3)\n"
+                                "    x = 7\n"
+                                "else\n"
+                                "    x = 9\n"
+                                "x");
+    T_ASSERT(branches.contains("jump"), false, "Jumps of a known condition");
+    T_ASSERT(count_of(branches, "load_constant(7)"), 0uz, "Dead branch");
+    T_ASSERT(count_of(branches, "load_constant(9)"), 1uz, "Live branch");
+
+    // An invariant call is evaluated once before the loop jumps to its
+    // condition, instead of in the body
+    constexpr std::string_view hoisted_source =
+        "real f(real n)\n"
+        "    real total = 0\n"
+        "    int i = 0\n"
+        "    while (i < 10)\n"
+        "        total += sqrt(n)\n"
+        "        i++\n"
+        "    total\n"
+        "f(16)";
+    T_ASSERT(run_source(hoisted_source), "40"s, "Result of a hoisted call");
+
+    auto hoisted = disassemble(hoisted_source, "f");
+    auto entry   = hoisted.substr(0, hoisted.find(" jump "));
+    T_ASSERT(count_of(hoisted, "call_builtin"), 1uz, "Calls of a hoisted call");
+    T_ASSERT(count_of(entry, "call_builtin"), 1uz, "Call hoisted from a loop");
+
+    dtn::compile_options unhoisted = {};
+    unhoisted.hoist_expressions    = false;
+    auto body  = disassemble(hoisted_source, "f", unhoisted);
+    auto start = body.substr(0, body.find(" jump "));
+    T_ASSERT(count_of(start, "call_builtin"), 0uz, "Call left in a loop");
+
+    // A small function is compiled in place of its call
+    constexpr std::string_view inlined_source =
+        "int twice(int x) x * 2\n"
+        "int f(int a) twice(a) + 1\n"
+        "f(4)";
+    T_ASSERT(run_source(inlined_source), "9"s, "Result of an inlined call");
+
+    auto inlined = disassemble(inlined_source, "f");
+    T_ASSERT(count_of(inlined, "call"), 0uz, "Call of a small function");
+    T_ASSERT(count_of(inlined, "multiply_int"), 1uz, "Inlined body");
+
+    // An overload of known operands is resolved when compiling, instead of
+    // being looked up when the program runs
+    constexpr std::string_view overload_source =
+        "struct vec2\n"
+        "    real x, y\n"
+        "vec2 operator(vec2 a + vec2 b) vec2(a.x + b.x, a.y + b.y)\n"
+        "vec2 sum(vec2 a, vec2 b) a + b\n"
+        "sum(vec2(1, 2), vec2(3, 4)).y";
+    T_ASSERT(run_source(overload_source), "6"s, "Result of a known overload");
+
+    auto resolved = disassemble(overload_source, "sum");
+    T_ASSERT(count_of(resolved, "add"), 0uz, "Overload found when running");
+    T_ASSERT(count_of(resolved, "call_operator"), 0uz,
+        "Custom overload found when running");
+    T_ASSERT(count_of(resolved, "call"), 0uz, "Call of a small overload");
+
+    // A structure whose value never escapes is kept in the registers of
+    // its fields, and one that escapes is created
+    constexpr std::string_view escape_source =
+        "struct vec2\n"
+        "    real x, y\n"
+        "real squares(real x, real y)\n"
+        "    vec2 v = vec2(x, y)\n"
+        "    v.x * v.x + v.y * v.y\n"
+        "vec2 made(real x, real y)\n"
+        "    vec2 v = vec2(x, y)\n"
+        "    v\n"
+        "squares(3, 4) + made(1, 2).y";
+    T_ASSERT(run_source(escape_source), "27"s, "Result of kept structures");
+
+    auto unescaped = disassemble(escape_source, "squares");
+    T_ASSERT(count_of(unescaped, "construct"), 0uz,
+        "Structure that never escapes");
+    auto escaped = disassemble(escape_source, "made");
+    T_ASSERT(count_of(escaped, "construct"), 1uz, "Structure that escapes");
+
+    // Operands of declared types use the opcodes of their types
+    constexpr std::string_view typed_source =
+        "int f(int a, int b) a + b\n"
+        "real g(real a, real b) a // b\n"
+        "real h(int a, real b) a * b\n"
+        "bool k(int a, int b) a > b\n"
+        "f(2, 4) * 100 + g(7, 2) * 10 + h(3, 1.5)";
+    T_ASSERT(run_source(typed_source), "634.5"s, "Result of typed operands");
+
+    auto f = disassemble(typed_source, "f");
+    T_ASSERT(count_of(f, "add_int"), 1uz, "Typed int addition");
+    T_ASSERT(count_of(f, "add"), 0uz, "Untyped addition");
+    auto g = disassemble(typed_source, "g");
+    T_ASSERT(count_of(g, "floor_divide_real"), 1uz, "Typed floor division");
+    auto h = disassemble(typed_source, "h");
+    T_ASSERT(count_of(h, "int_to_real"), 1uz, "Conversion of an int operand");
+    T_ASSERT(count_of(h, "multiply_real"), 1uz, "Typed mixed multiplication");
+    auto k = disassemble(typed_source, "k");
+    T_ASSERT(count_of(k, "less_int"), 1uz, "Typed comparison");
+
+    // An array is moved to a call at its last use instead of copied, and
+    // changing a copy leaves the original as it was
+    constexpr std::string_view moved_source =
+        "int grow(int[] v)\n"
+        "    int first = v.insert(0, 9)\n"
+        "    v.count() + first\n"
+        "int last()\n"
+        "    int[] a = [1, 2, 3]\n"
+        "    grow(a)\n"
+        "int kept()\n"
+        "    int[] a = [1, 2, 3]\n"
+        "    int n = grow(a)\n"
+        "    n * 10 + a.count()\n"
+        "last() * 1000 + kept()";
+    T_ASSERT(run_source(moved_source), "13133"s, "Result of moved arrays");
+
+    auto last = disassemble(moved_source, "last");
+    T_ASSERT(count_of(last, "take"), 1uz, "Array moved at its last use");
+    T_ASSERT(count_of(last, "copy"), 0uz, "Array copied at its last use");
+    auto kept = disassemble(moved_source, "kept");
+    T_ASSERT(count_of(kept, "copy") > 0, true,
+        "Array copied before a later use");
+
+    T_ASSERT(run_source("int[] a = [1, 2, 3]\n"
+                        "int[] b = a\n"
+                        "b[0] = 7\n"
+                        "a[0] * 10 + b[0]"),
+        "17"s, "Original after changing a copy");
+
+    // Runtime errors stop the program
+    T_ASSERT(run_source("int a = 5\nint b = 0\na // b"),
+        "division_by_zero"s, "Integer floor division by zero");
+    T_ASSERT(run_source("int a = 5\nint b = 0\na % b"),
+        "division_by_zero"s, "Integer modulo by zero");
+    T_ASSERT(run_source("int[] a = [1]\na[3]"), "index_out_of_range"s,
+        "Index out of range");
+    T_ASSERT(run_source("int f(int n) f(n + 1)\nf(0)", 50),
+        "stack_overflow"s, "Stack overflow");
+    T_ASSERT(run_source("int f(int n)\n"
+                        "    if (n < 40)\n"
+                        "        return f(n + 1)\n"
+                        "    n\n"
+                        "f(0)", 50),
+        "40"s, "Calls within the maximum depth");
+
+    // Batches give the results of running the function, except for the
+    // last places that the lanes of builtins may differ in
+    dtn::detronade batch_dtn("test", batch_source);
+    batch_dtn.compile();
+    auto batch = batch_dtn.compile_batch("f");
+    T_ASSERT(batch.has_value(), true, "Batch function");
+
+    std::mt19937                           random(42);
+    std::uniform_real_distribution<double> distribution(-300.0, 300.0);
+    std::vector<double>                    xs(64);
+    std::vector<double>                    ys(64);
+    std::vector<double>                    results(64);
+    for (std::size_t i = 0; i < xs.size(); i++)
+    {
+        xs[i] = distribution(random);
+        ys[i] = i % 8 == 0 ? 0.0 : distribution(random);
+    }
+
+    auto columns = std::to_array<std::span<const double>>({ xs, ys });
+    if (batch.has_value() && batch->evaluate(columns, results))
+    {
+        for (std::size_t i = 0; i < xs.size(); i++)
+        {
+            auto source = std::format("{}\nf({}, {})", batch_source,
+                real_literal(xs[i]), real_literal(ys[i]));
+            auto expected = run_real(source);
+            auto tolerance = 1e-12 * (1.0 + std::abs(xs[i]) + std::abs(ys[i]));
+            auto close     = std::abs(results[i] - expected) <= tolerance;
+            T_ASSERT_FMT(close, true, "Batch result of f({}, {}): {} != {}",
+                xs[i], ys[i], results[i], expected);
+        }
+    }
+
+    // Builtin lanes stay within the documented ulps of the scalar results
+    std::vector<double> args_x(1021);
+    std::vector<double> args_y(1021);
+    std::vector<double> scalar(1021);
+    std::vector<double> lanes(1021);
+    for (std::size_t i = 0; i < args_x.size(); i++)
+    {
+        args_x[i] = distribution(random) / 10.0;
+        args_y[i] = distribution(random) / 100.0;
+    }
+    args_x[0] = 0.0;
+    args_x[1] = -0.0;
+    args_x[2] = std::numeric_limits<double>::infinity();
+    args_x[3] = std::numeric_limits<double>::quiet_NaN();
+
+    auto functions = dtn::builtins();
+    for (std::size_t f = 0; f < functions.size(); f++)
+    {
+        auto &info = functions[f];
+        auto *y    = info.least == 2 ? args_y.data() : nullptr;
+        info.scalar(scalar.data(), args_x.data(), y, args_x.size());
+        info.lanes(lanes.data(), args_x.data(), y, args_x.size());
+
+        double worst = 0.0;
+        for (std::size_t i = 0; i < args_x.size(); i++)
+        {
+            worst = std::max(worst, ulps_between(lanes[i], scalar[i]));
+        }
+        auto within = worst <= info.ulps;
+        T_ASSERT_FMT(within, true, "Lanes of builtin {}: {} ulps > {} ulps", f,
+            worst, info.ulps);
+    }
+
+    T_END;
+}
@@ -51,6 +51,24 @@
 //  */
 // [[nodiscard]] auto test_() -> std::size_t;
 
+/**
+ *  @brief  Test Detronade's compile cache.
+ *  @return  Number of errors.
+ */
+[[nodiscard]] auto test_dtn_cache() -> std::size_t;
+
+/**
+ *  @brief  Test Detronade's lexer and parser.
+ *  @return  Number of errors.
+ */
+[[nodiscard]] auto test_dtn_parser() -> std::size_t;
+
+/**
+ *  @brief  Test Detronade's bytecode compiler and VM.
+ *  @return  Number of errors.
+ */
+[[nodiscard]] auto test_dtn_vm() -> std::size_t;
+
 /**
  *  @brief  The biggie.
  *  @return  zero on success.
@@ -78,6 +96,28 @@ auto main() -> int try
 
     // suite.tests.emplace_back(&_test);
 
+    test dtn_cache_test = {
+        "Test Detronade's compile cache",
+        "test_dtn_cache",
+        test_dtn_cache
+    };
+
+    test dtn_parser_test = {
+        "Test Detronade's lexer and parser",
+        "test_dtn_parser",
+        test_dtn_parser
+    };
+
+    test dtn_vm_test = {
+        "Test Detronade's bytecode compiler and VM",
+        "test_dtn_vm",
+        test_dtn_vm
+    };
+
+    suite.tests.emplace_back(&dtn_cache_test);
+    suite.tests.emplace_back(&dtn_parser_test);
+    suite.tests.emplace_back(&dtn_vm_test);
+
     auto failed_tests = suite.run();
     log_file.open("tester.log");
 